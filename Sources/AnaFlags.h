@@ -52,6 +52,7 @@ enum AnaFlags
   CPU_SSE42                  = 0x01000000, // SSE4.2
   CPU_AVX                    = 0x02000000, // AVX  PF RFU
   CPU_AVX2                   = 0x04000000, // AVX2 PF RFU
+  CPU_AVX512                 = 0x20000000, // AVX-512F + AVX-512BW
 
   // force MVAnalyse to use a different function for SAD / SADCHROMA (debug)
 	MOTION_USE_SSD             = 0x08000000,
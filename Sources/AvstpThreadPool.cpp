@@ -0,0 +1,320 @@
+/*****************************************************************************
+
+        AvstpThreadPool.cpp
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"AvstpThreadPool.h"
+
+#include	<algorithm>
+
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*
+==============================================================================
+Name: ctor
+Input parameters:
+	- nbr_threads: total number of threads, including the calling ones.
+		0 to use the number of hardware threads.
+==============================================================================
+*/
+
+AvstpThreadPool::AvstpThreadPool (int nbr_threads)
+:	_nbr_threads (
+		(nbr_threads > 0)
+		? nbr_threads
+		: std::max (int (std::thread::hardware_concurrency ()), 1)
+	)
+,	_queue_arr ()
+,	_thread_arr ()
+,	_enqueue_pos (0)
+,	_nbr_queued (0)
+,	_sleep_mutex ()
+,	_sleep_cond ()
+,	_quit_flag (false)
+{
+	const int		nbr_workers = _nbr_threads - 1;
+	for (int index = 0; index < nbr_workers; ++index)
+	{
+		_queue_arr.push_back (QueueUPtr (new WorkerQueue));
+	}
+	for (int index = 0; index < nbr_workers; ++index)
+	{
+		_thread_arr.push_back (std::thread (&AvstpThreadPool::work_loop, this, index));
+	}
+}
+
+
+
+AvstpThreadPool::~AvstpThreadPool ()
+{
+	{
+		std::lock_guard <std::mutex>	lock (_sleep_mutex);
+		_quit_flag = true;
+	}
+	_sleep_cond.notify_all ();
+
+	for (auto &thread : _thread_arr)
+	{
+		if (thread.joinable ())
+		{
+			thread.join ();
+		}
+	}
+}
+
+
+
+avstp_TaskDispatcher *	AvstpThreadPool::create_dispatcher ()
+{
+	return (reinterpret_cast <avstp_TaskDispatcher *> (new Dispatcher));
+}
+
+
+
+void	AvstpThreadPool::destroy_dispatcher (avstp_TaskDispatcher *td_ptr)
+{
+	Dispatcher *	disp_ptr = reinterpret_cast <Dispatcher *> (td_ptr);
+	assert (disp_ptr == 0 || disp_ptr->_nbr_pending == 0);
+
+	delete disp_ptr;
+}
+
+
+
+int	AvstpThreadPool::get_nbr_threads () const
+{
+	return (_nbr_threads);
+}
+
+
+
+int	AvstpThreadPool::enqueue_task (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr)
+{
+	if (td_ptr == 0 || task_ptr == 0)
+	{
+		return (avstp_Err_INVALID_ARG);
+	}
+
+	Task				task;
+	task._disp_ptr      = reinterpret_cast <Dispatcher *> (td_ptr);
+	task._task_ptr      = task_ptr;
+	task._user_data_ptr = user_data_ptr;
+	++ task._disp_ptr->_nbr_pending;
+
+	if (_queue_arr.empty ())
+	{
+		// Single thread: no need to defer
+		run_task (task);
+	}
+	else
+	{
+		// Workers keep their sub-tasks local, the other threads spread
+		// the tasks over all the queues.
+		const int		nbr_queues = int (_queue_arr.size ());
+		int				index = _cur_worker_index;
+		if (_cur_pool_ptr != this)
+		{
+			index = (_enqueue_pos ++ & 0x7FFFFFFF) % nbr_queues;
+		}
+
+		WorkerQueue &	queue = *_queue_arr [index];
+		{
+			std::lock_guard <std::mutex>	lock (queue._mutex);
+			queue._task_list.push_back (task);
+		}
+		++ _nbr_queued;
+
+		// Locking before notifying prevents a lost wake-up with a thread
+		// which just checked _nbr_queued.
+		{
+			std::lock_guard <std::mutex>	lock (_sleep_mutex);
+		}
+		_sleep_cond.notify_one ();
+	}
+
+	return (avstp_Err_OK);
+}
+
+
+
+int	AvstpThreadPool::wait_completion (avstp_TaskDispatcher *td_ptr)
+{
+	if (td_ptr == 0)
+	{
+		return (avstp_Err_INVALID_ARG);
+	}
+
+	Dispatcher &	disp = *reinterpret_cast <Dispatcher *> (td_ptr);
+	const int		index = (_cur_pool_ptr == this) ? _cur_worker_index : -1;
+
+	while (disp._nbr_pending > 0)
+	{
+		// Helps with any pending task instead of blocking
+		Task				task;
+		if (pop_task (task, index))
+		{
+			run_task (task);
+		}
+		else
+		{
+			std::unique_lock <std::mutex>	lock (_sleep_mutex);
+			_sleep_cond.wait (lock, [this, &disp] () {
+				return (disp._nbr_pending == 0 || _nbr_queued > 0);
+			});
+		}
+	}
+
+	const bool		exception_flag = disp._exception_flag.exchange (false);
+
+	return (exception_flag ? avstp_Err_EXCEPTION : avstp_Err_OK);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+void	AvstpThreadPool::work_loop (int index)
+{
+	_cur_pool_ptr     = this;
+	_cur_worker_index = index;
+
+	for ( ; ; )
+	{
+		Task				task;
+		if (pop_task (task, index))
+		{
+			run_task (task);
+		}
+		else
+		{
+			std::unique_lock <std::mutex>	lock (_sleep_mutex);
+			_sleep_cond.wait (lock, [this] () {
+				return (_quit_flag || _nbr_queued > 0);
+			});
+			if (_quit_flag)
+			{
+				break;
+			}
+		}
+	}
+}
+
+
+
+// index: worker index of the calling thread, -1 if not a worker.
+// Returns true if a task has been retrieved.
+bool	AvstpThreadPool::pop_task (Task &task, int index)
+{
+	const int		nbr_queues = int (_queue_arr.size ());
+
+	// Own queue first, most recent task
+	if (index >= 0)
+	{
+		WorkerQueue &	queue = *_queue_arr [index];
+		std::lock_guard <std::mutex>	lock (queue._mutex);
+		if (! queue._task_list.empty ())
+		{
+			task = queue._task_list.back ();
+			queue._task_list.pop_back ();
+			-- _nbr_queued;
+			return (true);
+		}
+	}
+
+	// Then steals the oldest task of the other queues
+	for (int k = 1; k <= nbr_queues; ++k)
+	{
+		const int		victim = (std::max (index, 0) + k) % nbr_queues;
+		if (victim == index)
+		{
+			continue;
+		}
+		WorkerQueue &	queue = *_queue_arr [victim];
+		std::lock_guard <std::mutex>	lock (queue._mutex);
+		if (! queue._task_list.empty ())
+		{
+			task = queue._task_list.front ();
+			queue._task_list.pop_front ();
+			-- _nbr_queued;
+			return (true);
+		}
+	}
+
+	return (false);
+}
+
+
+
+void	AvstpThreadPool::run_task (Task &task)
+{
+	Dispatcher &	disp = *task._disp_ptr;
+
+	try
+	{
+		task._task_ptr (
+			reinterpret_cast <avstp_TaskDispatcher *> (&disp),
+			task._user_data_ptr
+		);
+	}
+	catch (...)
+	{
+		disp._exception_flag = true;
+	}
+
+	if (-- disp._nbr_pending == 0)
+	{
+		wake_up_all ();
+	}
+}
+
+
+
+// Wakes up the threads waiting for a dispatcher completion
+void	AvstpThreadPool::wake_up_all ()
+{
+	{
+		std::lock_guard <std::mutex>	lock (_sleep_mutex);
+	}
+	_sleep_cond.notify_all ();
+}
+
+
+
+thread_local const AvstpThreadPool *	AvstpThreadPool::_cur_pool_ptr = 0;
+thread_local int	AvstpThreadPool::_cur_worker_index = -1;
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
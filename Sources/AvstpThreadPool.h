@@ -0,0 +1,162 @@
+/*****************************************************************************
+
+        AvstpThreadPool.h
+
+Portable implementation of the AVSTP task dispatching API, used by
+AvstpWrapper when avstp.dll cannot be found.
+
+Each worker thread owns a task queue. Tasks enqueued from a worker go to its
+own queue, tasks from other threads are spread over the queues. An idle
+worker takes its own tasks first (LIFO end) and then steals from the other
+queues (FIFO end). A thread waiting for the completion of a dispatcher
+processes pending tasks too, so tasks can wait for their own sub-tasks
+without exhausting the pool.
+
+The calling thread counts as one of the threads: the pool starts one worker
+less than the number of hardware threads.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (AvstpThreadPool_HEADER_INCLUDED)
+#define	AvstpThreadPool_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"avstp.h"
+
+#include	<atomic>
+#include	<condition_variable>
+#include	<deque>
+#include	<memory>
+#include	<mutex>
+#include	<thread>
+#include	<vector>
+
+
+
+class AvstpThreadPool
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	explicit			AvstpThreadPool (int nbr_threads = 0);
+	virtual			~AvstpThreadPool ();
+
+	// Same semantic as the avstp_* functions
+	avstp_TaskDispatcher *
+						create_dispatcher ();
+	void				destroy_dispatcher (avstp_TaskDispatcher *td_ptr);
+	int				get_nbr_threads () const;
+	int				enqueue_task (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr);
+	int				wait_completion (avstp_TaskDispatcher *td_ptr);
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	class Dispatcher
+	{
+	public:
+		std::atomic <int>
+							_nbr_pending { 0 };	// Enqueued and not finished yet
+		std::atomic <bool>
+							_exception_flag { false };
+	};
+
+	class Task
+	{
+	public:
+		Dispatcher *	_disp_ptr;
+		avstp_TaskPtr	_task_ptr;
+		void *			_user_data_ptr;
+	};
+
+	class WorkerQueue
+	{
+	public:
+		std::mutex		_mutex;
+		std::deque <Task>
+							_task_list;
+	};
+
+	typedef	std::unique_ptr <WorkerQueue>	QueueUPtr;
+
+	void				work_loop (int index);
+	bool				pop_task (Task &task, int index);
+	void				run_task (Task &task);
+	void				wake_up_all ();
+
+	const int		_nbr_threads;	// Including the calling thread
+	std::vector <QueueUPtr>
+						_queue_arr;		// One per worker
+	std::vector <std::thread>
+						_thread_arr;
+	std::atomic <int>
+						_enqueue_pos;	// Queue for the tasks from non-worker threads
+	std::atomic <int>
+						_nbr_queued;	// Tasks waiting in the queues
+
+	// Idle workers and waiting threads sleep here, woken up by new tasks
+	// and by the completion of the last task of a dispatcher.
+	std::mutex		_sleep_mutex;
+	std::condition_variable
+						_sleep_cond;
+	bool				_quit_flag;
+
+	static thread_local const AvstpThreadPool *
+						_cur_pool_ptr;
+	static thread_local int
+						_cur_worker_index;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						AvstpThreadPool (const AvstpThreadPool &other);
+	AvstpThreadPool &
+						operator = (const AvstpThreadPool &other);
+	bool				operator == (const AvstpThreadPool &other) const;
+	bool				operator != (const AvstpThreadPool &other) const;
+
+};	// class AvstpThreadPool
+
+
+
+//#include	"AvstpThreadPool.hpp"
+
+
+
+#endif	// AvstpThreadPool_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
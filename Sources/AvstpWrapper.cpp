@@ -55,6 +55,11 @@ Name: dtor
 
 AvstpWrapper::~AvstpWrapper ()
 {
+	// Still running: we are in the static destructors, under the loader
+	// lock. Joining the workers would hang, so the pool is leaked on
+	// purpose. The process exit terminates the threads anyway.
+	static_cast <void> (_fallback_pool_aptr.release ());
+
 	::FreeLibrary (reinterpret_cast < ::HMODULE> (_dll_hnd));
 	_dll_hnd = 0;
 }
@@ -148,6 +153,49 @@ int	AvstpWrapper::wait_completion (avstp_TaskDispatcher *td_ptr)
 
 
 
+/*
+==============================================================================
+Name: add_pool_user
+Description:
+	Registers a user of the built-in thread pool, typically a script
+	environment. Does not create the pool nor the singleton.
+Throws: Nothing
+==============================================================================
+*/
+
+void	AvstpWrapper::add_pool_user ()
+{
+	conc::CritSec	guard (use_pool_mutex ());
+	++ _nbr_pool_users;
+}
+
+
+
+/*
+==============================================================================
+Name: release_pool_user
+Description:
+	Unregisters a user of the built-in thread pool. The pool threads are
+	joined when there is no user left, so this must be called from a normal
+	context (for example an AtExit callback), never from DllMain or a static
+	destructor. No task should be running.
+Throws: Nothing
+==============================================================================
+*/
+
+void	AvstpWrapper::release_pool_user ()
+{
+	conc::CritSec	guard (use_pool_mutex ());
+	assert (_nbr_pool_users > 0);
+	-- _nbr_pool_users;
+	if (_nbr_pool_users == 0 && _singleton_init_flag)
+	{
+		_singleton_aptr->_fallback_pool_aptr.reset ();
+	}
+}
+
+
+
 /*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
 
 
@@ -160,12 +208,14 @@ AvstpWrapper::AvstpWrapper ()
 ,	_avstp_get_nbr_threads_ptr (0)
 ,	_avstp_enqueue_task_ptr (0)
 ,	_avstp_wait_completion_ptr (0)
+,	_fallback_flag (false)
+,	_fallback_pool_aptr ()
 {
 	if (_dll_hnd == 0)
 	{
 		::OutputDebugStringW (
 			L"AvstpWrapper: cannot find avstp.dll."
-			L"Usage restricted to single threading.\n"
+			L"Using the built-in thread pool.\n"
 		);
 //		throw std::runtime_error ("Cannot find avstp.dll.");
 		assign_fallback ();
@@ -218,6 +268,8 @@ void	AvstpWrapper::assign_normal ()
 
 void	AvstpWrapper::assign_fallback ()
 {
+	_fallback_flag = true;
+
 	_avstp_get_interface_version_ptr = &fallback_get_interface_version_ptr;
 	_avstp_create_dispatcher_ptr     = &fallback_create_dispatcher_ptr;
 	_avstp_destroy_dispatcher_ptr    = &fallback_destroy_dispatcher_ptr;
@@ -228,6 +280,34 @@ void	AvstpWrapper::assign_fallback ()
 
 
 
+AvstpThreadPool &	AvstpWrapper::use_fallback_pool ()
+{
+	assert (_fallback_flag);
+
+	conc::CritSec	guard (use_pool_mutex ());
+	if (_fallback_pool_aptr.get () == 0)
+	{
+		_fallback_pool_aptr = std::unique_ptr <AvstpThreadPool> (new AvstpThreadPool);
+	}
+
+	return (*_fallback_pool_aptr);
+}
+
+
+
+conc::Mutex &	AvstpWrapper::use_pool_mutex ()
+{
+	static conc::Mutex	mutex;
+
+	return (mutex);
+}
+
+
+
+// The fallback functions are only reachable through the singleton, which
+// owns the pool. A dispatcher keeps the pool alive: the functions taking one
+// don't need to check it.
+
 int	AvstpWrapper::fallback_get_interface_version_ptr ()
 {
 	return (avstp_INTERFACE_VERSION);
@@ -237,62 +317,42 @@ int	AvstpWrapper::fallback_get_interface_version_ptr ()
 
 avstp_TaskDispatcher *	AvstpWrapper::fallback_create_dispatcher_ptr ()
 {
-	return ((avstp_TaskDispatcher *) (&_dummy_dispatcher));
+	return (_singleton_aptr->use_fallback_pool ().create_dispatcher ());
 }
 
 
 
 void	AvstpWrapper::fallback_destroy_dispatcher_ptr (avstp_TaskDispatcher *td_ptr)
 {
-	assert (td_ptr == (avstp_TaskDispatcher *) (&_dummy_dispatcher));
+	_singleton_aptr->_fallback_pool_aptr->destroy_dispatcher (td_ptr);
 }
 
 
 
 int	AvstpWrapper::fallback_get_nbr_threads_ptr ()
 {
-	return (1);
+	return (_singleton_aptr->use_fallback_pool ().get_nbr_threads ());
 }
 
 
 
 int	AvstpWrapper::fallback_enqueue_task_ptr (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr)
 {
-	int				ret_val = avstp_Err_OK;
-
-	if (   td_ptr != (avstp_TaskDispatcher *) (&_dummy_dispatcher)
-	    || task_ptr == 0)
-	{
-		ret_val = avstp_Err_INVALID_ARG;
-	}
-	else
-	{
-		task_ptr (td_ptr, user_data_ptr);
-	}
-
-	return (ret_val);
+	return (_singleton_aptr->_fallback_pool_aptr->enqueue_task (td_ptr, task_ptr, user_data_ptr));
 }
 
 
 
 int	AvstpWrapper::fallback_wait_completion_ptr (avstp_TaskDispatcher *td_ptr)
 {
-	int				ret_val = avstp_Err_OK;
-
-	if (td_ptr != (avstp_TaskDispatcher *) (&_dummy_dispatcher))
-	{
-		ret_val = avstp_Err_INVALID_ARG;
-	}
-
-	return (ret_val);
+	return (_singleton_aptr->_fallback_pool_aptr->wait_completion (td_ptr));
 }
 
 
 
 std::unique_ptr <AvstpWrapper>	AvstpWrapper::_singleton_aptr;
 volatile bool	AvstpWrapper::_singleton_init_flag = false;
-
-int	AvstpWrapper::_dummy_dispatcher;
+int	AvstpWrapper::_nbr_pool_users = 0;
 
 
 
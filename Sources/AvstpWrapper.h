@@ -6,11 +6,17 @@
 A convenient wrapper on top of the AVSTP low-level API.
 Take care of:
 - Library discovery and initialisation
-- Fallback to mono-threaded mode if not found
+- Fallback to the built-in AvstpThreadPool if not found
 
 This is a singleton, you cannot construct it directly. Use use_instance()
 to access it from anywhere.
 
+The threads of the built-in pool must not be joined from the static
+destructors: they run under the loader lock, when the worker threads cannot
+terminate. The plugin registers each script environment as a pool user, and
+the pool is shut down when the last environment is deleted. It is started
+again on demand if needed.
+
 --- Legal stuff ---
 
 This program is free software. It comes without any warranty, to
@@ -35,6 +41,8 @@ http://sam.zoy.org/wtfpl/COPYING for more details.
 
 /*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
 
+#include	"conc/Mutex.h"
+#include	"AvstpThreadPool.h"
 #include	"avstp.h"
 
 #include	<memory>
@@ -62,6 +70,9 @@ public:
 	int				enqueue_task (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr);
 	int				wait_completion (avstp_TaskDispatcher *td_ptr);
 
+	static void		add_pool_user ();
+	static void		release_pool_user ();
+
 
 
 /*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -81,6 +92,11 @@ private:
 
 	void				assign_normal ();
 	void				assign_fallback ();
+	AvstpThreadPool &
+						use_fallback_pool ();
+
+	static conc::Mutex &
+						use_pool_mutex ();
 
 	static int		fallback_get_interface_version_ptr ();
 	static avstp_TaskDispatcher *
@@ -100,12 +116,15 @@ private:
 
 	void *			_dll_hnd;	// Avoids loading windows.h just for HMODULE
 
+	bool				_fallback_flag;
+	std::unique_ptr <AvstpThreadPool>
+						_fallback_pool_aptr;	// Only without avstp.dll. Created on demand, protected by use_pool_mutex()
+
 	static std::unique_ptr <AvstpWrapper>
                   _singleton_aptr;
    static volatile bool
 						_singleton_init_flag;
-
-	static int		_dummy_dispatcher;
+	static int		_nbr_pool_users;	// Protected by use_pool_mutex()
 
 
 
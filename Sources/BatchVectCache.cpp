@@ -0,0 +1,218 @@
+/*****************************************************************************
+
+        BatchVectCache.cpp
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"BatchVectCache.h"
+
+#include	<cassert>
+#include	<cstring>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+BatchVectCache::BatchVectCache (int arr_size)
+:	_arr_size (arr_size)
+,	_entry_arr (NBR_FRAMES)
+,	_date_cnt (0)
+,	_mutex ()
+,	_cond ()
+{
+	assert (arr_size > 0);
+
+	for (auto &entry : _entry_arr)
+	{
+		entry._nsrc  = -1;
+		entry._state = State_EMPTY;
+		entry._date  = 0;
+	}
+}
+
+
+
+// Returns the cache shared by all the filter instances working on the same
+// clip with the same parameters (sig), or creates it.
+BatchVectCache::SPtr	BatchVectCache::use_shared (const void *clip_ptr, const std::string &sig, int arr_size)
+{
+	assert (clip_ptr != 0);
+
+	std::lock_guard <std::mutex>	lock (_reg_mutex);
+
+	// Removes the caches not used any more
+	for (auto it = _registry.begin (); it != _registry.end (); )
+	{
+		if (it->second.expired ())
+		{
+			it = _registry.erase (it);
+		}
+		else
+		{
+			++ it;
+		}
+	}
+
+	const Key		key (clip_ptr, sig);
+	SPtr				cache_sptr;
+	auto				it = _registry.find (key);
+	if (it != _registry.end ())
+	{
+		cache_sptr = it->second.lock ();
+	}
+	if (! cache_sptr)
+	{
+		cache_sptr = SPtr (new BatchVectCache (arr_size));
+		_registry [key] = cache_sptr;
+	}
+	assert (cache_sptr->_arr_size == arr_size);
+
+	return cache_sptr;
+}
+
+
+
+// Copies len ints of the batch of the frame nsrc, from pos. If another
+// instance is computing the batch, waits for it.
+// Returns false if the batch is not available. The caller must then compute
+// it and call store(), or cancel() if it fails.
+bool	BatchVectCache::fetch (int nsrc, int pos, int len, int *vect_ptr)
+{
+	assert (nsrc >= 0);
+	assert (pos >= 0);
+	assert (len > 0);
+	assert (pos + len <= _arr_size);
+	assert (vect_ptr != 0);
+
+	std::unique_lock <std::mutex>	lock (_mutex);
+
+	Entry *			entry_ptr = find (nsrc);
+	while (entry_ptr != 0 && entry_ptr->_state == State_COMPUTING)
+	{
+		_cond.wait (lock);
+		entry_ptr = find (nsrc);
+	}
+
+	++ _date_cnt;
+	if (entry_ptr != 0)
+	{
+		assert (entry_ptr->_state == State_READY);
+		memcpy (vect_ptr, &entry_ptr->_vect_arr [pos], len * sizeof (vect_ptr [0]));
+		entry_ptr->_date = _date_cnt;
+
+		return true;
+	}
+
+	// Reserves the oldest entry not being computed. If all of them are busy,
+	// the batch will just not be cached.
+	for (auto &entry : _entry_arr)
+	{
+		if (   entry._state != State_COMPUTING
+		    && (entry_ptr == 0 || entry._date < entry_ptr->_date))
+		{
+			entry_ptr = &entry;
+		}
+	}
+	if (entry_ptr != 0)
+	{
+		entry_ptr->_nsrc  = nsrc;
+		entry_ptr->_state = State_COMPUTING;
+		entry_ptr->_date  = _date_cnt;
+	}
+
+	return false;
+}
+
+
+
+// Stores the batch of the frame nsrc, after fetch() failed, and wakes up the
+// instances waiting for it.
+void	BatchVectCache::store (int nsrc, const int *vect_ptr)
+{
+	assert (nsrc >= 0);
+	assert (vect_ptr != 0);
+
+	std::lock_guard <std::mutex>	lock (_mutex);
+
+	Entry *			entry_ptr = find (nsrc);
+	if (entry_ptr != 0 && entry_ptr->_state == State_COMPUTING)
+	{
+		entry_ptr->_vect_arr.resize (_arr_size);
+		memcpy (&entry_ptr->_vect_arr [0], vect_ptr, _arr_size * sizeof (vect_ptr [0]));
+		entry_ptr->_state = State_READY;
+		_cond.notify_all ();
+	}
+}
+
+
+
+// Releases the reservation of the frame nsrc when its computation failed.
+// The waiting instances will compute the batch themselves.
+void	BatchVectCache::cancel (int nsrc)
+{
+	assert (nsrc >= 0);
+
+	std::lock_guard <std::mutex>	lock (_mutex);
+
+	Entry *			entry_ptr = find (nsrc);
+	if (entry_ptr != 0 && entry_ptr->_state == State_COMPUTING)
+	{
+		entry_ptr->_nsrc  = -1;
+		entry_ptr->_state = State_EMPTY;
+		_cond.notify_all ();
+	}
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// Caller must lock _mutex
+BatchVectCache::Entry *	BatchVectCache::find (int nsrc)
+{
+	for (auto &entry : _entry_arr)
+	{
+		if (entry._nsrc == nsrc)
+		{
+			return &entry;
+		}
+	}
+
+	return 0;
+}
+
+
+
+std::mutex	BatchVectCache::_reg_mutex;
+BatchVectCache::Registry	BatchVectCache::_registry;
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,146 @@
+/*****************************************************************************
+
+        BatchVectCache.h
+
+Vector fields of all the Src/Ref pairs of a source frame, as searched in a
+row by MAnalyse in multi mode. The first request for an output frame of a
+source frame computes the whole batch, the requests for the other pairs of
+the same source frame are served from the cache.
+
+The cache is thread-safe. The MAnalyse instances created by Avisynth+ for
+the same call in MT_MULTI_INSTANCE mode share the same cache, identified by
+the super clip and a signature of the analysis parameters, so a batch is
+computed only once whatever the instance receiving the requests. An
+instance requesting a batch being computed by another instance waits for
+the result.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (BatchVectCache_HEADER_INCLUDED)
+#define	BatchVectCache_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	<condition_variable>
+#include	<map>
+#include	<memory>
+#include	<mutex>
+#include	<string>
+#include	<utility>
+#include	<vector>
+
+#include	<stdint.h>
+
+
+
+class BatchVectCache
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	enum {			NBR_FRAMES = 8 };	// Batches kept
+
+	typedef	std::shared_ptr <BatchVectCache>	SPtr;
+
+						BatchVectCache (int arr_size);
+	virtual			~BatchVectCache () {}
+
+	static SPtr		use_shared (const void *clip_ptr, const std::string &sig, int arr_size);
+
+	bool				fetch (int nsrc, int pos, int len, int *vect_ptr);
+	void				store (int nsrc, const int *vect_ptr);
+	void				cancel (int nsrc);
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	enum State
+	{
+		State_EMPTY = 0,
+		State_COMPUTING,
+		State_READY
+	};
+
+	class Entry
+	{
+	public:
+		int				_nsrc;		// -1 = empty
+		State				_state;
+		int64_t			_date;		// Value of _date_cnt when reserved or used
+		std::vector <int>
+							_vect_arr;	// Allocated on first use
+	};
+
+	typedef	std::vector <Entry>	EntryArray;
+
+	typedef	std::pair <const void *, std::string>	Key;
+	typedef	std::map <Key, std::weak_ptr <BatchVectCache> >	Registry;
+
+	Entry *			find (int nsrc);
+
+	const int		_arr_size;		// ints
+	EntryArray		_entry_arr;
+	int64_t			_date_cnt;
+	std::mutex		_mutex;
+	std::condition_variable
+						_cond;			// Signaled when a computation ends
+
+	static std::mutex
+						_reg_mutex;
+	static Registry
+						_registry;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						BatchVectCache ();
+						BatchVectCache (const BatchVectCache &other);
+	BatchVectCache &
+						operator = (const BatchVectCache &other);
+	bool				operator == (const BatchVectCache &other) const;
+	bool				operator != (const BatchVectCache &other) const;
+
+};	// class BatchVectCache
+
+
+
+//#include	"BatchVectCache.hpp"
+
+
+
+#endif	// BatchVectCache_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -20,6 +20,7 @@
 #include <map>
 #include <tuple>
 #include <stdint.h>
+#include "SADFunctions_avx512.h"
 
 #if !defined(_M_X64)
 #define rax	eax
@@ -209,8 +210,35 @@ func_copy[make_tuple(x, y, 4, NO_SIMD)] = Copy_C<x, y, float>;
     func_copy[make_tuple(2 , 2 , 1, USE_SSE2)] = Copy2x2_sse2;
     //func_copy[make_tuple(2 , 1 , 1, USE_SSE2)] = Copy2x1_sse2; no such
 
+    // templates in SADFunctions_avx512
+#define MAKE_COPY_FN(x, y) func_copy[make_tuple(x, y, 1, USE_AVX512)] = Copy_avx512<x, y, uint8_t>; \
+func_copy[make_tuple(x, y, 2, USE_AVX512)] = Copy_avx512<x, y, uint16_t>;
+      MAKE_COPY_FN(64, 64)
+      MAKE_COPY_FN(64, 48)
+      MAKE_COPY_FN(64, 32)
+      MAKE_COPY_FN(64, 16)
+      MAKE_COPY_FN(48, 64)
+      MAKE_COPY_FN(48, 48)
+      MAKE_COPY_FN(48, 24)
+      MAKE_COPY_FN(48, 12)
+      MAKE_COPY_FN(32, 64)
+      MAKE_COPY_FN(32, 32)
+      MAKE_COPY_FN(32, 24)
+      MAKE_COPY_FN(32, 16)
+      MAKE_COPY_FN(32, 8)
+      MAKE_COPY_FN(32, 4)
+      MAKE_COPY_FN(16, 64)
+      MAKE_COPY_FN(16, 32)
+      MAKE_COPY_FN(16, 16)
+      MAKE_COPY_FN(16, 12)
+      MAKE_COPY_FN(16, 8)
+      MAKE_COPY_FN(16, 4)
+      MAKE_COPY_FN(16, 2)
+      MAKE_COPY_FN(16, 1)
+#undef MAKE_COPY_FN
+
     COPYFunction *result = nullptr;
-    arch_t archlist[] = { USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
+    arch_t archlist[] = { USE_AVX512, USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
     int index = 0;
     while (result == nullptr) {
       arch_t current_arch_try = archlist[index++];
@@ -42,16 +42,3 @@ FakeBlockData::~FakeBlockData()
 {
 
 }
-
-/* moved to header because of forceinline
-void FakeBlockData::Update(const int *array)
-{
-	vector.x   = array [0];
-	vector.y   = array [1];
-	vector.sad = *(sad_t *)(&array [2]);
-//	nLength    = SquareLength(vector);
-//	nPitch     = pitch;
-//	pRef       = ref + x + y * pitch;
-}
-*/
-
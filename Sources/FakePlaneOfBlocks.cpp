@@ -22,9 +22,19 @@
 #include "FakePlaneOfBlocks.h"
 #include	"MVInterface.h"
 
+#include	<cassert>
+
 
 
 FakePlaneOfBlocks::FakePlaneOfBlocks(int sizeX, int sizeY, int lv, int pel, int _nOverlapX, int _nOverlapY, int _nBlkX, int _nBlkY)
+:	_x_arr()
+,	_y_arr()
+,	_mv_ptr(0)
+,	_vx_arr()
+,	_vy_arr()
+,	_sad_arr()
+,	_soa_flag(false)
+,	_soa_mutex()
 {
    nBlkSizeX = sizeX;
    nBlkSizeY = sizeY;
@@ -43,37 +53,64 @@ FakePlaneOfBlocks::FakePlaneOfBlocks(int sizeX, int sizeY, int lv, int pel, int
 	nLogScale = lv;
 	nScale = iexp2(nLogScale);
 
-	blocks = new FakeBlockData [nBlkCount];
+	_x_arr.resize(nBlkCount);
+	_y_arr.resize(nBlkCount);
+	_vx_arr.resize(nBlkCount);
+	_vy_arr.resize(nBlkCount);
+	_sad_arr.resize(nBlkCount);
 	for ( int j = 0, blkIdx = 0; j < nBlkY; j++ )
+	{
 		for ( int i = 0; i < nBlkX; i++, blkIdx++ )
-			blocks[blkIdx].Init(i * (nBlkSizeX - nOverlapX), j * (nBlkSizeY - nOverlapY));
+		{
+			_x_arr[blkIdx] = i * (nBlkSizeX - nOverlapX);
+			_y_arr[blkIdx] = j * (nBlkSizeY - nOverlapY);
+		}
+	}
 }
 
 
 
 FakePlaneOfBlocks::~FakePlaneOfBlocks()
 {
-//	for ( int i = 0; i < nBlkCount; i++ )
-//		delete blocks[i];
-
-	delete[] blocks;
+	// Nothing
 }
 
+// array is the vector clip data: x, y, sad for each block.
+// Only the pointer is kept, the caller has to keep the data alive as long
+// as the plane is used.
 void FakePlaneOfBlocks::Update(const int *array)
 {
-	array += 0;
+	static_assert(sizeof(VECTOR) == N_PER_BLOCK * sizeof(int), "VECTOR must match the vector clip layout");
+	_mv_ptr = reinterpret_cast<const VECTOR *>(array);
+	_soa_flag.store(false, std::memory_order_release);
+}
+
+void FakePlaneOfBlocks::BuildArrays() const
+{
+	std::lock_guard <std::mutex> lock(_soa_mutex);
+	if (_soa_flag.load(std::memory_order_relaxed))
+	{
+		return; // Built by another thread in the meantime
+	}
+
+	assert(_mv_ptr != 0);
+	int * const vx = &_vx_arr[0];
+	int * const vy = &_vy_arr[0];
+	sad_t * const sad = &_sad_arr[0];
 	for ( int i = 0; i < nBlkCount; i++ )
 	{
-		blocks[i].Update(array);
-		array += N_PER_BLOCK;
+		vx[i] = _mv_ptr[i].x;
+		vy[i] = _mv_ptr[i].y;
+		sad[i] = _mv_ptr[i].sad;
 	}
+	_soa_flag.store(true, std::memory_order_release);
 }
 
 bool FakePlaneOfBlocks::IsSceneChange(sad_t nTh1, int nTh2) const
 {
 	int sum = 0;
 	for ( int i = 0; i < nBlkCount; i++ )
-		sum += ( blocks[i].GetSAD() > nTh1 ) ? 1 : 0;
+		sum += ( _mv_ptr[i].sad > nTh1 ) ? 1 : 0;
 
 	return ( sum > nTh2 );
 }
@@ -20,12 +20,20 @@
 
 
 
+#include	"AllocAlign.h"
 #include	"FakeBlockData.h"
 
+#include	<atomic>
+#include	<mutex>
+#include	<vector>
+
 
 
 class FakePlaneOfBlocks
 {
+	// One element per block, 64-byte aligned for SIMD processing
+	typedef	std::vector <int, AllocAlign <int, 64> >	IntArray;
+	typedef	std::vector <sad_t, AllocAlign <sad_t, 64> >	SadArray;
 
 	int nWidth_Bi;
 	int nHeight_Bi;
@@ -41,7 +49,25 @@ class FakePlaneOfBlocks
 	int nOverlapX;
 	int nOverlapY;
 
-	FakeBlockData *blocks;
+	// Block positions, in pixels. Constant.
+	IntArray _x_arr;
+	IntArray _y_arr;
+
+	// Vectors are not copied: this points directly into the vector clip
+	// frame, which must be kept alive by the owner (see MVClip::Update).
+	const VECTOR * _mv_ptr;
+
+	// Structure-of-arrays copy of the vectors, built on demand by the
+	// GetArray*() accessors, at most once per Update. The accessors may be
+	// called concurrently by the worker threads of a frame: the build is
+	// guarded by _soa_mutex and published through _soa_flag.
+	mutable IntArray _vx_arr;
+	mutable IntArray _vy_arr;
+	mutable SadArray _sad_arr;
+	mutable std::atomic <bool> _soa_flag;
+	mutable std::mutex _soa_mutex;
+
+	void BuildArrays() const;
 
 public :
 
@@ -56,8 +82,8 @@ public :
 		return (( i >= 0 ) && ( i < nBlkCount ));
 	}
 
-  MV_FORCEINLINE const FakeBlockData& operator[](const int i) const {
-		return (blocks[i]);
+  MV_FORCEINLINE FakeBlockData operator[](const int i) const {
+		return (GetBlock(i));
 	}
 
   MV_FORCEINLINE int GetBlockCount() const { return nBlkCount; }
@@ -70,7 +96,17 @@ public :
   MV_FORCEINLINE int GetBlockSizeX() const { return nBlkSizeX; }
   MV_FORCEINLINE int GetBlockSizeY() const { return nBlkSizeY; }
   MV_FORCEINLINE int GetPel() const { return nPel; }
-  MV_FORCEINLINE const FakeBlockData& GetBlock(int i) const { return (blocks[i]); }
+  MV_FORCEINLINE FakeBlockData GetBlock(int i) const { return FakeBlockData(_x_arr[i], _y_arr[i], GetMV(i)); }
+  MV_FORCEINLINE VECTOR GetMV(int i) const { return _mv_ptr[i]; }
+  // Whole fields, GetBlockCount() elements in raster order.
+  // The vector fields are de-interleaved from the frame on first use, prefer
+  // GetMV() for sparse accesses. Thread-safe, but Update() must not be
+  // called while other threads are still using the plane.
+  MV_FORCEINLINE const int *GetArrayX() const { return &_x_arr[0]; }
+  MV_FORCEINLINE const int *GetArrayY() const { return &_y_arr[0]; }
+  MV_FORCEINLINE const int *GetArrayVx() const { if (!_soa_flag.load(std::memory_order_acquire)) BuildArrays(); return &_vx_arr[0]; }
+  MV_FORCEINLINE const int *GetArrayVy() const { if (!_soa_flag.load(std::memory_order_acquire)) BuildArrays(); return &_vy_arr[0]; }
+  MV_FORCEINLINE const sad_t *GetArraySAD() const { if (!_soa_flag.load(std::memory_order_acquire)) BuildArrays(); return &_sad_arr[0]; }
   MV_FORCEINLINE int GetOverlapX() const { return nOverlapX; }
   MV_FORCEINLINE int GetOverlapY() const { return nOverlapY; }
 };
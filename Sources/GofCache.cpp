@@ -0,0 +1,260 @@
+/*****************************************************************************
+
+        GofCache.cpp
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"GofCache.h"
+#include	"MVGroupOfFrames.h"
+
+#include	<algorithm>
+#include	<cassert>
+#include	<exception>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+GofCache::GofCache ()
+:	_entry_arr ()
+,	_index_arr (1, -1)
+,	_index_mask (0)
+,	_use_cnt (0)
+,	_last_n (-1)
+,	_seq_flag (false)
+{
+	// Nothing
+}
+
+
+
+GofCache::~GofCache ()
+{
+	// Nothing
+}
+
+
+
+// Adds a GOF to the cache, which takes its ownership. The GOF is not
+// assigned to any frame yet.
+void	GofCache::add (MVGroupOfFrames *gof_ptr)
+{
+	assert (gof_ptr != 0);
+
+	Entry				entry;
+	entry._gof_uptr.reset (gof_ptr);
+	entry._n        = -1;
+	entry._last_use = 0;
+	_entry_arr.push_back (std::move (entry));
+
+	// Keeps the index at least twice the cache size. The new entry is not
+	// assigned, so the existing mapping can be built again from scratch.
+	const int		nbr_entries = int (_entry_arr.size ());
+	if (int (_index_arr.size ()) < nbr_entries * 2)
+	{
+		int				index_size = 1;
+		while (index_size < nbr_entries * 2)
+		{
+			index_size <<= 1;
+		}
+		_index_arr.assign (index_size, -1);
+		_index_mask = index_size - 1;
+		for (int e = 0; e < nbr_entries; ++e)
+		{
+			if (_entry_arr [e]._n >= 0)
+			{
+				set_index (_entry_arr [e]._n, e);
+			}
+		}
+	}
+}
+
+
+
+int	GofCache::get_size () const
+{
+	return (int (_entry_arr.size ()));
+}
+
+
+
+// Returns the GOF already set up for the frame n, or 0 if the frame is not
+// in the cache.
+MVGroupOfFrames *	GofCache::find (int n)
+{
+	assert (n >= 0);
+
+	int				entry_index = _index_arr [n & _index_mask];
+	if (entry_index < 0 || _entry_arr [entry_index]._n != n)
+	{
+		// Index collision, or frame not in the cache
+		entry_index = -1;
+		const int		nbr_entries = int (_entry_arr.size ());
+		for (int e = 0; e < nbr_entries && entry_index < 0; ++e)
+		{
+			if (_entry_arr [e]._n == n)
+			{
+				entry_index = e;
+				set_index (n, e);
+			}
+		}
+		if (entry_index < 0)
+		{
+			return (0);
+		}
+	}
+
+	Entry &			entry = _entry_arr [entry_index];
+	++ _use_cnt;
+	entry._last_use = _use_cnt;
+
+	return (entry._gof_uptr.get ());
+}
+
+
+
+// Takes the least recently used GOF and assigns it to the frame n, whose
+// super frame is given. The caller must then Update() the returned GOF with
+// the planes of this frame.
+// The GOFs returned by the previous calls remain valid as long as there are
+// less calls than the cache size.
+MVGroupOfFrames &	GofCache::assign (int n, const ::PVideoFrame &frame)
+{
+	assert (n >= 0);
+	assert (! _entry_arr.empty ());
+
+	const int		nbr_entries = int (_entry_arr.size ());
+	int				lru_index = 0;
+	for (int e = 0; e < nbr_entries; ++e)
+	{
+		assert (_entry_arr [e]._n != n);
+		if (_entry_arr [e]._last_use < _entry_arr [lru_index]._last_use)
+		{
+			lru_index = e;
+		}
+	}
+
+	Entry *			lru_ptr = &_entry_arr [lru_index];
+	if (lru_ptr->_n >= 0 && _index_arr [lru_ptr->_n & _index_mask] == lru_index)
+	{
+		_index_arr [lru_ptr->_n & _index_mask] = -1;
+	}
+	set_index (n, lru_index);
+
+	++ _use_cnt;
+	lru_ptr->_n        = n;
+	lru_ptr->_frame    = frame;
+	lru_ptr->_last_use = _use_cnt;
+
+	return (*lru_ptr->_gof_uptr);
+}
+
+
+
+// Unassigns all the GOFs and releases the super frames.
+void	GofCache::clear ()
+{
+	for (auto &entry : _entry_arr)
+	{
+		entry._n        = -1;
+		entry._frame    = 0;
+		entry._last_use = 0;
+	}
+	std::fill (_index_arr.begin (), _index_arr.end (), -1);
+}
+
+
+
+// Call at the beginning of a request, n being the frame number driving the
+// access pattern (output or source frame). Access is sequential when n is
+// the previous frame or one of its neighbours. Otherwise the frames kept
+// from the previous request are unlikely to be used again and are released.
+void	GofCache::start_frame (int n)
+{
+	_seq_flag = (_last_n >= 0 && n >= _last_n - 1 && n <= _last_n + 1);
+	if (! _seq_flag)
+	{
+		clear ();
+	}
+	_last_n = n;
+}
+
+
+
+// Call at the end of a request. Releases the super frames if the access is
+// not sequential, so they are not pinned until the next request.
+void	GofCache::end_frame ()
+{
+	if (! _seq_flag)
+	{
+		clear ();
+	}
+}
+
+
+
+GofCache::FrameGuard::FrameGuard (GofCache &cache, int n)
+:	_cache (cache)
+,	_nbr_exceptions (std::uncaught_exceptions ())
+{
+	_cache.start_frame (n);
+}
+
+
+
+GofCache::FrameGuard::~FrameGuard ()
+{
+	if (std::uncaught_exceptions () > _nbr_exceptions)
+	{
+		_cache.clear ();
+		_cache._last_n = -1;
+	}
+	else
+	{
+		_cache.end_frame ();
+	}
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+void	GofCache::set_index (int n, int entry_index)
+{
+	assert (n >= 0);
+	assert (entry_index >= 0);
+	assert (entry_index < int (_entry_arr.size ()));
+
+	_index_arr [n & _index_mask] = entry_index;
+}
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,167 @@
+/*****************************************************************************
+
+        GofCache.h
+
+Small LRU cache of MVGroupOfFrames, keyed by super clip frame number.
+
+A GOF is only a set of plane descriptors pointing into a super frame, but
+its state (padding, lazy sub-pixel stripes already rendered) is lost each
+time it is updated with another frame. In linear processing, the same super
+frame is used several times in a row: the reference of the frame n is the
+source of the frame n+1 in MAnalyse, and most of the MDegrainN references
+are shared by consecutive frames. The cache keeps the GOFs of the recently
+used frames, so they can be used again without being set up.
+
+Lookups go through a small direct-mapped index keyed by the absolute frame
+number. It has at least twice as many slots as the cache has entries, so a
+sliding window of consecutive frames never collides and a hit costs a
+single test, whatever the cache size. On a collision, the cache falls back
+to a linear search.
+
+Each entry keeps a reference on its super frame, so the planes stay valid
+as long as the entry is not replaced. All the cached GOFs must be created
+with the same parameters and updated with the same plane mode, and all the
+frames must come from the same super clip.
+
+The cached super frames are held outside the AviSynth cache accounting:
+up to get_size() frames per filter instance. They are only worth keeping
+when the frames are requested in order. The filter brackets each GetFrame()
+with a FrameGuard, calling start_frame() and end_frame(): when the requested
+frame does not follow the previous one (random access, or the frames spread
+over several instances by the MT modes), the cache releases all its super
+frames at the end of the request instead of keeping them for the next one.
+
+The cache is not thread-safe, it is intended to be a filter member.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (GofCache_HEADER_INCLUDED)
+#define	GofCache_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#define	NOGDI
+#define	NOMINMAX
+#define	WIN32_LEAN_AND_MEAN
+#include "Windows.h"
+#include	"avisynth.h"
+
+#include	<memory>
+
+#include	<stdint.h>
+#include	<vector>
+
+
+
+class MVGroupOfFrames;
+
+class GofCache
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	// Brackets a request with start_frame() and end_frame(). If the request
+	// fails, the cache is cleared, its GOFs may be only partly set up.
+	class FrameGuard
+	{
+	public:
+		explicit			FrameGuard (GofCache &cache, int n);
+							~FrameGuard ();
+	private:
+		GofCache &		_cache;
+		const int		_nbr_exceptions;	// Uncaught exceptions at construction
+							FrameGuard (const FrameGuard &other);
+		FrameGuard &	operator = (const FrameGuard &other);
+	};
+
+						GofCache ();
+	virtual			~GofCache ();
+
+	void				add (MVGroupOfFrames *gof_ptr);
+	int				get_size () const;
+	MVGroupOfFrames *
+						find (int n);
+	MVGroupOfFrames &
+						assign (int n, const ::PVideoFrame &frame);
+	void				clear ();
+
+	void				start_frame (int n);
+	void				end_frame ();
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	class Entry
+	{
+	public:
+		std::unique_ptr <MVGroupOfFrames>
+							_gof_uptr;
+		::PVideoFrame	_frame;		// Keeps the planes alive
+		int				_n;			// Super frame number, -1 = not assigned
+		int64_t			_last_use;	// Value of _use_cnt when last found or assigned
+	};
+
+	typedef	std::vector <Entry>	EntryArray;
+	typedef	std::vector <int>	IndexArray;
+
+	void				set_index (int n, int entry_index);
+
+	EntryArray		_entry_arr;
+	IndexArray		_index_arr;	// Frame number modulo size -> entry index, -1 = none
+	int				_index_mask;
+	int64_t			_use_cnt;
+	int				_last_n;		// Frame of the previous request, -1 = none
+	bool				_seq_flag;	// The current request follows the previous one
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						GofCache (const GofCache &other);
+	GofCache &		operator = (const GofCache &other);
+	bool				operator == (const GofCache &other) const;
+	bool				operator != (const GofCache &other) const;
+
+};	// class GofCache
+
+
+
+//#include	"GofCache.hpp"
+
+
+
+#endif	// GofCache_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -18,12 +18,17 @@
 // http://www.gnu.org/copyleft/gpl.html .
 
 #include "AnaFlags.h"
+#include "AvstpWrapper.h"
 #include "debugprintf.h"
 #include "GroupOfPlanes.h"
 #include "MVGroupOfFrames.h"
 #include "profile.h"
 #include "avisynth.h"
 
+#include	<algorithm>
+#include	<climits>
+#include	<cassert>
+
 
 
 GroupOfPlanes::GroupOfPlanes(
@@ -46,6 +51,12 @@ GroupOfPlanes::GroupOfPlanes(
   , bits_per_pixel(_bits_per_pixel)
   , _mt_flag(mt_flag)
   , _dct_pool_ptr(dct_pool_ptr)
+  , _sched_pyramid_ptr()
+  , _graph_pyramid()
+  , _pyramid_task_arr()
+  , _pyramid_nbr_threads(0)
+  , _pyramid_meander_flag(false)
+  , _pyramid_valid_flag(false)
 {
   planes = new PlaneOfBlocks*[nLevelCount];
 
@@ -143,10 +154,70 @@ void	GroupOfPlanes::SearchMVs(
   SearchType		searchTypeSmallest =
     (nLevelCount == 1 || searchType == HSEARCH || searchType == VSEARCH)
     ? searchType
-    : EXHAUSTIVE; // full search for smallest coarse plane
+    : (searchType == SEASEARCH) ? SEASEARCH : EXHAUSTIVE; // full search for smallest coarse plane
   int				nSearchParamSmallest =
     (nLevelCount == 1) ? nPelSearch : nSearchParam;
   DebugPrintf("SearchType %i", searchType);
+
+  // Without global motion and DCT, a level only needs the vectors of the
+  // coarser level for its predictors, and only the rows around the current
+  // one. So all the levels are searched at once: a block row starts as soon
+  // as the coarse rows it is interpolated from are done, instead of waiting
+  // for the whole coarser level. Rows and slices are the same as in the
+  // level-by-level search, so are the vectors.
+  if (   _mt_flag && !global && _dct_pool_ptr == 0 && outfilebuf == 0
+      && nLevelCount > 1 && prepare_pyramid(meander))
+  {
+    int *				out_level = out;
+    int *				vecPrev_level = vecPrev;
+    for (int i = nLevelCount - 1; i >= 0; i--)
+    {
+      SearchType		searchTypeLevel =
+        (i == 0 || searchType == HSEARCH || searchType == VSEARCH)
+        ? searchType
+        : (searchType == SEASEARCH) ? SEASEARCH : EXHAUSTIVE; // full search for coarse planes
+      planes[i]->PrepareSearchMVs(
+        pSrcGOF->GetFrame(i),
+        pRefGOF->GetFrame(i),
+        searchTypeLevel,
+        (i == 0) ? nPelSearch : nSearchParam,
+        nLambda,
+        lsad,
+        pnew,
+        plevel,
+        flags,
+        out_level,
+        &globalMV,
+        outfilebuf,
+        (i == 0) ? fieldShift : 0,
+        &meanLumaChange,
+        divideExtra,
+        pzero,
+        pglobal,
+        badSAD,
+        badrange,
+        meander,
+        vecPrev_level,
+        (tryMany && i > 0)
+      );
+
+      out_level += planes[i]->GetArraySize(divideExtra);
+      if (vecPrev_level)
+      {
+        vecPrev_level += planes[i]->GetArraySize(divideExtra);
+      }
+    }
+
+    _sched_pyramid_ptr->start(_graph_pyramid, *this, &GroupOfPlanes::search_mv_pyramid);
+    _sched_pyramid_ptr->wait();
+
+    for (int i = nLevelCount - 1; i >= 0; i--)
+    {
+      planes[i]->FinishSearchMVs(&meanLumaChange);
+    }
+    return;
+  }
+
   bool				tryManyLevel = (tryMany && nLevelCount > 1);
   planes[nLevelCount - 1]->SearchMVs(
     pSrcGOF->GetFrame(nLevelCount - 1),
@@ -186,7 +257,7 @@ void	GroupOfPlanes::SearchMVs(
     SearchType		searchTypeLevel =
       (i == 0 || searchType == HSEARCH || searchType == VSEARCH)
       ? searchType
-      : EXHAUSTIVE; // full search for coarse planes
+      : (searchType == SEASEARCH) ? SEASEARCH : EXHAUSTIVE; // full search for coarse planes
     int				nSearchParamLevel =
       (i == 0) ? nPelSearch : nSearchParam; // special case for finest level
 
@@ -198,14 +269,7 @@ void	GroupOfPlanes::SearchMVs(
       //			DebugPrintf("SearchMV globalMV %i, %i", globalMV.x, globalMV.y);
     }
 
-    if (pixelsize == 1) {
-      if (planes[i]->GetnBlkSizeX()*planes[i]->GetnBlkSizeY() < 280) // for why 280: see calculation inside InterpolatePrediction
-        planes[i]->InterpolatePrediction<sad_t, sad_t>(*(planes[i + 1])); // use 32 bit intermediate for smallOverlap
-      else
-        planes[i]->InterpolatePrediction<sad_t, bigsad_t>(*(planes[i + 1])); // use 64bit intermediate for smallOverLap
-    }
-    else
-      planes[i]->InterpolatePrediction<bigsad_t, bigsad_t>(*(planes[i + 1])); // always use 64bit temporary inside
+    interpolate_prediction(i, 0, planes[i]->GetnBlkY());
 
     if (global) // can be moved after Interpolate, since it does not use the global mv results
     {
@@ -251,6 +315,243 @@ void	GroupOfPlanes::SearchMVs(
 
 
 
+// Computes the predictors of rows [blky_beg ; blky_end[ of a level from the
+// vectors of the coarser level.
+void	GroupOfPlanes::interpolate_prediction(int level, int blky_beg, int blky_end)
+{
+  PlaneOfBlocks &	plane = *(planes[level]);
+  const PlaneOfBlocks &	plane_coarse = *(planes[level + 1]);
+
+  if (pixelsize == 1) {
+    if (plane.GetnBlkSizeX()*plane.GetnBlkSizeY() < 280) // for why 280: see calculation inside InterpolatePrediction
+      plane.InterpolatePrediction<sad_t, sad_t>(plane_coarse, blky_beg, blky_end); // use 32 bit intermediate for smallOverlap
+    else
+      plane.InterpolatePrediction<sad_t, bigsad_t>(plane_coarse, blky_beg, blky_end); // use 64bit intermediate for smallOverLap
+  }
+  else
+    plane.InterpolatePrediction<bigsad_t, bigsad_t>(plane_coarse, blky_beg, blky_end); // always use 64bit temporary inside
+}
+
+
+
+// Builds the task graph of the pipelined search, if not done yet for the
+// current parameters. Each level is split like in PlaneOfBlocks::SearchMVs:
+// wavefront chunks without meander when possible, row slices otherwise.
+// The task searching the first rows of a chunk column or slice first
+// interpolates the predictors it needs, and depends on the tasks completing
+// the coarse rows used by this interpolation.
+// Returns false if the pipelined search cannot be used.
+bool	GroupOfPlanes::prepare_pyramid(bool meander)
+{
+  const int nbr_threads = AvstpWrapper::use_instance().get_nbr_threads();
+  if (nbr_threads == _pyramid_nbr_threads && meander == _pyramid_meander_flag)
+  {
+    return (_pyramid_valid_flag);
+  }
+
+  _pyramid_nbr_threads = nbr_threads;
+  _pyramid_meander_flag = meander;
+  _pyramid_valid_flag = false;
+  _graph_pyramid.clear();
+  _pyramid_task_arr.clear();
+  if (nbr_threads <= 1)
+  {
+    return (false);
+  }
+
+  // Grid of each level. nbr_cols = 0 for row slices.
+  std::vector <int>	nbr_cols_arr(nLevelCount);
+  std::vector <int>	chunk_w_arr(nLevelCount);
+  std::vector <int>	nbr_slices_arr(nLevelCount);
+  int				nbr_tasks = 1;	// Root
+  for (int i = 0; i < nLevelCount; i++)
+  {
+    const int		nBlkY = planes[i]->GetnBlkY();
+    if (!meander && planes[i]->GetWavefrontGrid(nbr_cols_arr[i], chunk_w_arr[i]))
+    {
+      nbr_tasks += nBlkY * nbr_cols_arr[i];
+    }
+    else
+    {
+      // Same split as MTSlicer
+      int				nbr_slices = std::min(nbr_threads, 64);
+      nbr_slices = std::min(nbr_slices, nBlkY / 4);
+      nbr_slices = std::max(nbr_slices, 1);
+      nbr_cols_arr[i] = 0;
+      nbr_slices_arr[i] = nbr_slices;
+      nbr_tasks += nbr_slices;
+    }
+  }
+  if (nbr_tasks > MAX_PYRAMID_TASKS)
+  {
+    return (false);
+  }
+
+  PyramidTask		root = { 0 };
+  _pyramid_task_arr.reserve(nbr_tasks);
+  _pyramid_task_arr.push_back(root);
+
+  // Index of the task completing each row of the coarser and current levels
+  std::vector <int>	row_task_coarse;
+  std::vector <int>	row_task_cur;
+
+  for (int i = nLevelCount - 1; i >= 0; i--)
+  {
+    const int		nBlkX = planes[i]->GetnBlkX();
+    const int		nBlkY = planes[i]->GetnBlkY();
+    const bool		coarsest_flag = (i == nLevelCount - 1);
+    row_task_cur.assign(nBlkY, 0);
+
+    const int		nbr_cols = nbr_cols_arr[i];
+    const int		nbr_slices = (nbr_cols > 0) ? nBlkY : nbr_slices_arr[i];
+    for (int s = 0; s < nbr_slices; s++)
+    {
+      for (int c = 0; c < std::max(nbr_cols, 1); c++)
+      {
+        PyramidTask		task = { 0 };
+        task.level = i;
+        task.wavefront_flag = (nbr_cols > 0);
+        if (task.wavefront_flag)
+        {
+          // Row s needs the predictors of row s + 1 (bottom-right one)
+          task.blky_beg = s;
+          task.blky_end = s + 1;
+          task.blkx_beg = c * chunk_w_arr[i];
+          task.blkx_end = std::min(task.blkx_beg + chunk_w_arr[i], nBlkX);
+          if (c == 0)
+          {
+            task.interp_beg = (s == 0) ? 0 : s + 1;
+            task.interp_end = std::min(s + 2, nBlkY);
+          }
+        }
+        else
+        {
+          task.blky_beg = s * nBlkY / nbr_slices;
+          task.blky_end = (s + 1) * nBlkY / nbr_slices;
+          task.blkx_beg = 0;
+          task.blkx_end = nBlkX;
+          task.interp_beg = task.blky_beg;
+          task.interp_end = task.blky_end;
+        }
+        if (coarsest_flag)
+        {
+          task.interp_beg = 0;
+          task.interp_end = 0;
+        }
+
+        const int		index = int(_pyramid_task_arr.size());
+        _pyramid_task_arr.push_back(task);
+        int				nbr_dep = 0;
+
+        // Same level: left and top-right (or top) chunks
+        if (task.wavefront_flag)
+        {
+          if (c > 0)
+          {
+            _graph_pyramid.add_dep(index - 1, index);
+            ++nbr_dep;
+          }
+          if (s > 0)
+          {
+            const int		c_top = std::min(c + 1, nbr_cols - 1);
+            _graph_pyramid.add_dep(index - c - nbr_cols + c_top, index);
+            ++nbr_dep;
+          }
+        }
+
+        // Coarser level: rows read by InterpolatePrediction
+        if (task.interp_beg < task.interp_end)
+        {
+          const int		nBlkY_coarse = planes[i + 1]->GetnBlkY();
+          const int		j_last = 2 * nBlkY_coarse - 1;
+          int				r_min = INT_MAX;
+          int				r_max = -1;
+          for (int j = task.interp_beg; j < task.interp_end; j++)
+          {
+            const int		jj = std::min(j, j_last);
+            const int		r = jj / 2;
+            r_min = std::min(r_min, r);
+            r_max = std::max(r_max, r);
+            if (jj > 0 && jj < j_last)
+            {
+              const int		r_off = r + ((jj & 1) ? 1 : -1);
+              r_min = std::min(r_min, r_off);
+              r_max = std::max(r_max, r_off);
+            }
+          }
+          int				index_prv = -1;
+          for (int r = r_min; r <= r_max; r++)
+          {
+            const int		index_from = row_task_coarse[r];
+            if (index_from != index_prv)
+            {
+              _graph_pyramid.add_dep(index_from, index);
+              ++nbr_dep;
+              index_prv = index_from;
+            }
+          }
+        }
+
+        if (nbr_dep == 0)
+        {
+          _graph_pyramid.add_dep(0, index);
+        }
+
+        // With the wavefront, the last chunk of a row completes the row and
+        // all the previous ones.
+        if (!task.wavefront_flag || c == nbr_cols - 1)
+        {
+          for (int y = task.blky_beg; y < task.blky_end; y++)
+          {
+            row_task_cur[y] = index;
+          }
+        }
+      }
+    }
+
+    row_task_coarse.swap(row_task_cur);
+  }
+  assert(int(_pyramid_task_arr.size()) == nbr_tasks);
+
+  if (_sched_pyramid_ptr.get() == 0)
+  {
+    _sched_pyramid_ptr = std::unique_ptr <SchedulerPyramid>(
+      new SchedulerPyramid(true)
+    );
+  }
+  _pyramid_valid_flag = true;
+
+  return (true);
+}
+
+
+
+void	GroupOfPlanes::search_mv_pyramid(SchedulerPyramid::TaskData &td)
+{
+  assert(&td != 0);
+
+  if (td._task_index == 0)
+  {
+    return;	// Nothing on the root node
+  }
+
+  const PyramidTask &	task = _pyramid_task_arr[td._task_index];
+  if (task.interp_beg < task.interp_end)
+  {
+    interpolate_prediction(task.level, task.interp_beg, task.interp_end);
+  }
+  if (task.wavefront_flag)
+  {
+    planes[task.level]->SearchMVsChunk(task.blky_beg, task.blkx_beg, task.blkx_end);
+  }
+  else
+  {
+    planes[task.level]->SearchMVsRows(task.blky_beg, task.blky_end);
+  }
+}
+
+
+
 void	GroupOfPlanes::RecalculateMVs(
   MVClip &mvClip,
   MVGroupOfFrames *pSrcGOF,
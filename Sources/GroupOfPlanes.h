@@ -20,14 +20,43 @@
 
 
 
+#include "MTFlowGraphSched.h"
+#include "MTFlowGraphSparse.h"
 #include "PlaneOfBlocks.h"
 #include "avisynth.h"
 
+#include	<memory>
+#include	<vector>
+
+
+
+// Maximum number of tasks (root included) for the pipelined search of all
+// the levels
+#define MAX_PYRAMID_TASKS (16384)
+
+
 
 class MVGroupOfFrames;
 
 class GroupOfPlanes
 {
+	typedef	MTFlowGraphSparse <MAX_PYRAMID_TASKS>	GraphPyramid;
+	typedef	MTFlowGraphSched <GroupOfPlanes, GraphPyramid, GroupOfPlanes, MAX_PYRAMID_TASKS>	SchedulerPyramid;
+
+	// One task of the pipelined search
+	class PyramidTask
+	{
+	public:
+		int            level;
+		int            blky_beg;      // Searched rows, [blky_beg ; blky_end[
+		int            blky_end;
+		int            blkx_beg;      // Searched columns, wavefront tasks only
+		int            blkx_end;
+		int            interp_beg;    // Rows predicted from the coarser level before the search
+		int            interp_end;
+		bool           wavefront_flag;
+	};
+
 	int            nBlkSizeX;
 	int            nBlkSizeY;
 	int            nLevelCount;
@@ -48,6 +77,19 @@ class GroupOfPlanes
 	PlaneOfBlocks **
 	               planes;
 
+	std::unique_ptr <SchedulerPyramid>
+	               _sched_pyramid_ptr;
+	GraphPyramid   _graph_pyramid;
+	std::vector <PyramidTask>
+	               _pyramid_task_arr;   // Indexed by the graph task index, root included
+	int            _pyramid_nbr_threads; // Parameters of the current graph, 0 = not built yet
+	bool           _pyramid_meander_flag;
+	bool           _pyramid_valid_flag;
+
+	bool           prepare_pyramid (bool meander);
+	void           search_mv_pyramid (SchedulerPyramid::TaskData &td);
+	void           interpolate_prediction (int level, int blky_beg, int blky_end);
+
 public :
   GroupOfPlanes(
     int _nBlkSizeX, int _nBlkSizeY, int _nLevelCount, int _nPel, int _nFlags,
@@ -45,6 +45,7 @@
 #include "MVBlockFps.h"
 
 // Analysing filter
+#include "AvstpWrapper.h"
 #include "MVAnalyse.h"
 #include "MVRecalculate.h"
 #include "MVSuper.h"
@@ -52,6 +53,7 @@
 // Test & helpers filters
 #include "Padding.h"
 #include "MVFinest.h"
+#include "MLoadVect.h"
 #include "MRestoreVect.h"
 #include "MScaleVect.h"
 #include "MStoreVect.h"
@@ -115,6 +117,8 @@ AVSValue __cdecl Create_MVCompensate(AVSValue args, void* user_data, IScriptEnvi
     args[14].AsBool(true),	// center
     args[15].IsClip() ? args[16].AsClip() : 0, // cclip
     args[16].AsInt(thsad),  // thSAD2  todo sad_t float
+    args[17].AsBool(false), // static
+    args[18].AsBool(false), // batch
     env
   );
 }
@@ -195,6 +199,7 @@ AVSValue __cdecl Create_MVAnalyse(AVSValue args, void* user_data, IScriptEnviron
     args[30].AsBool(false),  // multi
     args[31].AsBool(true),   // mt
     args[32].AsInt(0),   // scaleCSAD
+    args[33].AsString(""),   // vectfile
     env
   );
 }
@@ -266,6 +271,7 @@ AVSValue __cdecl Create_MVFlow(AVSValue args, void*, IScriptEnvironment* env)
     args[8].AsBool(true),
     args[9].AsBool(false), // planar
     args[10].IsClip() ? args[10].AsClip() : 0,
+    args[11].AsBool(true), // mt
     env
   );
 }
@@ -295,6 +301,7 @@ AVSValue __cdecl Create_MVFlowInter(AVSValue args, void*, IScriptEnvironment* en
     args[8].AsInt(MV_DEFAULT_SCD2),
     args[9].AsBool(true),   // isse
     args[10].AsBool(false), // planar
+    args[12].AsBool(true),  // mt
     env);
 }
 
@@ -320,6 +327,7 @@ AVSValue __cdecl Create_MVFlowFps(AVSValue args, void*, IScriptEnvironment* env)
     args[11].AsBool(true),  // isse
     args[12].AsBool(false), // planar
     args[13].AsInt(0), // optDebug
+    args[14].AsBool(true),  // mt
     env
   );
 }
@@ -454,9 +462,10 @@ AVSValue __cdecl Create_MDegrainN(AVSValue args, void*, IScriptEnvironment* env)
   const float limit = args[7].AsFloatf(255.f); // change limit. 2.7.25-: use 255 as default for all bit depth v42:float
   const int thSAD2 = args[14].AsInt(thSAD);  // thSAD2
   const int thSADC2 = args[15].AsInt(thSADC); // thSADC2
+  const bool static_flag = args[18].AsBool(false); // static block fast path, MDegrainN only
 
   // Switch to MDegrain1/2/3/4/5/6 when possible (faster)
-  if (thSAD2 == thSAD && thSADC == thSADC2)
+  if (thSAD2 == thSAD && thSADC == thSADC2 && !static_flag)
   {
     if (tr <= MAX_DEGRAIN) // up to MDegrain5 160926, MDegrain6 170105
     {
@@ -513,6 +522,66 @@ AVSValue __cdecl Create_MDegrainN(AVSValue args, void*, IScriptEnvironment* env)
     thSADC2,                   // thSADC2
     args[16].AsBool(true),   // mt
     args[17].AsBool(false),   // out16
+    static_flag,               // static
+    false,                     // weighted average
+    MDegrainN::Reduce_NONE,
+    "MDegrainN",
+    env
+  );
+}
+
+AVSValue __cdecl Create_MReduceN(AVSValue args, void*, IScriptEnvironment* env)
+{
+  int plane = args[7].AsInt(4);
+  int YUVplanes;
+
+  switch (plane)
+  {
+  case 0:
+    YUVplanes = 1;
+    break;
+  case 1:
+    YUVplanes = 2;
+    break;
+  case 2:
+    YUVplanes = 4;
+    break;
+  case 3:
+    YUVplanes = 6;
+    break;
+  case 4:
+  default:
+    YUVplanes = 7;
+    break;
+  }
+
+  const int thSAD = args[5].AsInt(400);     // thSAD
+  const int thSADC = args[6].AsInt(thSAD);   // thSADC
+  const float limit = args[8].AsFloatf(255.f);
+
+  return new MDegrainN(
+    args[0].AsClip(),        // source
+    args[1].AsClip(),        // super clip
+    args[2].AsClip(),        // mvmulti
+    args[3].AsInt(1),        // tr
+    thSAD,                     // thSAD
+    thSADC,                    // thSADC
+    YUVplanes,                 // YUV planes
+    limit,                     // limit
+    args[9].AsFloatf(limit),   // limitC
+    args[10].AsInt(MV_DEFAULT_SCD1), // thSCD1
+    args[11].AsInt(MV_DEFAULT_SCD2), // thSCD2
+    args[12].AsBool(true),   // isse
+    args[13].AsBool(false),  // planar
+    false,                     // lsb
+    args[14].AsInt(thSAD),   // thSAD2
+    args[15].AsInt(thSADC),  // thSADC2
+    args[16].AsBool(true),   // mt
+    false,                     // out16
+    false,                     // static
+    true,                      // temporal reduction
+    args[4].AsInt(MDegrainN::Reduce_MEDIAN), // mode
+    "MReduceN",
     env
   );
 }
@@ -601,6 +670,7 @@ AVSValue __cdecl Create_MVSuper(AVSValue args, void*, IScriptEnvironment* env)
     args[9].AsBool(true),   // isse2
     args[10].AsBool(false), // planar
     args[11].AsBool(true), // mt
+    args[12].AsBool(false), // lazy
     env
   );
 }
@@ -645,6 +715,14 @@ AVSValue __cdecl Create_MRestoreVect(AVSValue args, void*, IScriptEnvironment* e
   );
 }
 
+AVSValue __cdecl Create_MLoadVect(AVSValue args, void*, IScriptEnvironment* env_ptr)
+{
+  return new MLoadVect(
+    args[0].AsString(), // file name
+    env_ptr
+  );
+}
+
 AVSValue __cdecl Create_MScaleVect(AVSValue args, void*, IScriptEnvironment* env)
 {
   enum { CLIP, SCALE, SCALEV, MODE, FLIP, ADJUSTSUBPEL, BITS };
@@ -661,6 +739,14 @@ AVSValue __cdecl Create_MScaleVect(AVSValue args, void*, IScriptEnvironment* env
 }
 
 
+// The built-in thread pool is shut down with the last script environment,
+// outside the DLL unloading.
+static void __cdecl release_avstp_pool(void* /*user_data*/, IScriptEnvironment* /*env*/)
+{
+  AvstpWrapper::release_pool_user();
+}
+
+
 #ifdef AVISYNTH_PLUGIN_25
 extern "C" __declspec(dllexport) const char* __stdcall AvisynthPluginInit2(IScriptEnvironment* env) {
 #else
@@ -677,15 +763,18 @@ AvisynthPluginInit3(IScriptEnvironment* env, const AVS_Linkage* const vectors) {
   // Save the server pointers.
   AVS_linkage = vectors;
 #endif
+  AvstpWrapper::add_pool_user();
+  env->AtExit(release_avstp_pool, 0);
+
   env->AddFunction("MShow", "cc[scale]i[sil]i[tol]i[showsad]b[number]i[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVShow, 0);
-  env->AddFunction("MAnalyse", "c[blksize]i[blksizeV]i[levels]i[search]i[searchparam]i[pelsearch]i[isb]b[lambda]i[chroma]b[delta]i[truemotion]b[lsad]i[plevel]i[global]b[pnew]i[pzero]i[pglobal]i[overlap]i[overlapV]i[outfile]s[dct]i[divide]i[sadx264]i[badSAD]i[badrange]i[isse]b[meander]b[temporal]b[trymany]b[multi]b[mt]b[scaleCSAD]i", Create_MVAnalyse, 0);
+  env->AddFunction("MAnalyse", "c[blksize]i[blksizeV]i[levels]i[search]i[searchparam]i[pelsearch]i[isb]b[lambda]i[chroma]b[delta]i[truemotion]b[lsad]i[plevel]i[global]b[pnew]i[pzero]i[pglobal]i[overlap]i[overlapV]i[outfile]s[dct]i[divide]i[sadx264]i[badSAD]i[badrange]i[isse]b[meander]b[temporal]b[trymany]b[multi]b[mt]b[scaleCSAD]i[vectfile]s", Create_MVAnalyse, 0);
   env->AddFunction("MMask", "cc[ml]f[gamma]f[kind]i[time]f[Ysc]i[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVMask, 0);
-  env->AddFunction("MCompensate", "ccc[scbehavior]b[recursion]f[thSAD]i[fields]b[time]f[thSCD1]i[thSCD2]i[isse]b[planar]b[mt]b[tr]i[center]b[cclip]c[thSAD2]i", Create_MVCompensate, 0);
+  env->AddFunction("MCompensate", "ccc[scbehavior]b[recursion]f[thSAD]i[fields]b[time]f[thSCD1]i[thSCD2]i[isse]b[planar]b[mt]b[tr]i[center]b[cclip]c[thSAD2]i[static]b[batch]b", Create_MVCompensate, 0);
   env->AddFunction("MSCDetection", "cc[Ysc]i[thSCD1]i[thSCD2]i[isse]b", Create_MVSCDetection, 0);
   env->AddFunction("MDepan", "cc[mask]c[zoom]b[rot]b[pixaspect]f[error]f[info]b[log]s[wrong]f[zerow]f[range]i[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVDepan, 0);
-  env->AddFunction("MFlow", "ccc[time]f[mode]i[fields]b[thSCD1]i[thSCD2]i[isse]b[planar]b[tclip]c", Create_MVFlow, 0);
-  env->AddFunction("MFlowInter", "cccc[time]f[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[tclip]c", Create_MVFlowInter, 0);
-  env->AddFunction("MFlowFps", "cccc[num]i[den]i[mask]i[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[optDebug]i", Create_MVFlowFps, 0);
+  env->AddFunction("MFlow", "ccc[time]f[mode]i[fields]b[thSCD1]i[thSCD2]i[isse]b[planar]b[tclip]c[mt]b", Create_MVFlow, 0);
+  env->AddFunction("MFlowInter", "cccc[time]f[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[tclip]c[mt]b", Create_MVFlowInter, 0);
+  env->AddFunction("MFlowFps", "cccc[num]i[den]i[mask]i[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[optDebug]i[mt]b", Create_MVFlowFps, 0);
   env->AddFunction("MFlowBlur", "cccc[blur]f[prec]i[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVFlowBlur, 0);
   env->AddFunction("MDegrain1", "cccc[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b[out16]b", Create_MVDegrainX, (void *)1);
   env->AddFunction("MDegrain2", "cccccc[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b[out16]b", Create_MVDegrainX, (void *)2);
@@ -693,12 +782,14 @@ AvisynthPluginInit3(IScriptEnvironment* env, const AVS_Linkage* const vectors) {
   env->AddFunction("MDegrain4", "cccccccccc[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b[out16]b", Create_MVDegrainX, (void *)4);
   env->AddFunction("MDegrain5", "cccccccccccc[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b[out16]b", Create_MVDegrainX, (void *)5);
   env->AddFunction("MDegrain6", "cccccccccccccc[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b[out16]b", Create_MVDegrainX, (void *)6);
-  env->AddFunction("MDegrainN", "ccci[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[thsad2]i[thsadc2]i[mt]b[out16]b", Create_MDegrainN, 0);
+  env->AddFunction("MDegrainN", "ccci[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[thsad2]i[thsadc2]i[mt]b[out16]b[static]b", Create_MDegrainN, 0);
+  env->AddFunction("MReduceN", "ccci[mode]i[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[thsad2]i[thsadc2]i[mt]b", Create_MReduceN, 0);
   env->AddFunction("MRecalculate", "cc[thsad]i[smooth]i[blksize]i[blksizeV]i[search]i[searchparam]i[lambda]i[chroma]b[truemotion]b[pnew]i[overlap]i[overlapV]i[outfile]s[dct]i[divide]i[sadx264]i[isse]b[meander]b[tr]i[mt]b[scaleCSAD]i", Create_MVRecalculate, 0);
   env->AddFunction("MBlockFps", "cccc[num]i[den]i[mode]i[ml]i[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[mt]b", Create_MVBlockFps, 0);
-  env->AddFunction("MSuper", "c[hpad]i[vpad]i[pel]i[levels]i[chroma]b[sharp]i[rfilter]i[pelclip]c[isse]b[planar]b[mt]b", Create_MVSuper, 0);
+  env->AddFunction("MSuper", "c[hpad]i[vpad]i[pel]i[levels]i[chroma]b[sharp]i[rfilter]i[pelclip]c[isse]b[planar]b[mt]b[lazy]b", Create_MVSuper, 0);
   env->AddFunction("MStoreVect", "c+[vccs]s", Create_MStoreVect, 0);
   env->AddFunction("MRestoreVect", "c[index]i", Create_MRestoreVect, 0);
+  env->AddFunction("MLoadVect", "s", Create_MLoadVect, 0);
   env->AddFunction("MScaleVect", "c[scale]f[scaleV]f[mode]i[flip]b[adjustSubPel]b[bits]i", Create_MScaleVect, 0);
   //	env->AddFunction("MVFinest",     "c[isse]b", Create_MVFinest, 0);
   return("MVTools : set of tools based on a motion estimation engine");
@@ -1630,7 +1630,7 @@ void DiagonalBilin_sse2(unsigned char *pDst8, const unsigned char *pSrc8, int nD
       _mm_storel_epi64((__m128i *)&pDst8[x], m0);
     }
 
-    reinterpret_cast<pixel_t *>(pDst8)[nWidth - 1] = (reinterpret_cast<const pixel_t *>(pSrc8)[nWidth - 1] + reinterpret_cast<const pixel_t *>(pSrc8)[nWidth - 1 + nSrcPitch] + 1) >> 1;
+    reinterpret_cast<pixel_t *>(pDst8)[nWidth - 1] = (reinterpret_cast<const pixel_t *>(pSrc8)[nWidth - 1] + reinterpret_cast<const pixel_t *>(pSrc8 + nSrcPitch)[nWidth - 1] + 1) >> 1;
 
     pSrc8 += nSrcPitch;
     pDst8 += nDstPitch;
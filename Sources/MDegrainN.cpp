@@ -10,10 +10,13 @@
 #include "MVFilter.h"
 #include "profile.h"
 #include "SuperParams64Bits.h"
+#include "overlap_avx2.h"
+#include "MDegrainN_avx2.h"
 
 #include	<emmintrin.h>
 #include	<mmintrin.h>
 
+#include	<algorithm>
 #include	<cassert>
 #include	<cmath>
 #include <map>
@@ -111,6 +114,127 @@ void DegrainN_C(
   }
 }
 
+// MReduceN: temporal reduction of the source and the usable references,
+// without weighting. A reference is usable for a block when its weight is
+// not null. Same interface as DegrainN_C, no lsb nor out16 output.
+template <typename pixel_t>
+static MV_FORCEINLINE pixel_t ReduceN_mean(typename std::conditional < sizeof(pixel_t) <= 2, int, float>::type sum, int n)
+{
+  if constexpr(sizeof(pixel_t) <= 2)
+    return (pixel_t)((sum + (n >> 1)) / n);
+  else
+    return sum / n;
+}
+
+template <typename pixel_t, int blockWidth, int blockHeight, int reduce_mode>
+void ReduceN_C(
+  BYTE *pDst, BYTE *pDstLsb, int nDstPitch,
+  const BYTE *pSrc, int nSrcPitch,
+  const BYTE *pRef[], int Pitch[],
+  int Wall[], int trad
+)
+{
+  typedef typename std::conditional < sizeof(pixel_t) <= 2, int, float>::type target_t;
+
+  // Usable references, the same for the whole block
+  const pixel_t *ref_ptr_arr[MDegrainN::MAX_TEMP_RAD * 2];
+  int ref_pitch_arr[MDegrainN::MAX_TEMP_RAD * 2];
+  int nbr_ref = 0;
+  for (int k = 0; k < trad * 2; ++k)
+  {
+    if (Wall[k + 1] > 0)
+    {
+      ref_ptr_arr[nbr_ref] = reinterpret_cast<const pixel_t *>(pRef[k]);
+      ref_pitch_arr[nbr_ref] = Pitch[k] / sizeof(pixel_t);
+      ++nbr_ref;
+    }
+  }
+
+  if (nbr_ref == 0)
+  {
+    for (int h = 0; h < blockHeight; ++h)
+    {
+      memcpy(pDst, pSrc, blockWidth * sizeof(pixel_t));
+      pDst += nDstPitch;
+      pSrc += nSrcPitch;
+    }
+    return;
+  }
+
+  pixel_t val_arr[MDegrainN::MAX_TEMP_RAD * 2 + 1];
+  const int nbr_val = nbr_ref + 1;
+  const int half = nbr_val >> 1;
+
+  for (int h = 0; h < blockHeight; ++h)
+  {
+    const pixel_t *src_ptr = reinterpret_cast<const pixel_t *>(pSrc);
+    pixel_t *dst_ptr = reinterpret_cast<pixel_t *>(pDst);
+    for (int x = 0; x < blockWidth; ++x)
+    {
+      const pixel_t src = src_ptr[x];
+      if constexpr(reduce_mode == MDegrainN::Reduce_CLAMP)
+      {
+        pixel_t lo = ref_ptr_arr[0][x];
+        pixel_t hi = lo;
+        for (int r = 1; r < nbr_ref; ++r)
+        {
+          const pixel_t v = ref_ptr_arr[r][x];
+          lo = std::min(lo, v);
+          hi = std::max(hi, v);
+        }
+        dst_ptr[x] = std::min(std::max(src, lo), hi);
+      }
+      else if constexpr(reduce_mode == MDegrainN::Reduce_TRIMMED)
+      {
+        target_t sum = src;
+        pixel_t lo = src;
+        pixel_t hi = src;
+        for (int r = 0; r < nbr_ref; ++r)
+        {
+          const pixel_t v = ref_ptr_arr[r][x];
+          sum += v;
+          lo = std::min(lo, v);
+          hi = std::max(hi, v);
+        }
+        if (nbr_val >= 3)
+        {
+          dst_ptr[x] = ReduceN_mean<pixel_t>(sum - lo - hi, nbr_val - 2);
+        }
+        else
+        {
+          dst_ptr[x] = ReduceN_mean<pixel_t>(sum, nbr_val);
+        }
+      }
+      else // Reduce_MEDIAN
+      {
+        val_arr[0] = src;
+        for (int r = 0; r < nbr_ref; ++r)
+        {
+          val_arr[r + 1] = ref_ptr_arr[r][x];
+        }
+        std::nth_element(val_arr, val_arr + half, val_arr + nbr_val);
+        if ((nbr_val & 1) != 0)
+        {
+          dst_ptr[x] = val_arr[half];
+        }
+        else
+        {
+          // Even count: mean of the two middle values
+          const pixel_t lower = *std::max_element(val_arr, val_arr + half);
+          dst_ptr[x] = ReduceN_mean<pixel_t>(target_t(lower) + target_t(val_arr[half]), 2);
+        }
+      }
+    }
+
+    pDst += nDstPitch;
+    pSrc += nSrcPitch;
+    for (int r = 0; r < nbr_ref; ++r)
+    {
+      ref_ptr_arr[r] += ref_pitch_arr[r];
+    }
+  }
+}
+
 #if 0
 #ifndef _M_X64
 template <int blockWidth, int blockHeight>
@@ -491,6 +615,61 @@ func_degrain[make_tuple(x, y, DEGRAIN_TYPE_8BIT_OUT16, USE_SSE2)] = DegrainN_sse
 #undef MAKE_FN
 #undef MAKE_FN_LEVEL
 
+    // AVX2: 8 bit (also lsb and out16) for mod8 widths, 10-16 bit and float for mod4 widths
+#define MAKE_FN_8(x, y) \
+func_degrain[make_tuple(x, y, DEGRAIN_TYPE_8BIT, USE_AVX2)] = DegrainN_avx2<uint8_t, x, y, 0>; \
+func_degrain[make_tuple(x, y, DEGRAIN_TYPE_8BIT_STACKED, USE_AVX2)] = DegrainN_avx2<uint8_t, x, y, 1>; \
+func_degrain[make_tuple(x, y, DEGRAIN_TYPE_8BIT_OUT16, USE_AVX2)] = DegrainN_avx2<uint8_t, x, y, 2>;
+#define MAKE_FN_16(x, y) \
+func_degrain[make_tuple(x, y, DEGRAIN_TYPE_10to16BIT, USE_AVX2)] = DegrainN_avx2<uint16_t, x, y, 0>; \
+func_degrain[make_tuple(x, y, DEGRAIN_TYPE_32BIT, USE_AVX2)] = DegrainN_avx2<float, x, y, 0>;
+#define MAKE_FN(x, y) MAKE_FN_8(x, y) MAKE_FN_16(x, y)
+    MAKE_FN(64, 64)
+    MAKE_FN(64, 48)
+    MAKE_FN(64, 32)
+    MAKE_FN(64, 16)
+    MAKE_FN(48, 64)
+    MAKE_FN(48, 48)
+    MAKE_FN(48, 24)
+    MAKE_FN(48, 12)
+    MAKE_FN(32, 64)
+    MAKE_FN(32, 32)
+    MAKE_FN(32, 24)
+    MAKE_FN(32, 16)
+    MAKE_FN(32, 8)
+    MAKE_FN(24, 48)
+    MAKE_FN(24, 32)
+    MAKE_FN(24, 24)
+    MAKE_FN(24, 12)
+    MAKE_FN(24, 6)
+    MAKE_FN(16, 64)
+    MAKE_FN(16, 32)
+    MAKE_FN(16, 16)
+    MAKE_FN(16, 12)
+    MAKE_FN(16, 8)
+    MAKE_FN(16, 4)
+    MAKE_FN(16, 2)
+    MAKE_FN(16, 1)
+    MAKE_FN_16(12, 48)
+    MAKE_FN_16(12, 24)
+    MAKE_FN_16(12, 16)
+    MAKE_FN_16(12, 12)
+    MAKE_FN_16(12, 6)
+    MAKE_FN_16(12, 3)
+    MAKE_FN(8, 32)
+    MAKE_FN(8, 16)
+    MAKE_FN(8, 8)
+    MAKE_FN(8, 4)
+    MAKE_FN(8, 2)
+    MAKE_FN(8, 1)
+    MAKE_FN_16(4, 8)
+    MAKE_FN_16(4, 4)
+    MAKE_FN_16(4, 2)
+    MAKE_FN_16(4, 1)
+#undef MAKE_FN
+#undef MAKE_FN_16
+#undef MAKE_FN_8
+
   DenoiseNFunction* result = nullptr;
   arch_t archlist[] = { USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
   int index = 0;
@@ -506,15 +685,101 @@ func_degrain[make_tuple(x, y, DEGRAIN_TYPE_8BIT_OUT16, USE_SSE2)] = DegrainN_sse
 
 
 
+// C only. Reduce_MEDIAN, Reduce_TRIMMED or Reduce_CLAMP
+MDegrainN::DenoiseNFunction* MDegrainN::get_reduceN_function(int BlockX, int BlockY, int _bits_per_pixel, int reduce_mode)
+{
+  // BlkSizeX, BlkSizeY, pixelsize, reduce_mode
+  std::map<std::tuple<int, int, int, int>, DenoiseNFunction*> func_reduce;
+  using std::make_tuple;
+
+  int pixelsize;
+  if (_bits_per_pixel == 8)
+    pixelsize = 1;
+  else if (_bits_per_pixel <= 16)
+    pixelsize = 2;
+  else if (_bits_per_pixel == 32)
+    pixelsize = 4;
+  else
+    return nullptr;
+
+#define MAKE_FN_MODE(x, y, m) \
+func_reduce[make_tuple(x, y, 1, m)] = ReduceN_C<uint8_t, x, y, m>; \
+func_reduce[make_tuple(x, y, 2, m)] = ReduceN_C<uint16_t, x, y, m>; \
+func_reduce[make_tuple(x, y, 4, m)] = ReduceN_C<float, x, y, m>;
+#define MAKE_FN(x, y) \
+MAKE_FN_MODE(x, y, Reduce_MEDIAN) \
+MAKE_FN_MODE(x, y, Reduce_TRIMMED) \
+MAKE_FN_MODE(x, y, Reduce_CLAMP)
+    MAKE_FN(64, 64)
+    MAKE_FN(64, 48)
+    MAKE_FN(64, 32)
+    MAKE_FN(64, 16)
+    MAKE_FN(48, 64)
+    MAKE_FN(48, 48)
+    MAKE_FN(48, 24)
+    MAKE_FN(48, 12)
+    MAKE_FN(32, 64)
+    MAKE_FN(32, 32)
+    MAKE_FN(32, 24)
+    MAKE_FN(32, 16)
+    MAKE_FN(32, 8)
+    MAKE_FN(24, 48)
+    MAKE_FN(24, 32)
+    MAKE_FN(24, 24)
+    MAKE_FN(24, 12)
+    MAKE_FN(24, 6)
+    MAKE_FN(16, 64)
+    MAKE_FN(16, 32)
+    MAKE_FN(16, 16)
+    MAKE_FN(16, 12)
+    MAKE_FN(16, 8)
+    MAKE_FN(16, 4)
+    MAKE_FN(16, 2)
+    MAKE_FN(16, 1)
+    MAKE_FN(12, 48)
+    MAKE_FN(12, 24)
+    MAKE_FN(12, 16)
+    MAKE_FN(12, 12)
+    MAKE_FN(12, 6)
+    MAKE_FN(12, 3)
+    MAKE_FN(8, 32)
+    MAKE_FN(8, 16)
+    MAKE_FN(8, 8)
+    MAKE_FN(8, 4)
+    MAKE_FN(8, 2)
+    MAKE_FN(8, 1)
+    MAKE_FN(6, 24)
+    MAKE_FN(6, 12)
+    MAKE_FN(6, 6)
+    MAKE_FN(6, 3)
+    MAKE_FN(4, 8)
+    MAKE_FN(4, 4)
+    MAKE_FN(4, 2)
+    MAKE_FN(4, 1)
+    MAKE_FN(3, 6)
+    MAKE_FN(3, 3)
+    MAKE_FN(2, 4)
+    MAKE_FN(2, 2)
+    MAKE_FN(2, 1)
+#undef MAKE_FN
+#undef MAKE_FN_MODE
+
+  return func_reduce[make_tuple(BlockX, BlockY, pixelsize, reduce_mode)];
+}
+
+
+
 MDegrainN::MDegrainN(
   PClip child, PClip super, PClip mvmulti, int trad,
   sad_t thsad, sad_t thsadc, int yuvplanes, float nlimit, float nlimitc,
   sad_t nscd1, int nscd2, bool isse_flag, bool planar_flag, bool lsb_flag,
-  sad_t thsad2, sad_t thsadc2, bool mt_flag, bool out16_flag, IScriptEnvironment* env_ptr
+  sad_t thsad2, sad_t thsadc2, bool mt_flag, bool out16_flag, bool static_flag,
+  bool reduce_flag, int reduce_mode, const char *filter_name_0, IScriptEnvironment* env_ptr
 )
   : GenericVideoFilter(child)
-  , MVFilter(mvmulti, "MDegrainN", env_ptr, 1, 0)
+  , MVFilter(mvmulti, filter_name_0, env_ptr, 1, 0)
   , _mv_clip_arr()
+  , _ref_gof_cache()
   , _trad(trad)
   , _yuvplanes(yuvplanes)
   , _nlimit(nlimit)
@@ -524,6 +789,8 @@ MDegrainN::MDegrainN(
   , _lsb_flag(lsb_flag)
   , _mt_flag(mt_flag)
   , _out16_flag(out16_flag)
+  , _static_flag(static_flag)
+  , _reduce_mode(reduce_mode)
   , _height_lsb_or_out16_mul((lsb_flag || out16_flag) ? 2 : 1)
   , _nsupermodeyuv(-1)
   , _dst_planes(nullptr)
@@ -553,6 +820,10 @@ MDegrainN::MDegrainN(
   //,	_lsb_offset_arr ()
   , _covered_width(0)
   , _covered_height(0)
+  //,	_weight_arr ()
+  , _wref_arr()
+  //,	_blk_class_arr ()
+  //,	_static_ref_ptr_arr ()
   , _boundary_cnt_arr()
 {
   has_at_least_v8 = true;
@@ -562,13 +833,13 @@ MDegrainN::MDegrainN(
   if (trad > MAX_TEMP_RAD)
   {
     env_ptr->ThrowError(
-      "MDegrainN: temporal radius too large (max %d)",
+      "%s: temporal radius too large (max %d)", filter_name_0,
       MAX_TEMP_RAD
     );
   }
   else if (trad < 1)
   {
-    env_ptr->ThrowError("MDegrainN: temporal radius must be at least 1.");
+    env_ptr->ThrowError("%s: temporal radius must be at least 1.", filter_name_0);
   }
 
   _mv_clip_arr.resize(_trad * 2);
@@ -593,7 +864,7 @@ MDegrainN::MDegrainN(
   const ::VideoInfo &vi_super = _super->GetVideoInfo();
 
   if (!vi.IsSameColorspace(_super->GetVideoInfo()))
-    env_ptr->ThrowError("MDegrainN: source and super clip video format is different!");
+    env_ptr->ThrowError("%s: source and super clip video format is different!", filter_name_0);
 
   // v2.7.39- make subsampling independent from motion vector's origin:
   // because xRatioUV and yRatioUV: in MVFilter, property of motion vectors
@@ -629,11 +900,15 @@ MDegrainN::MDegrainN(
   thsadc2 = sad_t(thsadc2 / 255.0 * ((1 << bits_per_pixel) - 1));
   */
 
-  for (int k = 0; k < _trad * 2; ++k)
+  // From a frame to the next one, all the references but two are the same.
+  // With two extra GOFs, the references of the previous frame are never
+  // evicted before they become useless. The cache index is keyed by the
+  // absolute frame number, so in sequential access only the newly entering
+  // reference is requested from the super clip and set up, and finding the
+  // other ones does not depend on the radius.
+  for (int gof_cnt = 0; gof_cnt < _trad * 2 + 2; ++gof_cnt)
   {
-    MvClipInfo &c_info = _mv_clip_arr[k];
-
-    c_info._gof_sptr = SharedPtr <MVGroupOfFrames>(new MVGroupOfFrames(
+    MVGroupOfFrames *gof_ptr = new MVGroupOfFrames(
       nSuperLevels,
       nWidth,
       nHeight,
@@ -647,7 +922,19 @@ MDegrainN::MDegrainN(
       pixelsize_super,
       bits_per_pixel_super,
       mt_flag
-    ));
+    );
+    _ref_gof_cache.add(gof_ptr);
+    if ((params.param & SuperParams64Bits::PARAM_LAZY_FLAG) != 0)
+    {
+      gof_ptr->set_lazy_refine(
+        MVPlaneSet(_nsupermodeyuv), params.param & SuperParams64Bits::PARAM_SHARP_MASK
+      );
+    }
+  }
+
+  for (int k = 0; k < _trad * 2; ++k)
+  {
+    MvClipInfo &c_info = _mv_clip_arr[k];
 
     // Computes the SAD thresholds for this source frame, a cosine-shaped
     // smooth transition between thsad(c) and thsad(c)2.
@@ -667,21 +954,30 @@ MDegrainN::MDegrainN(
     || nWidth != vi.width
     || nPel != nSuperPel)
   {
-    env_ptr->ThrowError("MDegrainN : wrong source or super frame size");
+    env_ptr->ThrowError("%s : wrong source or super frame size", filter_name_0);
   }
 
   if(lsb_flag && (pixelsize != 1 || pixelsize_super != 1))
-    env_ptr->ThrowError("MDegrainN : lsb_flag only for 8 bit sources");
+    env_ptr->ThrowError("%s : lsb_flag only for 8 bit sources", filter_name_0);
 
   if (out16_flag) {
     if (pixelsize != 1 || pixelsize_super != 1)
-      env_ptr->ThrowError("MDegrainN : out16 flag only for 8 bit sources");
+      env_ptr->ThrowError("%s : out16 flag only for 8 bit sources", filter_name_0);
     if (!vi.IsY8() && !vi.IsYV12() && !vi.IsYV16() && !vi.IsYV24())
-      env_ptr->ThrowError("MDegrainN : only YV8, YV12, YV16 or YV24 allowed for out16");
+      env_ptr->ThrowError("%s : only YV8, YV12, YV16 or YV24 allowed for out16", filter_name_0);
   }
 
   if (lsb_flag && out16_flag)
-    env_ptr->ThrowError("MDegrainN : cannot specify both lsb and out16 flag");
+    env_ptr->ThrowError("%s : cannot specify both lsb and out16 flag", filter_name_0);
+
+  // MReduceN: the mode comes from the script, Reduce_NONE is not valid.
+  if (reduce_flag)
+  {
+    if (reduce_mode < 0 || reduce_mode >= Reduce_NBR_ELT)
+      env_ptr->ThrowError("%s : mode must be 0 (median), 1 (trimmed mean) or 2 (clamp)", filter_name_0);
+    if (lsb_flag || out16_flag || static_flag)
+      env_ptr->ThrowError("%s : lsb, out16 and static are not supported", filter_name_0);
+  }
 
   // output can be different bit depth from input
   pixelsize_output = pixelsize_super;
@@ -727,12 +1023,23 @@ MDegrainN::MDegrainN(
     _boundary_cnt_arr.resize(nBlkY);
   }
 
+  _weight_arr[0].resize(nBlkCount * (1 + _trad * 2));
+  _weight_arr[1].resize(nBlkCount * (1 + _trad * 2));
+  _wref_arr.resize(nBlkCount * _trad * 2);
+  if (_static_flag)
+  {
+    _blk_class_arr[0].resize(nBlkCount);
+    _blk_class_arr[1].resize(nBlkCount);
+  }
+
     // in overlaps.h
     // OverlapsLsbFunction
     // OverlapsFunction
     // in M(V)DegrainX: DenoiseXFunction
   arch_t arch;
-  if ((_cpuFlags & CPUF_AVX2) != 0)
+  if ((_cpuFlags & CPUF_AVX512F) != 0 && (_cpuFlags & CPUF_AVX512BW) != 0)
+    arch = USE_AVX512;
+  else if ((_cpuFlags & CPUF_AVX2) != 0)
     arch = USE_AVX2;
   else if ((_cpuFlags & CPUF_AVX) != 0)
     arch = USE_AVX;
@@ -756,21 +1063,41 @@ MDegrainN::MDegrainN(
   _oversluma32_ptr = get_overlaps_function(nBlkSizeX, nBlkSizeY, sizeof(float), arch);
   _overschroma32_ptr = get_overlaps_function(nBlkSizeX >> nLogxRatioUV_super, nBlkSizeY >> nLogyRatioUV_super, sizeof(float), arch);
 
-  _degrainluma_ptr = get_denoiseN_function(nBlkSizeX, nBlkSizeY, bits_per_pixel_super, lsb_flag, out16_flag, arch);
-  _degrainchroma_ptr = get_denoiseN_function(nBlkSizeX / xRatioUV_super, nBlkSizeY / yRatioUV_super, bits_per_pixel_super, lsb_flag, out16_flag, arch);
+  if (_reduce_mode != Reduce_NONE)
+  {
+    _degrainluma_ptr = get_reduceN_function(nBlkSizeX, nBlkSizeY, bits_per_pixel_super, _reduce_mode);
+    _degrainchroma_ptr = get_reduceN_function(nBlkSizeX / xRatioUV_super, nBlkSizeY / yRatioUV_super, bits_per_pixel_super, _reduce_mode);
+  }
+  else
+  {
+    _degrainluma_ptr = get_denoiseN_function(nBlkSizeX, nBlkSizeY, bits_per_pixel_super, lsb_flag, out16_flag, arch);
+    _degrainchroma_ptr = get_denoiseN_function(nBlkSizeX / xRatioUV_super, nBlkSizeY / yRatioUV_super, bits_per_pixel_super, lsb_flag, out16_flag, arch);
+  }
 
   if (!_oversluma_lsb_ptr)
-    env_ptr->ThrowError("MDegrainN : no valid _oversluma_lsb_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
+    env_ptr->ThrowError("%s : no valid _oversluma_lsb_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", filter_name_0, nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
   if (!_overschroma_lsb_ptr)
-    env_ptr->ThrowError("MDegrainN : no valid _overschroma_lsb_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
+    env_ptr->ThrowError("%s : no valid _overschroma_lsb_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", filter_name_0, nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
   if (!_oversluma_ptr)
-    env_ptr->ThrowError("MDegrainN : no valid _oversluma_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
+    env_ptr->ThrowError("%s : no valid _oversluma_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", filter_name_0, nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
   if (!_overschroma_ptr)
-    env_ptr->ThrowError("MDegrainN : no valid _overschroma_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
+    env_ptr->ThrowError("%s : no valid _overschroma_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", filter_name_0, nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
   if (!_degrainluma_ptr)
-    env_ptr->ThrowError("MDegrainN : no valid _degrainluma_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
+    env_ptr->ThrowError("%s : no valid _degrainluma_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", filter_name_0, nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
   if (!_degrainchroma_ptr)
-    env_ptr->ThrowError("MDegrainN : no valid _degrainchroma_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
+    env_ptr->ThrowError("%s : no valid _degrainchroma_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", filter_name_0, nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
+
+  // final conversion of the overlap accumulators
+  if ((_cpuFlags & CPUF_AVX2) != 0)
+  {
+    _short2bytes_ptr = Short2Bytes_avx2;
+    _short2word16_ptr = Short2Bytes_Int32toWord16_avx2;
+  }
+  else
+  {
+    _short2bytes_ptr = ((_cpuFlags & CPUF_SSE2) != 0) ? Short2Bytes_sse2 : Short2Bytes;
+    _short2word16_ptr = ((_cpuFlags & CPUF_SSE4_1) != 0) ? Short2Bytes_Int32toWord16_sse4 : Short2Bytes_Int32toWord16;
+  }
 
   if ((_cpuFlags & CPUF_SSE2) != 0)
   {
@@ -844,13 +1171,13 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
   _covered_width = nBlkX * (nBlkSizeX - nOverlapX) + nOverlapX;
   _covered_height = nBlkY * (nBlkSizeY - nOverlapY) + nOverlapY;
 
-  const BYTE * pRef[MAX_TEMP_RAD * 2][3];
-  int nRefPitches[MAX_TEMP_RAD * 2][3];
   unsigned char *pDstYUY2;
   const unsigned char *pSrcYUY2;
   int nDstPitchYUY2;
   int nSrcPitchYUY2;
 
+  GofCache::FrameGuard gof_guard(_ref_gof_cache, n);
+
   for (int k2 = 0; k2 < _trad * 2; ++k2)
   {
     // reorder ror regular frames order in v2.0.9.2
@@ -942,61 +1269,57 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
     }
   }
 
-  ::PVideoFrame ref[MAX_TEMP_RAD * 2];
+  memset(_planes_ptr, 0, _trad * 2 * sizeof(_planes_ptr[0]));
 
   for (int k2 = 0; k2 < _trad * 2; ++k2)
   {
     // reorder ror regular frames order in v2.0.9.2
     const int k = reorder_ref(k2);
     MVClip &mv_clip = *(_mv_clip_arr[k]._clip_sptr);
-    mv_clip.use_ref_frame(ref[k], _usable_flag_arr[k], _super, n, env_ptr);
-  }
+    int ref_index;
+    mv_clip.use_ref_frame(ref_index, _usable_flag_arr[k], _super, n, env_ptr);
+    if (!_usable_flag_arr[k])
+    {
+      continue;
+    }
 
-  if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2)
-  {
-    for (int k2 = 0; k2 < _trad * 2; ++k2)
+    // Consecutive frames share most of their references, the GOF may
+    // already be set up.
+    MVGroupOfFrames *gof_ptr = _ref_gof_cache.find(ref_index);
+    if (gof_ptr == 0)
     {
-      const int k = reorder_ref(k2);
-      if (_usable_flag_arr[k])
+      ::PVideoFrame ref = _super->GetFrame(ref_index, env_ptr);
+      const BYTE * pRef[3];
+      int nRefPitches[3];
+      if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2)
       {
-        pRef[k][0] = ref[k]->GetReadPtr();
-        pRef[k][1] = pRef[k][0] + ref[k]->GetRowSize() / 2;
-        pRef[k][2] = pRef[k][1] + ref[k]->GetRowSize() / 4;
-        nRefPitches[k][0] = ref[k]->GetPitch();
-        nRefPitches[k][1] = nRefPitches[k][0];
-        nRefPitches[k][2] = nRefPitches[k][0];
+        pRef[0] = ref->GetReadPtr();
+        pRef[1] = pRef[0] + ref->GetRowSize() / 2;
+        pRef[2] = pRef[1] + ref->GetRowSize() / 4;
+        nRefPitches[0] = ref->GetPitch();
+        nRefPitches[1] = nRefPitches[0];
+        nRefPitches[2] = nRefPitches[0];
       }
-    }
-  }
-  else
-  {
-    for (int k2 = 0; k2 < _trad * 2; ++k2)
-    {
-      const int k = reorder_ref(k2);
-      if (_usable_flag_arr[k])
+      else
       {
-        pRef[k][0] = YRPLAN(ref[k]);
-        pRef[k][1] = URPLAN(ref[k]);
-        pRef[k][2] = VRPLAN(ref[k]);
-        nRefPitches[k][0] = YPITCH(ref[k]);
-        nRefPitches[k][1] = UPITCH(ref[k]);
-        nRefPitches[k][2] = VPITCH(ref[k]);
+        pRef[0] = YRPLAN(ref);
+        pRef[1] = URPLAN(ref);
+        pRef[2] = VRPLAN(ref);
+        nRefPitches[0] = YPITCH(ref);
+        nRefPitches[1] = UPITCH(ref);
+        nRefPitches[2] = VPITCH(ref);
       }
-    }
-  }
 
-  memset(_planes_ptr, 0, _trad * 2 * sizeof(_planes_ptr[0]));
+      gof_ptr = &_ref_gof_cache.assign(ref_index, ref);
+      gof_ptr->Update(
+        _yuvplanes,
+        const_cast <BYTE *> (pRef[0]), nRefPitches[0],
+        const_cast <BYTE *> (pRef[1]), nRefPitches[1],
+        const_cast <BYTE *> (pRef[2]), nRefPitches[2]
+      );
+    }
 
-  for (int k2 = 0; k2 < _trad * 2; ++k2)
-  {
-    const int k = reorder_ref(k2);
-    MVGroupOfFrames &gof = *(_mv_clip_arr[k]._gof_sptr);
-    gof.Update(
-      _yuvplanes,
-      const_cast <BYTE *> (pRef[k][0]), nRefPitches[k][0],
-      const_cast <BYTE *> (pRef[k][1]), nRefPitches[k][1],
-      const_cast <BYTE *> (pRef[k][2]), nRefPitches[k][2]
-    );
+    MVGroupOfFrames &gof = *gof_ptr;
     if (_yuvplanes & YPLANE)
     {
       _planes_ptr[k][0] = gof.GetFrame(0)->GetPlane(YPLANE);
@@ -1009,6 +1332,25 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
     {
       _planes_ptr[k][2] = gof.GetFrame(0)->GetPlane(VPLANE);
     }
+
+    // Top-left corner of the full-pel plane, for the static blocks
+    for (int c = 0; c < 3; ++c)
+    {
+      if (_planes_ptr[k][c] != 0)
+      {
+        _static_ref_ptr_arr[k][c] = _planes_ptr[k][c]->GetPointer(0, 0);
+      }
+    }
+  }
+
+  // Weights of all the blocks, before the pixel processing
+  if ((_yuvplanes & YPLANE) != 0)
+  {
+    compute_weights(0, false);
+  }
+  if ((_yuvplanes & (UPLANE | VPLANE)) != 0)
+  {
+    compute_weights(1, true);
   }
 
   PROFILE_START(MOTION_PROFILE_COMPENSATION);
@@ -1076,13 +1418,29 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
         );
       }
 
-      slicer.start(
-        nBlkY,
-        *this,
-        &MDegrainN::process_luma_overlap_slice,
-        2
-      );
-      slicer.wait();
+      // Wide frames: rectangular tiles keep the reference areas read by
+      // each thread in the cache
+      if (Tiler::is_worth(_mt_flag, nBlkX, nBlkSizeX - nOverlapX))
+      {
+        Tiler tiler(_mt_flag);
+        tiler.start(
+          nBlkX, nBlkY,
+          nBlkSizeX - nOverlapX, nBlkSizeY - nOverlapY,
+          *this,
+          &MDegrainN::process_luma_overlap_slice
+        );
+        tiler.wait();
+      }
+      else
+      {
+        slicer.start(
+          nBlkY,
+          *this,
+          &MDegrainN::process_luma_overlap_slice,
+          2
+        );
+        slicer.wait();
+      }
 
       if (_lsb_flag)
       {
@@ -1096,7 +1454,7 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
       }
       else if (_out16_flag)
       {
-        Short2Bytes_Int32toWord16(
+        _short2word16_ptr(
           (uint16_t *)_dst_ptr_arr[0], _dst_pitch_arr[0],
           &_dst_int[0], _dst_int_pitch,
           _covered_width, _covered_height,
@@ -1105,7 +1463,7 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
       }
       else if(pixelsize_super == 1)
       {
-        Short2Bytes(
+        _short2bytes_ptr(
           _dst_ptr_arr[0], _dst_pitch_arr[0],
           &_dst_short[0], _dst_short_pitch,
           _covered_width, _covered_height
@@ -1113,7 +1471,7 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
       }
       else if (pixelsize_super == 2)
       {
-        Short2Bytes_Int32toWord16(
+        _short2word16_ptr(
           (uint16_t *)_dst_ptr_arr[0], _dst_pitch_arr[0],
           &_dst_int[0], _dst_int_pitch,
           _covered_width, _covered_height,
@@ -1289,13 +1647,28 @@ void	MDegrainN::process_chroma(int plane_mask)
         );
       }
 
-      slicer.start(
-        nBlkY,
-        *this,
-        &MDegrainN::process_chroma_overlap_slice <P>,
-        2
-      );
-      slicer.wait();
+      // Same tile grid as luma, in blocks
+      if (Tiler::is_worth(_mt_flag, nBlkX, nBlkSizeX - nOverlapX))
+      {
+        Tiler tiler(_mt_flag);
+        tiler.start(
+          nBlkX, nBlkY,
+          nBlkSizeX - nOverlapX, nBlkSizeY - nOverlapY,
+          *this,
+          &MDegrainN::process_chroma_overlap_slice <P>
+        );
+        tiler.wait();
+      }
+      else
+      {
+        slicer.start(
+          nBlkY,
+          *this,
+          &MDegrainN::process_chroma_overlap_slice <P>,
+          2
+        );
+        slicer.wait();
+      }
       
       if (_lsb_flag)
       {
@@ -1309,7 +1682,7 @@ void	MDegrainN::process_chroma(int plane_mask)
       }
       else if (_out16_flag)
       {
-        Short2Bytes_Int32toWord16(
+        _short2word16_ptr(
           (uint16_t *)_dst_ptr_arr[P], _dst_pitch_arr[P],
           &_dst_int[0], _dst_int_pitch,
           _covered_width >> nLogxRatioUV_super, _covered_height >> nLogyRatioUV_super,
@@ -1318,7 +1691,7 @@ void	MDegrainN::process_chroma(int plane_mask)
       }
       else if (pixelsize_super == 1)
       {
-        Short2Bytes(
+        _short2bytes_ptr(
           _dst_ptr_arr[P], _dst_pitch_arr[P],
           &_dst_short[0], _dst_short_pitch,
           _covered_width >> nLogxRatioUV_super, _covered_height >> nLogyRatioUV_super
@@ -1326,7 +1699,7 @@ void	MDegrainN::process_chroma(int plane_mask)
       }
       else if (pixelsize_super == 2)
       {
-        Short2Bytes_Int32toWord16(
+        _short2word16_ptr(
           (uint16_t *)_dst_ptr_arr[P], _dst_pitch_arr[P],
           &_dst_int[0], _dst_int_pitch,
           _covered_width >> nLogxRatioUV_super, _covered_height >> nLogyRatioUV_super,
@@ -1413,32 +1786,52 @@ void	MDegrainN::process_luma_normal_slice(Slicer::TaskData &td)
       int i = by * nBlkX + bx;
       const BYTE *ref_data_ptr_arr[MAX_TEMP_RAD * 2];
       int pitch_arr[MAX_TEMP_RAD * 2];
-      int weight_arr[1 + MAX_TEMP_RAD * 2];
+      int *weight_arr = &_weight_arr[0][i * (1 + _trad * 2)]; // Precomputed, 0th is src
+      const int blk_class = (_static_flag) ? _blk_class_arr[0][i] : BlkClass_NORMAL;
 
-      for (int k = 0; k < _trad * 2; ++k)
+      if (blk_class == BlkClass_TRIVIAL)
       {
-        use_block_y(
-          ref_data_ptr_arr[k],
-          pitch_arr[k],
-          weight_arr[k + 1],
-          _usable_flag_arr[k],
-          _mv_clip_arr[k],
-          i,
-          _planes_ptr[k][0],
-          pSrcCur,
-          xx << pixelsize_super_shift,
-          _src_pitch_arr[0]
+        // Only the source has a weight
+        BitBlt(
+          pDstCur + (xx << pixelsize_super_shift), _dst_pitch_arr[0],
+          pSrcCur + (xx << pixelsize_super_shift), _src_pitch_arr[0],
+          nBlkSizeX << pixelsize_super_shift, nBlkSizeY
         );
       }
+      else
+      {
+        for (int k = 0; k < _trad * 2; ++k)
+        {
+          if (blk_class == BlkClass_STATIC)
+          {
+            use_block_static(
+              ref_data_ptr_arr[k], pitch_arr[k], _usable_flag_arr[k], k, 0, bx, by,
+              pSrcCur, xx << pixelsize_super_shift, _src_pitch_arr[0]
+            );
+          }
+          else
+          {
+            use_block_y(
+              ref_data_ptr_arr[k],
+              pitch_arr[k],
+              _usable_flag_arr[k],
+              _mv_clip_arr[k],
+              i,
+              _planes_ptr[k][0],
+              pSrcCur,
+              xx << pixelsize_super_shift,
+              _src_pitch_arr[0]
+            );
+          }
+        }
 
-      norm_weights(weight_arr, _trad);
-
-      // luma
-      _degrainluma_ptr(
-        pDstCur + (xx << pixelsize_output_shift), pDstCur + _lsb_offset_arr[0] + (xx << pixelsize_super_shift), _dst_pitch_arr[0],
-        pSrcCur + (xx << pixelsize_super_shift), _src_pitch_arr[0],
-        ref_data_ptr_arr, pitch_arr, weight_arr, _trad
-      );
+        // luma
+        _degrainluma_ptr(
+          pDstCur + (xx << pixelsize_output_shift), pDstCur + _lsb_offset_arr[0] + (xx << pixelsize_super_shift), _dst_pitch_arr[0],
+          pSrcCur + (xx << pixelsize_super_shift), _src_pitch_arr[0],
+          ref_data_ptr_arr, pitch_arr, weight_arr, _trad
+        );
+      }
 
       xx += (nBlkSizeX); // xx: indexing offset
 
@@ -1496,14 +1889,14 @@ void	MDegrainN::process_luma_overlap_slice(Slicer::TaskData &td)
   if (nOverlapY == 0
     || (td._y_beg == 0 && td._y_end == nBlkY))
   {
-    process_luma_overlap_slice(td._y_beg, td._y_end);
+    process_luma_overlap_slice(td._y_beg, td._y_end, 0, nBlkX);
   }
 
   else
   {
     assert(td._y_end - td._y_beg >= 2);
 
-    process_luma_overlap_slice(td._y_beg, td._y_end - 1);
+    process_luma_overlap_slice(td._y_beg, td._y_end - 1, 0, nBlkX);
 
     const conc::AioAdd <int>	inc_ftor(+1);
 
@@ -1513,7 +1906,7 @@ void	MDegrainN::process_luma_overlap_slice(Slicer::TaskData &td)
     );
     if (td._y_beg > 0 && cnt_top == 2)
     {
-      process_luma_overlap_slice(td._y_beg - 1, td._y_beg);
+      process_luma_overlap_slice(td._y_beg - 1, td._y_beg, 0, nBlkX);
     }
 
     int cnt_bot = 2;
@@ -1526,14 +1919,14 @@ void	MDegrainN::process_luma_overlap_slice(Slicer::TaskData &td)
     }
     if (cnt_bot == 2)
     {
-      process_luma_overlap_slice(td._y_end - 1, td._y_end);
+      process_luma_overlap_slice(td._y_end - 1, td._y_end, 0, nBlkX);
     }
   }
 }
 
 
 
-void	MDegrainN::process_luma_overlap_slice(int y_beg, int y_end)
+void	MDegrainN::process_luma_overlap_slice(int y_beg, int y_end, int x_beg, int x_end)
 {
   TmpBlock       tmp_block;
 
@@ -1555,8 +1948,8 @@ void	MDegrainN::process_luma_overlap_slice(int y_beg, int y_end)
     */
 
     int wby = (by == 0) ? 0 * 3 : (by == nBlkY - 1) ? 2 * 3 : 1 * 3; // 0 for very first, 2*3 for very last, 1*3 for all others in the middle
-    int xx = 0; // logical offset. Mul by 2 for pixelsize_super==2. Don't mul for indexing int* array
-    for (int bx = 0; bx < nBlkX; ++bx)
+    int xx = x_beg * (nBlkSizeX - nOverlapX); // logical offset. Mul by 2 for pixelsize_super==2. Don't mul for indexing int* array
+    for (int bx = x_beg; bx < x_end; ++bx)
     {
       // select window
       // indexing overlap windows weighting table: left=+0 middle=+1 rightmost=+2
@@ -1566,32 +1959,52 @@ void	MDegrainN::process_luma_overlap_slice(int y_beg, int y_end)
       int i = by * nBlkX + bx;
       const BYTE *ref_data_ptr_arr[MAX_TEMP_RAD * 2];
       int pitch_arr[MAX_TEMP_RAD * 2];
-      int weight_arr[1 + MAX_TEMP_RAD * 2];
+      int *weight_arr = &_weight_arr[0][i * (1 + _trad * 2)]; // Precomputed, 0th is src
+      const int blk_class = (_static_flag) ? _blk_class_arr[0][i] : BlkClass_NORMAL;
 
-      for (int k = 0; k < _trad * 2; ++k)
+      const BYTE *blk_ptr = &tmp_block._d[0];
+      int blk_pitch = tmpPitch << pixelsize_super_shift;
+      if (blk_class == BlkClass_TRIVIAL)
       {
-        use_block_y(
-          ref_data_ptr_arr[k],
-          pitch_arr[k],
-          weight_arr[k + 1],
-          _usable_flag_arr[k],
-          _mv_clip_arr[k],
-          i,
-          _planes_ptr[k][0],
-          pSrcCur,
-          xx << pixelsize_super_shift,
-          _src_pitch_arr[0]
-        );
+        // Only the source has a weight, give it directly to the overlap
+        blk_ptr = pSrcCur + (xx << pixelsize_super_shift);
+        blk_pitch = _src_pitch_arr[0];
       }
+      else
+      {
+        for (int k = 0; k < _trad * 2; ++k)
+        {
+          if (blk_class == BlkClass_STATIC)
+          {
+            use_block_static(
+              ref_data_ptr_arr[k], pitch_arr[k], _usable_flag_arr[k], k, 0, bx, by,
+              pSrcCur, xx << pixelsize_super_shift, _src_pitch_arr[0]
+            );
+          }
+          else
+          {
+            use_block_y(
+              ref_data_ptr_arr[k],
+              pitch_arr[k],
+              _usable_flag_arr[k],
+              _mv_clip_arr[k],
+              i,
+              _planes_ptr[k][0],
+              pSrcCur,
+              xx << pixelsize_super_shift,
+              _src_pitch_arr[0]
+            );
+          }
+        }
 
-      norm_weights(weight_arr, _trad);
+        // luma
+        _degrainluma_ptr(
+          &tmp_block._d[0], tmp_block._lsb_ptr, tmpPitch << pixelsize_output_shift,
+          pSrcCur + (xx << pixelsize_super_shift), _src_pitch_arr[0],
+          ref_data_ptr_arr, pitch_arr, weight_arr, _trad
+        );
+      }
 
-      // luma
-      _degrainluma_ptr(
-        &tmp_block._d[0], tmp_block._lsb_ptr, tmpPitch << pixelsize_output_shift,
-        pSrcCur + (xx << pixelsize_super_shift), _src_pitch_arr[0],
-        ref_data_ptr_arr, pitch_arr, weight_arr, _trad
-      );
       if (_lsb_flag)
       {
         _oversluma_lsb_ptr(
@@ -1609,15 +2022,15 @@ void	MDegrainN::process_luma_overlap_slice(int y_beg, int y_end)
       {
         _oversluma_ptr(
           pDstShort + xx, _dst_short_pitch,
-          &tmp_block._d[0], tmpPitch,
+          blk_ptr, blk_pitch,
           winOver, nBlkSizeX
         );
       }
       else if (pixelsize_super == 2) {
-        _oversluma16_ptr((uint16_t *)(pDstInt + xx), _dst_int_pitch, &tmp_block._d[0], tmpPitch << pixelsize_super_shift, winOver, nBlkSizeX);
+        _oversluma16_ptr((uint16_t *)(pDstInt + xx), _dst_int_pitch, blk_ptr, blk_pitch, winOver, nBlkSizeX);
       }
       else { // pixelsize_super == 4
-        _oversluma32_ptr((uint16_t *)(pDstInt + xx), _dst_int_pitch, &tmp_block._d[0], tmpPitch << pixelsize_super_shift, winOver, nBlkSizeX);
+        _oversluma32_ptr((uint16_t *)(pDstInt + xx), _dst_int_pitch, blk_ptr, blk_pitch, winOver, nBlkSizeX);
       }
 
       xx += nBlkSizeX - nOverlapX;
@@ -1650,35 +2063,54 @@ void	MDegrainN::process_chroma_normal_slice(Slicer::TaskData &td)
       int i = by * nBlkX + bx;
       const BYTE *ref_data_ptr_arr[MAX_TEMP_RAD * 2]; // vs: const uint8_t *pointers[radius * 2]; // Moved by the degrain function. 
       int pitch_arr[MAX_TEMP_RAD * 2];
-      int weight_arr[1 + MAX_TEMP_RAD * 2]; // 0th is special. vs:int WSrc, WRefs[radius * 2]; 
+      int *weight_arr = &_weight_arr[1][i * (1 + _trad * 2)]; // Precomputed, 0th is src
+      const int blk_class = (_static_flag) ? _blk_class_arr[1][i] : BlkClass_NORMAL;
 
-      for (int k = 0; k < _trad * 2; ++k)
+      if (blk_class == BlkClass_TRIVIAL)
       {
-        use_block_uv(
-          ref_data_ptr_arr[k],
-          pitch_arr[k],
-          weight_arr[k + 1],
-          _usable_flag_arr[k],
-          _mv_clip_arr[k],
-          i,
-          _planes_ptr[k][P],
-          pSrcCur,
-          xx << pixelsize_super_shift, // the pointer increment inside knows that xx later here is incremented with nBlkSize and not nBlkSize>>_xRatioUV
-              // todo: copy from MDegrainX. Here we shift, and incement with nBlkSize>>_xRatioUV
-          _src_pitch_arr[P]
-        ); // vs: extra nLogPel, plane, xSubUV, ySubUV, thSAD
+        // Only the source has a weight
+        BitBlt(
+          pDstCur + (xx << pixelsize_super_shift), _dst_pitch_arr[P],
+          pSrcCur + (xx << pixelsize_super_shift), _src_pitch_arr[P],
+          (nBlkSizeX >> nLogxRatioUV_super) << pixelsize_super_shift, rowsize
+        );
       }
+      else
+      {
+        for (int k = 0; k < _trad * 2; ++k)
+        {
+          if (blk_class == BlkClass_STATIC)
+          {
+            use_block_static(
+              ref_data_ptr_arr[k], pitch_arr[k], _usable_flag_arr[k], k, P, bx, by,
+              pSrcCur, xx << pixelsize_super_shift, _src_pitch_arr[P]
+            );
+          }
+          else
+          {
+            use_block_uv(
+              ref_data_ptr_arr[k],
+              pitch_arr[k],
+              _usable_flag_arr[k],
+              _mv_clip_arr[k],
+              i,
+              _planes_ptr[k][P],
+              pSrcCur,
+              xx << pixelsize_super_shift, // the pointer increment inside knows that xx later here is incremented with nBlkSize and not nBlkSize>>_xRatioUV
+                  // todo: copy from MDegrainX. Here we shift, and incement with nBlkSize>>_xRatioUV
+              _src_pitch_arr[P]
+            ); // vs: extra nLogPel, plane, xSubUV, ySubUV, thSAD
+          }
+        }
 
-      norm_weights(weight_arr, _trad); // normaliseWeights<radius>(WSrc, WRefs);
-
-
-      // chroma
-      _degrainchroma_ptr(
-        pDstCur + (xx << pixelsize_output_shift),
-        pDstCur + (xx << pixelsize_super_shift) + _lsb_offset_arr[P], _dst_pitch_arr[P],
-        pSrcCur + (xx << pixelsize_super_shift), _src_pitch_arr[P],
-        ref_data_ptr_arr, pitch_arr, weight_arr, _trad
-      );
+        // chroma
+        _degrainchroma_ptr(
+          pDstCur + (xx << pixelsize_output_shift),
+          pDstCur + (xx << pixelsize_super_shift) + _lsb_offset_arr[P], _dst_pitch_arr[P],
+          pSrcCur + (xx << pixelsize_super_shift), _src_pitch_arr[P],
+          ref_data_ptr_arr, pitch_arr, weight_arr, _trad
+        );
+      }
 
       //if (nLogxRatioUV != nLogxRatioUV_super) // orphaned if. chroma processing failed between 2.7.1-2.7.20
       //xx += nBlkSizeX; // blksize of Y plane, that's why there is xx >> xRatioUVlog above
@@ -1740,14 +2172,14 @@ void	MDegrainN::process_chroma_overlap_slice(Slicer::TaskData &td)
   if (nOverlapY == 0
     || (td._y_beg == 0 && td._y_end == nBlkY))
   {
-    process_chroma_overlap_slice <P>(td._y_beg, td._y_end);
+    process_chroma_overlap_slice <P>(td._y_beg, td._y_end, 0, nBlkX);
   }
 
   else
   {
     assert(td._y_end - td._y_beg >= 2);
 
-    process_chroma_overlap_slice <P>(td._y_beg, td._y_end - 1);
+    process_chroma_overlap_slice <P>(td._y_beg, td._y_end - 1, 0, nBlkX);
 
     const conc::AioAdd <int> inc_ftor(+1);
 
@@ -1757,7 +2189,7 @@ void	MDegrainN::process_chroma_overlap_slice(Slicer::TaskData &td)
     );
     if (td._y_beg > 0 && cnt_top == 2)
     {
-      process_chroma_overlap_slice <P>(td._y_beg - 1, td._y_beg);
+      process_chroma_overlap_slice <P>(td._y_beg - 1, td._y_beg, 0, nBlkX);
     }
 
     int				cnt_bot = 2;
@@ -1770,7 +2202,7 @@ void	MDegrainN::process_chroma_overlap_slice(Slicer::TaskData &td)
     }
     if (cnt_bot == 2)
     {
-      process_chroma_overlap_slice <P>(td._y_end - 1, td._y_end);
+      process_chroma_overlap_slice <P>(td._y_end - 1, td._y_end, 0, nBlkX);
     }
   }
 }
@@ -1778,7 +2210,7 @@ void	MDegrainN::process_chroma_overlap_slice(Slicer::TaskData &td)
 
 
 template <int P>
-void	MDegrainN::process_chroma_overlap_slice(int y_beg, int y_end)
+void	MDegrainN::process_chroma_overlap_slice(int y_beg, int y_end, int x_beg, int x_end)
 {
   TmpBlock       tmp_block;
 
@@ -1804,8 +2236,8 @@ void	MDegrainN::process_chroma_overlap_slice(int y_beg, int y_end)
     */
 
     int wby = (by == 0) ? 0 * 3 : (by == nBlkY - 1) ? 2 * 3 : 1 * 3; // 0 for very first, 2*3 for very last, 1*3 for all others in the middle
-    int xx = 0; // logical offset. Mul by 2 for pixelsize_super==2. Don't mul for indexing int* array
-    for (int bx = 0; bx < nBlkX; ++bx)
+    int xx = x_beg * ((nBlkSizeX - nOverlapX) >> nLogxRatioUV_super); // logical offset. Mul by 2 for pixelsize_super==2. Don't mul for indexing int* array
+    for (int bx = x_beg; bx < x_end; ++bx)
     {
       // select window
       // indexing overlap windows weighting table: left=+0 middle=+1 rightmost=+2
@@ -1815,34 +2247,54 @@ void	MDegrainN::process_chroma_overlap_slice(int y_beg, int y_end)
       int i = by * nBlkX + bx;
       const BYTE *ref_data_ptr_arr[MAX_TEMP_RAD * 2];
       int pitch_arr[MAX_TEMP_RAD * 2];
-      int weight_arr[1 + MAX_TEMP_RAD * 2]; // 0th is special
+      int *weight_arr = &_weight_arr[1][i * (1 + _trad * 2)]; // Precomputed, 0th is src
+      const int blk_class = (_static_flag) ? _blk_class_arr[1][i] : BlkClass_NORMAL;
 
-      for (int k = 0; k < _trad * 2; ++k)
+      const BYTE *blk_ptr = &tmp_block._d[0];
+      int blk_pitch = tmpPitch << pixelsize_super_shift;
+      if (blk_class == BlkClass_TRIVIAL)
       {
-        use_block_uv(
-          ref_data_ptr_arr[k],
-          pitch_arr[k],
-          weight_arr[k + 1], // from 1st
-          _usable_flag_arr[k],
-          _mv_clip_arr[k],
-          i,
-          _planes_ptr[k][P],
-          pSrcCur,
-          xx << pixelsize_super_shift, //  the pointer increment inside knows that xx later here is incremented with nBlkSize and not nBlkSize>>_xRatioUV
-          _src_pitch_arr[P]
-        );
+        // Only the source has a weight, give it directly to the overlap
+        blk_ptr = pSrcCur + (xx << pixelsize_super_shift);
+        blk_pitch = _src_pitch_arr[P];
       }
+      else
+      {
+        for (int k = 0; k < _trad * 2; ++k)
+        {
+          if (blk_class == BlkClass_STATIC)
+          {
+            use_block_static(
+              ref_data_ptr_arr[k], pitch_arr[k], _usable_flag_arr[k], k, P, bx, by,
+              pSrcCur, xx << pixelsize_super_shift, _src_pitch_arr[P]
+            );
+          }
+          else
+          {
+            use_block_uv(
+              ref_data_ptr_arr[k],
+              pitch_arr[k],
+              _usable_flag_arr[k],
+              _mv_clip_arr[k],
+              i,
+              _planes_ptr[k][P],
+              pSrcCur,
+              xx << pixelsize_super_shift, //  the pointer increment inside knows that xx later here is incremented with nBlkSize and not nBlkSize>>_xRatioUV
+              _src_pitch_arr[P]
+            );
+          }
+        }
 
-      norm_weights(weight_arr, _trad); // 0th + 1..MAX_TEMP_RAD*2
+        // chroma
+        // here we don't pass pixelsize, because _degrainchroma_ptr points already to the uint16_t version
+        // if the clip was 16 bit one
+        _degrainchroma_ptr(
+          &tmp_block._d[0], tmp_block._lsb_ptr, tmpPitch << pixelsize_output_shift,
+          pSrcCur + (xx << pixelsize_super_shift), _src_pitch_arr[P],
+          ref_data_ptr_arr, pitch_arr, weight_arr, _trad
+        );
+      }
 
-      // chroma
-      // here we don't pass pixelsize, because _degrainchroma_ptr points already to the uint16_t version
-      // if the clip was 16 bit one
-      _degrainchroma_ptr(
-        &tmp_block._d[0], tmp_block._lsb_ptr, tmpPitch << pixelsize_output_shift,
-        pSrcCur + (xx << pixelsize_super_shift), _src_pitch_arr[P],
-        ref_data_ptr_arr, pitch_arr, weight_arr, _trad
-      );
       if (_lsb_flag)
       {
         _overschroma_lsb_ptr(
@@ -1863,20 +2315,20 @@ void	MDegrainN::process_chroma_overlap_slice(int y_beg, int y_end)
       {
         _overschroma_ptr(
           pDstShort + xx, _dst_short_pitch,
-          &tmp_block._d[0], tmpPitch,
+          blk_ptr, blk_pitch,
           winOverUV, nBlkSizeX >> nLogxRatioUV_super);
       } else if (pixelsize_super == 2)
       {
         _overschroma16_ptr(
           (uint16_t*)(pDstInt + xx), _dst_int_pitch, 
-          &tmp_block._d[0], tmpPitch << pixelsize_super_shift, 
+          blk_ptr, blk_pitch, 
           winOverUV, nBlkSizeX >> nLogxRatioUV_super);
       }
       else // if (pixelsize_super == 4)
       {
         _overschroma32_ptr(
           (uint16_t*)(pDstInt + xx), _dst_int_pitch,
-          &tmp_block._d[0], tmpPitch << pixelsize_super_shift,
+          blk_ptr, blk_pitch,
           winOverUV, nBlkSizeX >> nLogxRatioUV_super);
       }
 
@@ -1893,51 +2345,165 @@ void	MDegrainN::process_chroma_overlap_slice(int y_beg, int y_end)
 
 
 void	MDegrainN::use_block_y(
-  const BYTE * &p, int &np, int &wref, bool usable_flag, const MvClipInfo &c_info,
+  const BYTE * &p, int &np, bool usable_flag, const MvClipInfo &c_info,
   int i, const MVPlane *plane_ptr, const BYTE *src_ptr, int xx, int src_pitch
 )
 {
   if (usable_flag)
   {
-    const FakeBlockData &	block = c_info._clip_sptr->GetBlock(0, i);
-    const int blx = block.GetX() * nPel + block.GetMV().x;
-    const int bly = block.GetY() * nPel + block.GetMV().y;
+    const FakePlaneOfBlocks &plane0 = c_info._clip_sptr->GetPlane(0);
+    const VECTOR mv = plane0.GetMV(i);
+    const int blx = plane0.GetArrayX() [i] * nPel + mv.x;
+    const int bly = plane0.GetArrayY() [i] * nPel + mv.y;
     p = plane_ptr->GetPointer(blx, bly);
     np = plane_ptr->GetPitch();
-    const sad_t block_sad = block.GetSAD(); // SAD of MV Block. Scaled to MVClip's bits_per_pixel;
-    wref = DegrainWeight(c_info._thsad, c_info._thsad_sq, block_sad);
   }
   else
   {
     p = src_ptr + xx;
     np = src_pitch;
-    wref = 0;
+  }
+}
+
+
+
+// Same as use_block_y/uv for a zero vector, without reading it
+void	MDegrainN::use_block_static(
+  const BYTE * &p, int &np, bool usable_flag, int k, int plane_index,
+  int bx, int by, const BYTE *src_ptr, int xx, int src_pitch
+)
+{
+  if (usable_flag)
+  {
+    const int log_x = (plane_index == 0) ? 0 : nLogxRatioUV_super;
+    const int log_y = (plane_index == 0) ? 0 : nLogyRatioUV_super;
+    const int x = (bx * (nBlkSizeX - nOverlapX)) >> log_x;
+    const int y = (by * (nBlkSizeY - nOverlapY)) >> log_y;
+    np = _planes_ptr[k][plane_index]->GetPitch();
+    p = _static_ref_ptr_arr[k][plane_index] + y * np + (x << pixelsize_super_shift);
+  }
+  else
+  {
+    p = src_ptr + xx;
+    np = src_pitch;
   }
 }
 
 
 
 void	MDegrainN::use_block_uv(
-  const BYTE * &p, int &np, int &wref, bool usable_flag, const MvClipInfo &c_info,
+  const BYTE * &p, int &np, bool usable_flag, const MvClipInfo &c_info,
   int i, const MVPlane *plane_ptr, const BYTE *src_ptr, int xx, int src_pitch
 )
 {
   if (usable_flag)
   {
-    const FakeBlockData &block = c_info._clip_sptr->GetBlock(0, i);
-    const int blx = block.GetX() * nPel + block.GetMV().x;
-    const int bly = block.GetY() * nPel + block.GetMV().y;
+    const FakePlaneOfBlocks &plane0 = c_info._clip_sptr->GetPlane(0);
+    const VECTOR mv = plane0.GetMV(i);
+    const int blx = plane0.GetArrayX() [i] * nPel + mv.x;
+    const int bly = plane0.GetArrayY() [i] * nPel + mv.y;
     p = plane_ptr->GetPointer(blx >> nLogxRatioUV_super, bly >> nLogyRatioUV_super);
     np = plane_ptr->GetPitch();
-    const sad_t block_sad = block.GetSAD(); // SAD of MV Block. Scaled to MVClip's bits_per_pixel;
-    wref = DegrainWeight(c_info._thsadc, c_info._thsadc_sq, block_sad);
   }
   else
   {
     // just to have a valid data pointer, will not count, weight is zero
     p = src_ptr + xx; // done: kill  >> nLogxRatioUV_super from here and put it in the caller like in MDegrainX
     np = src_pitch;
-    wref = 0;
+  }
+}
+
+
+
+// Fills _weight_arr[wi] for the current frame.
+// The raw weights are computed for the whole frame at once, reference by
+// reference, then normalised and transposed to one row per block.
+void MDegrainN::compute_weights(int wi, bool chroma_flag)
+{
+  const int nbr_ref = _trad * 2;
+  for (int k = 0; k < nbr_ref; ++k)
+  {
+    int *wref_ptr = &_wref_arr[k * nBlkCount];
+    if (_usable_flag_arr[k])
+    {
+      const MvClipInfo &c_info = _mv_clip_arr[k];
+      DegrainWeightArray(
+        wref_ptr, c_info._clip_sptr->GetPlane(0).GetArraySAD(), nBlkCount,
+        chroma_flag ? c_info._thsadc : c_info._thsad,
+        chroma_flag ? c_info._thsadc_sq : c_info._thsad_sq
+      );
+    }
+    else
+    {
+      std::fill(wref_ptr, wref_ptr + nBlkCount, 0);
+    }
+  }
+
+  const int stride = 1 + nbr_ref;
+  for (int i = 0; i < nBlkCount; ++i)
+  {
+    int *weight_ptr = &_weight_arr[wi][i * stride];
+    for (int k = 0; k < nbr_ref; ++k)
+    {
+      weight_ptr[k + 1] = _wref_arr[k * nBlkCount + i];
+    }
+    // The reductions only test the weights against 0. Normalised, the
+    // small ones could be rounded to 0 with large radii.
+    if (_reduce_mode == Reduce_NONE)
+    {
+      norm_weights(weight_ptr, _trad);
+    }
+    else
+    {
+      weight_ptr[0] = 1 << DEGRAIN_WEIGHT_BITS;
+    }
+  }
+
+  if (_static_flag)
+  {
+    classify_blocks(wi);
+  }
+}
+
+
+
+// Static block classifier, from the vectors and the weights of the frame.
+// TRIVIAL: no reference has a weight, the output is the source block. Only
+// when the output has the same format as the source.
+// STATIC: all the usable references have a zero vector, the reference
+// blocks are co-located and their address doesn't depend on the vectors.
+void MDegrainN::classify_blocks(int wi)
+{
+  uint8_t *class_ptr = &_blk_class_arr[wi][0];
+  std::fill(class_ptr, class_ptr + nBlkCount, uint8_t(BlkClass_STATIC));
+  for (int k = 0; k < _trad * 2; ++k)
+  {
+    if (_usable_flag_arr[k])
+    {
+      const FakePlaneOfBlocks &plane = _mv_clip_arr[k]._clip_sptr->GetPlane(0);
+      const int *vx_ptr = plane.GetArrayVx();
+      const int *vy_ptr = plane.GetArrayVy();
+      for (int i = 0; i < nBlkCount; ++i)
+      {
+        if ((vx_ptr[i] | vy_ptr[i]) != 0)
+        {
+          class_ptr[i] = BlkClass_NORMAL;
+        }
+      }
+    }
+  }
+
+  if (!_lsb_flag && !_out16_flag)
+  {
+    const int one = 1 << DEGRAIN_WEIGHT_BITS;
+    const int stride = 1 + _trad * 2;
+    for (int i = 0; i < nBlkCount; ++i)
+    {
+      if (_weight_arr[wi][i * stride] == one)
+      {
+        class_ptr[i] = BlkClass_TRIVIAL;
+      }
+    }
   }
 }
 
@@ -4,7 +4,9 @@
 
 
 #include	"conc/AtomicInt.h"
+#include "GofCache.h"
 #include "MTSlicer.h"
+#include "MTTiler.h"
 #include "MVClip.h"
 #include "MVFilter.h"
 #include	"MVGroupOfFrames.h"
@@ -29,11 +31,24 @@ public:
 
   enum { MAX_TEMP_RAD = 128 };
 
+  // Temporal reduction of the source and compensated reference blocks,
+  // replacing the weighted average.
+  enum Reduce
+  {
+    Reduce_NONE = -1, // Weighted average, regular MDegrainN
+    Reduce_MEDIAN = 0,
+    Reduce_TRIMMED,   // Mean without the minimum and the maximum
+    Reduce_CLAMP,     // Source clamped to the reference range
+
+    Reduce_NBR_ELT
+  };
+
   MDegrainN(
     ::PClip child, ::PClip super, ::PClip mvmulti, int trad,
     sad_t thsad, sad_t thsadc, int yuvplanes, float nlimit, float nlimitc,
     sad_t nscd1, int nscd2, bool isse_flag, bool planar_flag, bool lsb_flag,
-    sad_t thsad2, sad_t thsadc2, bool mt_flag, bool out16_flag, ::IScriptEnvironment* env_ptr
+    sad_t thsad2, sad_t thsadc2, bool mt_flag, bool out16_flag, bool static_flag,
+    bool reduce_flag, int reduce_mode, const char *filter_name_0, ::IScriptEnvironment* env_ptr
   );
   ~MDegrainN();
 
@@ -59,12 +74,12 @@ private:
     );
 
   DenoiseNFunction* get_denoiseN_function(int BlockX, int BlockY, int _bits_per_pixel, bool _lsb_flag, bool _out16_flag, arch_t arch);
+  DenoiseNFunction* get_reduceN_function(int BlockX, int BlockY, int _bits_per_pixel, int reduce_mode);
 
   class MvClipInfo
   {
   public:
     SharedPtr <MVClip> _clip_sptr;
-    SharedPtr <MVGroupOfFrames> _gof_sptr;
     sad_t _thsad;
     sad_t _thsadc;
     double _thsad_sq;
@@ -73,6 +88,7 @@ private:
   typedef std::vector <MvClipInfo> MvClipArray;
 
   typedef MTSlicer <MDegrainN> Slicer;
+  typedef MTTiler <MDegrainN> Tiler;
 
   class TmpBlock
   {
@@ -84,36 +100,52 @@ private:
     unsigned char* _lsb_ptr;// Not allocated, it's just a reference to a part of the _d area
   };
 
+  enum BlkClass
+  {
+    BlkClass_NORMAL = 0,
+    BlkClass_STATIC,
+    BlkClass_TRIVIAL
+  };
+
   MV_FORCEINLINE int reorder_ref(int index) const;
   template <int P>
   MV_FORCEINLINE void process_chroma(int plane_mask);
 
   void process_luma_normal_slice(Slicer::TaskData &td);
   void process_luma_overlap_slice(Slicer::TaskData &td);
-  void process_luma_overlap_slice(int y_beg, int y_end);
+  void process_luma_overlap_slice(int y_beg, int y_end, int x_beg, int x_end);
 
   template <int P>
   void process_chroma_normal_slice(Slicer::TaskData &td);
   template <int P>
   void process_chroma_overlap_slice(Slicer::TaskData &td);
   template <int P>
-  void process_chroma_overlap_slice(int y_beg, int y_end);
+  void process_chroma_overlap_slice(int y_beg, int y_end, int x_beg, int x_end);
 
   MV_FORCEINLINE void
     use_block_y(
-      const BYTE * &p, int &np, int &wref, bool usable_flag, const MvClipInfo &c_info,
+      const BYTE * &p, int &np, bool usable_flag, const MvClipInfo &c_info,
       int i, const MVPlane *plane_ptr, const BYTE *src_ptr, int xx, int src_pitch
     );
   MV_FORCEINLINE void
     use_block_uv(
-      const BYTE * &p, int &np, int &wref, bool usable_flag, const MvClipInfo &c_info,
+      const BYTE * &p, int &np, bool usable_flag, const MvClipInfo &c_info,
       int i, const MVPlane *plane_ptr, const BYTE *src_ptr, int xx, int src_pitch
     );
 
+  MV_FORCEINLINE void
+    use_block_static(
+      const BYTE * &p, int &np, bool usable_flag, int k, int plane_index,
+      int bx, int by, const BYTE *src_ptr, int xx, int src_pitch
+    );
+
+  void compute_weights(int wi, bool chroma_flag);
+  void classify_blocks(int wi);
   static MV_FORCEINLINE void
     norm_weights(int wref_arr[], int trad);
 
   MvClipArray _mv_clip_arr;
+  GofCache _ref_gof_cache; // Reference GOFs, keyed by super frame number
 
   int _trad;// Temporal radius (nbr frames == _trad * 2 + 1)
   int _yuvplanes;
@@ -125,6 +157,8 @@ private:
   const bool _lsb_flag;
   const bool _out16_flag;
   const bool _mt_flag;
+  const bool _static_flag; // Static block fast path
+  const int _reduce_mode; // Reduce_NONE or temporal reduction (MReduceN)
   int _height_lsb_or_out16_mul;
   //int pixelsize, bits_per_pixel; // in MVFilter
   //int xRatioUV, yRatioUV; // in MVFilter
@@ -160,6 +194,8 @@ private:
   DenoiseNFunction *_degrainchroma_ptr;
 
   LimitFunction_t *LimitFunction;
+  Short2BytesFunction_t *_short2bytes_ptr;
+  Short2BytesInt32toWord16Function_t *_short2word16_ptr;
 
 // -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -
 // Processing variables
@@ -179,6 +215,17 @@ private:
   int _covered_width;
   int _covered_height;
 
+  // Block weights of the current frame, computed before the pixel
+  // processing. [0] is luma, [1] chroma. One row of 1 + _trad * 2
+  // normalised weights per block, in the order expected by DenoiseNFunction.
+  std::vector <int> _weight_arr[2];
+  // Raw weights, one row of nBlkCount per reference. Temporary.
+  std::vector <int> _wref_arr;
+  // BlkClass of each block, for the weights of _weight_arr. Only with
+  // _static_flag.
+  std::vector <uint8_t> _blk_class_arr[2];
+  const BYTE *_static_ref_ptr_arr[MAX_TEMP_RAD * 2][3];
+
   // This array has an nBlkY size. It is used in vertical overlap mode
   // to avoid read/write sync problems when processing is multithreaded.
   // Only elements corresponding to the first row of each sub-plane are
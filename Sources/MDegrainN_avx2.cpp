@@ -0,0 +1,391 @@
+#include "MDegrainN_avx2.h"
+#include "def.h"
+
+#include <immintrin.h>
+#include <cassert>
+#include <stdint.h>
+
+// DegrainN kernels for AVX2. See DegrainN_C in MDegrainN.cpp for the reference.
+//
+// Each reference is read once per pixel, so these are bandwidth bound:
+// 16 pixels (8 bit, 16 bit) or 8 pixels (float) per step, and for the
+// narrow blocks two rows are processed together to fill the 256 bit registers.
+
+// loads 16 pixels of 8 bit, zero extended to 16 bit.
+// two_rows: 8 pixels from p and 8 pixels from p + pitch
+template <bool two_rows>
+static MV_FORCEINLINE __m256i load_8to16(const uint8_t *p, int pitch)
+{
+  if constexpr(two_rows)
+    return _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)),
+      _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + pitch))));
+  else
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+
+// loads 32 bytes. two_rows: 16 bytes from p and 16 bytes from p + pitch
+template <bool two_rows>
+static MV_FORCEINLINE __m256i load_32bytes(const uint8_t *p, int pitch)
+{
+  if constexpr(two_rows)
+    return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))),
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + pitch)), 1);
+  else
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+// stores 32 bytes. two_rows: 16 bytes to p and 16 bytes to p + pitch
+template <bool two_rows>
+static MV_FORCEINLINE void store_32bytes(uint8_t *p, int pitch, __m256i v)
+{
+  if constexpr(two_rows)
+  {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm256_castsi256_si128(v));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p + pitch), _mm256_extracti128_si256(v, 1));
+  }
+  else
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+}
+
+// stores 16 bytes. two_rows: 8 bytes to p and 8 bytes to p + pitch
+template <bool two_rows>
+static MV_FORCEINLINE void store_16bytes(uint8_t *p, int pitch, __m128i v)
+{
+  if constexpr(two_rows)
+  {
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(p), v);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(p + pitch), _mm_srli_si128(v, 8));
+  }
+  else
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+}
+
+// 8 bit source, 16 pixels at offset x (two_rows: 8 pixels of 2 rows)
+// Sum of the weights is 256, the weighted sum fits into 16 bits.
+template <int out16_type, bool two_rows>
+static MV_FORCEINLINE void degrain_8bit_16px(
+  uint8_t *pDst, uint8_t *pDstLsb, int nDstPitch,
+  const uint8_t *pSrc, int nSrcPitch,
+  const uint8_t *pRef[], int Pitch[],
+  int Wall[], int trad, int x)
+{
+  __m256i val = _mm256_mullo_epi16(load_8to16<two_rows>(pSrc + x, nSrcPitch), _mm256_set1_epi16(Wall[0]));
+  if constexpr(out16_type == 0)
+    val = _mm256_add_epi16(val, _mm256_set1_epi16(128)); // rounding
+  for (int k = 0; k < trad; ++k)
+  {
+    const __m256i s1 = _mm256_mullo_epi16(load_8to16<two_rows>(pRef[k * 2] + x, Pitch[k * 2]), _mm256_set1_epi16(Wall[k * 2 + 1]));
+    const __m256i s2 = _mm256_mullo_epi16(load_8to16<two_rows>(pRef[k * 2 + 1] + x, Pitch[k * 2 + 1]), _mm256_set1_epi16(Wall[k * 2 + 2]));
+    val = _mm256_add_epi16(val, _mm256_add_epi16(s1, s2));
+  }
+
+  const __m128i val_lo = _mm256_castsi256_si128(val);
+  const __m128i val_hi = _mm256_extracti128_si256(val, 1);
+  if constexpr(out16_type == 2)
+  {
+    // native 16 bit out: 32 bytes
+    store_32bytes<two_rows>(pDst + x * 2, nDstPitch, val);
+  }
+  else
+  {
+    const __m128i msb = _mm_packus_epi16(_mm_srli_epi16(val_lo, 8), _mm_srli_epi16(val_hi, 8));
+    store_16bytes<two_rows>(pDst + x, nDstPitch, msb);
+    if constexpr(out16_type == 1)
+    {
+      const __m128i m = _mm_set1_epi16(255);
+      const __m128i lsb = _mm_packus_epi16(_mm_and_si128(val_lo, m), _mm_and_si128(val_hi, m));
+      store_16bytes<two_rows>(pDstLsb + x, nDstPitch, lsb);
+    }
+  }
+}
+
+// 8 bit source, 8 pixels at offset x, 128 bit
+template <int out16_type>
+static MV_FORCEINLINE void degrain_8bit_8px(
+  uint8_t *pDst, uint8_t *pDstLsb,
+  const uint8_t *pSrc,
+  const uint8_t *pRef[],
+  int Wall[], int trad, int x)
+{
+  __m128i val = _mm_mullo_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pSrc + x))), _mm_set1_epi16(Wall[0]));
+  if constexpr(out16_type == 0)
+    val = _mm_add_epi16(val, _mm_set1_epi16(128)); // rounding
+  for (int k = 0; k < trad; ++k)
+  {
+    const __m128i s1 = _mm_mullo_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pRef[k * 2] + x))), _mm_set1_epi16(Wall[k * 2 + 1]));
+    const __m128i s2 = _mm_mullo_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pRef[k * 2 + 1] + x))), _mm_set1_epi16(Wall[k * 2 + 2]));
+    val = _mm_add_epi16(val, _mm_add_epi16(s1, s2));
+  }
+  const __m128i z = _mm_setzero_si128();
+  if constexpr(out16_type == 2)
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + x * 2), val);
+  else
+  {
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(pDst + x), _mm_packus_epi16(_mm_srli_epi16(val, 8), z));
+    if constexpr(out16_type == 1)
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(pDstLsb + x), _mm_packus_epi16(_mm_and_si128(val, _mm_set1_epi16(255)), z));
+  }
+}
+
+// 10-16 bit source, 16 pixels at offset x (two_rows: 8 pixels of 2 rows)
+// madd_epi16 is signed, so the pixels are biased by -32768 and the bias is
+// added back as 32768 * sum(weights) with the rounder. The result is the same as
+// the 32 bit integer arithmetic of the C version.
+template <bool two_rows>
+static MV_FORCEINLINE void degrain_16bit_16px(
+  uint8_t *pDst, int nDstPitch,
+  const uint8_t *pSrc, int nSrcPitch,
+  const uint8_t *pRef[], int Pitch[],
+  int Wall[], int trad, int x, const __m256i &offset)
+{
+  const __m256i bias = _mm256_set1_epi16(-32768);
+  const __m256i z = _mm256_setzero_si256();
+  const int xb = x * 2;
+
+  const __m256i s = _mm256_xor_si256(load_32bytes<two_rows>(pSrc + xb, nSrcPitch), bias);
+  const __m256i w0 = _mm256_set1_epi32(Wall[0]); // (w, 0) pairs
+  __m256i acc_lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(s, z), w0);
+  __m256i acc_hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(s, z), w0);
+  for (int k = 0; k < trad; ++k)
+  {
+    const __m256i a = _mm256_xor_si256(load_32bytes<two_rows>(pRef[k * 2] + xb, Pitch[k * 2]), bias);
+    const __m256i b = _mm256_xor_si256(load_32bytes<two_rows>(pRef[k * 2 + 1] + xb, Pitch[k * 2 + 1]), bias);
+    const __m256i w = _mm256_set1_epi32((Wall[k * 2 + 2] << 16) | (Wall[k * 2 + 1] & 0xFFFF));
+    acc_lo = _mm256_add_epi32(acc_lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+    acc_hi = _mm256_add_epi32(acc_hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+  }
+  acc_lo = _mm256_srai_epi32(_mm256_add_epi32(acc_lo, offset), 8);
+  acc_hi = _mm256_srai_epi32(_mm256_add_epi32(acc_hi, offset), 8);
+  // unpacklo/hi and packus are both lane-wise, the pixel order is restored
+  store_32bytes<two_rows>(pDst + xb, nDstPitch, _mm256_packus_epi32(acc_lo, acc_hi));
+}
+
+// 10-16 bit source, 8 or 4 pixels at offset x, 128 bit
+template <int nPixels>
+static MV_FORCEINLINE void degrain_16bit_128(
+  uint8_t *pDst,
+  const uint8_t *pSrc,
+  const uint8_t *pRef[],
+  int Wall[], int trad, int x, const __m128i &offset)
+{
+  const __m128i bias = _mm_set1_epi16(-32768);
+  const __m128i z = _mm_setzero_si128();
+  const int xb = x * 2;
+  auto load = [](const uint8_t *p) {
+    if constexpr(nPixels == 8)
+      return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    else
+      return _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+  };
+
+  const __m128i s = _mm_xor_si128(load(pSrc + xb), bias);
+  const __m128i w0 = _mm_set1_epi32(Wall[0]);
+  __m128i acc_lo = _mm_madd_epi16(_mm_unpacklo_epi16(s, z), w0);
+  __m128i acc_hi = _mm_madd_epi16(_mm_unpackhi_epi16(s, z), w0);
+  for (int k = 0; k < trad; ++k)
+  {
+    const __m128i a = _mm_xor_si128(load(pRef[k * 2] + xb), bias);
+    const __m128i b = _mm_xor_si128(load(pRef[k * 2 + 1] + xb), bias);
+    const __m128i w = _mm_set1_epi32((Wall[k * 2 + 2] << 16) | (Wall[k * 2 + 1] & 0xFFFF));
+    acc_lo = _mm_add_epi32(acc_lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+    if constexpr(nPixels == 8)
+      acc_hi = _mm_add_epi32(acc_hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+  }
+  acc_lo = _mm_srai_epi32(_mm_add_epi32(acc_lo, offset), 8);
+  if constexpr(nPixels == 8)
+  {
+    acc_hi = _mm_srai_epi32(_mm_add_epi32(acc_hi, offset), 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + xb), _mm_packus_epi32(acc_lo, acc_hi));
+  }
+  else
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(pDst + xb), _mm_packus_epi32(acc_lo, acc_lo));
+}
+
+// float, 8 pixels at offset x (two_rows: 4 pixels of 2 rows)
+// same operation order as the C version, no FMA
+template <bool two_rows>
+static MV_FORCEINLINE void degrain_float_8px(
+  uint8_t *pDst, int nDstPitch,
+  const uint8_t *pSrc, int nSrcPitch,
+  const uint8_t *pRef[], int Pitch[],
+  int Wall[], int trad, int x)
+{
+  const int xb = x * 4;
+  __m256 val = _mm256_mul_ps(_mm256_castsi256_ps(load_32bytes<two_rows>(pSrc + xb, nSrcPitch)), _mm256_set1_ps((float)Wall[0]));
+  val = _mm256_add_ps(val, _mm256_setzero_ps()); // rounder is 0 for float
+  for (int k = 0; k < trad; ++k)
+  {
+    const __m256 s1 = _mm256_mul_ps(_mm256_castsi256_ps(load_32bytes<two_rows>(pRef[k * 2] + xb, Pitch[k * 2])), _mm256_set1_ps((float)Wall[k * 2 + 1]));
+    const __m256 s2 = _mm256_mul_ps(_mm256_castsi256_ps(load_32bytes<two_rows>(pRef[k * 2 + 1] + xb, Pitch[k * 2 + 1])), _mm256_set1_ps((float)Wall[k * 2 + 2]));
+    val = _mm256_add_ps(val, _mm256_add_ps(s1, s2));
+  }
+  val = _mm256_mul_ps(val, _mm256_set1_ps(1.0f / 256));
+  store_32bytes<two_rows>(pDst + xb, nDstPitch, _mm256_castps_si256(val));
+}
+
+// float, 4 pixels at offset x, 128 bit
+static MV_FORCEINLINE void degrain_float_4px(
+  uint8_t *pDst,
+  const uint8_t *pSrc,
+  const uint8_t *pRef[],
+  int Wall[], int trad, int x)
+{
+  const int xb = x * 4;
+  __m128 val = _mm_mul_ps(_mm_loadu_ps(reinterpret_cast<const float *>(pSrc + xb)), _mm_set1_ps((float)Wall[0]));
+  val = _mm_add_ps(val, _mm_setzero_ps());
+  for (int k = 0; k < trad; ++k)
+  {
+    const __m128 s1 = _mm_mul_ps(_mm_loadu_ps(reinterpret_cast<const float *>(pRef[k * 2] + xb)), _mm_set1_ps((float)Wall[k * 2 + 1]));
+    const __m128 s2 = _mm_mul_ps(_mm_loadu_ps(reinterpret_cast<const float *>(pRef[k * 2 + 1] + xb)), _mm_set1_ps((float)Wall[k * 2 + 2]));
+    val = _mm_add_ps(val, _mm_add_ps(s1, s2));
+  }
+  val = _mm_mul_ps(val, _mm_set1_ps(1.0f / 256));
+  _mm_storeu_ps(reinterpret_cast<float *>(pDst + xb), val);
+}
+
+template <typename pixel_t, int blockWidth, int blockHeight, int out16_type>
+void DegrainN_avx2(
+  uint8_t *pDst, uint8_t *pDstLsb, int nDstPitch,
+  const uint8_t *pSrc, int nSrcPitch,
+  const uint8_t *pRef[], int Pitch[],
+  int Wall[], int trad
+)
+{
+  constexpr bool lsb_flag = (out16_type == 1);
+
+  // the row is exactly one half of a ymm register: process two rows together
+  constexpr int row_bytes = blockWidth * sizeof(pixel_t) * (out16_type == 0 ? 1 : 2);
+  constexpr bool two_rows =
+    (blockHeight % 2) == 0 && (
+      (sizeof(pixel_t) == 1 && blockWidth == 8) ||
+      (sizeof(pixel_t) != 1 && row_bytes == 16));
+  constexpr int row_step = two_rows ? 2 : 1;
+
+  // per pixel group width and the remainders
+  constexpr int px_per_ymm = (sizeof(pixel_t) == 4) ? 8 : 16;
+  constexpr int wModYmm = two_rows ? blockWidth : (blockWidth / px_per_ymm) * px_per_ymm;
+
+  static_assert(sizeof(pixel_t) != 1 || blockWidth % 8 == 0, "DegrainN_avx2: 8 bit block width must be mod8");
+  static_assert(blockWidth % 4 == 0, "DegrainN_avx2: block width must be mod4");
+
+  int wsum = 0;
+  if constexpr(sizeof(pixel_t) == 2)
+  {
+    for (int i = 0; i <= trad * 2; ++i)
+      wsum += Wall[i];
+  }
+  const int offset_i = 32768 * wsum + 128;
+  const __m256i offset = _mm256_set1_epi32(offset_i);
+
+  for (int h = 0; h < blockHeight; h += row_step)
+  {
+    if constexpr(sizeof(pixel_t) == 1)
+    {
+      if constexpr(two_rows)
+        degrain_8bit_16px<out16_type, true>(pDst, pDstLsb, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad, 0);
+      else
+      {
+        for (int x = 0; x < wModYmm; x += 16)
+          degrain_8bit_16px<out16_type, false>(pDst, pDstLsb, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad, x);
+        if constexpr(wModYmm != blockWidth)
+          degrain_8bit_8px<out16_type>(pDst, pDstLsb, pSrc, pRef, Wall, trad, wModYmm);
+      }
+    }
+    else if constexpr(sizeof(pixel_t) == 2)
+    {
+      if constexpr(two_rows)
+        degrain_16bit_16px<true>(pDst, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad, 0, offset);
+      else
+      {
+        for (int x = 0; x < wModYmm; x += 16)
+          degrain_16bit_16px<false>(pDst, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad, x, offset);
+        constexpr int rest = blockWidth - wModYmm; // 0, 4, 8 or 12
+        if constexpr(rest >= 8)
+          degrain_16bit_128<8>(pDst, pSrc, pRef, Wall, trad, wModYmm, _mm256_castsi256_si128(offset));
+        if constexpr(rest % 8 != 0)
+          degrain_16bit_128<4>(pDst, pSrc, pRef, Wall, trad, blockWidth - 4, _mm256_castsi256_si128(offset));
+      }
+    }
+    else
+    {
+      if constexpr(two_rows)
+        degrain_float_8px<true>(pDst, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad, 0);
+      else
+      {
+        for (int x = 0; x < wModYmm; x += 8)
+          degrain_float_8px<false>(pDst, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad, x);
+        if constexpr(wModYmm != blockWidth)
+          degrain_float_4px(pDst, pSrc, pRef, Wall, trad, wModYmm);
+      }
+    }
+
+    pDst += nDstPitch * row_step;
+    if constexpr(lsb_flag)
+      pDstLsb += nDstPitch * row_step;
+    pSrc += nSrcPitch * row_step;
+    for (int k = 0; k < trad; ++k)
+    {
+      pRef[k * 2] += Pitch[k * 2] * row_step;
+      pRef[k * 2 + 1] += Pitch[k * 2 + 1] * row_step;
+    }
+  }
+  _mm256_zeroupper();
+}
+
+// Instantiate
+// match with get_denoiseN_function in MDegrainN.cpp
+#define MAKE_FN_8(x, y) \
+template void DegrainN_avx2<uint8_t, x, y, 0>(uint8_t *pDst, uint8_t *pDstLsb, int nDstPitch, const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef[], int Pitch[], int Wall[], int trad); \
+template void DegrainN_avx2<uint8_t, x, y, 1>(uint8_t *pDst, uint8_t *pDstLsb, int nDstPitch, const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef[], int Pitch[], int Wall[], int trad); \
+template void DegrainN_avx2<uint8_t, x, y, 2>(uint8_t *pDst, uint8_t *pDstLsb, int nDstPitch, const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef[], int Pitch[], int Wall[], int trad);
+#define MAKE_FN_16(x, y) \
+template void DegrainN_avx2<uint16_t, x, y, 0>(uint8_t *pDst, uint8_t *pDstLsb, int nDstPitch, const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef[], int Pitch[], int Wall[], int trad); \
+template void DegrainN_avx2<float, x, y, 0>(uint8_t *pDst, uint8_t *pDstLsb, int nDstPitch, const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef[], int Pitch[], int Wall[], int trad);
+#define MAKE_FN(x, y) MAKE_FN_8(x, y) MAKE_FN_16(x, y)
+MAKE_FN(64, 64)
+MAKE_FN(64, 48)
+MAKE_FN(64, 32)
+MAKE_FN(64, 16)
+MAKE_FN(48, 64)
+MAKE_FN(48, 48)
+MAKE_FN(48, 24)
+MAKE_FN(48, 12)
+MAKE_FN(32, 64)
+MAKE_FN(32, 32)
+MAKE_FN(32, 24)
+MAKE_FN(32, 16)
+MAKE_FN(32, 8)
+MAKE_FN(24, 48)
+MAKE_FN(24, 32)
+MAKE_FN(24, 24)
+MAKE_FN(24, 12)
+MAKE_FN(24, 6)
+MAKE_FN(16, 64)
+MAKE_FN(16, 32)
+MAKE_FN(16, 16)
+MAKE_FN(16, 12)
+MAKE_FN(16, 8)
+MAKE_FN(16, 4)
+MAKE_FN(16, 2)
+MAKE_FN(16, 1)
+MAKE_FN_16(12, 48)
+MAKE_FN_16(12, 24)
+MAKE_FN_16(12, 16)
+MAKE_FN_16(12, 12)
+MAKE_FN_16(12, 6)
+MAKE_FN_16(12, 3)
+MAKE_FN(8, 32)
+MAKE_FN(8, 16)
+MAKE_FN(8, 8)
+MAKE_FN(8, 4)
+MAKE_FN(8, 2)
+MAKE_FN(8, 1)
+MAKE_FN_16(4, 8)
+MAKE_FN_16(4, 4)
+MAKE_FN_16(4, 2)
+MAKE_FN_16(4, 1)
+#undef MAKE_FN
+#undef MAKE_FN_16
+#undef MAKE_FN_8
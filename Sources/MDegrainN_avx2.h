@@ -0,0 +1,20 @@
+#ifndef __MDEGRAINN_AVX2__
+#define __MDEGRAINN_AVX2__
+
+#include <stdint.h>
+
+// AVX2 versions of DegrainN_C, same arguments and results.
+// out16_type:
+//   0: native 8, 16 bit or float
+//   1: 8bit in, lsb
+//   2: 8bit in, native16 out
+// 8 bit: block width mod8. 16 bit and float: block width mod4.
+template <typename pixel_t, int blockWidth, int blockHeight, int out16_type>
+void DegrainN_avx2(
+  uint8_t *pDst, uint8_t *pDstLsb, int nDstPitch,
+  const uint8_t *pSrc, int nSrcPitch,
+  const uint8_t *pRef[], int Pitch[],
+  int Wall[], int trad
+);
+
+#endif
@@ -0,0 +1,283 @@
+/*****************************************************************************
+
+        MLoadVect.cpp
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"commonfunctions.h"
+#include	"CopyCode.h"
+#include	"MLoadVect.h"
+
+#include	<algorithm>
+
+#include	<cassert>
+#include	<cstring>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+MLoadVect::MLoadVect (const char *filename_0, ::IScriptEnvironment *env)
+:	vi ()
+,	_file_hnd (INVALID_HANDLE_VALUE)
+,	_map_hnd (0)
+,	_head_ptr (0)
+,	_file_size (0)
+,	_granularity (0)
+,	_hdr ()
+,	_mad ()
+{
+	assert (filename_0 != 0);
+	assert (env != 0);
+
+	SYSTEM_INFO		sys_info;
+	::GetSystemInfo (&sys_info);
+	_granularity = int (sys_info.dwAllocationGranularity);
+
+	_file_hnd = ::CreateFileA (
+		filename_0, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, 0
+	);
+	LARGE_INTEGER	file_size;
+	if (   _file_hnd == INVALID_HANDLE_VALUE
+	    || ! ::GetFileSizeEx (_file_hnd, &file_size))
+	{
+		release ();
+		env->ThrowError ("MLoadVect: cannot open file %s.", filename_0);
+	}
+	_file_size = file_size.QuadPart;
+	if (_file_size < int64_t (sizeof (_hdr)))
+	{
+		release ();
+		env->ThrowError ("MLoadVect: file too small to contain valid data.");
+	}
+
+	_map_hnd = ::CreateFileMappingA (_file_hnd, 0, PAGE_READONLY, 0, 0, 0);
+	if (_map_hnd != 0)
+	{
+		_head_ptr = static_cast <const uint8_t *> (
+			::MapViewOfFile (_map_hnd, FILE_MAP_READ, 0, 0, sizeof (_hdr))
+		);
+	}
+	if (_head_ptr == 0)
+	{
+		release ();
+		env->ThrowError ("MLoadVect: cannot map file %s.", filename_0);
+	}
+	memcpy (&_hdr, _head_ptr, sizeof (_hdr));
+	::UnmapViewOfFile (_head_ptr);
+	_head_ptr = 0;
+
+	// Header check. The frame data is not decoded, the analysis data header
+	// of each frame is checked by the clients.
+	if (_hdr._key != VectFile::KEY)
+	{
+		release ();
+		env->ThrowError ("MLoadVect: %s is not a vector file.", filename_0);
+	}
+	if (_hdr._version != VectFile::VERSION)
+	{
+		release ();
+		env->ThrowError (
+			"MLoadVect: unsupported version (%d) of the vector file.",
+			_hdr._version
+		);
+	}
+	VectFile::Header	ref = _hdr;
+	VectFile::compute_layout (ref);
+	if (   _hdr._mad_size     != ref._mad_size
+	    || _hdr._header_size  != ref._header_size
+	    || _hdr._data_offset  != ref._data_offset
+	    || _hdr._frame_size   != ref._frame_size
+	    || _hdr._frame_stride != ref._frame_stride
+	    || _hdr._nbr_frames   <= 0
+	    || _hdr._frame_size   <= 0
+	    || _hdr._data_offset  >  _file_size
+	    || _hdr._mad.GetMagicKey () != MVAnalysisData::MOTION_MAGIC_KEY
+	    || _hdr._mad.nVersion != MVAnalysisData::VERSION)
+	{
+		release ();
+		env->ThrowError ("MLoadVect: unexpected or corrupted file header.");
+	}
+
+	vi.width           = _hdr._width;
+	vi.height          = _hdr._height;
+	vi.pixel_type      = _hdr._pixel_type;
+	vi.image_type      = _hdr._image_type;
+	vi.fps_numerator   = _hdr._fps_num;
+	vi.fps_denominator = _hdr._fps_den;
+	vi.num_frames      = _hdr._nbr_frames;
+	if (vi.RowSize () != _hdr._row_size)
+	{
+		release ();
+		env->ThrowError ("MLoadVect: unexpected or corrupted file header.");
+	}
+
+	// Keeps the header and the index mapped
+	_head_ptr = static_cast <const uint8_t *> (::MapViewOfFile (
+		_map_hnd, FILE_MAP_READ, 0, 0,
+		size_t (_hdr._header_size) + _hdr._nbr_frames
+	));
+	if (_head_ptr == 0)
+	{
+		release ();
+		env->ThrowError ("MLoadVect: cannot map file %s.", filename_0);
+	}
+
+	_mad = _hdr._mad;
+	CHECK_COMPILE_TIME (SizeOfIntPtr, (sizeof (int) <= sizeof (void *)));
+#if !defined(_WIN64)
+	vi.nchannels = reinterpret_cast <uintptr_t> (&_mad);
+#else
+	// hack!
+	uintptr_t p = reinterpret_cast <uintptr_t> (&_mad);
+	vi.nchannels = 0x80000000L | (int)(p >> 32);
+	vi.sample_type = (int)(p & 0xffffffffUL);
+#endif
+}
+
+
+
+MLoadVect::~MLoadVect ()
+{
+	release ();
+}
+
+
+
+// O(1): the frame position is given by its number. Only the pages of the
+// requested frame are mapped.
+::PVideoFrame __stdcall	MLoadVect::GetFrame (int n, ::IScriptEnvironment *env_ptr)
+{
+	assert (env_ptr != 0);
+
+	n = std::max (std::min (n, vi.num_frames - 1), 0);
+
+	if (_head_ptr [_hdr._header_size + n] == 0)
+	{
+		env_ptr->ThrowError (
+			"MLoadVect: frame %d is missing from the file. "
+			"All the frames must be requested during the analysis.",
+			n
+		);
+	}
+
+	const int64_t	offset = VectFile::get_frame_offset (_hdr, n);
+	if (offset + _hdr._frame_size > _file_size)
+	{
+		env_ptr->ThrowError ("MLoadVect: file truncated at frame %d.", n);
+	}
+
+	// Views must start on the allocation granularity
+	const int64_t	view_beg = offset - offset % _granularity;
+	const int		view_ofs = int (offset - view_beg);
+	const uint8_t*	view_ptr = static_cast <const uint8_t *> (::MapViewOfFile (
+		_map_hnd, FILE_MAP_READ,
+		DWORD (view_beg >> 32), DWORD (view_beg & 0xFFFFFFFF),
+		size_t (view_ofs) + _hdr._frame_size
+	));
+	if (view_ptr == 0)
+	{
+		env_ptr->ThrowError ("MLoadVect: cannot map frame %d.", n);
+	}
+
+	::PVideoFrame	dst_ptr = env_ptr->NewVideoFrame (vi);
+	BitBlt (
+		dst_ptr->GetWritePtr (), dst_ptr->GetPitch (),
+		view_ptr + view_ofs, _hdr._row_size,
+		_hdr._row_size, _hdr._height
+	);
+	::UnmapViewOfFile (view_ptr);
+
+	return (dst_ptr);
+}
+
+
+
+bool __stdcall	MLoadVect::GetParity (int n)
+{
+	MV_UNUSED (n);
+
+	return (false);
+}
+
+
+
+void __stdcall	MLoadVect::GetAudio (void *buf, int64_t start, int64_t count, ::IScriptEnvironment *env)
+{
+	// Nothing, there is no audio
+	MV_UNUSED (buf);
+	MV_UNUSED (start);
+	MV_UNUSED (count);
+	MV_UNUSED (env);
+}
+
+
+
+int __stdcall	MLoadVect::SetCacheHints (int cachehints, int frame_range)
+{
+	MV_UNUSED (frame_range);
+
+	return (cachehints == CACHE_GET_MTMODE ? MT_NICE_FILTER : 0);
+}
+
+
+
+const ::VideoInfo & __stdcall	MLoadVect::GetVideoInfo ()
+{
+	return (vi);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+void	MLoadVect::release ()
+{
+	if (_head_ptr != 0)
+	{
+		::UnmapViewOfFile (_head_ptr);
+		_head_ptr = 0;
+	}
+	if (_map_hnd != 0)
+	{
+		::CloseHandle (_map_hnd);
+		_map_hnd = 0;
+	}
+	if (_file_hnd != INVALID_HANDLE_VALUE)
+	{
+		::CloseHandle (_file_hnd);
+		_file_hnd = INVALID_HANDLE_VALUE;
+	}
+}
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,115 @@
+/*****************************************************************************
+
+        MLoadVect.h
+
+Source filter serving the vector clip stored in a file by MAnalyse (vectfile
+parameter). The file is memory-mapped, each frame is fetched directly from
+its position in the file. The output clip can be used in place of the
+MAnalyse output.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MLoadVect_HEADER_INCLUDED)
+#define	MLoadVect_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"def.h"
+#include	"VectFile.h"
+
+#define	NOGDI
+#define	NOMINMAX
+#define	WIN32_LEAN_AND_MEAN
+#include "Windows.h"
+#include	"avisynth.h"
+#include <stdint.h>
+
+
+
+class MLoadVect
+:	public ::IClip
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	explicit			MLoadVect (const char *filename_0, ::IScriptEnvironment *env);
+	virtual			~MLoadVect ();
+
+	// IClip
+	::PVideoFrame __stdcall
+						GetFrame (int n, ::IScriptEnvironment *env_ptr) override;
+	bool __stdcall	GetParity (int n) override;
+	void __stdcall	GetAudio (void *buf, int64_t start, int64_t count, ::IScriptEnvironment *env) override;
+	int __stdcall	SetCacheHints (int cachehints, int frame_range) override;
+	const ::VideoInfo & __stdcall
+						GetVideoInfo () override;
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	void				release ();
+
+	::VideoInfo		vi;
+	HANDLE			_file_hnd;
+	HANDLE			_map_hnd;
+	const uint8_t *
+						_head_ptr;			// Mapped header and index
+	int64_t			_file_size;
+	int				_granularity;		// Bytes, alignment of the mapped views
+	VectFile::Header
+						_hdr;
+	MVAnalysisData	_mad;					// Transmitted to the clients through vi
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						MLoadVect ();
+						MLoadVect (const MLoadVect &other);
+	MLoadVect &		operator = (const MLoadVect &other);
+	bool				operator == (const MLoadVect &other) const;
+	bool				operator != (const MLoadVect &other) const;
+
+};	// class MLoadVect
+
+
+
+//#include	"MLoadVect.hpp"
+
+
+
+#endif	// MLoadVect_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -69,7 +69,7 @@ MTFlowGraphSched <T, GR, GD, MAXT>::MTFlowGraphSched (bool mt_flag)
 ,	_dep_graph_ptr (0)
 ,	_task_data_arr ()
 ,	_in_cnt_arr ()
-,	_mt_flag ()
+,	_mt_flag (mt_flag)
 {
 	// Nothing
 }
@@ -0,0 +1,126 @@
+/*****************************************************************************
+
+        MTFlowGraphSparse.h
+
+A dependency graph for MTFlowGraphSched with an arbitrary structure.
+
+Works like MTFlowGraphSimple, but the list of dependent tasks is allocated
+on demand for each node. The memory grows with the number of dependencies
+instead of the square of the number of tasks, so the graph can hold
+thousands of tasks with a few dependencies each.
+
+Template parameters:
+
+- MAXT: maximum number of tasks contained in the graph, root included.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MTFlowGraphSparse_HEADER_INCLUDED)
+#define	MTFlowGraphSparse_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	<vector>
+
+
+
+template <int MAXT>
+class MTFlowGraphSparse
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	using ThisType = MTFlowGraphSparse <MAXT>;
+
+	class Iterator
+	{
+	public:
+		inline 			Iterator (const ThisType &fg, int node);
+		inline void		next ();
+		inline bool		cont () const;
+		inline int		get_index () const;
+
+	private:
+		const std::vector <int> &
+							_out_arr;
+		int				_pos;
+	};
+
+						MTFlowGraphSparse ();
+	virtual			~MTFlowGraphSparse () {}
+
+	void				add_dep (int index_from, int index_to);
+	void				clear ();
+
+	int				get_last_node () const;
+	int				get_nbr_in (int task_index) const;
+	Iterator			get_out_node_it (int task_index) const;
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	class Node
+	{
+	public:
+		int				_nbr_in;
+		std::vector <int>
+							_out_arr;
+	};
+
+	int				_last_node;
+	std::vector <Node>
+						_node_arr;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						MTFlowGraphSparse (const MTFlowGraphSparse <MAXT> &other);
+	MTFlowGraphSparse <MAXT> &
+						operator = (const MTFlowGraphSparse <MAXT> &other);
+	bool				operator == (const MTFlowGraphSparse <MAXT> &other) const;
+	bool				operator != (const MTFlowGraphSparse <MAXT> &other) const;
+
+};	// class MTFlowGraphSparse
+
+
+
+#include	"MTFlowGraphSparse.hpp"
+
+
+
+#endif	// MTFlowGraphSparse_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,249 @@
+/*****************************************************************************
+
+        MTFlowGraphSparse.hpp
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MTFlowGraphSparse_CODEHEADER_INCLUDED)
+#define	MTFlowGraphSparse_CODEHEADER_INCLUDED
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	<algorithm>
+
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*
+==============================================================================
+Name: ctor
+Description:
+	Creates the graph. There is only one node, the root.
+Throws: std::bad_alloc
+==============================================================================
+*/
+
+template <int MAXT>
+MTFlowGraphSparse <MAXT>::MTFlowGraphSparse ()
+:	_last_node (0)
+,	_node_arr ()
+{
+	clear ();
+}
+
+
+
+/*
+==============================================================================
+Name: add_dep
+Description:
+	Add a dependency between two tasks, so index_from is always executed before
+	index_to. Note that the task must be connected (indirectly) to the root to
+	be executed. Root has index 0.
+	Same rules as MTFlowGraphSimple: a link added twice is counted twice, and
+	circular dependencies must be avoided.
+Input parameters:
+	- index_from: index of the task to execute first. Range [0 ; MAXT[.
+	- index_to: index of the task dependent on index_from. Range ]0 ; MAXT[.
+Throws: std::bad_alloc
+==============================================================================
+*/
+
+template <int MAXT>
+void	MTFlowGraphSparse <MAXT>::add_dep (int index_from, int index_to)
+{
+	assert (index_from >= 0);
+	assert (index_from < MAXT);
+	assert (index_to > 0);	// Excludes the root node
+	assert (index_to < MAXT);
+	assert (index_from != index_to);
+
+	const int		nbr_nodes = std::max (index_from, index_to) + 1;
+	if (int (_node_arr.size ()) < nbr_nodes)
+	{
+		Node				node;
+		node._nbr_in = 0;
+		_node_arr.resize (nbr_nodes, node);
+	}
+
+	_node_arr [index_from]._out_arr.push_back (index_to);
+	++ _node_arr [index_to]._nbr_in;
+
+	_last_node = std::max (_last_node, index_from);
+	_last_node = std::max (_last_node, index_to);
+}
+
+
+
+/*
+==============================================================================
+Name: clear
+Description:
+	Removes all the dependencies, thus all tasks excepted the root.
+Throws: std::bad_alloc
+==============================================================================
+*/
+
+template <int MAXT>
+void	MTFlowGraphSparse <MAXT>::clear ()
+{
+	_last_node = 0;
+	_node_arr.clear ();
+	Node				root;
+	root._nbr_in = 0;
+	_node_arr.push_back (root);
+}
+
+
+
+/*
+==============================================================================
+Name: get_last_node
+Description:
+	Indicates the highest referenced task index. This is distinct to the last
+	task in execution order, because index and order are not linked.
+Returns: The last task index, range [0 ; MAXT[
+Throws: Nothing
+==============================================================================
+*/
+
+template <int MAXT>
+int	MTFlowGraphSparse <MAXT>::get_last_node () const
+{
+	assert (_last_node >= 0);
+	assert (_last_node < MAXT);
+
+	return (_last_node);
+}
+
+
+
+/*
+==============================================================================
+Name: get_nbr_in
+Description:
+	Gives the number of input nodes for a task, that is the number of its
+	dependencies.
+Input parameters:
+	- task_index: Index of the desired task, >= 0.
+Returns: The number of direct preceding tasks, >= 0.
+Throws: Nothing
+==============================================================================
+*/
+
+template <int MAXT>
+int	MTFlowGraphSparse <MAXT>::get_nbr_in (int task_index) const
+{
+	assert (task_index >= 0);
+	assert (task_index <= _last_node);
+
+	return (_node_arr [task_index]._nbr_in);
+}
+
+
+
+/*
+==============================================================================
+Name: get_out_node_it
+Description:
+	Returns an iterator on the list of tasks depending on the provided task.
+	The iterator is initialised to the first task of the list.
+Input parameters:
+	- task_index: index of the task we want to know its dependent task list.
+Returns:
+	The iterator, pointing on the first element (or terminated if the node
+	is a leaf and the list is empty).
+Throws: Nothing.
+==============================================================================
+*/
+
+template <int MAXT>
+typename MTFlowGraphSparse <MAXT>::Iterator	MTFlowGraphSparse <MAXT>::get_out_node_it (int task_index) const
+{
+	assert (task_index >= 0);
+	assert (task_index <= _last_node);
+
+	return (Iterator (*this, task_index));
+}
+
+
+
+/*
+==============================================================================
+Name: ctor
+Description:
+	Iterator constructor, internal, not for public use.
+Throws: Nothing
+==============================================================================
+*/
+
+template <int MAXT>
+MTFlowGraphSparse <MAXT>::Iterator::Iterator (const ThisType &fg, int node)
+:	_out_arr (fg._node_arr [node]._out_arr)
+,	_pos (0)
+{
+	assert (&fg != 0);
+	assert (node >= 0);
+	assert (node < MAXT);
+}
+
+
+
+template <int MAXT>
+void	MTFlowGraphSparse <MAXT>::Iterator::next ()
+{
+	assert (cont ());
+
+	++ _pos;
+}
+
+
+
+template <int MAXT>
+bool	MTFlowGraphSparse <MAXT>::Iterator::cont () const
+{
+	return (_pos < int (_out_arr.size ()));
+}
+
+
+
+template <int MAXT>
+int	MTFlowGraphSparse <MAXT>::Iterator::get_index () const
+{
+	assert (cont ());
+
+	return (_out_arr [_pos]);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+#endif	// MTFlowGraphSparse_CODEHEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
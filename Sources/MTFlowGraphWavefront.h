@@ -0,0 +1,124 @@
+/*****************************************************************************
+
+        MTFlowGraphWavefront.h
+
+A dependency graph for MTFlowGraphSched describing a 2D wavefront.
+
+The tasks form a grid of rows and columns. Task (r, c) can start when its
+left neighbour (r, c-1) and the top-right neighbour (r-1, c+1) are done.
+On the last column, the top-right neighbour is replaced with the top one.
+This is the dependency pattern of a raster scan where each element uses
+the left, top and top-right elements as predictors: row r can start as soon
+as row r-1 is two elements ahead.
+
+Nodes are not stored, dependencies are computed on the fly, so the graph can
+be much larger than MTFlowGraphSimple. The root is at index 0, task (r, c) is
+at index 1 + r * nbr_cols + c.
+
+Template parameters:
+
+- MAXT: maximum number of tasks contained in the graph, root included.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MTFlowGraphWavefront_HEADER_INCLUDED)
+#define	MTFlowGraphWavefront_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+template <int MAXT>
+class MTFlowGraphWavefront
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	using ThisType = MTFlowGraphWavefront <MAXT>;
+
+	class Iterator
+	{
+	public:
+		inline 			Iterator (const ThisType &fg, int node);
+		inline void		next ();
+		inline bool		cont () const;
+		inline int		get_index () const;
+
+	private:
+		int				_out_arr [2];
+		int				_nbr_out;
+		int				_pos;
+	};
+
+						MTFlowGraphWavefront ();
+	virtual			~MTFlowGraphWavefront () {}
+
+	void				set_grid (int nbr_rows, int nbr_cols);
+	inline int		get_nbr_rows () const;
+	inline int		get_nbr_cols () const;
+	inline int		get_row (int task_index) const;
+	inline int		get_col (int task_index) const;
+
+	int				get_last_node () const;
+	int				get_nbr_in (int task_index) const;
+	Iterator			get_out_node_it (int task_index) const;
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	int				_nbr_rows;
+	int				_nbr_cols;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						MTFlowGraphWavefront (const MTFlowGraphWavefront <MAXT> &other);
+	MTFlowGraphWavefront <MAXT> &
+						operator = (const MTFlowGraphWavefront <MAXT> &other);
+	bool				operator == (const MTFlowGraphWavefront <MAXT> &other) const;
+	bool				operator != (const MTFlowGraphWavefront <MAXT> &other) const;
+
+};	// class MTFlowGraphWavefront
+
+
+
+#include	"MTFlowGraphWavefront.hpp"
+
+
+
+#endif	// MTFlowGraphWavefront_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,318 @@
+/*****************************************************************************
+
+        MTFlowGraphWavefront.hpp
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MTFlowGraphWavefront_CODEHEADER_INCLUDED)
+#define	MTFlowGraphWavefront_CODEHEADER_INCLUDED
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*
+==============================================================================
+Name: ctor
+Description:
+	Creates the graph. There is only one node, the root.
+Throws: Nothing
+==============================================================================
+*/
+
+template <int MAXT>
+MTFlowGraphWavefront <MAXT>::MTFlowGraphWavefront ()
+:	_nbr_rows (0)
+,	_nbr_cols (0)
+{
+	// Nothing
+}
+
+
+
+/*
+==============================================================================
+Name: set_grid
+Description:
+	Sets the grid dimensions. Don't call it while tasks are running.
+Input parameters:
+	- nbr_rows: number of rows, > 0
+	- nbr_cols: number of columns, > 0. nbr_rows * nbr_cols must be < MAXT.
+Throws: Nothing
+==============================================================================
+*/
+
+template <int MAXT>
+void	MTFlowGraphWavefront <MAXT>::set_grid (int nbr_rows, int nbr_cols)
+{
+	assert (nbr_rows > 0);
+	assert (nbr_cols > 0);
+	assert (nbr_rows * nbr_cols < MAXT);
+
+	_nbr_rows = nbr_rows;
+	_nbr_cols = nbr_cols;
+}
+
+
+
+template <int MAXT>
+int	MTFlowGraphWavefront <MAXT>::get_nbr_rows () const
+{
+	return (_nbr_rows);
+}
+
+
+
+template <int MAXT>
+int	MTFlowGraphWavefront <MAXT>::get_nbr_cols () const
+{
+	return (_nbr_cols);
+}
+
+
+
+/*
+==============================================================================
+Name: get_row
+Description:
+	Retrieves the grid row of a task.
+Input parameters:
+	- task_index: Index of the task, > 0 (the root has no position)
+Returns: The row, in [0 ; nbr_rows[
+Throws: Nothing
+==============================================================================
+*/
+
+template <int MAXT>
+int	MTFlowGraphWavefront <MAXT>::get_row (int task_index) const
+{
+	assert (task_index > 0);
+	assert (task_index <= get_last_node ());
+
+	return ((task_index - 1) / _nbr_cols);
+}
+
+
+
+/*
+==============================================================================
+Name: get_col
+Description:
+	Retrieves the grid column of a task.
+Input parameters:
+	- task_index: Index of the task, > 0 (the root has no position)
+Returns: The column, in [0 ; nbr_cols[
+Throws: Nothing
+==============================================================================
+*/
+
+template <int MAXT>
+int	MTFlowGraphWavefront <MAXT>::get_col (int task_index) const
+{
+	assert (task_index > 0);
+	assert (task_index <= get_last_node ());
+
+	return ((task_index - 1) % _nbr_cols);
+}
+
+
+
+/*
+==============================================================================
+Name: get_last_node
+Description:
+	Indicates the highest task index.
+Returns: The last task index, range [0 ; MAXT[
+Throws: Nothing
+==============================================================================
+*/
+
+template <int MAXT>
+int	MTFlowGraphWavefront <MAXT>::get_last_node () const
+{
+	return (_nbr_rows * _nbr_cols);
+}
+
+
+
+/*
+==============================================================================
+Name: get_nbr_in
+Description:
+	Gives the number of input nodes for a task, that is the number of its
+	dependencies.
+Input parameters:
+	- task_index: Index of the desired task, >= 0.
+Returns: The number of direct preceding tasks, >= 0.
+Throws: Nothing
+==============================================================================
+*/
+
+template <int MAXT>
+int	MTFlowGraphWavefront <MAXT>::get_nbr_in (int task_index) const
+{
+	assert (task_index >= 0);
+	assert (task_index <= get_last_node ());
+
+	if (task_index == 0)
+	{
+		return (0);
+	}
+
+	const int		row = get_row (task_index);
+	const int		col = get_col (task_index);
+	if (row == 0 && col == 0)
+	{
+		return (1);	// Root
+	}
+
+	return (((row > 0) ? 1 : 0) + ((col > 0) ? 1 : 0));
+}
+
+
+
+/*
+==============================================================================
+Name: get_out_node_it
+Description:
+	Returns an iterator on the list of tasks depending on the provided task.
+	The iterator is initialised to the first task of the list.
+Input parameters:
+	- task_index: index of the task we want to know its dependent task list.
+Returns:
+	The iterator, pointing on the first element (or terminated if the node
+	is a leaf and the list is empty).
+Throws: Nothing.
+==============================================================================
+*/
+
+template <int MAXT>
+typename MTFlowGraphWavefront <MAXT>::Iterator	MTFlowGraphWavefront <MAXT>::get_out_node_it (int task_index) const
+{
+	assert (task_index >= 0);
+	assert (task_index <= get_last_node ());
+
+	return (Iterator (*this, task_index));
+}
+
+
+
+/*
+==============================================================================
+Name: ctor
+Description:
+	Iterator constructor, internal, not for public use.
+	Computes the list of the dependent tasks:
+	- (r, c+1), the right neighbour
+	- (r+1, c-1), the bottom-left neighbour, which uses (r, c) as top-right
+	- (r+1, c) if c is the last column (no top-right there)
+Throws: Nothing
+==============================================================================
+*/
+
+template <int MAXT>
+MTFlowGraphWavefront <MAXT>::Iterator::Iterator (const ThisType &fg, int node)
+:	_nbr_out (0)
+,	_pos (0)
+{
+	assert (&fg != 0);
+	assert (node >= 0);
+	assert (node < MAXT);
+
+	if (node == 0)
+	{
+		if (fg._nbr_rows > 0 && fg._nbr_cols > 0)
+		{
+			_out_arr [_nbr_out] = 1;
+			++ _nbr_out;
+		}
+	}
+	else
+	{
+		const int		nbr_cols = fg._nbr_cols;
+		const int		row = fg.get_row (node);
+		const int		col = fg.get_col (node);
+		if (col + 1 < nbr_cols)
+		{
+			_out_arr [_nbr_out] = node + 1;
+			++ _nbr_out;
+		}
+		if (row + 1 < fg._nbr_rows)
+		{
+			if (col > 0)
+			{
+				_out_arr [_nbr_out] = node + nbr_cols - 1;
+				++ _nbr_out;
+			}
+			if (col == nbr_cols - 1)
+			{
+				_out_arr [_nbr_out] = node + nbr_cols;
+				++ _nbr_out;
+			}
+		}
+	}
+
+	assert (_nbr_out <= 2);
+}
+
+
+
+template <int MAXT>
+void	MTFlowGraphWavefront <MAXT>::Iterator::next ()
+{
+	assert (cont ());
+
+	++ _pos;
+}
+
+
+
+template <int MAXT>
+bool	MTFlowGraphWavefront <MAXT>::Iterator::cont () const
+{
+	return (_pos < _nbr_out);
+}
+
+
+
+template <int MAXT>
+int	MTFlowGraphWavefront <MAXT>::Iterator::get_index () const
+{
+	assert (cont ());
+
+	return (_out_arr [_pos]);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+#endif	// MTFlowGraphWavefront_CODEHEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
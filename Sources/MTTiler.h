@@ -0,0 +1,174 @@
+/*****************************************************************************
+
+        MTTiler.h
+
+Splits a task on a 2D grid of elements (the blocks of a frame) into
+rectangular tiles processed in parallel. Compared to MTSlicer, a thread works
+on a narrower part of the frame, so the reference pixels read for a tile are
+more likely to stay in the cache on wide frames.
+
+The elements can write outside their own area (overlapped blocks), so two
+adjacent elements must never be processed at the same time. Each tile is
+split into items:
+
+- INT: the tile interior, all its elements but the last row and column
+- HOR: the horizontal seam, the last row of the tile without its last column
+- VER: the vertical seam, the last column of the tile
+- CROSS: the element at the crossing of both seams
+
+The interiors are enqueued first. A seam item is run by the task completing
+its last neighbouring item, HOR seams before VER seams and VER seams before
+the crossings, the same way MDegrainN and MVCompensate process the boundary
+rows with their _boundary_cnt_arr counters. The last row and column of the
+frame are not seams and belong to the interiors.
+
+The element processing must not reach elements further than the immediate
+neighbours, which is true with blocks overlapping by half their size at most.
+
+This class can be instantiated on the stack.
+
+Template parameters:
+
+- T: Main processing class (most likely your Avisynth filter).
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MTTiler_HEADER_INCLUDED)
+#define	MTTiler_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"conc/AtomicInt.h"
+#include	"avstp.h"
+
+#include	<vector>
+
+
+
+class AvstpWrapper;
+
+template <class T>
+class MTTiler
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	typedef	MTTiler <T>	ThisType;
+
+	// Target tile size, in pixels. A 512-pixel wide tile keeps the
+	// reference areas of a few frames in a typical L2 cache.
+	enum {			TILE_W_PIX = 512 };
+	enum {			TILE_H_PIX = 128 };
+
+	// Half-open ranges of elements
+	typedef	void (T::*ProcPtr) (int y_beg, int y_end, int x_beg, int x_end);
+
+	explicit			MTTiler (bool mt_flag = true);
+	virtual			~MTTiler ();
+
+	inline bool		is_mt () const;
+	static int		compute_tile_size (int step, int tile_pix);
+	static int		compute_nbr_tiles (int nbr_elt, int tile_size);
+	static bool		is_worth (bool mt_flag, int nbr_elt_x, int step_x);
+	void				start (int width, int height, int step_x, int step_y, T &obj, ProcPtr proc_ptr);
+	void				wait ();
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	enum Item
+	{
+		Item_INT = 0,
+		Item_HOR,
+		Item_VER,
+		Item_CROSS,
+
+		Item_NBR_ELT
+	};
+
+	class TaskData
+	{
+	public:
+		ThisType *		_tiler_ptr;
+		int				_tx;
+		int				_ty;
+	};
+
+	typedef	std::vector <conc::AtomicInt <int> >	CntArray;
+
+	static void		redirect_task (avstp_TaskDispatcher *dispatcher_ptr, void *data_ptr);
+
+	void				run_item (Item item, int tx, int ty);
+	void				notify (Item item, int tx, int ty);
+	bool				is_existing (Item item, int tx, int ty) const;
+	int				compute_nbr_deps (Item item, int tx, int ty) const;
+
+	AvstpWrapper &	_avstp;
+
+	T *				_obj_ptr;
+	ProcPtr			_proc_ptr;
+	avstp_TaskDispatcher * volatile
+						_dispatcher_ptr;
+	int				_nbr_tx;
+	int				_nbr_ty;
+	std::vector <int>
+						_bnd_x_arr;		// Tile boundaries, _nbr_tx + 1 elements
+	std::vector <int>
+						_bnd_y_arr;		// Tile boundaries, _nbr_ty + 1 elements
+	std::vector <TaskData>
+						_task_data_arr;
+	CntArray			_cnt_arr [Item_NBR_ELT];	// Completed dependencies, per tile. Not used for INT
+	const bool		_mt_flag;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						MTTiler (const MTTiler &other);
+	MTTiler &		operator = (const MTTiler &other);
+	bool				operator == (const MTTiler &other) const;
+	bool				operator != (const MTTiler &other) const;
+
+};	// class MTTiler
+
+
+
+#include	"MTTiler.hpp"
+
+
+
+#endif	// MTTiler_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,442 @@
+/*****************************************************************************
+
+        MTTiler.hpp
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MTTiler_CODEHEADER_INCLUDED)
+#define	MTTiler_CODEHEADER_INCLUDED
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"conc/AioAdd.h"
+#include	"conc/AtomicIntOp.h"
+#include	"AvstpWrapper.h"
+
+#include	<algorithm>
+
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*
+==============================================================================
+Name: constructor
+Input parameters:
+	- mt_flag: set it to false to disable multi-threading. If set to true, the
+		actual number of threads used will depend on the AVSTP settings.
+Throws: an exception if AvstpWrapper cannot be accessed or constructed.
+==============================================================================
+*/
+
+template <class T>
+MTTiler <T>::MTTiler (bool mt_flag)
+:	_avstp (AvstpWrapper::use_instance ())
+,	_obj_ptr (0)
+,	_proc_ptr (0)
+,	_dispatcher_ptr (0)
+,	_nbr_tx (0)
+,	_nbr_ty (0)
+,	_bnd_x_arr ()
+,	_bnd_y_arr ()
+,	_task_data_arr ()
+,	_cnt_arr ()
+,	_mt_flag (mt_flag)
+{
+	// Nothing
+}
+
+
+
+/*
+==============================================================================
+Name: dtor
+Description:
+	Before destruction, waits for tasks still running to be completed.
+==============================================================================
+*/
+
+template <class T>
+MTTiler <T>::~MTTiler ()
+{
+	if (_dispatcher_ptr != 0)
+	{
+		wait ();
+	}
+}
+
+
+
+template <class T>
+bool	MTTiler <T>::is_mt () const
+{
+	return (_mt_flag);
+}
+
+
+
+/*
+==============================================================================
+Name: compute_tile_size
+Description:
+	Converts a tile size in pixels into a number of elements.
+Input parameters:
+	- step: distance between two consecutive elements, in pixels, > 0.
+	- tile_pix: tile size, in pixels.
+Returns: the tile size in elements, >= 2 so the tile interior is never empty.
+Throws: Nothing
+==============================================================================
+*/
+
+template <class T>
+int	MTTiler <T>::compute_tile_size (int step, int tile_pix)
+{
+	assert (step > 0);
+
+	return (std::max (tile_pix / step, 2));
+}
+
+
+
+template <class T>
+int	MTTiler <T>::compute_nbr_tiles (int nbr_elt, int tile_size)
+{
+	assert (tile_size > 0);
+
+	return (std::max (nbr_elt / tile_size, 1));
+}
+
+
+
+/*
+==============================================================================
+Name: is_worth
+Description:
+	Indicates if the frame is wide enough to be split into at least two tile
+	columns. Otherwise a simple MTSlicer gives the same memory access pattern
+	with less synchronisation.
+Input parameters:
+	- mt_flag: multi-threading is requested.
+	- nbr_elt_x: number of elements in a row.
+	- step_x: horizontal distance between two elements, in pixels.
+Returns: true if the tiles should be used.
+Throws: Nothing
+==============================================================================
+*/
+
+template <class T>
+bool	MTTiler <T>::is_worth (bool mt_flag, int nbr_elt_x, int step_x)
+{
+	const int		tile_w = compute_tile_size (step_x, TILE_W_PIX);
+
+	return (mt_flag && compute_nbr_tiles (nbr_elt_x, tile_w) >= 2);
+}
+
+
+
+/*
+==============================================================================
+Name: start
+Description:
+	Runs the processing function on the whole element grid. The tile size is
+	derived from TILE_W_PIX and TILE_H_PIX.
+	The function returns as soon as the tile interiors are enqueued. Use
+	wait() to wait for the completion of the whole grid. In monothreaded mode,
+	the grid is processed at once before the function returns, but wait() is
+	still required.
+Input parameters:
+	- width: number of elements in a row, > 0.
+	- height: number of element rows, > 0.
+	- step_x, step_y: distance between two elements, in pixels, > 0.
+	- obj: the object whose function is called.
+	- proc_ptr: processing function, called with half-open ranges of rows and
+		columns.
+Throws: Depends on dispatcher creation failures.
+==============================================================================
+*/
+
+template <class T>
+void	MTTiler <T>::start (int width, int height, int step_x, int step_y, T &obj, ProcPtr proc_ptr)
+{
+	assert (width > 0);
+	assert (height > 0);
+	assert (step_x > 0);
+	assert (step_y > 0);
+	assert (proc_ptr != 0);
+
+	_obj_ptr  = &obj;
+	_proc_ptr = proc_ptr;
+
+	if (_mt_flag)
+	{
+		const int		tile_w = compute_tile_size (step_x, TILE_W_PIX);
+		const int		tile_h = compute_tile_size (step_y, TILE_H_PIX);
+		_nbr_tx = compute_nbr_tiles (width,  tile_w);
+		_nbr_ty = compute_nbr_tiles (height, tile_h);
+
+		_bnd_x_arr.resize (_nbr_tx + 1);
+		for (int tx = 0; tx <= _nbr_tx; ++tx)
+		{
+			_bnd_x_arr [tx] = tx * width / _nbr_tx;
+		}
+		_bnd_y_arr.resize (_nbr_ty + 1);
+		for (int ty = 0; ty <= _nbr_ty; ++ty)
+		{
+			_bnd_y_arr [ty] = ty * height / _nbr_ty;
+		}
+
+		const int		nbr_tiles = _nbr_tx * _nbr_ty;
+		for (int item = Item_HOR; item < Item_NBR_ELT; ++item)
+		{
+			_cnt_arr [item].resize (nbr_tiles);
+			for (int pos = 0; pos < nbr_tiles; ++pos)
+			{
+				_cnt_arr [item] [pos] = 0;
+			}
+		}
+
+		_task_data_arr.resize (nbr_tiles);
+		for (int ty = 0; ty < _nbr_ty; ++ty)
+		{
+			for (int tx = 0; tx < _nbr_tx; ++tx)
+			{
+				TaskData &		task_data = _task_data_arr [ty * _nbr_tx + tx];
+				task_data._tiler_ptr = this;
+				task_data._tx        = tx;
+				task_data._ty        = ty;
+			}
+		}
+
+		_dispatcher_ptr = _avstp.create_dispatcher ();
+
+		for (int pos = 0; pos < nbr_tiles; ++pos)
+		{
+			_avstp.enqueue_task (
+				_dispatcher_ptr,
+				&redirect_task,
+				&_task_data_arr [pos]
+			);
+		}
+	}
+
+	// Multi-threading disabled
+	else
+	{
+		((*_obj_ptr).*(_proc_ptr)) (0, height, 0, width);
+	}
+}
+
+
+
+/*
+==============================================================================
+Name: wait
+Description:
+	Waits for the completion of the processing previously started with
+	start(). A call to wait() is mandatory after a start(), and you cannot call
+	wait() if nothing has been started.
+Throws: Nothing.
+==============================================================================
+*/
+
+template <class T>
+void	MTTiler <T>::wait ()
+{
+	assert (_proc_ptr != 0);
+
+	if (_mt_flag)
+	{
+		assert (_dispatcher_ptr != 0);
+
+		_avstp.wait_completion (_dispatcher_ptr);
+		_avstp.destroy_dispatcher (_dispatcher_ptr);
+	}
+
+	_proc_ptr = 0;
+	_dispatcher_ptr = 0;
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+template <class T>
+void	MTTiler <T>::redirect_task (avstp_TaskDispatcher *dispatcher_ptr, void *data_ptr)
+{
+	TaskData *		td_ptr = reinterpret_cast <TaskData *> (data_ptr);
+	assert (td_ptr != 0);
+	assert (td_ptr->_tiler_ptr != 0);
+
+	td_ptr->_tiler_ptr->run_item (Item_INT, td_ptr->_tx, td_ptr->_ty);
+}
+
+
+
+// Processes an item, then runs the items for which it was the last
+// dependency.
+template <class T>
+void	MTTiler <T>::run_item (Item item, int tx, int ty)
+{
+	assert (is_existing (item, tx, ty));
+
+	const bool		last_c_flag = (tx == _nbr_tx - 1);
+	const bool		last_r_flag = (ty == _nbr_ty - 1);
+	const int		x_beg = _bnd_x_arr [tx];
+	const int		x_end = _bnd_x_arr [tx + 1];
+	const int		y_beg = _bnd_y_arr [ty];
+	const int		y_end = _bnd_y_arr [ty + 1];
+	const int		x_int = (last_c_flag) ? x_end : x_end - 1;
+	const int		y_int = (last_r_flag) ? y_end : y_end - 1;
+
+	switch (item)
+	{
+	case	Item_INT:
+		((*_obj_ptr).*(_proc_ptr)) (y_beg, y_int, x_beg, x_int);
+		notify (Item_HOR, tx    , ty    );
+		notify (Item_HOR, tx    , ty - 1);
+		notify (Item_VER, tx    , ty    );
+		notify (Item_VER, tx - 1, ty    );
+		break;
+
+	case	Item_HOR:
+		((*_obj_ptr).*(_proc_ptr)) (y_int, y_end, x_beg, x_int);
+		notify (Item_VER  , tx    , ty    );
+		notify (Item_VER  , tx - 1, ty    );
+		notify (Item_VER  , tx    , ty + 1);
+		notify (Item_VER  , tx - 1, ty + 1);
+		notify (Item_CROSS, tx    , ty    );
+		notify (Item_CROSS, tx - 1, ty    );
+		break;
+
+	case	Item_VER:
+		((*_obj_ptr).*(_proc_ptr)) (y_beg, y_int, x_int, x_end);
+		notify (Item_CROSS, tx    , ty    );
+		notify (Item_CROSS, tx    , ty - 1);
+		break;
+
+	case	Item_CROSS:
+		((*_obj_ptr).*(_proc_ptr)) (y_int, y_end, x_int, x_end);
+		break;
+
+	default:
+		assert (false);
+		break;
+	}
+}
+
+
+
+// Counts a completed dependency of an item and runs it if it was the last
+// one. Does nothing if the item does not exist.
+template <class T>
+void	MTTiler <T>::notify (Item item, int tx, int ty)
+{
+	assert (item != Item_INT);
+
+	if (is_existing (item, tx, ty))
+	{
+		const conc::AioAdd <int>	inc_ftor (+1);
+
+		const int		cnt = conc::AtomicIntOp::exec_new (
+			_cnt_arr [item] [ty * _nbr_tx + tx],
+			inc_ftor
+		);
+		if (cnt == compute_nbr_deps (item, tx, ty))
+		{
+			run_item (item, tx, ty);
+		}
+	}
+}
+
+
+
+template <class T>
+bool	MTTiler <T>::is_existing (Item item, int tx, int ty) const
+{
+	bool				exist_flag =
+		(tx >= 0 && tx < _nbr_tx && ty >= 0 && ty < _nbr_ty);
+
+	if (item == Item_HOR || item == Item_CROSS)
+	{
+		exist_flag = exist_flag && (ty < _nbr_ty - 1);
+	}
+	if (item == Item_VER || item == Item_CROSS)
+	{
+		exist_flag = exist_flag && (tx < _nbr_tx - 1);
+	}
+
+	return (exist_flag);
+}
+
+
+
+// Dependencies:
+// HOR (tx, ty): INT (tx, ty) and INT (tx, ty + 1)
+// VER (tx, ty): INT (tx, ty) and INT (tx + 1, ty),
+//               HOR (tx, ty) and HOR (tx + 1, ty) if not on the last row,
+//               HOR (tx, ty - 1) and HOR (tx + 1, ty - 1) if not on the first row
+// CROSS (tx, ty): HOR (tx, ty), HOR (tx + 1, ty), VER (tx, ty), VER (tx, ty + 1)
+template <class T>
+int	MTTiler <T>::compute_nbr_deps (Item item, int tx, int ty) const
+{
+	int				nbr_deps = 0;
+
+	switch (item)
+	{
+	case	Item_HOR:
+		nbr_deps = 2;
+		break;
+
+	case	Item_VER:
+		nbr_deps = 2;
+		if (ty < _nbr_ty - 1)
+		{
+			nbr_deps += 2;
+		}
+		if (ty > 0)
+		{
+			nbr_deps += 2;
+		}
+		break;
+
+	case	Item_CROSS:
+		nbr_deps = 4;
+		break;
+
+	default:
+		assert (false);
+		break;
+	}
+
+	return (nbr_deps);
+}
+
+
+
+#endif	// MTTiler_CODEHEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
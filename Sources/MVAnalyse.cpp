@@ -43,16 +43,20 @@ MVAnalyse::MVAnalyse(
   int _overlapx, int _overlapy, const char* _outfilename, int _dctmode,
   int _divide, int _sadx264, sad_t _badSAD, int _badrange, bool _isse,
   bool _meander, bool temporal_flag, bool _tryMany, bool multi_flag,
-  bool mt_flag, int _chromaSADScale, IScriptEnvironment* env
+  bool mt_flag, int _chromaSADScale, const char *vectfilename_0,
+    IScriptEnvironment* env
 )
   : ::GenericVideoFilter(_child)
   , _srd_arr(1)
+  , _batch_cache_sptr()
+  , _batch_vect_arr()
   , _vectorfields_aptr()
   , _multi_flag(multi_flag)
   , _temporal_flag(temporal_flag)
   , _mt_flag(mt_flag)
   , _dct_factory_ptr()
   , _dct_pool()
+  , _vect_file_aptr()
   , _delta_max(0)
   
 {
@@ -136,16 +140,27 @@ MVAnalyse::MVAnalyse(
 
   analysisData.chromaSADScale = _chromaSADScale;
 
-  pSrcGOF = new MVGroupOfFrames(
-    nSuperLevels, analysisData.nWidth, analysisData.nHeight,
-    nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV,
-    _isse, analysisData.xRatioUV, analysisData.yRatioUV, pixelsize, bits_per_pixel, mt_flag
-  );
-  pRefGOF = new MVGroupOfFrames(
-    nSuperLevels, analysisData.nWidth, analysisData.nHeight,
-    nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV,
-    _isse, analysisData.xRatioUV, analysisData.yRatioUV, pixelsize, bits_per_pixel, mt_flag
-  );
+  // A frame is used again as source (or reference) delta frames later, so
+  // the window of consecutive frames spans delta + 1 frames (2 * delta + 1
+  // in multi mode), plus one to absorb the order of the accesses.
+  const int		gof_cache_size =
+    (multi_flag) ? df * 2 + 2 : std::max(df, 0) + 2;
+  for (int gof_cnt = 0; gof_cnt < gof_cache_size; ++gof_cnt)
+  {
+    MVGroupOfFrames *	gof_ptr = new MVGroupOfFrames(
+      nSuperLevels, analysisData.nWidth, analysisData.nHeight,
+      nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV,
+      _isse, analysisData.xRatioUV, analysisData.yRatioUV, pixelsize, bits_per_pixel, mt_flag
+    );
+    _gof_cache.add(gof_ptr);
+    if ((params.param & SuperParams64Bits::PARAM_LAZY_FLAG) != 0)
+    {
+      const int sharp = params.param & SuperParams64Bits::PARAM_SHARP_MASK;
+      gof_ptr->set_lazy_refine(MVPlaneSet(nSuperModeYUV), sharp);
+    }
+  }
+  pSrcGOF = 0;
+  pRefGOF = 0;
 
   analysisData.nBlkSizeX = _blksizex;
   analysisData.nBlkSizeY = _blksizey;
@@ -336,6 +351,10 @@ MVAnalyse::MVAnalyse(
     searchType = VSEARCH;
     nSearchParam = (stp < 1) ? 1 : stp;
     break;
+  case 8:
+    searchType = SEASEARCH;
+    nSearchParam = (stp < 1) ? 1 : stp;
+    break;
   case 2:
   default:
     searchType = LOGARITHMIC;
@@ -432,12 +451,6 @@ MVAnalyse::MVAnalyse(
     analysisDataDivided.nLvCount = analysisData.nLvCount + 1;
   }
 
-  if (_temporal_flag)
-  {
-    _srd_arr[0]._vec_prev.resize(_vectorfields_aptr->GetArraySize()); // array for prev vectors
-  }
-  _srd_arr[0]._vec_prev_frame = -2;
-
   // From this point, analysisData and analysisDataDivided references will
   // become invalid, because of the _srd_arr.resize(). Don't use them any more.
 
@@ -473,6 +486,8 @@ MVAnalyse::MVAnalyse(
 
     vi.num_frames *= _delta_max * 2;
     vi.MulDivFPS(_delta_max * 2, 1);
+
+    _batch_vect_arr.resize(_srd_arr.size() * _vectorfields_aptr->GetArraySize());
   }
 
   // we'll transmit to the processing filters a handle
@@ -498,6 +513,53 @@ MVAnalyse::MVAnalyse(
     vi.sample_type = (int)(p & 0xffffffffUL);
 #endif
   }
+
+  if (_temporal_flag || _multi_flag)
+  {
+    // Everything which can change the vectors. The instances created for
+    // the same call by Avisynth+ (MT_MULTI_INSTANCE) have the same signature.
+    char sig_0[1024];
+    const MVAnalysisData &ad = _srd_arr[0]._analysis_data;
+    sprintf_s(
+      sig_0, sizeof(sig_0),
+      "%d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d "
+      "%d %d %d %d %d %d %d %d %d %d %d",
+      ad.nBlkSizeX, ad.nBlkSizeY, ad.nOverlapX, ad.nOverlapY, ad.nLvCount,
+      ad.nPel, ad.nDeltaFrame, int(ad.isBackward), ad.nFlags,
+      ad.chromaSADScale, int(searchType), nSearchParam, nPelSearch,
+      nLambda, int(lsad), pnew, plevel, int(global), pglobal, pzero,
+      divideExtra, int(badSAD), badrange, int(meander), int(tryMany),
+      int(_multi_flag), _delta_max, _dctmode, _sadx264, cpuFlags,
+      int(_mt_flag), _vectorfields_aptr->GetArraySize(), int(_temporal_flag)
+    );
+    if (_temporal_flag)
+    {
+      _temporal_cache_sptr = TemporalPredCache::use_shared(
+        static_cast <void *> (child), sig_0,
+        int(_srd_arr.size()), _vectorfields_aptr->GetArraySize()
+      );
+      _vec_pred.resize(_vectorfields_aptr->GetArraySize());
+    }
+    if (_multi_flag)
+    {
+      _batch_cache_sptr = BatchVectCache::use_shared(
+        static_cast <void *> (child), sig_0, int(_batch_vect_arr.size())
+      );
+    }
+  }
+
+  if (lstrlen(vectfilename_0) > 0)
+  {
+    _vect_file_aptr = std::unique_ptr<VectFileWriter>(new VectFileWriter);
+    const MVAnalysisData &mad =
+      (divideExtra)
+      ? _srd_arr[0]._analysis_data_divided
+      : _srd_arr[0]._analysis_data;
+    if (!_vect_file_aptr->open(vectfilename_0, vi, mad))
+    {
+      env->ThrowError("MAnalyse: vector file can not be created!");
+    }
+  }
 }
 
 
@@ -512,9 +574,7 @@ MVAnalyse::~MVAnalyse()
     outfilebuf = 0;
   }
 
-  delete pSrcGOF;
   pSrcGOF = 0;
-  delete pRefGOF;
   pRefGOF = 0;
   _RPT1(0, "MAnalyze destroyed %d\n",_instance_id);
 
@@ -531,26 +591,7 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
 
   SrcRefData &	srd = _srd_arr[srd_index];
 
-  const int		nbr_src_frames = child->GetVideoInfo().num_frames;
-  int				minframe;
-  int				maxframe;
-  int				nref;
-  if (srd._analysis_data.nDeltaFrame > 0)
-  {
-    const int		offset =
-      (srd._analysis_data.isBackward)
-      ? srd._analysis_data.nDeltaFrame
-      : -srd._analysis_data.nDeltaFrame;
-    minframe = std::max(-offset, 0);
-    maxframe = nbr_src_frames + std::min(-offset, 0);
-    nref = nsrc + offset;
-  }
-  else // special static mode
-  {
-    nref = -srd._analysis_data.nDeltaFrame;	// positive fixed frame number
-    minframe = 0;
-    maxframe = nbr_src_frames;
-  }
+  GofCache::FrameGuard gof_guard(_gof_cache, nsrc);
 
   PVideoFrame			dst = env->NewVideoFrame(vi); // frameprop inheritance later (if there is source)
   unsigned char *	pDst = dst->GetWritePtr();
@@ -580,26 +621,108 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
   }
   pDst += headerSize;
 
-  if (nsrc < minframe || nsrc >= maxframe)
+  int				nref;
+  const bool		valid_flag = find_ref_frame(nref, nsrc, srd);
+
+  if (_multi_flag)
+  {
+    PVideoFrame	src;
+    if (valid_flag && has_at_least_v8)
+    {
+      src = child->GetFrame(nsrc, env); // v2.0
+      env->copyFrameProps(src, dst); // frame property support
+    }
+    const int		arr_size = _vectorfields_aptr->GetArraySize();
+    if (!_batch_cache_sptr->fetch(
+      nsrc, srd_index * arr_size, arr_size, reinterpret_cast <int *> (pDst)
+    ))
+    {
+      search_batch(nsrc, src, env);
+      memcpy(
+        pDst,
+        &_batch_vect_arr[srd_index * arr_size],
+        arr_size * sizeof(int)
+      );
+    }
+  }
+  else
+  {
+    PVideoFrame	src;
+    if (valid_flag)
+    {
+      src = child->GetFrame(nsrc, env); // v2.0
+      if(has_at_least_v8) env->copyFrameProps(src, dst); // frame property support
+    }
+    search_pair(reinterpret_cast <int *> (pDst), n, nsrc, srd_index, src, env);
+  }
+
+  if (_vect_file_aptr)
+  {
+    if (!_vect_file_aptr->write_frame(n, dst->GetReadPtr(), dst->GetPitch()))
+    {
+      env->ThrowError("MAnalyse: error while writing frame %d to the vector file.", n);
+    }
+  }
+  _RPT3(0, "MAnalyze GetFrame END, frame_nsrc=%d nref=%d id=%d\n", nsrc, nref, _instance_id);
+  return dst;
+}
+
+
+
+// Returns false if the reference frame is out of the clip. In this case the
+// vectors are invalid.
+bool	MVAnalyse::find_ref_frame(int &nref, int nsrc, const SrcRefData &srd) const
+{
+  const int		nbr_src_frames = child->GetVideoInfo().num_frames;
+  int				minframe;
+  int				maxframe;
+  if (srd._analysis_data.nDeltaFrame > 0)
+  {
+    const int		offset =
+      (srd._analysis_data.isBackward)
+      ? srd._analysis_data.nDeltaFrame
+      : -srd._analysis_data.nDeltaFrame;
+    minframe = std::max(-offset, 0);
+    maxframe = nbr_src_frames + std::min(-offset, 0);
+    nref = nsrc + offset;
+  }
+  else // special static mode
+  {
+    nref = -srd._analysis_data.nDeltaFrame;	// positive fixed frame number
+    minframe = 0;
+    maxframe = nbr_src_frames;
+  }
+
+  return (nsrc >= minframe && nsrc < maxframe);
+}
+
+
+
+// Searches the vectors for a single Src/Ref pair.
+// n is the output frame number, for the output file.
+// src is the source frame, it may be empty and is fetched only if needed.
+void	MVAnalyse::search_pair(int *vect_ptr, int n, int nsrc, int srd_index, ::PVideoFrame &src, ::IScriptEnvironment *env)
+{
+  SrcRefData &	srd = _srd_arr[srd_index];
+
+  int				nref;
+  if (!find_ref_frame(nref, nsrc, srd))
   {
     // fill all vectors with invalid data
-    _vectorfields_aptr->WriteDefaultToArray(reinterpret_cast <int *> (pDst));
+    _vectorfields_aptr->WriteDefaultToArray(vect_ptr);
   }
 
   else
   {
 //		DebugPrintf ("MVAnalyse: Get src frame %d",nsrc);
     _RPT3(0, "MAnalyze GetFrame, frame_nsrc=%d nref=%d id=%d\n", nsrc, nref, _instance_id);
-    
-    PVideoFrame	src = child->GetFrame(nsrc, env); // v2.0
-    if(has_at_least_v8) env->copyFrameProps(src, dst); // frame property support
 
-    load_src_frame(*pSrcGOF, src, srd._analysis_data);
+    pSrcGOF = &use_gof(nsrc, src, srd._analysis_data, env);
 
 //		DebugPrintf ("MVAnalyse: Get ref frame %d", nref);
 //		DebugPrintf ("MVAnalyse frame %i backward=%i", nsrc, srd._analysis_data.isBackward);
-    ::PVideoFrame	ref = child->GetFrame(nref, env); // v2.0
-    load_src_frame(*pRefGOF, ref, srd._analysis_data);
+    ::PVideoFrame	ref;
+    pRefGOF = &use_gof(nref, ref, srd._analysis_data, env);
 
     const int		fieldShift = ClipFnc::compute_fieldshift(
       child,
@@ -614,17 +737,17 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
       fwrite(&n, sizeof(int), 1, outfile);	// write frame number
     }
 
-    // temporal predictor dst if prev frame was really prev
+    // temporal predictor from the closest frame already analysed
     int *			pVecPrevOrNull = 0;
-    if (_temporal_flag && srd._vec_prev_frame == nsrc - 1)
+    if (_temporal_flag && _temporal_cache_sptr->fetch(nsrc, srd_index, &_vec_pred[0]))
     {
-      pVecPrevOrNull = &srd._vec_prev[0];
+      pVecPrevOrNull = &_vec_pred[0];
     }
 
     _vectorfields_aptr->SearchMVs(
       pSrcGOF, pRefGOF,
       searchType, nSearchParam, nPelSearch, nLambda, lsad, pnew, plevel,
-      global, srd._analysis_data.nFlags, reinterpret_cast<int*>(pDst),
+      global, srd._analysis_data.nFlags, vect_ptr,
       outfilebuf, fieldShift, pzero, pglobal, badSAD, badrange,
       meander, pVecPrevOrNull, tryMany
     );
@@ -634,7 +757,7 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
       // make extra level with divided sublocks with median (not estimated)
       // motion
       _vectorfields_aptr->ExtraDivide(
-        reinterpret_cast <int *> (pDst),
+        vect_ptr,
         srd._analysis_data.nFlags
       );
     }
@@ -650,20 +773,65 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
         outfile
       );
     }
+
+    if (_temporal_flag)
+    {
+      // store the vectors for use as predictor in the neighbour frames
+      _temporal_cache_sptr->store(nsrc, srd_index, vect_ptr);
+    }
   }
+}
+
+
 
-  if (_temporal_flag)
+// Multi mode: searches the vectors of all the Src/Ref pairs for the source
+// frame nsrc into _batch_vect_arr, and shares them with the other instances.
+// The pairs are searched in a row, so the source GOF is set up once and its
+// planes are still in the cache for the next pair.
+// src is the source frame, it may be empty and is fetched only if needed.
+// Must be called after a failed _batch_cache_sptr->fetch().
+void	MVAnalyse::search_batch(int nsrc, ::PVideoFrame &src, ::IScriptEnvironment *env)
+{
+  const int		ndiv = int(_srd_arr.size());
+  const int		arr_size = _vectorfields_aptr->GetArraySize();
+  try
   {
-    // store previous vectors for use as predictor in next frame
-    memcpy(
-      &srd._vec_prev[0],
-      reinterpret_cast <int *> (pDst),
-      _vectorfields_aptr->GetArraySize()
-    );
-    srd._vec_prev_frame = nsrc;
+    for (int srd_index = 0; srd_index < ndiv; ++srd_index)
+    {
+      search_pair(
+        &_batch_vect_arr[srd_index * arr_size],
+        nsrc * ndiv + srd_index, nsrc, srd_index,
+        src, env
+      );
+    }
   }
-  _RPT3(0, "MAnalyze GetFrame END, frame_nsrc=%d nref=%d id=%d\n", nsrc, nref, _instance_id);
-  return dst;
+  catch (...)
+  {
+    // Lets the waiting instances search the vectors themselves
+    _batch_cache_sptr->cancel(nsrc);
+    throw;
+  }
+  _batch_cache_sptr->store(nsrc, &_batch_vect_arr[0]);
+}
+
+
+
+// Returns the GOF of the super frame n, set up. frame is the super frame, it
+// may be empty and is fetched only if the GOF is not in the cache.
+MVGroupOfFrames &	MVAnalyse::use_gof(int n, ::PVideoFrame &frame, const MVAnalysisData &ana_data, ::IScriptEnvironment *env)
+{
+  MVGroupOfFrames *	gof_ptr = _gof_cache.find(n);
+  if (gof_ptr == 0)
+  {
+    if (!frame)
+    {
+      frame = child->GetFrame(n, env); // v2.0
+    }
+    gof_ptr = &_gof_cache.assign(n, frame);
+    load_src_frame(*gof_ptr, frame, ana_data);
+  }
+
+  return *gof_ptr;
 }
 
 
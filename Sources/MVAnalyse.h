@@ -26,8 +26,12 @@
 
 #include "conc/ObjPool.h"
 #include "DCTFactory.h"
+#include "GofCache.h"
 #include "GroupOfPlanes.h"
 #include "MVAnalysisData.h"
+#include "TemporalPredCache.h"
+#include "BatchVectCache.h"
+#include "VectFileWriter.h"
 #include "yuy2planes.h"
 
 #include "Windows.h"
@@ -54,15 +58,19 @@ protected:
   public:
     MVAnalysisData _analysis_data;
     MVAnalysisData _analysis_data_divided;
-
-    std::vector<int> _vec_prev;
-    int _vec_prev_frame;
   };
 
   typedef std::vector<SrcRefData> SrcRefArray;
 
   SrcRefArray _srd_arr;
 
+  // Multi mode: all the Src/Ref pairs of a source frame are searched at once,
+  // the source frame is fetched and loaded only once. The results are shared
+  // with the other instances of the same filter until the other output
+  // frames of the group are requested. 0 if not multi.
+  BatchVectCache::SPtr _batch_cache_sptr;
+  std::vector<int> _batch_vect_arr; // One vector array per Src/Ref pair, in _srd_arr order
+
   /*! \brief Frames of blocks for which motion vectors will be computed */
   std::unique_ptr<GroupOfPlanes> _vectorfields_aptr; // Temporary data, structure initialised once.
 
@@ -95,6 +103,11 @@ protected:
   bool tryMany; // try refine around many predictors
   const bool _multi_flag;
   const bool _temporal_flag;
+
+  // Temporal predictors: final vectors of the recent source frames, shared
+  // with the other instances of the same filter. 0 if not temporal.
+  TemporalPredCache::SPtr _temporal_cache_sptr;
+  std::vector<int> _vec_pred; // Predictor for the current search
   const bool _mt_flag;
 
   int pixelsize; // PF
@@ -103,6 +116,8 @@ protected:
   FILE *outfile;
   short * outfilebuf;
 
+  std::unique_ptr<VectFileWriter> _vect_file_aptr; // Indexed vector file, for MLoadVect. 0 if not used
+
   //	YUY2Planes * SrcPlanes;
   //	YUY2Planes * RefPlanes;
 
@@ -111,7 +126,11 @@ protected:
 
   int headerSize;
 
-  MVGroupOfFrames *pSrcGOF, *pRefGOF; //v2.0. Temporary data, structure initialised once.
+  // Source and reference GOFs of the current search, from _gof_cache.
+  // The reference of a frame is the source of another one, the GOF can be
+  // used again without being set up.
+  GofCache _gof_cache;
+  MVGroupOfFrames *pSrcGOF, *pRefGOF;
 
   int nModeYUV;
 
@@ -126,20 +145,27 @@ public:
     int _overlapx, int _overlapy, const char* _outfilename, int _dctmode,
     int _divide, int _sadx264, sad_t _badSAD, int _badrange, bool _isse,
     bool _meander, bool temporal_flag, bool _tryMany, bool multi_flag,
-    bool mt_flag, int _chromaSADScale, IScriptEnvironment* env);
+    bool mt_flag, int _chromaSADScale, const char *vectfilename_0,
+    IScriptEnvironment* env);
   ~MVAnalyse();
 
   ::PVideoFrame __stdcall	GetFrame(int n, ::IScriptEnvironment* env) override;
 
   int __stdcall SetCacheHints(int cachehints, int frame_range) override {
-    return cachehints == CACHE_GET_MTMODE ? (_temporal_flag || lstrlen(outfilename)>0 ? MT_SERIALIZED : MT_MULTI_INSTANCE) : 0;
+    return cachehints == CACHE_GET_MTMODE ? (lstrlen(outfilename)>0 || _vect_file_aptr ? MT_SERIALIZED : MT_MULTI_INSTANCE) : 0;
     // adaptive!
-    // temporal = true or using output file is not MT-friendly
+    // using output file is not MT-friendly. temporal = true is fine, the
+    // predictors are shared between the instances, as well as the multi
+    // mode batches.
   }
 
 private:
 
   void load_src_frame(MVGroupOfFrames &gof, ::PVideoFrame &src, const MVAnalysisData &ana_data);
+  MVGroupOfFrames & use_gof(int n, ::PVideoFrame &frame, const MVAnalysisData &ana_data, ::IScriptEnvironment *env);
+  bool find_ref_frame(int &nref, int nsrc, const SrcRefData &srd) const;
+  void search_pair(int *vect_ptr, int n, int nsrc, int srd_index, ::PVideoFrame &src, ::IScriptEnvironment *env);
+  void search_batch(int nsrc, ::PVideoFrame &src, ::IScriptEnvironment *env);
 };
 
 #endif
@@ -130,6 +130,11 @@ MVBlockFps::MVBlockFps(
 
   pRefBGOF = new MVGroupOfFrames(nSuperLevels, nWidth, nHeight, nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV, cpuFlags, xRatioUVs[1], yRatioUVs[1], pixelsize_super, bits_per_pixel_super, mt_flag);
   pRefFGOF = new MVGroupOfFrames(nSuperLevels, nWidth, nHeight, nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV, cpuFlags, xRatioUVs[1], yRatioUVs[1], pixelsize_super, bits_per_pixel_super, mt_flag);
+  if ((params.param & SuperParams64Bits::PARAM_LAZY_FLAG) != 0)
+  {
+    pRefBGOF->set_lazy_refine(MVPlaneSet(nSuperModeYUV), params.param & SuperParams64Bits::PARAM_SHARP_MASK);
+    pRefFGOF->set_lazy_refine(MVPlaneSet(nSuperModeYUV), params.param & SuperParams64Bits::PARAM_SHARP_MASK);
+  }
   int nSuperWidth = super->GetVideoInfo().width;
   int nSuperHeight = super->GetVideoInfo().height;
 
@@ -150,7 +155,9 @@ MVBlockFps::MVBlockFps(
   // OverlapsFunction
   // in M(V)DegrainX: DenoiseXFunction
   arch_t arch;
-  if ((cpuFlags & CPUF_AVX2) != 0)
+  if ((cpuFlags & CPUF_AVX512F) != 0 && (cpuFlags & CPUF_AVX512BW) != 0)
+    arch = USE_AVX512;
+  else if ((cpuFlags & CPUF_AVX2) != 0)
     arch = USE_AVX2;
   else if ((cpuFlags & CPUF_AVX) != 0)
     arch = USE_AVX;
@@ -27,6 +27,7 @@ MVClip::MVClip(const PClip &vectors, sad_t _nSCD1, int _nSCD2, IScriptEnvironmen
 ,	_group_len (group_len)
 ,	_group_ofs (group_ofs)
 ,	_frame_update_flag (true)
+,	_vec_frame ()
 {
 	vi.num_frames = (vi.num_frames - group_ofs + group_len - 1) / group_len;
 	vi.MulDivFPS (1, group_len);
@@ -216,6 +217,7 @@ void MVClip::Update (PVideoFrame &fn, IScriptEnvironment *env)
 	const int		hs_i32 = header_size / sizeof(int);
 	pMv       += hs_i32;									// go to data - v1.8.1
 	data_size -= hs_i32;
+	_vec_frame = fn;	// planes point into the frame data, no copy
   const bool		ok_flag = FakeGroupOfPlanes::Update(pMv, data_size);	// fixed a bug with lost frames
 	if (! ok_flag)
 	{
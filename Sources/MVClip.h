@@ -59,6 +59,10 @@ class MVClip
 	int				_group_ofs;
 	bool				_frame_update_flag;
 
+	// Vector frame of the last Update(). FakePlaneOfBlocks reads the vectors
+	// directly from it, so it must stay alive until the next Update().
+	::PVideoFrame	_vec_frame;
+
 public :
 	MVClip(const PClip &vectors, sad_t nSCD1, int nSCD2, IScriptEnvironment *env, int group_len, int group_ofs);
    ~MVClip();
@@ -82,7 +86,7 @@ public :
    MV_FORCEINLINE int GetVPadding() const { return nVPadding; }
    MV_FORCEINLINE sad_t GetThSCD1() const { return nSCD1; }
    MV_FORCEINLINE int GetThSCD2() const { return nSCD2; }
-   MV_FORCEINLINE const FakeBlockData& GetBlock(int nLevel, int nBlk) const { return GetPlane(nLevel)[nBlk]; }
+   MV_FORCEINLINE FakeBlockData GetBlock(int nLevel, int nBlk) const { return GetPlane(nLevel)[nBlk]; }
    bool IsUsable(sad_t nSCD1_, int nSCD2_) const;
    bool IsUsable() const { return IsUsable(nSCD1, nSCD2); }
    bool IsSceneChange() const { return FakeGroupOfPlanes::IsSceneChange(nSCD1, nSCD2); }
@@ -25,6 +25,7 @@
 #include "MVFrame.h"
 #include	"MVGroupOfFrames.h"
 #include "MVPlane.h"
+#include "overlap_avx2.h"
 #include "profile.h"
 #include "SuperParams64Bits.h"
 #include "Time256ProviderCst.h"
@@ -37,7 +38,7 @@ MVCompensate::MVCompensate(
   PClip _child, PClip _super, PClip vectors, bool sc, double _recursionPercent,
   sad_t _thsad, bool _fields, double _time100, sad_t _nSCD1, int _nSCD2, bool _isse2, bool _planar,
   bool mt_flag, int trad, bool center_flag, PClip cclip_sptr, sad_t _thsad2,
-  IScriptEnvironment* env_ptr
+  bool static_flag, bool batch_flag, IScriptEnvironment* env_ptr
 )
   : GenericVideoFilter(_child)
   , _mv_clip_arr(1)
@@ -48,6 +49,13 @@ MVCompensate::MVCompensate(
   , _multi_flag(trad > 0)
   , _center_flag(center_flag)
   , _mt_flag(mt_flag)
+  , _static_flag(static_flag)
+  , _batch_flag(false)
+  , _batch_nsrc(-1)
+  , _batch_frame_arr()
+  , _vx_ptr(0)
+  , _vy_ptr(0)
+  , _sad_ptr(0)
   //,	nLogxRatioUV (( xRatioUV == 2) ? 1 : 0) MVFilter has nLogxRatioUV
   //,	nLogyRatioUV ((yRatioUV == 2) ? 1 : 0)
   , _boundary_cnt_arr()
@@ -115,6 +123,13 @@ MVCompensate::MVCompensate(
 
   scBehavior = sc;
   recursion = std::max(0, std::min(256, int(_recursionPercent / 100 * 256))); // convert to int scaled 0 to 256
+
+  // Recursion depends on the request order, it cannot be batched.
+  _batch_flag = (batch_flag && _multi_flag && recursion == 0);
+  if (_batch_flag)
+  {
+    _batch_frame_arr.resize(_trad * 2);
+  }
   fields = _fields;
   planar = _planar;
 
@@ -149,7 +164,9 @@ MVCompensate::MVCompensate(
   }
 
   arch_t arch;
-  if ((cpuFlags & CPUF_AVX2) != 0)
+  if ((cpuFlags & CPUF_AVX512F) != 0 && (cpuFlags & CPUF_AVX512BW) != 0)
+    arch = USE_AVX512;
+  else if ((cpuFlags & CPUF_AVX2) != 0)
     arch = USE_AVX2;
   else if ((cpuFlags & CPUF_AVX) != 0)
     arch = USE_AVX;
@@ -189,8 +206,31 @@ MVCompensate::MVCompensate(
   if (!vi.IsSameColorspace(_super->GetVideoInfo()))
     env_ptr->ThrowError("MCompensate : source and super clip video format is different!");
 
-  pRefGOF = new MVGroupOfFrames(nSuperLevels, nWidth, nHeight, nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV, cpuFlags, xRatioUVs[1], yRatioUVs[1], pixelsize_super, bits_per_pixel_super, mt_flag);
-  pSrcGOF = new MVGroupOfFrames(nSuperLevels, nWidth, nHeight, nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV, cpuFlags, xRatioUVs[1], yRatioUVs[1], pixelsize_super, bits_per_pixel_super, mt_flag);
+  // A super frame is used again up to 2 * delta frames later
+  int delta_max = 1;
+  for (int k = 0; k < int(_mv_clip_arr.size()); ++k)
+  {
+    delta_max = std::max(delta_max, _mv_clip_arr[k]._clip_sptr->GetDeltaFrame());
+  }
+  const int gof_cache_size = delta_max * 2 + 2;
+  for (int gof_cnt = 0; gof_cnt <= gof_cache_size; ++gof_cnt)
+  {
+    MVGroupOfFrames *gof_ptr = new MVGroupOfFrames(nSuperLevels, nWidth, nHeight, nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV, cpuFlags, xRatioUVs[1], yRatioUVs[1], pixelsize_super, bits_per_pixel_super, mt_flag);
+    if ((params.param & SuperParams64Bits::PARAM_LAZY_FLAG) != 0)
+    {
+      gof_ptr->set_lazy_refine(MVPlaneSet(nSuperModeYUV), params.param & SuperParams64Bits::PARAM_SHARP_MASK);
+    }
+    if (gof_cnt < gof_cache_size)
+    {
+      _gof_cache.add(gof_ptr);
+    }
+    else
+    {
+      pLoopGOF = gof_ptr;
+    }
+  }
+  pRefGOF = 0;
+  pSrcGOF = 0;
   nSuperWidth = super->GetVideoInfo().width;
   nSuperHeight = super->GetVideoInfo().height;
 
@@ -271,8 +311,7 @@ MVCompensate::~MVCompensate()
       _aligned_free(DstShortV);
     }
   }
-  delete pRefGOF; // v2.0
-  delete pSrcGOF;
+  delete pLoopGOF; // v2.0
 
   if (recursion > 0)
   {
@@ -295,6 +334,46 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
   {
     return (_cclip_sptr->GetFrame(nsrc, env_ptr));
   }
+
+  if (!_batch_flag)
+  {
+    GofCache::FrameGuard gof_guard(_gof_cache, nsrc);
+    return (compensate_frame(nsrc, nvec, vindex, env_ptr));
+  }
+
+  // Batch mode: the first request for a source frame compensates all its
+  // neighbours. The source super frame and its GOF are loaded once and
+  // shared through _gof_cache, as well as the overlap buffers.
+  if (nsrc != _batch_nsrc)
+  {
+    _batch_nsrc = -1; // In case of exception
+    GofCache::FrameGuard gof_guard(_gof_cache, nsrc);
+    for (int k = 0; k < _trad * 2; ++k)
+    {
+      _batch_frame_arr[k] = 0;
+    }
+    for (int k = 0; k < _trad * 2; ++k)
+    {
+      // Each output frame has its own vector frame index when center=false
+      int nsrc_k;
+      int nvec_k;
+      int vindex_k;
+      compute_src_frame(nsrc_k, nvec_k, vindex_k, compute_output_index(nsrc, k));
+      assert(nsrc_k == nsrc && vindex_k == k);
+      _batch_frame_arr[k] = compensate_frame(nsrc_k, nvec_k, vindex_k, env_ptr);
+    }
+    _batch_nsrc = nsrc;
+  }
+
+  return (_batch_frame_arr[vindex]);
+}
+
+
+
+// Compensates the source frame nsrc with the vector clip vindex, read at
+// frame nvec.
+PVideoFrame MVCompensate::compensate_frame(int nsrc, int nvec, int vindex, IScriptEnvironment* env_ptr)
+{
   MvClipInfo &info = _mv_clip_arr[vindex];
   _mv_clip_ptr = info._clip_sptr.get();
   _thsad = info._thsad;
@@ -401,13 +480,24 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
         else // pixelsize == 4
           Blend<float>(pLoop[i], pLoop[i], pRef[i], nSuperHeight >> nLogyRatioUVs[i], nSuperWidth >> nLogxRatioUVs[i], nLoopPitches[i], nLoopPitches[i], nRefPitches[i], time256, cpuFlags);
       }
+      pRefGOF = pLoopGOF;
       pRefGOF->Update(YUVPLANES, (BYTE*)pLoop[0], nLoopPitches[0], (BYTE*)pLoop[1], nLoopPitches[1], (BYTE*)pLoop[2], nLoopPitches[2]);
     }
     else
     {
-      pRefGOF->Update(YUVPLANES, (BYTE*)pRef[0], nRefPitches[0], (BYTE*)pRef[1], nRefPitches[1], (BYTE*)pRef[2], nRefPitches[2]);// v2.0
+      pRefGOF = _gof_cache.find(nref);
+      if (pRefGOF == 0)
+      {
+        pRefGOF = &_gof_cache.assign(nref, ref);
+        pRefGOF->Update(YUVPLANES, (BYTE*)pRef[0], nRefPitches[0], (BYTE*)pRef[1], nRefPitches[1], (BYTE*)pRef[2], nRefPitches[2]);// v2.0
+      }
+    }
+    pSrcGOF = _gof_cache.find(nsrc);
+    if (pSrcGOF == 0)
+    {
+      pSrcGOF = &_gof_cache.assign(nsrc, src);
+      pSrcGOF->Update(YUVPLANES, (BYTE*)pSrc[0], nSrcPitches[0], (BYTE*)pSrc[1], nSrcPitches[1], (BYTE*)pSrc[2], nSrcPitches[2]);
     }
-    pSrcGOF->Update(YUVPLANES, (BYTE*)pSrc[0], nSrcPitches[0], (BYTE*)pSrc[1], nSrcPitches[1], (BYTE*)pSrc[2], nSrcPitches[2]);
 
     pPlanes[0] = pRefGOF->GetFrame(0)->GetPlane(YPLANE);
     pSrcPlanes[0] = pSrcGOF->GetFrame(0)->GetPlane(YPLANE);
@@ -442,6 +532,15 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
     // No overlap
     if (nOverlapX == 0 && nOverlapY == 0)
     {
+      if (_static_flag)
+      {
+        // Built here, before the threads
+        const FakePlaneOfBlocks &plane = _mv_clip_ptr->GetPlane(0);
+        _vx_ptr = plane.GetArrayVx();
+        _vy_ptr = plane.GetArrayVy();
+        _sad_ptr = plane.GetArraySAD();
+      }
+
       slicer.start(nBlkY, *this, &MVCompensate::compensate_slice_normal);
       slicer.wait();
     }
@@ -464,12 +563,30 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
       if (pPlanes[2])
         MemZoneSet(reinterpret_cast<unsigned char*>(DstShortV), 0, (nWidth_B * ovrBufferElementSize) >> nLogxRatioUVs[2], nHeight_B >> nLogyRatioUVs[2], 0, 0, dstShortPitchUV * ovrBufferElementSize);
 
-      slicer.start(nBlkY, *this, &MVCompensate::compensate_slice_overlap, 2);
-      slicer.wait();
+      // Wide frames: rectangular tiles keep the reference area read by
+      // each thread in the cache
+      if (Tiler::is_worth(_mt_flag, nBlkX, nBlkSizeX - nOverlapX))
+      {
+        Tiler tiler(_mt_flag);
+        tiler.start(nBlkX, nBlkY, nBlkSizeX - nOverlapX, nBlkSizeY - nOverlapY, *this, &MVCompensate::compensate_slice_overlap);
+        tiler.wait();
+      }
+      else
+      {
+        slicer.start(nBlkY, *this, &MVCompensate::compensate_slice_overlap, 2);
+        slicer.wait();
+      }
 
       if (pixelsize_super == 1) {
         // nWidth_B and nHeight_B, right and bottom was blended
-        if ((cpuFlags & CPUF_SSE2) != 0) {
+        if ((cpuFlags & CPUF_AVX2) != 0) {
+          Short2Bytes_avx2(pDst[0], nDstPitches[0], (uint16_t *)DstShort, dstShortPitch, nWidth_B, nHeight_B);
+          if (pPlanes[1])
+            Short2Bytes_avx2(pDst[1], nDstPitches[1], (uint16_t *)DstShortU, dstShortPitchUV, nWidth_B >> nLogxRatioUVs[1], nHeight_B >> nLogyRatioUVs[1]);
+          if (pPlanes[2])
+            Short2Bytes_avx2(pDst[2], nDstPitches[2], (uint16_t *)DstShortV, dstShortPitchUV, nWidth_B >> nLogxRatioUVs[2], nHeight_B >> nLogyRatioUVs[2]);
+        }
+        else if ((cpuFlags & CPUF_SSE2) != 0) {
           Short2Bytes_sse2(pDst[0], nDstPitches[0], (uint16_t *)DstShort, dstShortPitch, nWidth_B, nHeight_B);
           if (pPlanes[1])
             Short2Bytes_sse2(pDst[1], nDstPitches[1], (uint16_t *)DstShortU, dstShortPitchUV, nWidth_B >> nLogxRatioUVs[1], nHeight_B >> nLogyRatioUVs[1]);
@@ -486,7 +603,14 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
       }
       else if (pixelsize_super == 2)
       {
-        if ((cpuFlags & CPUF_SSE4_1) != 0) {
+        if ((cpuFlags & CPUF_AVX2) != 0) {
+          Short2Bytes_Int32toWord16_avx2((uint16_t *)(pDst[0]), nDstPitches[0], (int *)DstShort, dstShortPitch, nWidth_B, nHeight_B, bits_per_pixel_super);
+          if (pPlanes[1])
+            Short2Bytes_Int32toWord16_avx2((uint16_t *)(pDst[1]), nDstPitches[1], (int *)DstShortU, dstShortPitchUV, nWidth_B >> nLogxRatioUVs[1], nHeight_B >> nLogyRatioUVs[1], bits_per_pixel_super);
+          if (pPlanes[2])
+            Short2Bytes_Int32toWord16_avx2((uint16_t *)(pDst[2]), nDstPitches[2], (int *)DstShortV, dstShortPitchUV, nWidth_B >> nLogxRatioUVs[2], nHeight_B >> nLogyRatioUVs[2], bits_per_pixel_super);
+        }
+        else if ((cpuFlags & CPUF_SSE4_1) != 0) {
           Short2Bytes_Int32toWord16_sse4((uint16_t *)(pDst[0]), nDstPitches[0], (int *)DstShort, dstShortPitch, nWidth_B, nHeight_B, bits_per_pixel_super);
           if (pPlanes[1])
             Short2Bytes_Int32toWord16_sse4((uint16_t *)(pDst[1]), nDstPitches[1], (int *)DstShortU, dstShortPitchUV, nWidth_B >> nLogxRatioUVs[1], nHeight_B >> nLogyRatioUVs[1], bits_per_pixel_super);
@@ -642,6 +766,47 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
 
 
 
+int	MVCompensate::classify_block(int index) const
+{
+  if (_sad_ptr[index] >= _thsad)
+  {
+    return BlkClass_SOURCE;
+  }
+  if ((_vx_ptr[index] | _vy_ptr[index]) == 0)
+  {
+    return BlkClass_STATIC;
+  }
+  return BlkClass_MOVING;
+}
+
+
+
+// Copies nbr_blk consecutive blocks of a row, with a zero vector, from the
+// full-pel planes of the reference or the source.
+void	MVCompensate::copy_block_run(BYTE *pDstCur[3], int xx, MVPlane * const planes[3], int bx, int by, int nbr_blk)
+{
+  const int blx = bx * nBlkSizeX * nPel;
+  const int bly = by * nBlkSizeY * nPel;
+  const int width = nbr_blk * nBlkSizeX;
+  BitBlt(
+    pDstCur[0] + xx, nDstPitches[0],
+    planes[0]->GetPointer(blx, bly), planes[0]->GetPitch(),
+    width << pixelsize_super_shift, nBlkSizeY
+  );
+  for (int i = 1; i < planecount; i++) {
+    if (planes[i])
+    {
+      BitBlt(
+        pDstCur[i] + (xx >> nLogxRatioUVs[i]), nDstPitches[i],
+        planes[i]->GetPointer(blx >> nLogxRatioUVs[i], bly >> nLogyRatioUVs[i]), planes[i]->GetPitch(),
+        (width >> nLogxRatioUVs[i]) << pixelsize_super_shift, nBlkSizeY >> nLogyRatioUVs[i]
+      );
+    }
+  }
+}
+
+
+
 void	MVCompensate::compensate_slice_normal(Slicer::TaskData &td)
 {
   assert(&td != 0);
@@ -659,12 +824,37 @@ void	MVCompensate::compensate_slice_normal(Slicer::TaskData &td)
     SrcCurPitches[i] = rowsize * nSrcPitches[i];
   }
 
+  const bool static_flag = (_static_flag && fieldShift == 0);
+
   for (int by = td._y_beg; by < td._y_end; ++by)
   {
     int xx = 0; // pixelsize-aware, no need to multiply inside
     for (int bx = 0; bx < nBlkX; ++bx)
     {
       const int index = by * nBlkX + bx;
+      if (static_flag)
+      {
+        const int blk_class = classify_block(index);
+        if (blk_class != BlkClass_MOVING)
+        {
+          // Collects the following blocks of the same class and copies
+          // them at once, they are contiguous in the reference or source.
+          int bx_end = bx + 1;
+          while (bx_end < nBlkX && classify_block(index + bx_end - bx) == blk_class)
+          {
+            ++bx_end;
+          }
+          const int nbr_blk = bx_end - bx;
+          copy_block_run(
+            pDstCur, xx, (blk_class == BlkClass_STATIC) ? pPlanes : pSrcPlanes,
+            bx, by, nbr_blk
+          );
+          xx += (nbr_blk * nBlkSizeX) << pixelsize_super_shift;
+          bx = bx_end - 1;
+          continue;
+        }
+      }
+
       const FakeBlockData &block = _mv_clip_ptr->GetBlock(0, index);
       /*
       blx = block.GetX() * nPel + block.GetMV().x * time256 / 256;
@@ -726,14 +916,14 @@ void	MVCompensate::compensate_slice_overlap(Slicer::TaskData &td)
   if (nOverlapY == 0
     || (td._y_beg == 0 && td._y_end == nBlkY))
   {
-    compensate_slice_overlap(td._y_beg, td._y_end);
+    compensate_slice_overlap(td._y_beg, td._y_end, 0, nBlkX);
   }
 
   else
   {
     assert(td._y_end - td._y_beg >= 2);
 
-    compensate_slice_overlap(td._y_beg, td._y_end - 1);
+    compensate_slice_overlap(td._y_beg, td._y_end - 1, 0, nBlkX);
 
     const conc::AioAdd <int> inc_ftor(+1);
 
@@ -743,7 +933,7 @@ void	MVCompensate::compensate_slice_overlap(Slicer::TaskData &td)
     );
     if (td._y_beg > 0 && cnt_top == 2)
     {
-      compensate_slice_overlap(td._y_beg - 1, td._y_beg);
+      compensate_slice_overlap(td._y_beg - 1, td._y_beg, 0, nBlkX);
     }
 
     int cnt_bot = 2;
@@ -756,14 +946,14 @@ void	MVCompensate::compensate_slice_overlap(Slicer::TaskData &td)
     }
     if (cnt_bot == 2)
     {
-      compensate_slice_overlap(td._y_end - 1, td._y_end);
+      compensate_slice_overlap(td._y_end - 1, td._y_end, 0, nBlkX);
     }
   }
 }
 
 
 
-void	MVCompensate::compensate_slice_overlap(int y_beg, int y_end)
+void	MVCompensate::compensate_slice_overlap(int y_beg, int y_end, int x_beg, int x_end)
 {
   int rowsizes[3];
 
@@ -799,8 +989,8 @@ void	MVCompensate::compensate_slice_overlap(int y_beg, int y_end)
     */
 
     int wby = (by == 0) ? 0 * 3 : (by == nBlkY - 1) ? 2 * 3 : 1 * 3; // 0 for very first, 2*3 for very last, 1*3 for all others in the middle
-    int xx = 0; // xx is pixelsize-aware
-    for (int bx = 0; bx < nBlkX; ++bx)
+    int xx = (x_beg * (nBlkSizeX - nOverlapX)) << ovrBufferElementSize_shift; // xx is pixelsize-aware
+    for (int bx = x_beg; bx < x_end; ++bx)
     {
       // select window
       // indexing overlap windows weighting table: left=+0 middle=+1 rightmost=+2
@@ -993,3 +1183,26 @@ bool MVCompensate::compute_src_frame(int &nsrc, int &nvec, int &vindex, int n) c
 
 
 
+// Inverse of compute_src_frame() in multi mode: output frame of the source
+// frame nsrc compensated with the vector clip vindex.
+int MVCompensate::compute_output_index(int nsrc, int vindex) const
+{
+  assert(_multi_flag);
+  assert(nsrc >= 0);
+  assert(vindex >= 0 && vindex < _trad * 2);
+
+  if (_center_flag)
+  {
+    const int tbsize = _trad * 2 + 1;
+    // vindex = td * 2 - 1 after the center, td * 2 - 2 before
+    const int offset = ((vindex & 1) != 0)
+      ? _trad + (vindex + 1) / 2
+      : _trad - (vindex / 2 + 1);
+    return nsrc * tbsize + offset;
+  }
+
+  return nsrc * (_trad * 2) + vindex;
+}
+
+
+
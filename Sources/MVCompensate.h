@@ -3,7 +3,9 @@
 
 #include	"conc/AtomicInt.h"
 #include "CopyCode.h"
+#include "GofCache.h"
 #include	"MTSlicer.h"
+#include	"MTTiler.h"
 #include "MVClip.h"
 #include "MVFilter.h"
 #include "overlap.h"
@@ -30,13 +32,17 @@ public:
 		PClip _child, PClip _super, PClip vectors, bool sc, double _recursionPercent,
 		sad_t thsad, bool _fields, double _time100, sad_t nSCD1, int nSCD2, bool isse2, bool _planar,
 		bool mt_flag, int trad, bool center_flag, PClip cclip_sptr, sad_t thsad2,
-		IScriptEnvironment* env_ptr
+		bool static_flag, bool batch_flag, IScriptEnvironment* env_ptr
 	);
 	~MVCompensate();
 	PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) override;
 
+  // In batch mode, consecutive output frames must reach the same instance
+  // to share its batch.
   int __stdcall SetCacheHints(int cachehints, int frame_range) override {
-    return cachehints == CACHE_GET_MTMODE ? MT_MULTI_INSTANCE : 0;
+    if (cachehints == CACHE_GET_MTMODE)
+      return _batch_flag ? MT_SERIALIZED : MT_MULTI_INSTANCE;
+    return 0;
   }
 
 private:
@@ -52,11 +58,24 @@ private:
 	typedef	std::vector <MvClipInfo>	MvClipArray;
 
 	typedef	MTSlicer <MVCompensate>	Slicer;
+	typedef	MTTiler <MVCompensate>	Tiler;
 
+	enum BlkClass
+	{
+		BlkClass_MOVING = 0,
+		BlkClass_STATIC,  // Zero vector, copied from the reference
+		BlkClass_SOURCE   // Over thSAD, copied from the source
+	};
+
+	MV_FORCEINLINE int
+	               classify_block (int index) const;
+	PVideoFrame    compensate_frame (int nsrc, int nvec, int vindex, IScriptEnvironment* env_ptr);
+	void           copy_block_run (BYTE *pDstCur[3], int xx, MVPlane * const planes[3], int bx, int by, int nbr_blk);
 	void           compensate_slice_normal (Slicer::TaskData &td);
 	void           compensate_slice_overlap (Slicer::TaskData &td);
-	void           compensate_slice_overlap (int y_beg, int y_end);
+	void           compensate_slice_overlap (int y_beg, int y_end, int x_beg, int x_end);
 	bool           compute_src_frame (int &nsrc, int &nvec, int &vindex, int n) const;
+	int            compute_output_index (int nsrc, int vindex) const;
 
 	MvClipArray    _mv_clip_arr;
 	bool scBehavior;
@@ -93,8 +112,10 @@ private:
 	int nSuperHeight;
 	int nSuperHPad;
 	int nSuperVPad;
-	MVGroupOfFrames *pRefGOF;
-	MVGroupOfFrames *pSrcGOF;
+	GofCache _gof_cache; // Super frames, keyed by frame number. A reference is often used again as source.
+	MVGroupOfFrames *pLoopGOF; // Recursion: blended reference, not cached
+	MVGroupOfFrames *pRefGOF; // From _gof_cache or pLoopGOF
+	MVGroupOfFrames *pSrcGOF; // From _gof_cache
 
 	unsigned char *pLoop[3];
 	int nLoopPitches[3];
@@ -105,10 +126,18 @@ private:
 	bool           _center_flag;  // Indicates if the output frames should be in the order -tr, ..., -1, C, +1, ..., +tr (true) or -1, +1, -2, +2,..., -tr, +tr (false).
 
 	bool           _mt_flag;
+	bool           _static_flag;  // Static block fast path: runs of co-located blocks are copied at once. No overlap only.
+	bool           _batch_flag;   // Temporal radius mode: all the compensated frames of a source frame are computed on its first request.
+	int            _batch_nsrc;   // Source frame of _batch_frame_arr, -1 = none
+	std::vector <PVideoFrame>
+	               _batch_frame_arr; // Compensated frames of _batch_nsrc, indexed by vector clip
 
 	// Processing variables
 	MVClip *       _mv_clip_ptr;  // Vector clip used to process this frame
 	sad_t            _thsad;
+	const int *    _vx_ptr;       // Vectors of _mv_clip_ptr, for the static blocks
+	const int *    _vy_ptr;
+	const sad_t *  _sad_ptr;
 // const int xSubUV; // PF mvfilter has nLogxRatioUV
 //	const int		ySubUV;
 	int            fieldShift;
@@ -28,11 +28,14 @@
 #include "SuperParams64Bits.h"
 #include "CopyCode.h"
 #include "overlap.h"
+#include "overlap_avx2.h"
 #include <stdint.h>
 #include <commonfunctions.h>
 #include "def.h"
 
 //#include	<mmintrin.h>
+#include	<emmintrin.h>
+#include	<algorithm>
 
 // PF 160926: MDegrain3 -> MDegrainX: common 1..5 level MDegrain functions
 // 170105: MDegrain6
@@ -382,6 +385,11 @@ MVDegrainX::MVDegrainX(
   for (int i = 0; i < level; i++) {
     pRefBGOF[i] = new MVGroupOfFrames(nSuperLevels, nWidth, nHeight, nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV, cpuFlags, xRatioUV_super, yRatioUV_super, pixelsize_super, bits_per_pixel_super, _mt_flag);
     pRefFGOF[i] = new MVGroupOfFrames(nSuperLevels, nWidth, nHeight, nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV, cpuFlags, xRatioUV_super, yRatioUV_super, pixelsize_super, bits_per_pixel_super, _mt_flag);
+    if ((params.param & SuperParams64Bits::PARAM_LAZY_FLAG) != 0)
+    {
+      pRefBGOF[i]->set_lazy_refine(MVPlaneSet(nSuperModeYUV), params.param & SuperParams64Bits::PARAM_SHARP_MASK);
+      pRefFGOF[i]->set_lazy_refine(MVPlaneSet(nSuperModeYUV), params.param & SuperParams64Bits::PARAM_SHARP_MASK);
+    }
   }
   int nSuperWidth = vi_super.width;
 
@@ -443,7 +451,9 @@ MVDegrainX::MVDegrainX(
   // OverlapsFunction
   // in M(V)DegrainX: DenoiseXFunction
   arch_t arch;
-  if ((cpuFlags & CPUF_AVX2) != 0)
+  if ((cpuFlags & CPUF_AVX512F) != 0 && (cpuFlags & CPUF_AVX512BW) != 0)
+    arch = USE_AVX512;
+  else if ((cpuFlags & CPUF_AVX2) != 0)
     arch = USE_AVX2;
   else if ((cpuFlags & CPUF_AVX) != 0)
     arch = USE_AVX;
@@ -493,6 +503,9 @@ MVDegrainX::MVDegrainX(
   tmpBlock = (uint8_t *)_aligned_malloc(tmp_size * height_lsb_or_out16_mul, 64); // new BYTE[tmp_size * height_lsb_or_out16_mul]; PF. 16.10.26
   tmpBlockLsb = (lsb_flag) ? (tmpBlock + tmp_size) : 0;
 
+  WRefArrY.resize(nBlkCount * level * 2);
+  WRefArrUV.resize(nBlkCount * level * 2);
+
   if ((cpuFlags & CPUF_SSE2) != 0)
   {
     if(out16_flag)
@@ -784,6 +797,12 @@ PVideoFrame __stdcall MVDegrainX::GetFrame(int n, IScriptEnvironment* env)
     }
   }
 
+  // Weights of all the blocks, before the pixel processing
+  if (YUVplanes & YPLANE)
+    compute_weights(WRefArrY, thSAD, thSAD_sq, isUsableB, isUsableF);
+  if (YUVplanes & (UPLANE | VPLANE))
+    compute_weights(WRefArrUV, thSADC, thSADC_sq, isUsableB, isUsableF);
+
   PROFILE_START(MOTION_PROFILE_COMPENSATION);
   pDstCur[0] = pDst[0];
   pDstCur[1] = pDst[1];
@@ -826,8 +845,10 @@ PVideoFrame __stdcall MVDegrainX::GetFrame(int n, IScriptEnvironment* env)
           int WRefB[MAX_DEGRAIN], WRefF[MAX_DEGRAIN];
 
           for (int j = 0; j < level; j++) {
-            use_block_y(pB[j], npB[j], WRefB[j], isUsableB[j], *mvClipB[j], i, pPlanesB[0][j], pSrcCur[0], xx << pixelsize_super_shift, nSrcPitches[0]);
-            use_block_y(pF[j], npF[j], WRefF[j], isUsableF[j], *mvClipF[j], i, pPlanesF[0][j], pSrcCur[0], xx << pixelsize_super_shift, nSrcPitches[0]);
+            use_block_y(pB[j], npB[j], isUsableB[j], *mvClipB[j], i, pPlanesB[0][j], pSrcCur[0], xx << pixelsize_super_shift, nSrcPitches[0]);
+            use_block_y(pF[j], npF[j], isUsableF[j], *mvClipF[j], i, pPlanesF[0][j], pSrcCur[0], xx << pixelsize_super_shift, nSrcPitches[0]);
+            WRefB[j] = WRefArrY[(j * 2) * nBlkCount + i];
+            WRefF[j] = WRefArrY[(j * 2 + 1) * nBlkCount + i];
           }
           NORMWEIGHTS(WSrc, WRefB, WRefF);
 
@@ -917,8 +938,10 @@ PVideoFrame __stdcall MVDegrainX::GetFrame(int n, IScriptEnvironment* env)
           int WRefB[MAX_DEGRAIN], WRefF[MAX_DEGRAIN];
 
           for (int j = 0; j < level; j++) {
-            use_block_y(pB[j], npB[j], WRefB[j], isUsableB[j], *mvClipB[j], i, pPlanesB[0][j], pSrcCur[0], xx << pixelsize_super_shift, nSrcPitches[0]);
-            use_block_y(pF[j], npF[j], WRefF[j], isUsableF[j], *mvClipF[j], i, pPlanesF[0][j], pSrcCur[0], xx << pixelsize_super_shift, nSrcPitches[0]);
+            use_block_y(pB[j], npB[j], isUsableB[j], *mvClipB[j], i, pPlanesB[0][j], pSrcCur[0], xx << pixelsize_super_shift, nSrcPitches[0]);
+            use_block_y(pF[j], npF[j], isUsableF[j], *mvClipF[j], i, pPlanesF[0][j], pSrcCur[0], xx << pixelsize_super_shift, nSrcPitches[0]);
+            WRefB[j] = WRefArrY[(j * 2) * nBlkCount + i];
+            WRefF[j] = WRefArrY[(j * 2 + 1) * nBlkCount + i];
           }
           NORMWEIGHTS(WSrc, WRefB, WRefF);
           // luma
@@ -962,21 +985,27 @@ PVideoFrame __stdcall MVDegrainX::GetFrame(int n, IScriptEnvironment* env)
       }
       else if (out16_flag)
       {
-        if ((cpuFlags & CPUF_SSE4_1) != 0)
+        if ((cpuFlags & CPUF_AVX2) != 0)
+          Short2Bytes_Int32toWord16_avx2((uint16_t *)(pDst[0]), nDstPitches[0], DstInt, dstIntPitch, nWidth_B, nHeight_B, bits_per_pixel_output);
+        else if ((cpuFlags & CPUF_SSE4_1) != 0)
           Short2Bytes_Int32toWord16_sse4((uint16_t *)(pDst[0]), nDstPitches[0], DstInt, dstIntPitch, nWidth_B, nHeight_B, bits_per_pixel_output);
         else
           Short2Bytes_Int32toWord16((uint16_t *)(pDst[0]), nDstPitches[0], DstInt, dstIntPitch, nWidth_B, nHeight_B, bits_per_pixel_output);
       }
       else if (pixelsize_super == 1)
       { 
-        if((cpuFlags & CPUF_SSE2) != 0)
+        if ((cpuFlags & CPUF_AVX2) != 0)
+          Short2Bytes_avx2(pDst[0], nDstPitches[0], DstShort, dstShortPitch, nWidth_B, nHeight_B);
+        else if ((cpuFlags & CPUF_SSE2) != 0)
           Short2Bytes_sse2(pDst[0], nDstPitches[0], DstShort, dstShortPitch, nWidth_B, nHeight_B);
         else
           Short2Bytes(pDst[0], nDstPitches[0], DstShort, dstShortPitch, nWidth_B, nHeight_B);
       }
       else if (pixelsize_super == 2)
       {
-        if ((cpuFlags & CPUF_SSE4_1) != 0)
+        if ((cpuFlags & CPUF_AVX2) != 0)
+          Short2Bytes_Int32toWord16_avx2((uint16_t *)(pDst[0]), nDstPitches[0], DstInt, dstIntPitch, nWidth_B, nHeight_B, bits_per_pixel_super);
+        else if ((cpuFlags & CPUF_SSE4_1) != 0)
           Short2Bytes_Int32toWord16_sse4((uint16_t *)(pDst[0]), nDstPitches[0], DstInt, dstIntPitch, nWidth_B, nHeight_B, bits_per_pixel_super);
         else
           Short2Bytes_Int32toWord16((uint16_t *)(pDst[0]), nDstPitches[0], DstInt, dstIntPitch, nWidth_B, nHeight_B, bits_per_pixel_super);
@@ -1107,8 +1136,10 @@ void MVDegrainX::process_chroma(int plane_mask, BYTE *pDst, BYTE *pDstCur, int n
 
           for (int j = 0; j < level; j++) {
             // xx: byte granularity pointer shift
-            use_block_uv(pBV[j], npBV[j], WRefB[j], isUsableB[j], *mvClipB[j], i, pPlanesB[j], pSrcCur, xx << pixelsize_super_shift, nSrcPitch);
-            use_block_uv(pFV[j], npFV[j], WRefF[j], isUsableF[j], *mvClipF[j], i, pPlanesF[j], pSrcCur, xx << pixelsize_super_shift, nSrcPitch);
+            use_block_uv(pBV[j], npBV[j], isUsableB[j], *mvClipB[j], i, pPlanesB[j], pSrcCur, xx << pixelsize_super_shift, nSrcPitch);
+            use_block_uv(pFV[j], npFV[j], isUsableF[j], *mvClipF[j], i, pPlanesF[j], pSrcCur, xx << pixelsize_super_shift, nSrcPitch);
+            WRefB[j] = WRefArrUV[(j * 2) * nBlkCount + i];
+            WRefF[j] = WRefArrUV[(j * 2 + 1) * nBlkCount + i];
           }
           NORMWEIGHTS(WSrc, WRefB, WRefF);
           // chroma
@@ -1199,8 +1230,10 @@ void MVDegrainX::process_chroma(int plane_mask, BYTE *pDst, BYTE *pDstCur, int n
           int WSrc, WRefB[MAX_DEGRAIN], WRefF[MAX_DEGRAIN];
 
           for (int j = 0; j < level; j++) {
-            use_block_uv(pBV[j], npBV[j], WRefB[j], isUsableB[j], *mvClipB[j], i, pPlanesB[j], pSrcCur, xx << pixelsize_super_shift, nSrcPitch);
-            use_block_uv(pFV[j], npFV[j], WRefF[j], isUsableF[j], *mvClipF[j], i, pPlanesF[j], pSrcCur, xx << pixelsize_super_shift, nSrcPitch);
+            use_block_uv(pBV[j], npBV[j], isUsableB[j], *mvClipB[j], i, pPlanesB[j], pSrcCur, xx << pixelsize_super_shift, nSrcPitch);
+            use_block_uv(pFV[j], npFV[j], isUsableF[j], *mvClipF[j], i, pPlanesF[j], pSrcCur, xx << pixelsize_super_shift, nSrcPitch);
+            WRefB[j] = WRefArrUV[(j * 2) * nBlkCount + i];
+            WRefF[j] = WRefArrUV[(j * 2 + 1) * nBlkCount + i];
           }
           NORMWEIGHTS(WSrc, WRefB, WRefF);
           // chroma
@@ -1247,21 +1280,27 @@ void MVDegrainX::process_chroma(int plane_mask, BYTE *pDst, BYTE *pDstCur, int n
       }
       else if (out16_flag)
       {
-        if ((cpuFlags & CPUF_SSE4_1) != 0)
+        if ((cpuFlags & CPUF_AVX2) != 0)
+          Short2Bytes_Int32toWord16_avx2((uint16_t *)(pDst), nDstPitch, DstInt, dstIntPitch, nWidth_B >> nLogxRatioUV_super, nHeight_B >> nLogyRatioUV_super, bits_per_pixel_output);
+        else if ((cpuFlags & CPUF_SSE4_1) != 0)
           Short2Bytes_Int32toWord16_sse4((uint16_t *)(pDst), nDstPitch, DstInt, dstIntPitch, nWidth_B >> nLogxRatioUV_super, nHeight_B >> nLogyRatioUV_super, bits_per_pixel_output);
         else
           Short2Bytes_Int32toWord16((uint16_t *)(pDst), nDstPitch, DstInt, dstIntPitch, nWidth_B >> nLogxRatioUV_super, nHeight_B >> nLogyRatioUV_super, bits_per_pixel_output);
       }
       else if (pixelsize_super == 1)
       { // pixelsize
-        if ((cpuFlags & CPUF_SSE2) != 0)
+        if ((cpuFlags & CPUF_AVX2) != 0)
+          Short2Bytes_avx2(pDst, nDstPitch, DstShort, dstShortPitch, nWidth_B >> nLogxRatioUV_super, nHeight_B >> nLogyRatioUV_super);
+        else if ((cpuFlags & CPUF_SSE2) != 0)
           Short2Bytes_sse2(pDst, nDstPitch, DstShort, dstShortPitch, nWidth_B >> nLogxRatioUV_super, nHeight_B >> nLogyRatioUV_super);
         else
           Short2Bytes(pDst, nDstPitch, DstShort, dstShortPitch, nWidth_B >> nLogxRatioUV_super, nHeight_B >> nLogyRatioUV_super);
       }
       else if (pixelsize_super == 2)
       { 
-        if ((cpuFlags & CPUF_SSE4_1) != 0)
+        if ((cpuFlags & CPUF_AVX2) != 0)
+          Short2Bytes_Int32toWord16_avx2((uint16_t *)(pDst), nDstPitch, DstInt, dstIntPitch, nWidth_B >> nLogxRatioUV_super, nHeight_B >> nLogyRatioUV_super, bits_per_pixel_super);
+        else if ((cpuFlags & CPUF_SSE4_1) != 0)
           Short2Bytes_Int32toWord16_sse4((uint16_t *)(pDst), nDstPitch, DstInt, dstIntPitch, nWidth_B >> nLogxRatioUV_super, nHeight_B >> nLogyRatioUV_super, bits_per_pixel_super);
         else
           Short2Bytes_Int32toWord16((uint16_t *)(pDst), nDstPitch, DstInt, dstIntPitch, nWidth_B >> nLogxRatioUV_super, nHeight_B >> nLogyRatioUV_super, bits_per_pixel_super);
@@ -1315,7 +1354,7 @@ void MVDegrainX::process_chroma(int plane_mask, BYTE *pDst, BYTE *pDstCur, int n
 
 // todo: put together with use_block_uv,  
 // todo: change /xRatioUV_super and /yRatioUV_super to bit shifts everywhere
-MV_FORCEINLINE void	MVDegrainX::use_block_y(const BYTE * &p, int &np, int &WRef, bool isUsable, const MVClip &mvclip, int i, const MVPlane *pPlane, const BYTE *pSrcCur, int xx, int nSrcPitch)
+MV_FORCEINLINE void	MVDegrainX::use_block_y(const BYTE * &p, int &np, bool isUsable, const MVClip &mvclip, int i, const MVPlane *pPlane, const BYTE *pSrcCur, int xx, int nSrcPitch)
 {
   if (isUsable)
   {
@@ -1324,20 +1363,17 @@ MV_FORCEINLINE void	MVDegrainX::use_block_y(const BYTE * &p, int &np, int &WRef,
     int bly = block.GetY() * nPel + block.GetMV().y;
     p = pPlane->GetPointer(blx, bly);
     np = pPlane->GetPitch();
-    sad_t blockSAD = block.GetSAD(); // SAD of MV Block. Scaled to MVClip's bits_per_pixel;
-    WRef = DegrainWeight(thSAD, thSAD_sq, blockSAD);
   }
   else
   {
     // just to point on a valid area. It'll be read in code but its weight will be zero, anyway.
     p = pSrcCur + xx; // xx here:byte offset
     np = nSrcPitch;
-    WRef = 0;
   }
 }
 
 // no difference for 1-2-3
-MV_FORCEINLINE void MVDegrainX::use_block_uv(const BYTE * &p, int &np, int &WRef, bool isUsable, const MVClip &mvclip, int i, const MVPlane *pPlane, const BYTE *pSrcCur, int xx, int nSrcPitch)
+MV_FORCEINLINE void MVDegrainX::use_block_uv(const BYTE * &p, int &np, bool isUsable, const MVClip &mvclip, int i, const MVPlane *pPlane, const BYTE *pSrcCur, int xx, int nSrcPitch)
 {
   if (isUsable)
   {
@@ -1346,19 +1382,60 @@ MV_FORCEINLINE void MVDegrainX::use_block_uv(const BYTE * &p, int &np, int &WRef
     int bly = block.GetY() * nPel + block.GetMV().y;
     p = pPlane->GetPointer(blx >> nLogxRatioUV_super, bly >> nLogyRatioUV_super); // pixelsize - aware
     np = pPlane->GetPitch();
-    sad_t blockSAD = block.GetSAD();  // SAD of MV Block. Scaled to MVClip's bits_per_pixel;
-    WRef = DegrainWeight(thSADC, thSADC_sq, blockSAD);
   }
   else
   {
     p = pSrcCur + xx; // xx:byte offset
     np = nSrcPitch;
-    WRef = 0;
   }
 }
 
 
 
+void MVDegrainX::compute_weights(std::vector<int> &wref_arr, sad_t thsad, double thsad_sq, const bool isUsableB[MAX_DEGRAIN], const bool isUsableF[MAX_DEGRAIN])
+{
+  for (int j = 0; j < level; j++)
+  {
+    for (int d = 0; d < 2; d++) // backward, forward
+    {
+      int *pW = &wref_arr[(j * 2 + d) * nBlkCount];
+      const bool isUsable = (d == 0) ? isUsableB[j] : isUsableF[j];
+      const MVClip &mvclip = (d == 0) ? *mvClipB[j] : *mvClipF[j];
+      if (isUsable)
+        DegrainWeightArray(pW, mvclip.GetPlane(0).GetArraySAD(), nBlkCount, thsad, thsad_sq);
+      else
+        std::fill_n(pW, nBlkCount, 0);
+    }
+  }
+}
+
+// DegrainWeight, 4 blocks at once.
+// Same double precision operations in the same order as the scalar version,
+// so the results are identical. thSAD <= blockSAD lanes are masked to 0,
+// which also takes care of the 0/0 case.
+void DegrainWeightArray(int *dst_ptr, const sad_t *sad_ptr, int nbr_blk, int thSAD, double thSAD_sq)
+{
+  const __m128d one = _mm_set1_pd(double(1 << DEGRAIN_WEIGHT_BITS));
+  const __m128d th_sq = _mm_set1_pd(thSAD_sq);
+  const __m128i th = _mm_set1_epi32(thSAD);
+  int i = 0;
+  for (; i <= nbr_blk - 4; i += 4)
+  {
+    const __m128i sad = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sad_ptr + i));
+    const __m128d sad_lo = _mm_cvtepi32_pd(sad);
+    const __m128d sad_hi = _mm_cvtepi32_pd(_mm_srli_si128(sad, 8));
+    const __m128d sq_lo = _mm_mul_pd(sad_lo, sad_lo);
+    const __m128d sq_hi = _mm_mul_pd(sad_hi, sad_hi);
+    const __m128d w_lo = _mm_div_pd(_mm_mul_pd(one, _mm_sub_pd(th_sq, sq_lo)), _mm_add_pd(th_sq, sq_lo));
+    const __m128d w_hi = _mm_div_pd(_mm_mul_pd(one, _mm_sub_pd(th_sq, sq_hi)), _mm_add_pd(th_sq, sq_hi));
+    const __m128i w = _mm_unpacklo_epi64(_mm_cvttpd_epi32(w_lo), _mm_cvttpd_epi32(w_hi));
+    const __m128i mask = _mm_cmpgt_epi32(th, sad);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst_ptr + i), _mm_and_si128(w, mask));
+  }
+  for (; i < nbr_blk; i++)
+    dst_ptr[i] = DegrainWeight(thSAD, thSAD_sq, sad_ptr[i]);
+}
+
 template<int level>
 MV_FORCEINLINE void	norm_weights(int &WSrc, int(&WRefB)[MAX_DEGRAIN], int(&WRefF)[MAX_DEGRAIN])
 {
@@ -7,6 +7,7 @@
 #include "overlap.h"
 #include "yuy2planes.h"
 #include <stdint.h>
+#include <vector>
 #include "def.h"
 #include "intrin.h"
 
@@ -96,6 +97,11 @@ private:
   int * DstInt;
   int dstIntPitch;
 
+  // Raw block weights of the current frame, one row of nBlkCount per
+  // reference: backward j at row j*2, forward j at row j*2+1
+  std::vector<int> WRefArrY;
+  std::vector<int> WRefArrUV;
+
   const int level;
   int framenumber;
 
@@ -119,8 +125,9 @@ private:
     bool isUsableB[MAX_DEGRAIN], bool isUsableF[MAX_DEGRAIN], MVPlane *pPlanesB[MAX_DEGRAIN], MVPlane *pPlanesF[MAX_DEGRAIN],
     int lsb_offset_uv, int nWidth_B, int nHeight_B);
   // MV_FORCEINLINE void process_chroma(int plane_mask, BYTE *pDst, BYTE *pDstCur, int nDstPitch, const BYTE *pSrc, const BYTE *pSrcCur, int nSrcPitch, bool isUsableB, bool isUsableF, bool isUsableB2, bool isUsableF2, bool isUsableB3, bool isUsableF3, MVPlane *pPlanesB, MVPlane *pPlanesF, MVPlane *pPlanesB2, MVPlane *pPlanesF2, MVPlane *pPlanesB3, MVPlane *pPlanesF3, int lsb_offset_uv, int nWidth_B, int nHeight_B);
-  MV_FORCEINLINE void use_block_y(const BYTE * &p, int &np, int &WRef, bool isUsable, const MVClip &mvclip, int i, const MVPlane *pPlane, const BYTE *pSrcCur, int xx, int nSrcPitch);
-  MV_FORCEINLINE void use_block_uv(const BYTE * &p, int &np, int &WRef, bool isUsable, const MVClip &mvclip, int i, const MVPlane *pPlane, const BYTE *pSrcCur, int xx, int nSrcPitch);
+  MV_FORCEINLINE void use_block_y(const BYTE * &p, int &np, bool isUsable, const MVClip &mvclip, int i, const MVPlane *pPlane, const BYTE *pSrcCur, int xx, int nSrcPitch);
+  MV_FORCEINLINE void use_block_uv(const BYTE * &p, int &np, bool isUsable, const MVClip &mvclip, int i, const MVPlane *pPlane, const BYTE *pSrcCur, int xx, int nSrcPitch);
+  void compute_weights(std::vector<int> &wref_arr, sad_t thsad, double thsad_sq, const bool isUsableB[MAX_DEGRAIN], const bool isUsableF[MAX_DEGRAIN]);
   Denoise1to6Function *get_denoise123_function(int BlockX, int BlockY, int _bits_per_pixel, bool _lsb_flag, bool _out16_flag, int _level, arch_t _arch);
 };
 
@@ -843,6 +850,9 @@ MV_FORCEINLINE int DegrainWeight(int thSAD, double thSAD_sq, int blockSAD)
   return (int)((double)(1 << DEGRAIN_WEIGHT_BITS)*(thSAD_sq - blockSAD_sq) / (thSAD_sq + blockSAD_sq));
 }
 
+// DegrainWeight for a whole array of block SADs, SIMD. Same results.
+void DegrainWeightArray(int *dst_ptr, const sad_t *sad_ptr, int nbr_blk, int thSAD, double thSAD_sq);
+
 template<int level>
 MV_FORCEINLINE void norm_weights(int &WSrc, int(&WRefB)[MAX_DEGRAIN], int(&RefF)[MAX_DEGRAIN]);
 
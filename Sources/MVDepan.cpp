@@ -570,16 +570,22 @@ PVideoFrame __stdcall MVDepan::GetFrame(int ndest, IScriptEnvironment* env)
     //		float testDx = 0;
     //		float testDy = 0;
 
+        const FakePlaneOfBlocks &plane0 = mvclip.GetPlane(0);
+        const int *x_arr = plane0.GetArrayX();
+        const int *y_arr = plane0.GetArrayY();
+        const int *vx_arr = plane0.GetArrayVx();
+        const int *vy_arr = plane0.GetArrayVy();
+        const sad_t *sad_arr = plane0.GetArraySAD();
         for (int j = 0; j < nBlkY; j++)
         {
           for (int i = 0; i < nBlkX; i++)
           {
             int nb = j*nBlkX + i;
-            blockDx[nb] = mvclip.GetBlock(0, nb).GetMV().x * dPel;
-            blockDy[nb] = mvclip.GetBlock(0, nb).GetMV().y * dPel;
-            blockSAD[nb] = mvclip.GetBlock(0, nb).GetSAD();
-            blockX[nb] = mvclip.GetBlock(0, nb).GetX() + nBlkSizeX / 2;//i*nBlkSize + nBlkSize/2;// rewritten in v1.2.5
-            blockY[nb] = mvclip.GetBlock(0, nb).GetY() + nBlkSizeY / 2;//j*nBlkSize + nBlkSize/2;//
+            blockDx[nb] = vx_arr[nb] * dPel;
+            blockDy[nb] = vy_arr[nb] * dPel;
+            blockSAD[nb] = sad_arr[nb];
+            blockX[nb] = x_arr[nb] + nBlkSizeX / 2;//i*nBlkSize + nBlkSize/2;// rewritten in v1.2.5
+            blockY[nb] = y_arr[nb] + nBlkSizeY / 2;//j*nBlkSize + nBlkSize/2;//
             if (mask && blockX[nb] < vi.width && blockY[nb] < vi.height)
               blockWeightMask[nb] = maskp[blockX[nb] * BPP + blockY[nb] * mask_pitch];
             else
@@ -66,6 +66,11 @@ GenericVideoFilter(_super)
     bits_per_pixel = _super->GetVideoInfo().BitsPerComponent();
 
 	pRefGOF = new MVGroupOfFrames(nSuperLevels, nWidth, nHeight, nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV, cpuFlags, xRatioUV, yRatioUV, pixelsize, bits_per_pixel, true);
+	_lazy_flag = ((params.param & SuperParams64Bits::PARAM_LAZY_FLAG) != 0);
+	if (_lazy_flag)
+	{
+		pRefGOF->set_lazy_refine(MVPlaneSet(nSuperModeYUV), params.param & SuperParams64Bits::PARAM_SHARP_MASK);
+	}
 
 //	if (nHeight != nHeightS || nHeight != vi.height || nWidth != nSuperWidth-nSuperHPad*2 || nWidth != vi.width)
 //		env->ThrowError("MVFinest : different frame sizes of input clips");
@@ -154,6 +159,12 @@ PVideoFrame __stdcall MVFinest::GetFrame(int n, IScriptEnvironment* env)
     MVPlaneSet nMode = vi.IsY() ? YPLANE : YUVPLANES;
 		pRefGOF->Update(nMode, (BYTE*)pRef[0], nRefPitches[0], (BYTE*)pRef[1], nRefPitches[1], (BYTE*)pRef[2], nRefPitches[2]);// v2.0
 
+		// Whole planes are copied, render them at once
+		if (_lazy_flag)
+		{
+			pRefGOF->Refine(nMode);
+		}
+
 		MVPlane *pPlanes[3];
 
     MVPlaneSet planes[3] = { YPLANE, UPLANE, VPLANE };
@@ -33,6 +33,7 @@ private:
     int nSuperHPad;
     int nSuperVPad;
     MVGroupOfFrames *pRefGOF;
+    bool _lazy_flag; // Sub-pixel planes of the super clip not rendered yet
 //   bool usePelClipHere;
 
 
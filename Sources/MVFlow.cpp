@@ -26,10 +26,11 @@
 #include "commonfunctions.h"
 
 MVFlow::MVFlow(PClip _child, PClip super, PClip _mvec, int _time256, int _mode, bool _fields,
-  sad_t nSCD1, int nSCD2, bool _isse, bool _planar, PClip _timeclip, IScriptEnvironment* env) :
+  sad_t nSCD1, int nSCD2, bool _isse, bool _planar, PClip _timeclip, bool mt_flag, IScriptEnvironment* env) :
   GenericVideoFilter(_child),
   MVFilter(_mvec, "MFlow", env, 1, 0),
-  mvClip(_mvec, nSCD1, nSCD2, env, 1, 0)
+  mvClip(_mvec, nSCD1, nSCD2, env, 1, 0),
+  _mt_flag(mt_flag)
 {
   has_at_least_v8 = true;
   try { env->CheckVersion(8); }
@@ -387,16 +388,20 @@ PVideoFrame __stdcall MVFlow::GetFrame(int n, IScriptEnvironment* env)
       VectorSmallMaskYToHalfUV(VYSmallY, nBlkXP, nBlkYP, VYSmallUV, yRatioUVs[1]);
     }
 
-    // upsize (bilinear interpolate) vector masks to fullframe size
-
-    const int nPel = 1;
-    upsizer->SimpleResizeDo_int16(VXFullY, nWidthP, nHeightP, VPitchY, VXSmallY, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight);
-    upsizer->SimpleResizeDo_int16(VYFullY, nWidthP, nHeightP, VPitchY, VYSmallY, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight);
-    if (!isGrey) {
-      upsizerUV->SimpleResizeDo_int16(VXFullUV, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUV, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV);
-      upsizerUV->SimpleResizeDo_int16(VYFullUV, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUV, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV);
+    for (int p = 0; p < planecount; ++p)
+    {
+      _dst_ptr_arr[p] = pDst[p];
+      _dst_pitch_arr[p] = nDstPitches[p];
+      _ref_ptr_arr[p] = pRef[p] + ((p == 0) ? nOffsetY : nOffsetUV); //padded
+      _ref_pitch_arr[p] = nRefPitches[p];
     }
 
+    // upsize (bilinear interpolate) vector masks to fullframe size
+    // and fetch, in independent row slices
+    Slicer slicer(_mt_flag);
+    slicer.start(nHeightP, *this, &MVFlow::process_slice, 4);
+    slicer.wait();
+
     if (mode == 1)
     {
       MemZoneSet(pDst[0], 0, nWidth*pixelsize_super, nHeight, 0, 0, nDstPitches[0]);
@@ -406,31 +411,7 @@ PVideoFrame __stdcall MVFlow::GetFrame(int n, IScriptEnvironment* env)
       }
     }
 
-    if (mode == 0) // fetch mode
-    {
-      if (pixelsize_super == 1) {
-        Fetch<uint8_t>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, nRefPitches[0], VXFullY, VPitchY, VYFullY, VPitchY, nWidth, nHeight, time256); //padded
-        if (!isGrey) {
-          Fetch<uint8_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, nRefPitches[1], VXFullUV, VPitchUV, VYFullUV, VPitchUV, nWidthUV, nHeightUV, time256);
-          Fetch<uint8_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, nRefPitches[2], VXFullUV, VPitchUV, VYFullUV, VPitchUV, nWidthUV, nHeightUV, time256);
-        }
-      }
-      else if(pixelsize_super == 2) {
-        Fetch<uint16_t>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, nRefPitches[0], VXFullY, VPitchY, VYFullY, VPitchY, nWidth, nHeight, time256); //padded
-        if (!isGrey) {
-          Fetch<uint16_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, nRefPitches[1], VXFullUV, VPitchUV, VYFullUV, VPitchUV, nWidthUV, nHeightUV, time256);
-          Fetch<uint16_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, nRefPitches[2], VXFullUV, VPitchUV, VYFullUV, VPitchUV, nWidthUV, nHeightUV, time256);
-        }
-      }
-      else if (pixelsize_super == 4) {
-        Fetch<float>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, nRefPitches[0], VXFullY, VPitchY, VYFullY, VPitchY, nWidth, nHeight, time256); //padded
-        if (!isGrey) {
-          Fetch<float>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, nRefPitches[1], VXFullUV, VPitchUV, VYFullUV, VPitchUV, nWidthUV, nHeightUV, time256);
-          Fetch<float>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, nRefPitches[2], VXFullUV, VPitchUV, VYFullUV, VPitchUV, nWidthUV, nHeightUV, time256);
-        }
-      }
-    }
-    else if (mode == 1) // shift mode
+    if (mode == 1) // shift mode, scattered writes: not sliced
     {
       if (pixelsize_super == 1) {
         MemZoneSet(pDst[0], 255, nWidth, nHeight, 0, 0, nDstPitches[0]);
@@ -489,3 +470,59 @@ PVideoFrame __stdcall MVFlow::GetFrame(int n, IScriptEnvironment* env)
     return src;
   }
 }
+
+
+
+// Luma rows [td._y_beg, td._y_end) of the padded plane, chroma rows in
+// the same proportion.
+void MVFlow::process_slice(Slicer::TaskData &td)
+{
+  const int y_beg = td._y_beg;
+  const int y_end = td._y_end;
+  const int y_beg_uv = y_beg * nHeightPUV / nHeightP;
+  const int y_end_uv = y_end * nHeightPUV / nHeightP;
+
+  {
+    // upsize (bilinear interpolate) vector masks to fullframe size
+    const int nPel = 1;
+    upsizer->SimpleResizeDo_int16(VXFullY, nWidthP, nHeightP, VPitchY, VXSmallY, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight, y_beg, y_end);
+    upsizer->SimpleResizeDo_int16(VYFullY, nWidthP, nHeightP, VPitchY, VYSmallY, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight, y_beg, y_end);
+    if (!isGrey) {
+      upsizerUV->SimpleResizeDo_int16(VXFullUV, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUV, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV, y_beg_uv, y_end_uv);
+      upsizerUV->SimpleResizeDo_int16(VYFullUV, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUV, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV, y_beg_uv, y_end_uv);
+    }
+  }
+
+  if (mode != 0)
+    return;
+
+  // fetch mode
+  fetch_rows(0, VXFullY, VYFullY, VPitchY, nWidth, std::min(y_beg, nHeight), std::min(y_end, nHeight));
+  if (!isGrey) {
+    const int yb = std::min(y_beg_uv, nHeightUV);
+    const int ye = std::min(y_end_uv, nHeightUV);
+    fetch_rows(1, VXFullUV, VYFullUV, VPitchUV, nWidthUV, yb, ye);
+    fetch_rows(2, VXFullUV, VYFullUV, VPitchUV, nWidthUV, yb, ye);
+  }
+}
+
+
+
+void MVFlow::fetch_rows(int p, short *VXFull, short *VYFull, int VPitch, int width, int y_beg, int y_end)
+{
+  if (y_beg >= y_end)
+    return;
+
+  BYTE *pdst = _dst_ptr_arr[p] + y_beg * _dst_pitch_arr[p];
+  const BYTE *pref = _ref_ptr_arr[p] + y_beg * _ref_pitch_arr[p] * nPel;
+  VXFull += y_beg * VPitch;
+  VYFull += y_beg * VPitch;
+  const int height = y_end - y_beg;
+
+  if (pixelsize_super == 1)
+    Fetch<uint8_t>(pdst, _dst_pitch_arr[p], pref, _ref_pitch_arr[p], VXFull, VPitch, VYFull, VPitch, width, height, time256);
+  else if (pixelsize_super == 2)
+    Fetch<uint16_t>(pdst, _dst_pitch_arr[p], pref, _ref_pitch_arr[p], VXFull, VPitch, VYFull, VPitch, width, height, time256);
+  else if (pixelsize_super == 4)
+    Fetch<float>(pdst, _dst_pitch_arr[p], pref, _ref_pitch_arr[p], VXFull, VPitch, VYFull, VPitch, width, height, time256);
+}
@@ -3,6 +3,7 @@
 
 #include "MVClip.h"
 #include "MVFilter.h"
+#include "MTSlicer.h"
 #include "SimpleResize.h"
 #include "Time256ProviderCst.h"
 #include "Time256ProviderPlane.h"
@@ -102,9 +103,22 @@ private:
   int nLogxRatioUVs[3];
   int nLogyRatioUVs[3];
 
+  typedef MTSlicer <MVFlow> Slicer;
+
+  const bool _mt_flag;
+
+  // per-frame data for the row slices
+  BYTE *_dst_ptr_arr[3];
+  const BYTE *_ref_ptr_arr[3]; // with padding offset
+  int _dst_pitch_arr[3];
+  int _ref_pitch_arr[3];
+
+  void process_slice(Slicer::TaskData &td);
+  void fetch_rows(int p, short *VXFull, short *VYFull, int VPitch, int width, int y_beg, int y_end);
+
 public:
   MVFlow(PClip _child, PClip _super, PClip _vectors, int _time256, int _mode, bool _fields,
-    sad_t nSCD1, int nSCD2, bool isse, bool _planar, PClip _timeclip, IScriptEnvironment* env);
+    sad_t nSCD1, int nSCD2, bool isse, bool _planar, PClip _timeclip, bool mt_flag, IScriptEnvironment* env);
   ~MVFlow();
   PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) override;
 
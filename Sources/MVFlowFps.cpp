@@ -28,12 +28,13 @@
 
 
 MVFlowFps::MVFlowFps(PClip _child, PClip super, PClip _mvbw, PClip _mvfw, unsigned int _num, unsigned int _den, int _maskmode, double _ml,
-  bool _blend, sad_t nSCD1, int nSCD2, bool _isse, bool _planar, int _optDebug, IScriptEnvironment* env) :
+  bool _blend, sad_t nSCD1, int nSCD2, bool _isse, bool _planar, int _optDebug, bool mt_flag, IScriptEnvironment* env) :
   GenericVideoFilter(_child),
   MVFilter(_mvfw, "MFlowFps", env, 1, 0),
   mvClipB(_mvbw, nSCD1, nSCD2, env, 1, 0),
   mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0),
-  optDebug(_optDebug)
+  optDebug(_optDebug),
+  _mt_flag(mt_flag)
 {
   has_at_least_v8 = true;
   try { env->CheckVersion(8); }
@@ -255,6 +256,10 @@ MVFlowFps::MVFlowFps(PClip _child, PClip super, PClip _mvbw, PClip _mvfw, unsign
 
   nleftLast = -1000;
   nrightLast = -1000;
+  nleftLastExtra = -1000;
+  nrightLastExtra = -1000;
+  isUsableBBLast = false;
+  isUsableFFLast = false;
 
   if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
   {
@@ -470,7 +475,12 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
     int nOffsetY = nRefPitches[0] * nVPadding*nPel + nHPadding*nPel*pixelsize_super;
     int nOffsetUV = nRefPitches[1] * nVPaddingUV*nPel + nHPaddingUV*nPel*pixelsize_super;
 
-    if (nright != nrightLast)
+    // The small (block level) masks are made here, serially. Upsizing them to
+    // full frame and the interpolation work on independent rows, they are
+    // done in the row slices.
+
+    _resize_b_flag = (nright != nrightLast);
+    if (_resize_b_flag)
     {
       PROFILE_START(MOTION_PROFILE_MASK);
       // make  vector vx and vy small masks
@@ -484,17 +494,6 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
       }
 
       PROFILE_STOP(MOTION_PROFILE_MASK);
-      // upsize (bilinear interpolate) vector masks to fullframe size
-      PROFILE_START(MOTION_PROFILE_RESIZE);
-
-      upsizer->SimpleResizeDo_int16(VXFullYB, nWidthP, nHeightP, VPitchY, VXSmallYB, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VYFullYB, nWidthP, nHeightP, VPitchY, VYSmallYB, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight);
-      if (needDistinctChroma) {
-        upsizerUV->SimpleResizeDo_int16(VXFullUVB, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVB, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VYFullUVB, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVB, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV);
-      }
-      PROFILE_STOP(MOTION_PROFILE_RESIZE);
-
     }
    // analyse vectors field to detect occlusion
    // Backward part
@@ -504,17 +503,12 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
     CheckAndPadMaskSmall(MaskSmallB, nBlkXP, nBlkYP, nBlkX, nBlkY);
 
     PROFILE_STOP(MOTION_PROFILE_MASK);
-    PROFILE_START(MOTION_PROFILE_RESIZE);
-  // upsize (bilinear interpolate) vector masks to fullframe size
-    upsizer->SimpleResizeDo_uint8(MaskFullYB, nWidthP, nHeightP, VPitchY, MaskSmallB, nBlkXP, nBlkXP);
-    if(needDistinctChroma)
-      upsizerUV->SimpleResizeDo_uint8(MaskFullUVB, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallB, nBlkXP, nBlkXP);
-    PROFILE_STOP(MOTION_PROFILE_RESIZE);
 
     nrightLast = nright;
 
     // Forward part
-    if (nleft != nleftLast)
+    _resize_f_flag = (nleft != nleftLast);
+    if (_resize_f_flag)
     {
      // make  vector vx and vy small masks
       PROFILE_START(MOTION_PROFILE_MASK);
@@ -528,17 +522,6 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
       }
 
       PROFILE_STOP(MOTION_PROFILE_MASK);
-      // upsize (bilinear interpolate) vector masks to fullframe size
-      PROFILE_START(MOTION_PROFILE_RESIZE);
-
-      upsizer->SimpleResizeDo_int16(VXFullYF, nWidthP, nHeightP, VPitchY, VXSmallYF, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VYFullYF, nWidthP, nHeightP, VPitchY, VYSmallYF, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight);
-      if (needDistinctChroma) {
-        upsizerUV->SimpleResizeDo_int16(VXFullUVF, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVF, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VYFullUVF, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVF, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV);
-      }
-      PROFILE_STOP(MOTION_PROFILE_RESIZE);
-
     }
    // analyse vectors field to detect occlusion
    // Forward part
@@ -548,31 +531,39 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
     CheckAndPadMaskSmall(MaskSmallF, nBlkXP, nBlkYP, nBlkX, nBlkY);
 
     PROFILE_STOP(MOTION_PROFILE_MASK);
-    PROFILE_START(MOTION_PROFILE_RESIZE);
-  // upsize (bilinear interpolate) vector masks to fullframe size
-    upsizer->SimpleResizeDo_uint8(MaskFullYF, nWidthP, nHeightP, VPitchY, MaskSmallF, nBlkXP, nBlkXP);
-    if(needDistinctChroma)
-      upsizerUV->SimpleResizeDo_uint8(MaskFullUVF, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallF, nBlkXP, nBlkXP);
-    PROFILE_STOP(MOTION_PROFILE_RESIZE);
 
     nleftLast = nleft;
 
     // Backward and forward is ready
 
   // Get motion info from more frames for occlusion areas
-    PVideoFrame mvFF = mvClipF.GetFrame(nleft, env);
-    mvClipF.Update(mvFF, env);// forward from prev to cur
-    mvFF = 0;
+    // Like the B and F fields above, the upsized extra fields depend only on the
+    // source pair, output frames between the same nleft and nright reuse them.
+    const bool extraCached = (maskmode == 2 && nleft == nleftLastExtra && nright == nrightLastExtra);
+    bool isUsableB;
+    bool isUsableF;
+    if (extraCached)
+    {
+      isUsableB = isUsableBBLast;
+      isUsableF = isUsableFFLast;
+    }
+    else
+    {
+      PVideoFrame mvFF = mvClipF.GetFrame(nleft, env);
+      mvClipF.Update(mvFF, env);// forward from prev to cur
+      mvFF = 0;
 
-    PVideoFrame mvBB = mvClipB.GetFrame(nright, env);
-    mvClipB.Update(mvBB, env);// backward from next next to next
-    mvBB = 0;
+      PVideoFrame mvBB = mvClipB.GetFrame(nright, env);
+      mvClipB.Update(mvBB, env);// backward from next next to next
+      mvBB = 0;
 
-    bool isUsableB = mvClipB.IsUsable();
-    bool isUsableF = mvClipF.IsUsable();
+      isUsableB = mvClipB.IsUsable();
+      isUsableF = mvClipF.IsUsable();
+    }
     _RPT5(0, "part#2 IsUsableB=%d IsUsableF=%d frame=%d,nleft=%d,nright=%d\n", isUsableB ? 1 : 0, isUsableF ? 1 : 0, n, nleft, nright);
 
-    if (maskmode == 2 && isUsableB && isUsableF) // slow method with extra frames
+    _resize_extra_flag = (maskmode == 2 && isUsableB && isUsableF && !extraCached);
+    if (_resize_extra_flag)
     {
      // get vector mask from extra frames
       PROFILE_START(MOTION_PROFILE_MASK);
@@ -588,305 +579,103 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
         VectorSmallMaskYToHalfUV(VYSmallYFF, nBlkXP, nBlkYP, VYSmallUVFF, yRatioUVs[1]);
       }
       PROFILE_STOP(MOTION_PROFILE_MASK);
+    }
+    if (maskmode == 2 && !extraCached)
+    {
+      nleftLastExtra = nleft;
+      nrightLastExtra = nright;
+      isUsableBBLast = isUsableB;
+      isUsableFFLast = isUsableF;
+    }
 
-      PROFILE_START(MOTION_PROFILE_RESIZE);
-    // upsize vectors to full frame
-      upsizer->SimpleResizeDo_int16(VXFullYBB, nWidthP, nHeightP, VPitchY, VXSmallYBB, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VYFullYBB, nWidthP, nHeightP, VPitchY, VYSmallYBB, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight);
-      if (needDistinctChroma) {
-        upsizerUV->SimpleResizeDo_int16(VXFullUVBB, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVBB, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VYFullUVBB, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVBB, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV);
-      }
+    if (maskmode == 2 && isUsableB && isUsableF)
+      _flow_mode = 2; // slow method with extra frames
+    else if (maskmode == 1)
+      _flow_mode = 1; // old method without extra frames
+    else
+      _flow_mode = 0; // faster simple method
 
-      upsizer->SimpleResizeDo_int16(VXFullYFF, nWidthP, nHeightP, VPitchY, VXSmallYFF, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VYFullYFF, nWidthP, nHeightP, VPitchY, VYSmallYFF, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight);
-      if (needDistinctChroma) {
-        upsizerUV->SimpleResizeDo_int16(VXFullUVFF, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVFF, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VYFullUVFF, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVFF, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV);
-      }
-      PROFILE_STOP(MOTION_PROFILE_RESIZE);
+    for (int p = 0; p < planecount; ++p)
+    {
+      const int nOffset = (p > 0 && needDistinctChroma) ? nOffsetUV : nOffsetY;
+      _dst_ptr_arr[p] = pDst[p];
+      _dst_pitch_arr[p] = nDstPitches[p];
+      _src_ptr_arr[p] = pSrc[p] + nOffset;
+      _ref_ptr_arr[p] = pRef[p] + nOffset;
+      _ref_pitch_arr[p] = nRefPitches[p];
+    }
+    _time256 = time256;
 
-      PROFILE_START(MOTION_PROFILE_FLOWINTER);
-      {
-        if (pixelsize_super == 1) {
-          FlowInterExtra<uint8_t>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-            VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-            nWidth, nHeight, time256, nPel, VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-          if (!isGrey) {
-            if (needDistinctChroma) {
-              FlowInterExtra<uint8_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel, VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-              FlowInterExtra<uint8_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel, VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-            }
-            else {
-              FlowInterExtra<uint8_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetY, pSrc[1] + nOffsetY, nRefPitches[1],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel, VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-              FlowInterExtra<uint8_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetY, pSrc[2] + nOffsetY, nRefPitches[2],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel, VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-            }
-          }
-        }
-        else if (pixelsize_super == 2) {
-          FlowInterExtra<uint16_t>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-            VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-            nWidth, nHeight, time256, nPel, VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-          if (!isGrey) {
-            if (needDistinctChroma) {
-              FlowInterExtra<uint16_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel, VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-              FlowInterExtra<uint16_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel, VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-            }
-            else {
-              FlowInterExtra<uint16_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetY, pSrc[1] + nOffsetY, nRefPitches[1],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel, VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-              FlowInterExtra<uint16_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetY, pSrc[2] + nOffsetY, nRefPitches[2],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel, VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-            }
-          }
-        }
-        else if (pixelsize_super == 4) {
-          FlowInterExtra<float>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-            VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-            nWidth, nHeight, time256, nPel, VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-          if (!isGrey) {
-            if (needDistinctChroma) {
-              FlowInterExtra<float>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel, VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-              FlowInterExtra<float>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel, VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-            }
-            else {
-              FlowInterExtra<float>(pDst[1], nDstPitches[1], pRef[1] + nOffsetY, pSrc[1] + nOffsetY, nRefPitches[1],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel, VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-              FlowInterExtra<float>(pDst[2], nDstPitches[2], pRef[2] + nOffsetY, pSrc[2] + nOffsetY, nRefPitches[2],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel, VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-            }
-          }
-        }
-      }
-      PROFILE_STOP(MOTION_PROFILE_FLOWINTER);
+    // upsizing and flow, timed together (profiling is not thread safe)
+    PROFILE_START(MOTION_PROFILE_FLOWINTER);
+    Slicer slicer(_mt_flag);
+    slicer.start(nHeightP, *this, &MVFlowFps::process_slice, 4);
+    slicer.wait();
+    PROFILE_STOP(MOTION_PROFILE_FLOWINTER);
+
+    if (_flow_mode == 2)
+    {
       if (optDebug > 0) {
         char buf[2048];
         sprintf_s(buf, "FlowInter mode=2");
         DrawString(dst, vi, 0, 6, buf);
       }
     }
-    else if (maskmode == 1) // old method without extra frames
+    else if (_flow_mode == 1)
     {
-      PROFILE_START(MOTION_PROFILE_FLOWINTER);
-      {
-        if (pixelsize_super == 1) {
-          FlowInter<uint8_t>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-            VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-            nWidth, nHeight, time256, nPel);
-          if (!isGrey) {
-            if (needDistinctChroma) {
-              FlowInter<uint8_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel);
-              FlowInter<uint8_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel);
-            }
-            else {
-              FlowInter<uint8_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetY, pSrc[1] + nOffsetY, nRefPitches[1],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel);
-              FlowInter<uint8_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetY, pSrc[2] + nOffsetY, nRefPitches[2],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel);
-            }
-          }
-        }
-        else if (pixelsize_super == 2) {
-          FlowInter<uint16_t>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-            VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-            nWidth, nHeight, time256, nPel);
-          if (!isGrey) {
-            if (needDistinctChroma) {
-              FlowInter<uint16_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel);
-              FlowInter<uint16_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel);
-            }
-            else {
-              FlowInter<uint16_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetY, pSrc[1] + nOffsetY, nRefPitches[1],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel);
-              FlowInter<uint16_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetY, pSrc[2] + nOffsetY, nRefPitches[2],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel);
-            }
-          }
-        }
-        else if (pixelsize_super == 4) {
-          FlowInter<float>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-            VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-            nWidth, nHeight, time256, nPel);
-          if (!isGrey) {
-            if (needDistinctChroma) {
-              FlowInter<float>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel);
-              FlowInter<float>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel);
-            }
-            else {
-              FlowInter<float>(pDst[1], nDstPitches[1], pRef[1] + nOffsetY, pSrc[1] + nOffsetY, nRefPitches[1],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel);
-              FlowInter<float>(pDst[2], nDstPitches[2], pRef[2] + nOffsetY, pSrc[2] + nOffsetY, nRefPitches[2],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel);
-            }
-          }
-        }
-      }
       if (optDebug > 0) {
         char buf[2048];
         sprintf_s(buf, "FlowInter mode=1");
         DrawString(dst, vi, 0, 6, buf);
       }
-      PROFILE_STOP(MOTION_PROFILE_FLOWINTER);
     }
-    else // mode=0, faster simple method
+    else
     {
-
-      PROFILE_START(MOTION_PROFILE_FLOWINTER);
-      {
-        if (pixelsize_super == 1) {
-          FlowInterSimple<uint8_t>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-            VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-            nWidth, nHeight, time256, nPel);
-          if (!isGrey) {
-            if (needDistinctChroma) {
-              FlowInterSimple<uint8_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel);
-              FlowInterSimple<uint8_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel); // 2.5.11.22 Line 598
-            }
-            else {
-              FlowInterSimple<uint8_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetY, pSrc[1] + nOffsetY, nRefPitches[1],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel);
-              FlowInterSimple<uint8_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetY, pSrc[2] + nOffsetY, nRefPitches[2],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel);
-            }
-          }
-        }
-        else if (pixelsize_super == 2) {
-          FlowInterSimple<uint16_t>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-            VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-            nWidth, nHeight, time256, nPel);
-          if (!isGrey) {
-            if (needDistinctChroma) {
-              FlowInterSimple<uint16_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel);
-              FlowInterSimple<uint16_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel); // 2.5.11.22 Line 598
-            }
-            else {
-              FlowInterSimple<uint16_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetY, pSrc[1] + nOffsetY, nRefPitches[1],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel);
-              FlowInterSimple<uint16_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetY, pSrc[2] + nOffsetY, nRefPitches[2],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel);
-            }
-          }
-        }
-        else if (pixelsize_super == 4) {
-          FlowInterSimple<float>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-            VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-            nWidth, nHeight, time256, nPel);
-          if (!isGrey) {
-            if (needDistinctChroma) {
-              FlowInterSimple<float>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel);
-              FlowInterSimple<float>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-                VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-                nWidthUV, nHeightUV, time256, nPel); // 2.5.11.22 Line 598
-            }
-            else {
-              FlowInterSimple<float>(pDst[1], nDstPitches[1], pRef[1] + nOffsetY, pSrc[1] + nOffsetY, nRefPitches[1],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel);
-              FlowInterSimple<float>(pDst[2], nDstPitches[2], pRef[2] + nOffsetY, pSrc[2] + nOffsetY, nRefPitches[2],
-                VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-                nWidth, nHeight, time256, nPel);
-            }
+      if (optDebug > 0) {
+        int sum_VXFullYB = 0;
+        int sum_VXFullYF = 0;
+        int sum_VYFullYB = 0;
+        int sum_VYFullYF = 0;
+        int sum_MaskFullYB = 0;
+        int sum_MaskFullYF = 0;
+        for (int y = 0; y < nHeight; y++)
+          for (int x = 0; x < nWidth; x++) {
+            sum_VXFullYB += VXFullYB[y * VPitchY + x];
+            sum_VXFullYF += VXFullYF[y * VPitchY + x];
+            sum_VYFullYB += VYFullYB[y * VPitchY + x];
+            sum_VYFullYF += VYFullYF[y * VPitchY + x];
+            sum_MaskFullYB += MaskFullYB[y * VPitchY + x];
+            sum_MaskFullYF += MaskFullYF[y * VPitchY + x];
           }
-        }
-        if (optDebug > 0) {
-          int sum_VXFullYB = 0;
-          int sum_VXFullYF = 0;
-          int sum_VYFullYB = 0;
-          int sum_VYFullYF = 0;
-          int sum_MaskFullYB = 0;
-          int sum_MaskFullYF = 0;
-          for (int y = 0; y < nHeight; y++)
-            for (int x = 0; x < nWidth; x++) {
-              sum_VXFullYB += VXFullYB[y * VPitchY + x];
-              sum_VXFullYF += VXFullYF[y * VPitchY + x];
-              sum_VYFullYB += VYFullYB[y * VPitchY + x];
-              sum_VYFullYF += VYFullYF[y * VPitchY + x];
-              sum_MaskFullYB += MaskFullYB[y * VPitchY + x];
-              sum_MaskFullYF += MaskFullYF[y * VPitchY + x];
-            }
 
-          int sum_MaskSmallB = 0;
-          int sum_MaskSmallF = 0;
-          for (int y = 0; y < nBlkY; y++)
-            for (int x = 0; x < nBlkX; x++) {
-              sum_MaskSmallB += MaskSmallB[nBlkXP*y + x];
-              sum_MaskSmallF += MaskSmallF[nBlkXP*y + x];
-            }
+        int sum_MaskSmallB = 0;
+        int sum_MaskSmallF = 0;
+        for (int y = 0; y < nBlkY; y++)
+          for (int x = 0; x < nBlkX; x++) {
+            sum_MaskSmallB += MaskSmallB[nBlkXP*y + x];
+            sum_MaskSmallF += MaskSmallF[nBlkXP*y + x];
+          }
 
-          int sum_MaskSmallBP = 0;
-          int sum_MaskSmallFP = 0;
-          for (int y = 0; y < nBlkYP; y++)
-            for (int x = 0; x < nBlkXP; x++) {
-              sum_MaskSmallBP += MaskSmallB[nBlkXP*y + x];
-              sum_MaskSmallFP += MaskSmallB[nBlkXP*y + x];
-            }
-          char buf[2048];
-          sprintf_s(buf, "FlowInterSimple mode=0 or mode=2 not usable");
-          DrawString(dst, vi, 0, 6, buf);
-          sprintf_s(buf, "sum_VXFullYB=%d sum_VXFullYF=%d", sum_VXFullYB, sum_VXFullYF);
-          DrawString(dst, vi, 0, 7, buf);
-          sprintf_s(buf, "sum_VYFullYB=%d sum_VYFullYF=%d", sum_VYFullYB, sum_VYFullYF);
-          DrawString(dst, vi, 0, 8, buf);
-          sprintf_s(buf, "sum_MaskFullYB=%d sum_MaskFullYF=%d", sum_MaskFullYB, sum_MaskFullYF);
-          DrawString(dst, vi, 0, 9, buf);
-          sprintf_s(buf, "sum_MaskSmallBP=%d sum_MaskSmallFP=%d", sum_MaskSmallBP, sum_MaskSmallFP);
-          DrawString(dst, vi, 0, 10, buf);
-          sprintf_s(buf, "sum_MaskSmallB=%d sum_MaskSmallF=%d", sum_MaskSmallB, sum_MaskSmallF);
-          DrawString(dst, vi, 0, 11, buf);
-        }
-        PROFILE_STOP(MOTION_PROFILE_FLOWINTER);
+        int sum_MaskSmallBP = 0;
+        int sum_MaskSmallFP = 0;
+        for (int y = 0; y < nBlkYP; y++)
+          for (int x = 0; x < nBlkXP; x++) {
+            sum_MaskSmallBP += MaskSmallB[nBlkXP*y + x];
+            sum_MaskSmallFP += MaskSmallB[nBlkXP*y + x];
+          }
+        char buf[2048];
+        sprintf_s(buf, "FlowInterSimple mode=0 or mode=2 not usable");
+        DrawString(dst, vi, 0, 6, buf);
+        sprintf_s(buf, "sum_VXFullYB=%d sum_VXFullYF=%d", sum_VXFullYB, sum_VXFullYF);
+        DrawString(dst, vi, 0, 7, buf);
+        sprintf_s(buf, "sum_VYFullYB=%d sum_VYFullYF=%d", sum_VYFullYB, sum_VYFullYF);
+        DrawString(dst, vi, 0, 8, buf);
+        sprintf_s(buf, "sum_MaskFullYB=%d sum_MaskFullYF=%d", sum_MaskFullYB, sum_MaskFullYF);
+        DrawString(dst, vi, 0, 9, buf);
+        sprintf_s(buf, "sum_MaskSmallBP=%d sum_MaskSmallFP=%d", sum_MaskSmallBP, sum_MaskSmallFP);
+        DrawString(dst, vi, 0, 10, buf);
+        sprintf_s(buf, "sum_MaskSmallB=%d sum_MaskSmallF=%d", sum_MaskSmallB, sum_MaskSmallF);
+        DrawString(dst, vi, 0, 11, buf);
       }
       if (optDebug > 0) {
         char buf[2048];
@@ -1026,3 +815,134 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
   }
 
 }
+
+
+
+// Luma rows [td._y_beg, td._y_end) of the padded plane, chroma rows in
+// the same proportion: upsizes the vector and occlusion masks needed for
+// this frame, then interpolates the same rows of the output.
+void MVFlowFps::process_slice(Slicer::TaskData &td)
+{
+  const int y_beg = td._y_beg;
+  const int y_end = td._y_end;
+  int y_beg_uv = y_beg;
+  int y_end_uv = y_end;
+  if (needDistinctChroma)
+  {
+    y_beg_uv = y_beg * nHeightPUV / nHeightP;
+    y_end_uv = y_end * nHeightPUV / nHeightP;
+  }
+
+  // upsize (bilinear interpolate) vector masks to fullframe size
+  if (_resize_b_flag)
+  {
+    upsizer->SimpleResizeDo_int16(VXFullYB, nWidthP, nHeightP, VPitchY, VXSmallYB, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight, y_beg, y_end);
+    upsizer->SimpleResizeDo_int16(VYFullYB, nWidthP, nHeightP, VPitchY, VYSmallYB, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight, y_beg, y_end);
+    if (needDistinctChroma) {
+      upsizerUV->SimpleResizeDo_int16(VXFullUVB, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVB, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV, y_beg_uv, y_end_uv);
+      upsizerUV->SimpleResizeDo_int16(VYFullUVB, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVB, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV, y_beg_uv, y_end_uv);
+    }
+  }
+  upsizer->SimpleResizeDo_uint8(MaskFullYB, nWidthP, nHeightP, VPitchY, MaskSmallB, nBlkXP, nBlkXP, y_beg, y_end);
+  if (needDistinctChroma)
+    upsizerUV->SimpleResizeDo_uint8(MaskFullUVB, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallB, nBlkXP, nBlkXP, y_beg_uv, y_end_uv);
+
+  if (_resize_f_flag)
+  {
+    upsizer->SimpleResizeDo_int16(VXFullYF, nWidthP, nHeightP, VPitchY, VXSmallYF, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight, y_beg, y_end);
+    upsizer->SimpleResizeDo_int16(VYFullYF, nWidthP, nHeightP, VPitchY, VYSmallYF, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight, y_beg, y_end);
+    if (needDistinctChroma) {
+      upsizerUV->SimpleResizeDo_int16(VXFullUVF, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVF, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV, y_beg_uv, y_end_uv);
+      upsizerUV->SimpleResizeDo_int16(VYFullUVF, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVF, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV, y_beg_uv, y_end_uv);
+    }
+  }
+  upsizer->SimpleResizeDo_uint8(MaskFullYF, nWidthP, nHeightP, VPitchY, MaskSmallF, nBlkXP, nBlkXP, y_beg, y_end);
+  if (needDistinctChroma)
+    upsizerUV->SimpleResizeDo_uint8(MaskFullUVF, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallF, nBlkXP, nBlkXP, y_beg_uv, y_end_uv);
+
+  if (_resize_extra_flag)
+  {
+    upsizer->SimpleResizeDo_int16(VXFullYBB, nWidthP, nHeightP, VPitchY, VXSmallYBB, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight, y_beg, y_end);
+    upsizer->SimpleResizeDo_int16(VYFullYBB, nWidthP, nHeightP, VPitchY, VYSmallYBB, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight, y_beg, y_end);
+    if (needDistinctChroma) {
+      upsizerUV->SimpleResizeDo_int16(VXFullUVBB, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVBB, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV, y_beg_uv, y_end_uv);
+      upsizerUV->SimpleResizeDo_int16(VYFullUVBB, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVBB, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV, y_beg_uv, y_end_uv);
+    }
+
+    upsizer->SimpleResizeDo_int16(VXFullYFF, nWidthP, nHeightP, VPitchY, VXSmallYFF, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight, y_beg, y_end);
+    upsizer->SimpleResizeDo_int16(VYFullYFF, nWidthP, nHeightP, VPitchY, VYSmallYFF, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight, y_beg, y_end);
+    if (needDistinctChroma) {
+      upsizerUV->SimpleResizeDo_int16(VXFullUVFF, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVFF, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV, y_beg_uv, y_end_uv);
+      upsizerUV->SimpleResizeDo_int16(VYFullUVFF, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVFF, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV, y_beg_uv, y_end_uv);
+    }
+  }
+
+  flow_rows(0, std::min(y_beg, nHeight), std::min(y_end, nHeight));
+  if (!isGrey) {
+    const int height_uv = needDistinctChroma ? nHeightUV : nHeight;
+    const int yb = std::min(y_beg_uv, height_uv);
+    const int ye = std::min(y_end_uv, height_uv);
+    flow_rows(1, yb, ye);
+    flow_rows(2, yb, ye);
+  }
+}
+
+
+
+// FlowInterExtra, FlowInter or FlowInterSimple (by _flow_mode) on the
+// rows [y_beg, y_end) of a plane.
+void MVFlowFps::flow_rows(int p, int y_beg, int y_end)
+{
+  if (y_beg >= y_end)
+    return;
+
+  // U and V share the luma masks when the chroma is not subsampled
+  const bool uv = (p > 0 && needDistinctChroma);
+  const int VPitch = uv ? VPitchUV : VPitchY;
+  const int width = uv ? nWidthUV : nWidth;
+  const int v_offset = y_beg * VPitch;
+  short *VXFullB = (uv ? VXFullUVB : VXFullYB) + v_offset;
+  short *VXFullF = (uv ? VXFullUVF : VXFullYF) + v_offset;
+  short *VYFullB = (uv ? VYFullUVB : VYFullYB) + v_offset;
+  short *VYFullF = (uv ? VYFullUVF : VYFullYF) + v_offset;
+  BYTE *MaskFullB = (uv ? MaskFullUVB : MaskFullYB) + v_offset;
+  BYTE *MaskFullF = (uv ? MaskFullUVF : MaskFullYF) + v_offset;
+
+  BYTE *pdst = _dst_ptr_arr[p] + y_beg * _dst_pitch_arr[p];
+  const int ref_row_offset = y_beg * _ref_pitch_arr[p] * nPel;
+  const BYTE *pref = _ref_ptr_arr[p] + ref_row_offset;
+  const BYTE *psrc = _src_ptr_arr[p] + ref_row_offset;
+  const int height = y_end - y_beg;
+
+  if (_flow_mode == 2)
+  {
+    short *VXFullBB = (uv ? VXFullUVBB : VXFullYBB) + v_offset;
+    short *VXFullFF = (uv ? VXFullUVFF : VXFullYFF) + v_offset;
+    short *VYFullBB = (uv ? VYFullUVBB : VYFullYBB) + v_offset;
+    short *VYFullFF = (uv ? VYFullUVFF : VYFullYFF) + v_offset;
+    decltype(&FlowInterExtra<uint8_t>) flow_fn =
+      (pixelsize_super == 1) ? FlowInterExtra<uint8_t> :
+      (pixelsize_super == 2) ? FlowInterExtra<uint16_t> :
+      FlowInterExtra<float>;
+    flow_fn(pdst, _dst_pitch_arr[p], pref, psrc, _ref_pitch_arr[p],
+      VXFullB, VXFullF, VYFullB, VYFullF, MaskFullB, MaskFullF, VPitch,
+      width, height, _time256, nPel, VXFullBB, VXFullFF, VYFullBB, VYFullFF);
+  }
+  else
+  {
+    decltype(&FlowInter<uint8_t>) flow_fn;
+    if (_flow_mode == 1)
+      flow_fn =
+        (pixelsize_super == 1) ? FlowInter<uint8_t> :
+        (pixelsize_super == 2) ? FlowInter<uint16_t> :
+        FlowInter<float>;
+    else
+      flow_fn =
+        (pixelsize_super == 1) ? FlowInterSimple<uint8_t> :
+        (pixelsize_super == 2) ? FlowInterSimple<uint16_t> :
+        FlowInterSimple<float>;
+    flow_fn(pdst, _dst_pitch_arr[p], pref, psrc, _ref_pitch_arr[p],
+      VXFullB, VXFullF, VYFullB, VYFullF, MaskFullB, MaskFullF, VPitch,
+      width, height, _time256, nPel);
+  }
+}
@@ -3,6 +3,7 @@
 
 #include "MVClip.h"
 #include "MVFilter.h"
+#include "MTSlicer.h"
 #include "SimpleResize.h"
 #include "yuy2planes.h"
 #include <atomic>
@@ -35,6 +36,11 @@ private:
 
   int nleftLast;
   int nrightLast;
+  // source pair of the extra (maskmode=2) vector fields, and their usability
+  int nleftLastExtra;
+  int nrightLastExtra;
+  bool isUsableBBLast;
+  bool isUsableFFLast;
 
   int64_t fa, fb;
 
@@ -117,9 +123,28 @@ private:
   int nLogxRatioUVs[3];
   int nLogyRatioUVs[3];
 
+  typedef MTSlicer <MVFlowFps> Slicer;
+
+  const bool _mt_flag;
+
+  // per-frame data for the row slices
+  BYTE *_dst_ptr_arr[3];
+  const BYTE *_src_ptr_arr[3]; // with padding offset
+  const BYTE *_ref_ptr_arr[3]; // with padding offset
+  int _dst_pitch_arr[3];
+  int _ref_pitch_arr[3];
+  int _time256;
+  bool _resize_b_flag; // new source pair: B vectors to upsize
+  bool _resize_f_flag; // new source pair: F vectors to upsize
+  bool _resize_extra_flag; // new source pair: BB and FF vectors to upsize
+  int _flow_mode; // 0: FlowInterSimple, 1: FlowInter, 2: FlowInterExtra
+
+  void process_slice(Slicer::TaskData &td);
+  void flow_rows(int p, int y_beg, int y_end);
+
 public:
   MVFlowFps(PClip _child, PClip _super, PClip _mvbw, PClip _mvfw, unsigned int _num, unsigned int _den, int _maskmode, double _ml,
-    bool _blend, sad_t nSCD1, int nSCD2, bool isse, bool _planar, int _optDebug, IScriptEnvironment* env);
+    bool _blend, sad_t nSCD1, int nSCD2, bool isse, bool _planar, int _optDebug, bool mt_flag, IScriptEnvironment* env);
   ~MVFlowFps();
   PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) override;
 
@@ -28,11 +28,12 @@
 #include "commonfunctions.h"
 
 MVFlowInter::MVFlowInter(PClip _child, PClip super, PClip _mvbw, PClip _mvfw, int _time256, double _ml,
-  bool _blend, sad_t nSCD1, int nSCD2, bool _isse, bool _planar, IScriptEnvironment* env) :
+  bool _blend, sad_t nSCD1, int nSCD2, bool _isse, bool _planar, bool mt_flag, IScriptEnvironment* env) :
   GenericVideoFilter(_child),
   MVFilter(_mvfw, "MFlowInter", env, 1, 0),
   mvClipB(_mvbw, nSCD1, nSCD2, env, 1, 0),
-  mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0)
+  mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0),
+  _mt_flag(mt_flag)
 {
   has_at_least_v8 = true;
   try { env->CheckVersion(8); }
@@ -401,7 +402,9 @@ PVideoFrame __stdcall MVFlowInter::GetFrame(int n, IScriptEnvironment* env)
     mvClipB.Update(mvBB, env);// backward from next next to next
     mvBB = 0;
 
-    if (mvClipB.IsUsable() && mvClipF.IsUsable())
+    // bad extra frames: use old method without extra frames
+    _extra_flag = mvClipB.IsUsable() && mvClipF.IsUsable();
+    if (_extra_flag)
     {
       // get vector mask from extra frames
       MakeVectorSmallMasks(mvClipB, nBlkX, nBlkY, VXSmallYBB, nBlkXP, VYSmallYBB, nBlkXP);
@@ -415,146 +418,28 @@ PVideoFrame __stdcall MVFlowInter::GetFrame(int n, IScriptEnvironment* env)
         VectorSmallMaskYToHalfUV(VXSmallYFF, nBlkXP, nBlkYP, VXSmallUVFF, xRatioUVs[1]);
         VectorSmallMaskYToHalfUV(VYSmallYFF, nBlkXP, nBlkYP, VYSmallUVFF, yRatioUVs[1]);
       }
-
-      // Upsize Y: B and F vectors and mask to full frame (same for MFlowInter and MFlowInterExtra)
-      upsizer->SimpleResizeDo_int16(VXFull_B, nWidthP, nHeightP, VPitchY, VXSmallYB, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VYFull_B, nWidthP, nHeightP, VPitchY, VYSmallYB, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VXFull_F, nWidthP, nHeightP, VPitchY, VXSmallYF, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VYFull_F, nWidthP, nHeightP, VPitchY, VYSmallYF, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight);
-
-      upsizer->SimpleResizeDo_uint8(MaskFull_B, nWidthP, nHeightP, VPitchY, MaskSmallB, nBlkXP, nBlkXP);
-      upsizer->SimpleResizeDo_uint8(MaskFull_F, nWidthP, nHeightP, VPitchY, MaskSmallF, nBlkXP, nBlkXP);
-
-      // Upsize Y: BB and FF vectors to full frame (MFlowInterExtra only)
-      upsizer->SimpleResizeDo_int16(VXFull_BB, nWidthP, nHeightP, VPitchY, VXSmallYBB, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VYFull_BB, nWidthP, nHeightP, VPitchY, VYSmallYBB, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VXFull_FF, nWidthP, nHeightP, VPitchY, VXSmallYFF, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VYFull_FF, nWidthP, nHeightP, VPitchY, VYSmallYFF, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight);
-
-      // FlowInterExtra Y
-      if (pixelsize_super == 1) {
-        FlowInterExtra<uint8_t>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-          VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchY,
-          nWidth, nHeight, time256, nPel, VXFull_BB, VXFull_FF, VYFull_BB, VYFull_FF);
-      }
-      else if (pixelsize_super == 2) {
-        FlowInterExtra<uint16_t>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-          VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchY,
-          nWidth, nHeight, time256, nPel, VXFull_BB, VXFull_FF, VYFull_BB, VYFull_FF);
-      }
-      else if (pixelsize_super == 4) {
-        FlowInterExtra<float>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-          VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchY,
-          nWidth, nHeight, time256, nPel, VXFull_BB, VXFull_FF, VYFull_BB, VYFull_FF);
-      }
-
-      // Upsize UV: B and F vectors and mask to full frame (same for MFlowInter and MFlowInterExtra)
-      if (!isGrey) {
-        upsizerUV->SimpleResizeDo_int16(VXFull_B, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVB, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VYFull_B, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVB, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VXFull_F, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVF, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VYFull_F, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVF, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV);
-
-        upsizerUV->SimpleResizeDo_uint8(MaskFull_B, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallB, nBlkXP, nBlkXP);
-        upsizerUV->SimpleResizeDo_uint8(MaskFull_F, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallF, nBlkXP, nBlkXP);
-
-        // Upsize UV: BB and FF vectors to full frame (MFlowInterExtra only)
-        upsizerUV->SimpleResizeDo_int16(VXFull_BB, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVBB, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VYFull_BB, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVBB, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VXFull_FF, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVFF, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VYFull_FF, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVFF, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV);
-
-        // FlowInterExtra U/V
-        if (pixelsize_super == 1) {
-          FlowInterExtra<uint8_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-            VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchUV,
-            nWidthUV, nHeightUV, time256, nPel, VXFull_BB, VXFull_FF, VYFull_BB, VYFull_FF);
-          FlowInterExtra<uint8_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-            VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchUV,
-            nWidthUV, nHeightUV, time256, nPel, VXFull_BB, VXFull_FF, VYFull_BB, VYFull_FF);
-        }
-        else if (pixelsize_super == 2) {
-          FlowInterExtra<uint16_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-            VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchUV,
-            nWidthUV, nHeightUV, time256, nPel, VXFull_BB, VXFull_FF, VYFull_BB, VYFull_FF);
-          FlowInterExtra<uint16_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-            VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchUV,
-            nWidthUV, nHeightUV, time256, nPel, VXFull_BB, VXFull_FF, VYFull_BB, VYFull_FF);
-        }
-        else if (pixelsize_super == 4) {
-          FlowInterExtra<float>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-            VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchUV,
-            nWidthUV, nHeightUV, time256, nPel, VXFull_BB, VXFull_FF, VYFull_BB, VYFull_FF);
-          FlowInterExtra<float>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-            VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchUV,
-            nWidthUV, nHeightUV, time256, nPel, VXFull_BB, VXFull_FF, VYFull_BB, VYFull_FF);
-        }
-      }
     }
-    else // bad extra frames, use old method without extra frames
-    {
-      // Upsize Y: B and F vectors and mask to full frame (same for MFlowInter and MFlowInterExtra)
-      upsizer->SimpleResizeDo_int16(VXFull_B, nWidthP, nHeightP, VPitchY, VXSmallYB, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VYFull_B, nWidthP, nHeightP, VPitchY, VYSmallYB, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VXFull_F, nWidthP, nHeightP, VPitchY, VXSmallYF, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight);
-      upsizer->SimpleResizeDo_int16(VYFull_F, nWidthP, nHeightP, VPitchY, VYSmallYF, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight);
-
-      upsizer->SimpleResizeDo_uint8(MaskFull_B, nWidthP, nHeightP, VPitchY, MaskSmallB, nBlkXP, nBlkXP);
-      upsizer->SimpleResizeDo_uint8(MaskFull_F, nWidthP, nHeightP, VPitchY, MaskSmallF, nBlkXP, nBlkXP);
-
-      // FlowInter Y
-      if (pixelsize_super == 1) {
-        FlowInter<uint8_t>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-          VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchY,
-          nWidth, nHeight, time256, nPel);
-      }
-      else if (pixelsize_super == 2) {
-        FlowInter<uint16_t>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-          VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchY,
-          nWidth, nHeight, time256, nPel);
-      }
-      else if (pixelsize_super == 4) {
-        FlowInter<float>(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-          VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchY,
-          nWidth, nHeight, time256, nPel);
-      }
 
-      // Upsize UV: B and F vectors and mask to full frame (same for MFlowInter and MFlowInterExtra)
-      if (!isGrey) {
-        upsizerUV->SimpleResizeDo_int16(VXFull_B, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVB, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VYFull_B, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVB, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VXFull_F, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVF, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV);
-        upsizerUV->SimpleResizeDo_int16(VYFull_F, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVF, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV);
-
-        upsizerUV->SimpleResizeDo_uint8(MaskFull_B, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallB, nBlkXP, nBlkXP);
-        upsizerUV->SimpleResizeDo_uint8(MaskFull_F, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallF, nBlkXP, nBlkXP);
+    for (int p = 0; p < planecount; ++p)
+    {
+      _dst_ptr_arr[p] = pDst[p];
+      _dst_pitch_arr[p] = nDstPitches[p];
+      _src_ptr_arr[p] = pSrc[p] + ((p == 0) ? nOffsetY : nOffsetUV);
+      _ref_ptr_arr[p] = pRef[p] + ((p == 0) ? nOffsetY : nOffsetUV);
+      _ref_pitch_arr[p] = nRefPitches[p];
+    }
 
-        // FlowInter U/V
-        if (pixelsize_super == 1) {
-          FlowInter<uint8_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-            VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchUV,
-            nWidthUV, nHeightUV, time256, nPel);
-          FlowInter<uint8_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-            VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchUV,
-            nWidthUV, nHeightUV, time256, nPel);
-        }
-        else if (pixelsize_super == 2) {
-          FlowInter<uint16_t>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-            VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchUV,
-            nWidthUV, nHeightUV, time256, nPel);
-          FlowInter<uint16_t>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-            VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchUV,
-            nWidthUV, nHeightUV, time256, nPel);
-        }
-        else if (pixelsize_super == 4) {
-          FlowInter<float>(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-            VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchUV,
-            nWidthUV, nHeightUV, time256, nPel);
-          FlowInter<float>(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-            VXFull_B, VXFull_F, VYFull_B, VYFull_F, MaskFull_B, MaskFull_F, VPitchUV,
-            nWidthUV, nHeightUV, time256, nPel);
-        }
-      }
+    // Upsizing and FlowInter work on independent rows: slice them.
+    // Y and U/V share the fullframe buffers, so U/V needs its own pass.
+    Slicer slicer(_mt_flag);
+    _chroma_pass_flag = false;
+    slicer.start(nHeightP, *this, &MVFlowInter::process_slice, 4);
+    slicer.wait();
+    if (!isGrey)
+    {
+      _chroma_pass_flag = true;
+      slicer.start(nHeightPUV, *this, &MVFlowInter::process_slice, 4);
+      slicer.wait();
     }
 
     if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
@@ -637,3 +522,107 @@ PVideoFrame __stdcall MVFlowInter::GetFrame(int n, IScriptEnvironment* env)
     }
   }
 }
+
+
+
+// Upsizes the vector and occlusion masks for the rows [td._y_beg, td._y_end)
+// of the padded plane and interpolates the same rows of the output.
+void MVFlowInter::process_slice(Slicer::TaskData &td)
+{
+  const int y_beg = td._y_beg;
+  const int y_end = td._y_end;
+
+  if (!_chroma_pass_flag)
+  {
+    // Upsize Y: B and F vectors and mask to full frame (same for MFlowInter and MFlowInterExtra)
+    upsizer->SimpleResizeDo_int16(VXFull_B, nWidthP, nHeightP, VPitchY, VXSmallYB, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight, y_beg, y_end);
+    upsizer->SimpleResizeDo_int16(VYFull_B, nWidthP, nHeightP, VPitchY, VYSmallYB, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight, y_beg, y_end);
+    upsizer->SimpleResizeDo_int16(VXFull_F, nWidthP, nHeightP, VPitchY, VXSmallYF, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight, y_beg, y_end);
+    upsizer->SimpleResizeDo_int16(VYFull_F, nWidthP, nHeightP, VPitchY, VYSmallYF, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight, y_beg, y_end);
+
+    upsizer->SimpleResizeDo_uint8(MaskFull_B, nWidthP, nHeightP, VPitchY, MaskSmallB, nBlkXP, nBlkXP, y_beg, y_end);
+    upsizer->SimpleResizeDo_uint8(MaskFull_F, nWidthP, nHeightP, VPitchY, MaskSmallF, nBlkXP, nBlkXP, y_beg, y_end);
+
+    if (_extra_flag)
+    {
+      // Upsize Y: BB and FF vectors to full frame (MFlowInterExtra only)
+      upsizer->SimpleResizeDo_int16(VXFull_BB, nWidthP, nHeightP, VPitchY, VXSmallYBB, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight, y_beg, y_end);
+      upsizer->SimpleResizeDo_int16(VYFull_BB, nWidthP, nHeightP, VPitchY, VYSmallYBB, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight, y_beg, y_end);
+      upsizer->SimpleResizeDo_int16(VXFull_FF, nWidthP, nHeightP, VPitchY, VXSmallYFF, nBlkXP, nBlkXP, nPel, true, nWidth, nHeight, y_beg, y_end);
+      upsizer->SimpleResizeDo_int16(VYFull_FF, nWidthP, nHeightP, VPitchY, VYSmallYFF, nBlkXP, nBlkXP, nPel, false, nWidth, nHeight, y_beg, y_end);
+    }
+
+    flow_rows(0, VPitchY, nWidth, std::min(y_beg, nHeight), std::min(y_end, nHeight));
+  }
+  else
+  {
+    // Upsize UV: B and F vectors and mask to full frame (same for MFlowInter and MFlowInterExtra)
+    upsizerUV->SimpleResizeDo_int16(VXFull_B, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVB, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV, y_beg, y_end);
+    upsizerUV->SimpleResizeDo_int16(VYFull_B, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVB, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV, y_beg, y_end);
+    upsizerUV->SimpleResizeDo_int16(VXFull_F, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVF, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV, y_beg, y_end);
+    upsizerUV->SimpleResizeDo_int16(VYFull_F, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVF, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV, y_beg, y_end);
+
+    upsizerUV->SimpleResizeDo_uint8(MaskFull_B, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallB, nBlkXP, nBlkXP, y_beg, y_end);
+    upsizerUV->SimpleResizeDo_uint8(MaskFull_F, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallF, nBlkXP, nBlkXP, y_beg, y_end);
+
+    if (_extra_flag)
+    {
+      // Upsize UV: BB and FF vectors to full frame (MFlowInterExtra only)
+      upsizerUV->SimpleResizeDo_int16(VXFull_BB, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVBB, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV, y_beg, y_end);
+      upsizerUV->SimpleResizeDo_int16(VYFull_BB, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVBB, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV, y_beg, y_end);
+      upsizerUV->SimpleResizeDo_int16(VXFull_FF, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVFF, nBlkXP, nBlkXP, nPel, true, nWidthUV, nHeightUV, y_beg, y_end);
+      upsizerUV->SimpleResizeDo_int16(VYFull_FF, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVFF, nBlkXP, nBlkXP, nPel, false, nWidthUV, nHeightUV, y_beg, y_end);
+    }
+
+    flow_rows(1, VPitchUV, nWidthUV, std::min(y_beg, nHeightUV), std::min(y_end, nHeightUV));
+    flow_rows(2, VPitchUV, nWidthUV, std::min(y_beg, nHeightUV), std::min(y_end, nHeightUV));
+  }
+}
+
+
+
+// FlowInter or FlowInterExtra on the rows [y_beg, y_end) of a plane.
+// The fullframe masks must be ready for these rows.
+void MVFlowInter::flow_rows(int p, int VPitch, int width, int y_beg, int y_end)
+{
+  if (y_beg >= y_end)
+    return;
+
+  BYTE *pdst = _dst_ptr_arr[p] + y_beg * _dst_pitch_arr[p];
+  const int ref_row_offset = y_beg * _ref_pitch_arr[p] * nPel;
+  const BYTE *pref = _ref_ptr_arr[p] + ref_row_offset;
+  const BYTE *psrc = _src_ptr_arr[p] + ref_row_offset;
+  const int v_offset = y_beg * VPitch;
+  const int height = y_end - y_beg;
+
+  decltype(&FlowInter<uint8_t>) flow_fn = nullptr;
+  decltype(&FlowInterExtra<uint8_t>) flow_extra_fn = nullptr;
+  if (pixelsize_super == 1) {
+    flow_fn = FlowInter<uint8_t>;
+    flow_extra_fn = FlowInterExtra<uint8_t>;
+  }
+  else if (pixelsize_super == 2) {
+    flow_fn = FlowInter<uint16_t>;
+    flow_extra_fn = FlowInterExtra<uint16_t>;
+  }
+  else if (pixelsize_super == 4) {
+    flow_fn = FlowInter<float>;
+    flow_extra_fn = FlowInterExtra<float>;
+  }
+
+  if (_extra_flag)
+  {
+    flow_extra_fn(pdst, _dst_pitch_arr[p], pref, psrc, _ref_pitch_arr[p],
+      VXFull_B + v_offset, VXFull_F + v_offset, VYFull_B + v_offset, VYFull_F + v_offset,
+      MaskFull_B + v_offset, MaskFull_F + v_offset, VPitch,
+      width, height, time256, nPel,
+      VXFull_BB + v_offset, VXFull_FF + v_offset, VYFull_BB + v_offset, VYFull_FF + v_offset);
+  }
+  else
+  {
+    flow_fn(pdst, _dst_pitch_arr[p], pref, psrc, _ref_pitch_arr[p],
+      VXFull_B + v_offset, VXFull_F + v_offset, VYFull_B + v_offset, VYFull_F + v_offset,
+      MaskFull_B + v_offset, MaskFull_F + v_offset, VPitch,
+      width, height, time256, nPel);
+  }
+}
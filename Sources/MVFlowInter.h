@@ -3,6 +3,7 @@
 
 #include "MVClip.h"
 #include "MVFilter.h"
+#include "MTSlicer.h"
 #include "SimpleResize.h"
 #include "yuy2planes.h"
 
@@ -92,9 +93,25 @@ private:
   int nLogxRatioUVs[3];
   int nLogyRatioUVs[3];
 
+  typedef MTSlicer <MVFlowInter> Slicer;
+
+  const bool _mt_flag;
+
+  // per-frame data for the row slices
+  BYTE *_dst_ptr_arr[3];
+  const BYTE *_src_ptr_arr[3]; // with padding offset
+  const BYTE *_ref_ptr_arr[3]; // with padding offset
+  int _dst_pitch_arr[3];
+  int _ref_pitch_arr[3];
+  bool _extra_flag; // BB and FF vectors are usable
+  bool _chroma_pass_flag;
+
+  void process_slice(Slicer::TaskData &td);
+  void flow_rows(int p, int VPitch, int width, int y_beg, int y_end);
+
 public:
   MVFlowInter(PClip _child, PClip _finest, PClip _mvbw, PClip _mvfw, int _time256, double _ml,
-    bool _blend, sad_t nSCD1, int nSCD2, bool isse, bool _planar, IScriptEnvironment* env);
+    bool _blend, sad_t nSCD1, int nSCD2, bool isse, bool _planar, bool mt_flag, IScriptEnvironment* env);
   ~MVFlowInter();
   PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) override;
 
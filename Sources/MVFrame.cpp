@@ -120,6 +120,24 @@ void	MVFrame::set_interp (MVPlaneSet _nMode, int rfilter, int sharp)
 
 
 
+void	MVFrame::set_lazy_refine (MVPlaneSet _nMode, int sharp)
+{
+   if (nMode & YPLANE & _nMode)
+	{
+      pYPlane->set_lazy_refine (sharp);
+	}
+   if (nMode & UPLANE & _nMode)
+	{
+      pUPlane->set_lazy_refine (sharp);
+	}
+   if (nMode & VPLANE & _nMode)
+	{
+      pVPlane->set_lazy_refine (sharp);
+	}
+}
+
+
+
 void MVFrame::Refine(MVPlaneSet _nMode)
 {
    if (nMode & YPLANE & _nMode)
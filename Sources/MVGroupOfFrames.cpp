@@ -97,6 +97,14 @@ void	MVGroupOfFrames::set_interp (MVPlaneSet nMode, int rfilter, int sharp)
 
 
 
+// Only the finest frame can have sub-pixel planes
+void	MVGroupOfFrames::set_lazy_refine (MVPlaneSet nMode, int sharp)
+{
+   pFrames[0]->set_lazy_refine (nMode, sharp);
+}
+
+
+
 void MVGroupOfFrames::Refine(MVPlaneSet nMode)
 {
    pFrames[0]->Refine(nMode);
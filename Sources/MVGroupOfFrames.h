@@ -53,6 +53,7 @@ public :
    MVFrame *GetFrame(int nLevel);
    void SetPlane(const uint8_t *pNewSrc, int nNewPitch, MVPlaneSet nMode);
    void set_interp (MVPlaneSet nMode, int rfilter, int sharp);
+   void set_lazy_refine (MVPlaneSet nMode, int sharp);
    void Refine(MVPlaneSet nMode);
    void Pad(MVPlaneSet nMode);
    void Reduce(MVPlaneSet nMode);
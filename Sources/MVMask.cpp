@@ -280,10 +280,11 @@ PVideoFrame __stdcall MVMask::GetFrame(int n, IScriptEnvironment* env)
   if (mvClip.IsUsable())
   {
     // smallMask is 8 bits, this is the target
+    const FakePlaneOfBlocks &plane0 = mvClip.GetPlane(0);
     if (kind == 0) // vector length mask
     {
       for (int j = 0; j < nBlkCount; j++)
-        smallMask[j] = Length(mvClip.GetBlock(0, j).GetMV(), mvClip.GetPel());
+        smallMask[j] = Length(plane0.GetMV(j), mvClip.GetPel());
     }
     else if (kind == 1) // SAD mask
     {
@@ -303,24 +304,27 @@ PVideoFrame __stdcall MVMask::GetFrame(int n, IScriptEnvironment* env)
     }
     else if (kind == 3) // vector x mask
     {
+      const int *vx_arr = plane0.GetArrayVx();
       for (int j = 0; j < nBlkCount; j++)
-        smallMask[j] = std::max(int(0), std::min(255, int(mvClip.GetBlock(0, j).GetMV().x * fMaskNormFactor * 100 + 128))); // shited by 128 for signed support
+        smallMask[j] = std::max(int(0), std::min(255, int(vx_arr[j] * fMaskNormFactor * 100 + 128))); // shited by 128 for signed support
       //smallMask[j] = mvClip.GetBlock(0, j).GetMV().x + 128; // shited by 128 for signed support
     }
     else if (kind == 4) // vector y mask
     {
+      const int *vy_arr = plane0.GetArrayVy();
       for (int j = 0; j < nBlkCount; j++)
-        smallMask[j] = std::max(int(0), std::min(255, int(mvClip.GetBlock(0, j).GetMV().y * fMaskNormFactor * 100 + 128))); // shited by 128 for signed support
+        smallMask[j] = std::max(int(0), std::min(255, int(vy_arr[j] * fMaskNormFactor * 100 + 128))); // shited by 128 for signed support
       //smallMask[j] = mvClip.GetBlock(0, j).GetMV().y + 128; // shited by 128 for signed support
     }
     else if (kind == 5) // vector x mask in U, y mask in V
     {
+      const int *vx_arr = plane0.GetArrayVx();
+      const int *vy_arr = plane0.GetArrayVy();
       for (int j = 0; j < nBlkCount; j++) {
-        VECTOR v = mvClip.GetBlock(0, j).GetMV();
-      //smallMask[j] = v.x + 128; // shited by 128 for signed support
-      //smallMaskV[j] = v.y + 128; // shited by 128 for signed support
-        smallMask[j] = std::max(0, std::min(255, int(v.x * fMaskNormFactor * 100 + 128))); // shifted by 128 for signed support
-        smallMaskV[j] = std::max(0, std::min(255, int(v.y * fMaskNormFactor * 100 + 128))); // shifted by 128 for signed support
+      //smallMask[j] = vx_arr[j] + 128; // shited by 128 for signed support
+      //smallMaskV[j] = vy_arr[j] + 128; // shited by 128 for signed support
+        smallMask[j] = std::max(0, std::min(255, int(vx_arr[j] * fMaskNormFactor * 100 + 128))); // shifted by 128 for signed support
+        smallMaskV[j] = std::max(0, std::min(255, int(vy_arr[j] * fMaskNormFactor * 100 + 128))); // shifted by 128 for signed support
       }
     }
 
@@ -29,9 +29,26 @@ We have a lot of dependencies between the planes that kills the parallelism.
 A better optimisation would be slicing each plane. However this requires a
 significant modification of the assembly code to handle correctly the plane
 boundaries.
+
+Lazy refine (set_lazy_refine()):
+The sub-pixel planes are not computed by refine_start(). Instead, the
+accessors render the stripes of rows of the requested plane on first access.
+The super frame is shared by all the clients and their instances, so it is
+never written: the sub-pixel planes are rendered into a buffer owned by the
+MVPlane, and only the full-pel plane is read from the frame.
+The vertical kernels process the rows at the plane boundaries differently,
+so a partial range is computed with a few context rows into a temporary
+buffer, and the result is identical to the full-plane rendering.
+
+Integral images (GetAbsoluteBlockSum()):
+Used by the successive elimination search to get the sum of any reference
+block in constant time. They are built on first use for each sub-pixel plane
+and kept until the next Update(), so all the blocks searched in the frame
+share them.
 */
 
 
+#include "conc/CritSec.h"
 #include "CopyCode.h"
 #include "Interpolation.h"
 #include "MVPlane.h"
@@ -66,6 +83,16 @@ MVPlane::MVPlane(int _nWidth, int _nHeight, int _nPel, int _nHPad, int _nVPad, i
   , _plan_refine()
   , _slicer_reduce(mt_flag)
   , _redp_ptr(0)
+  , _lazy_flag(false)
+  , _lazy_nbr_stripes(0)
+  , _lazy_done_arr()
+  , _lazy_mutex()
+  , _lazy_tmp_arr()
+  , _lazy_buf_ptr(0)
+  , _lazy_buf_size(0)
+  , _integral_arr()
+  , _integral_done_arr()
+  , _integral_mutex()
 {
   bool _isse = !!(cpuFlags & CPUF_SSE2);
   bool hasSSE41 = !!(cpuFlags & CPUF_SSE4_1);
@@ -110,6 +137,8 @@ MVPlane::MVPlane(int _nWidth, int _nHeight, int _nPel, int _nHPad, int _nVPad, i
 
 MVPlane::~MVPlane()
 {
+  _aligned_free(_lazy_buf_ptr);
+  _lazy_buf_ptr = 0;
   delete[] pPlane;
   pPlane = 0;
 }
@@ -135,6 +164,43 @@ void MVPlane::set_interp(int rfilter, int sharp)
     break;
   };
 
+  build_plan_refine();
+}
+
+
+
+// Renders the sub-pixel planes on demand, see the top of the file.
+// To be called on a plane whose sub-pixel planes are not computed by the
+// super clip. sharp is the interpolation used by MSuper.
+void MVPlane::set_lazy_refine(int sharp)
+{
+  if (nPel > 1)
+  {
+    nSharp = sharp;
+    build_plan_refine();
+
+    for (int idx = 0; idx < 16; ++idx)
+    {
+      _lazy_dep_mask_arr[idx] = 0;
+    }
+    for (int idx = 1; idx < nPel * nPel; ++idx)
+    {
+      for (MTFlowGraphSimple <16>::Iterator it = _plan_refine.get_out_node_it(idx); it.cont(); it.next())
+      {
+        _lazy_dep_mask_arr[it.get_index()] |= 1 << idx;
+      }
+    }
+
+    _lazy_nbr_stripes = (nExtendedHeight + (1 << LAZY_STRIPE_L2) - 1) >> LAZY_STRIPE_L2;
+    _lazy_done_arr.resize(nPel * nPel * _lazy_nbr_stripes);
+    _lazy_flag = true;
+  }
+}
+
+
+
+void MVPlane::build_plan_refine()
+{
   _plan_refine.clear();
   if (nSharp == 0)
   {
@@ -204,12 +270,45 @@ void MVPlane::Update(uint8_t* pSrc, int _nPitch) //v2.0
 
   nOffsetPadding = nPitch * nVPadding + (nHPadding << pixelsize_shift);
 
-  for (int i = 0; i < nPel * nPel; i++)
+  if (_lazy_flag)
   {
-    pPlane[i] = pSrc + i * nPitch * nExtendedHeight;
+    // Sub-pixel planes in the private buffer, same layout as in the frame
+    const int plane_size = nPitch * nExtendedHeight;
+    const int buf_size = plane_size * (nPel * nPel - 1);
+    if (buf_size > _lazy_buf_size)
+    {
+      _aligned_free(_lazy_buf_ptr);
+      _lazy_buf_ptr = (uint8_t *)_aligned_malloc(buf_size, 64);
+      _lazy_buf_size = buf_size;
+    }
+    pPlane[0] = pSrc;
+    for (int i = 1; i < nPel * nPel; i++)
+    {
+      pPlane[i] = _lazy_buf_ptr + (i - 1) * plane_size;
+    }
+  }
+  else
+  {
+    for (int i = 0; i < nPel * nPel; i++)
+    {
+      pPlane[i] = pSrc + i * nPitch * nExtendedHeight;
+    }
   }
 
   ResetState();
+
+  for (int idx = 0; idx < nPel * nPel; ++idx)
+  {
+    _integral_done_arr[idx] = 0;
+  }
+
+  if (_lazy_flag)
+  {
+    for (int pos = 0; pos < int(_lazy_done_arr.size()); ++pos)
+    {
+      _lazy_done_arr[pos] = 0;
+    }
+  }
 }
 
 
@@ -269,6 +368,15 @@ void MVPlane::refine_wait()
       _sched_refine.wait();
     }
 
+    // Everything is rendered now
+    if (_lazy_flag)
+    {
+      for (int pos = 0; pos < int(_lazy_done_arr.size()); ++pos)
+      {
+        _lazy_done_arr[pos] = 1;
+      }
+    }
+
     isRefined = true;
   }
 }
@@ -437,30 +545,49 @@ void MVPlane::refine_pel2(SchedulerRefine::TaskData &td)
 {
   assert(&td != 0);
 
-  switch (td._task_index)
+  refine_rows_pel2(td._task_index, 0, nExtendedHeight);
+}
+
+
+
+void MVPlane::refine_pel4(SchedulerRefine::TaskData &td)
+{
+  assert(&td != 0);
+
+  refine_rows_pel4(td._task_index, 0, nExtendedHeight);
+}
+
+
+
+// Renders the rows [y_beg ; y_end[ of the sub-pixel plane idx.
+// The planes it depends on must be ready for these rows, plus the next one.
+void MVPlane::refine_rows_pel2(int idx, int y_beg, int y_end) const
+{
+  switch (idx)
   {
   case 0:  break;	// Nothing on the root node
   case 1:
     switch (nSharp)
     {
-    case 0: _bilin_hor_ptr(pPlane[1], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
-    case 1: _bicubic_hor_ptr(pPlane[1], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
-    default: _wiener_hor_ptr(pPlane[1], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
+    case 0: interp_hor(_bilin_hor_ptr, 1, 0, y_beg, y_end); break;
+    case 1: interp_hor(_bicubic_hor_ptr, 1, 0, y_beg, y_end); break;
+    default: interp_hor(_wiener_hor_ptr, 1, 0, y_beg, y_end); break;
     }
+    break;
   case 2:
     switch (nSharp)
     {
-    case 0: _bilin_ver_ptr(pPlane[2], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
-    case 1: _bicubic_ver_ptr(pPlane[2], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
-    default: _wiener_ver_ptr(pPlane[2], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
+    case 0: interp_ver(_bilin_ver_ptr, 2, 0, y_beg, y_end); break;
+    case 1: interp_ver(_bicubic_ver_ptr, 2, 0, y_beg, y_end); break;
+    default: interp_ver(_wiener_ver_ptr, 2, 0, y_beg, y_end); break;
     }
     break;
   case 3:
     switch (nSharp)
     {
-    case 0: _bilin_dia_ptr(pPlane[3], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
-    case 1: _bicubic_hor_ptr(pPlane[3], pPlane[2], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;	// faster from ready-made horizontal
-    default: _wiener_hor_ptr(pPlane[3], pPlane[2], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;	// faster from ready-made horizontal
+    case 0: interp_ver(_bilin_dia_ptr, 3, 0, y_beg, y_end); break;
+    case 1: interp_hor(_bicubic_hor_ptr, 3, 2, y_beg, y_end); break;	// faster from ready-made horizontal
+    default: interp_hor(_wiener_hor_ptr, 3, 2, y_beg, y_end); break;	// faster from ready-made horizontal
     }
     break;
   default:
@@ -471,49 +598,47 @@ void MVPlane::refine_pel2(SchedulerRefine::TaskData &td)
 
 
 
-void MVPlane::refine_pel4(SchedulerRefine::TaskData &td)
+void MVPlane::refine_rows_pel4(int idx, int y_beg, int y_end) const
 {
-  assert(&td != 0);
-
-  switch (td._task_index)
+  switch (idx)
   {
   case 0:  break;	// Nothing on the root node
-  case 1:  _average_ptr(pPlane[1], pPlane[0], pPlane[2], nPitch, nExtendedWidth, nExtendedHeight); break;
+  case 1:  average_rows(1, 0, 0, 0, 2, y_beg, y_end); break;
   case 2:
     switch (nSharp)
     {
-    case 0: _bilin_hor_ptr(pPlane[2], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
-    case 1: _bicubic_hor_ptr(pPlane[2], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
-    default: _wiener_hor_ptr(pPlane[2], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
+    case 0: interp_hor(_bilin_hor_ptr, 2, 0, y_beg, y_end); break;
+    case 1: interp_hor(_bicubic_hor_ptr, 2, 0, y_beg, y_end); break;
+    default: interp_hor(_wiener_hor_ptr, 2, 0, y_beg, y_end); break;
     }
     break;
-  case 3:  _average_ptr(pPlane[3], pPlane[0] + 1 * pixelsize, pPlane[2], nPitch, nExtendedWidth - 1, nExtendedHeight); break;
-  case 4:  _average_ptr(pPlane[4], pPlane[0], pPlane[8], nPitch, nExtendedWidth, nExtendedHeight); break;
-  case 5:  _average_ptr(pPlane[5], pPlane[4], pPlane[6], nPitch, nExtendedWidth, nExtendedHeight); break;
-  case 6:  _average_ptr(pPlane[6], pPlane[2], pPlane[10], nPitch, nExtendedWidth, nExtendedHeight); break;
-  case 7:  _average_ptr(pPlane[7], pPlane[4] + 1 * pixelsize, pPlane[6], nPitch, nExtendedWidth - 1, nExtendedHeight); break;
+  case 3:  average_rows(3, 0, 1, 0, 2, y_beg, y_end); break;
+  case 4:  average_rows(4, 0, 0, 0, 8, y_beg, y_end); break;
+  case 5:  average_rows(5, 4, 0, 0, 6, y_beg, y_end); break;
+  case 6:  average_rows(6, 2, 0, 0, 10, y_beg, y_end); break;
+  case 7:  average_rows(7, 4, 1, 0, 6, y_beg, y_end); break;
   case 8:
     switch (nSharp)
     {
-    case 0: _bilin_ver_ptr(pPlane[8], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
-    case 1: _bicubic_ver_ptr(pPlane[8], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
-    default: _wiener_ver_ptr(pPlane[8], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
+    case 0: interp_ver(_bilin_ver_ptr, 8, 0, y_beg, y_end); break;
+    case 1: interp_ver(_bicubic_ver_ptr, 8, 0, y_beg, y_end); break;
+    default: interp_ver(_wiener_ver_ptr, 8, 0, y_beg, y_end); break;
     }
     break;
-  case 9:  _average_ptr(pPlane[9], pPlane[8], pPlane[10], nPitch, nExtendedWidth, nExtendedHeight); break;
+  case 9:  average_rows(9, 8, 0, 0, 10, y_beg, y_end); break;
   case 10:
     switch (nSharp)
     {
-    case 0: _bilin_dia_ptr(pPlane[10], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;
-    case 1: _bicubic_hor_ptr(pPlane[10], pPlane[8], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;	// faster from ready-made horizontal
-    default: _wiener_hor_ptr(pPlane[10], pPlane[8], nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel); break;	// faster from ready-made horizontal
+    case 0: interp_ver(_bilin_dia_ptr, 10, 0, y_beg, y_end); break;
+    case 1: interp_hor(_bicubic_hor_ptr, 10, 8, y_beg, y_end); break;	// faster from ready-made horizontal
+    default: interp_hor(_wiener_hor_ptr, 10, 8, y_beg, y_end); break;	// faster from ready-made horizontal
     }
     break;
-  case 11: _average_ptr(pPlane[11], pPlane[8] + 1*pixelsize, pPlane[10], nPitch, nExtendedWidth - 1, nExtendedHeight); break;
-  case 12: _average_ptr(pPlane[12], pPlane[0] + nPitch, pPlane[8], nPitch, nExtendedWidth, nExtendedHeight - 1); break;
-  case 13: _average_ptr(pPlane[13], pPlane[12], pPlane[14], nPitch, nExtendedWidth, nExtendedHeight); break;
-  case 14: _average_ptr(pPlane[14], pPlane[2] + nPitch, pPlane[10], nPitch, nExtendedWidth, nExtendedHeight - 1); break;
-  case 15: _average_ptr(pPlane[15], pPlane[12] + 1 * pixelsize, pPlane[14], nPitch, nExtendedWidth - 1, nExtendedHeight); break;
+  case 11: average_rows(11, 8, 1, 0, 10, y_beg, y_end); break;
+  case 12: average_rows(12, 0, 0, 1, 8, y_beg, y_end); break;
+  case 13: average_rows(13, 12, 0, 0, 14, y_beg, y_end); break;
+  case 14: average_rows(14, 2, 0, 1, 10, y_beg, y_end); break;
+  case 15: average_rows(15, 12, 1, 0, 14, y_beg, y_end); break;
   default:
     assert(false);
     break;
@@ -522,6 +647,182 @@ void MVPlane::refine_pel4(SchedulerRefine::TaskData &td)
 
 
 
+// Horizontal kernels work on each row independently
+void MVPlane::interp_hor(InterpFncPtr fnc_ptr, int dst_idx, int src_idx, int y_beg, int y_end) const
+{
+  const int offset = y_beg * nPitch;
+  fnc_ptr(
+    pPlane[dst_idx] + offset, pPlane[src_idx] + offset,
+    nPitch, nPitch, nExtendedWidth, y_end - y_beg, bits_per_pixel
+  );
+}
+
+
+
+// Vertical and diagonal kernels switch to bilinear on the first 2 and the
+// last 4 rows of their input. A partial range is rendered with these
+// context rows into a temporary buffer, then copied.
+void MVPlane::interp_ver(InterpFncPtr fnc_ptr, int dst_idx, int src_idx, int y_beg, int y_end) const
+{
+  if (y_beg == 0 && y_end == nExtendedHeight)
+  {
+    fnc_ptr(
+      pPlane[dst_idx], pPlane[src_idx],
+      nPitch, nPitch, nExtendedWidth, nExtendedHeight, bits_per_pixel
+    );
+  }
+  else
+  {
+    // The window must also be tall enough to keep both boundary areas apart
+    const int win_end = std::min(y_end + 4, nExtendedHeight);
+    const int win_beg = std::max(std::min(y_beg - 2, win_end - 8), 0);
+    const int win_h = win_end - win_beg;
+
+    // One more row: some SIMD kernels write past the row width
+    _lazy_tmp_arr.resize((win_h + 1) * nPitch);
+    fnc_ptr(
+      &_lazy_tmp_arr[0], pPlane[src_idx] + win_beg * nPitch,
+      nPitch, nPitch, nExtendedWidth, win_h, bits_per_pixel
+    );
+    BitBlt(
+      pPlane[dst_idx] + y_beg * nPitch, nPitch,
+      &_lazy_tmp_arr[(y_beg - win_beg) * nPitch], nPitch,
+      nExtendedWidth << pixelsize_shift, y_end - y_beg
+    );
+  }
+}
+
+
+
+// dst = average (src1 shifted by (dx, dy), src2)
+// The last dx columns and dy rows of dst are not rendered.
+void MVPlane::average_rows(int dst_idx, int src1_idx, int dx, int dy, int src2_idx, int y_beg, int y_end) const
+{
+  y_end = std::min(y_end, nExtendedHeight - dy);
+  if (y_beg < y_end)
+  {
+    const int offset = y_beg * nPitch;
+    _average_ptr(
+      pPlane[dst_idx] + offset,
+      pPlane[src1_idx] + offset + dy * nPitch + (dx << pixelsize_shift),
+      pPlane[src2_idx] + offset,
+      nPitch, nExtendedWidth - dx, y_end - y_beg
+    );
+  }
+}
+
+
+
+void MVPlane::refine_lazy_stripe(int idx, int stripe) const
+{
+  conc::CritSec guard(_lazy_mutex);
+
+  // May have been rendered by another thread in the meantime
+  if (_lazy_done_arr[idx * _lazy_nbr_stripes + stripe] == 0)
+  {
+    refine_stripe(idx, stripe);
+  }
+}
+
+
+
+template <typename pixel_t>
+static void build_integral_rows(uint32_t *dst_ptr, int dst_pitch, const uint8_t *src_ptr, int src_pitch, int w, int h)
+{
+  std::fill(dst_ptr, dst_ptr + w + 1, uint32_t(0));
+  for (int y = 0; y < h; ++y)
+  {
+    const pixel_t *src_row = reinterpret_cast<const pixel_t *>(src_ptr + y * src_pitch);
+    const uint32_t *prv_row = dst_ptr + y * dst_pitch;
+    uint32_t *dst_row = dst_ptr + (y + 1) * dst_pitch;
+    uint32_t sum = 0;
+    dst_row[0] = 0;
+    for (int x = 0; x < w; ++x)
+    {
+      sum += src_row[x];
+      dst_row[x + 1] = prv_row[x + 1] + sum;
+    }
+  }
+}
+
+
+
+// The plane must be padded and refined. With the lazy refine, the missing
+// stripes of the sub-pixel plane are rendered first.
+void MVPlane::build_integral(int idx) const
+{
+  assert(pixelsize <= 2);
+
+  conc::CritSec guard(_integral_mutex);
+
+  // May have been built by another thread in the meantime
+  if (_integral_done_arr[idx] == 0)
+  {
+    if (_lazy_flag && idx != 0)
+    {
+      for (int s = 0; s < _lazy_nbr_stripes; ++s)
+      {
+        if (_lazy_done_arr[idx * _lazy_nbr_stripes + s] == 0)
+        {
+          refine_lazy_stripe(idx, s);
+        }
+      }
+    }
+
+    const int ipitch = nExtendedWidth + 1;
+    _integral_arr[idx].resize(ipitch * (nExtendedHeight + 1));
+    if (pixelsize == 1)
+    {
+      build_integral_rows<uint8_t>(&_integral_arr[idx][0], ipitch, pPlane[idx], nPitch, nExtendedWidth, nExtendedHeight);
+    }
+    else
+    {
+      build_integral_rows<uint16_t>(&_integral_arr[idx][0], ipitch, pPlane[idx], nPitch, nExtendedWidth, nExtendedHeight);
+    }
+
+    _integral_done_arr[idx] = 1;
+  }
+}
+
+
+
+// _lazy_mutex must be locked.
+void MVPlane::refine_stripe(int idx, int stripe) const
+{
+  const int y_beg = stripe << LAZY_STRIPE_L2;
+  const int y_end = std::min((stripe + 1) << LAZY_STRIPE_L2, nExtendedHeight);
+
+  // Sources are needed for one more row (averages with a vertical shift)
+  const int s_last = std::min(y_end, nExtendedHeight - 1) >> LAZY_STRIPE_L2;
+  const int dep_mask = _lazy_dep_mask_arr[idx];
+  for (int dep = 1; dep < nPel * nPel; ++dep)
+  {
+    if ((dep_mask & (1 << dep)) != 0)
+    {
+      for (int s = stripe; s <= s_last; ++s)
+      {
+        if (_lazy_done_arr[dep * _lazy_nbr_stripes + s] == 0)
+        {
+          refine_stripe(dep, s);
+        }
+      }
+    }
+  }
+
+  if (nPel == 2)
+  {
+    refine_rows_pel2(idx, y_beg, y_end);
+  }
+  else
+  {
+    refine_rows_pel4(idx, y_beg, y_end);
+  }
+
+  _lazy_done_arr[idx * _lazy_nbr_stripes + stripe] = 1;
+}
+
+
+
 void MVPlane::reduce_slice(SlicerReduce::TaskData &td)
 {
   assert(&td != 0);
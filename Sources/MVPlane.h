@@ -25,6 +25,8 @@
 #define	NOMINMAX
 #define	WIN32_LEAN_AND_MEAN
 
+#include	"conc/AtomicInt.h"
+#include	"conc/Mutex.h"
 #include	"MTFlowGraphSimple.h"
 #include	"MTFlowGraphSched.h"
 #include	"MTSlicer.h"
@@ -32,7 +34,9 @@
 
 #include	"Windows.h"
 
+#include	<algorithm>
 #include	<cstdio>
+#include	<vector>
 #include <stdint.h>
 #include "def.h"
 
@@ -46,6 +50,7 @@ public:
    ~MVPlane();
 
    void set_interp (int rfilter, int sharp);
+   void set_lazy_refine (int sharp);
    void Update(uint8_t* pSrc, int _nPitch);
    void ChangePlane(const uint8_t *pNewPlane, int nNewPitch);
    void Pad();
@@ -69,6 +74,11 @@ public:
       nX >>= NPELL2;
       nY >>= NPELL2;
 
+      if (_lazy_flag && idx != 0)
+      {
+         refine_lazy (idx, nY);
+      }
+
       return pPlane[idx] + (nX << pixelsize_shift) + nY * nPitch;
    }
 
@@ -110,6 +120,46 @@ public:
 		return pPlane[0] + (nX << pixelsize_shift) + nY * nPitch;
 	}
 
+   // Sum of the pixels of a w x h block, from the integral image of the
+   // sub-pixel plane. The integral images are built on first use.
+   template <int NPELL2>
+  MV_FORCEINLINE uint32_t GetAbsoluteBlockSumPel(int nX, int nY, int w, int h) const
+   {
+		enum {	MASK = (1 << NPELL2) - 1	};
+
+      int idx = (nX & MASK) | ((nY & MASK) << NPELL2);
+
+      nX >>= NPELL2;
+      nY >>= NPELL2;
+
+      if (_integral_done_arr[idx] == 0)
+      {
+         build_integral(idx);
+      }
+
+      // Modulo 2^32 arithmetic, exact as long as the block sum fits
+      const int ipitch = nExtendedWidth + 1;
+      const uint32_t *p = &_integral_arr[idx][0] + nY * ipitch + nX;
+      const uint32_t *q = p + h * ipitch;
+      return q[w] - q[0] - p[w] + p[0];
+   }
+
+  MV_FORCEINLINE uint32_t GetAbsoluteBlockSum(int nX, int nY, int w, int h) const
+   {
+      if (nPel == 1)
+		{
+         return GetAbsoluteBlockSumPel <0> (nX, nY, w, h);
+		}
+      else if (nPel == 2)
+		{
+         return GetAbsoluteBlockSumPel <1> (nX, nY, w, h);
+		}
+      else // nPel == 4
+      {
+         return GetAbsoluteBlockSumPel <2> (nX, nY, w, h);
+      }
+   }
+
   MV_FORCEINLINE int GetPitch() const { return nPitch; }
   MV_FORCEINLINE int GetWidth() const { return nWidth; }
   MV_FORCEINLINE int GetHeight() const { return nHeight; }
@@ -134,10 +184,42 @@ private:
 		int nWidth, int nHeight, int y_beg, int y_end, int cpuFlags
 	);
 
+	// Lazy refine: sub-pixel planes are rendered by stripes of rows
+	enum {	LAZY_STRIPE_L2 = 5	};
+
+	void	build_plan_refine ();
 	void	refine_pel2 (SchedulerRefine::TaskData &td);
 	void	refine_pel4 (SchedulerRefine::TaskData &td);
+	void	refine_rows_pel2 (int idx, int y_beg, int y_end) const;
+	void	refine_rows_pel4 (int idx, int y_beg, int y_end) const;
+	void	interp_hor (InterpFncPtr fnc_ptr, int dst_idx, int src_idx, int y_beg, int y_end) const;
+	void	interp_ver (InterpFncPtr fnc_ptr, int dst_idx, int src_idx, int y_beg, int y_end) const;
+	void	average_rows (int dst_idx, int src1_idx, int dx, int dy, int src2_idx, int y_beg, int y_end) const;
+	void	refine_lazy_stripe (int idx, int stripe) const;
+	void	build_integral (int idx) const;
+	void	refine_stripe (int idx, int stripe) const;
 	void	reduce_slice (SlicerReduce::TaskData &td);
 
+	// Makes sure the rows a block may read from sub-pixel plane idx,
+	// starting at row y, are rendered.
+	MV_FORCEINLINE void	refine_lazy (int idx, int y) const
+	{
+		const int		s_beg = std::max (y, 0) >> LAZY_STRIPE_L2;
+		const int		s_end = std::min (
+			(y + MAX_BLOCK_SIZE - 1) >> LAZY_STRIPE_L2,
+			_lazy_nbr_stripes - 1
+		);
+		const conc::AtomicInt <int> *	done_ptr =
+			&_lazy_done_arr [idx * _lazy_nbr_stripes];
+		for (int s = s_beg; s <= s_end; ++s)
+		{
+			if (done_ptr [s] == 0)
+			{
+				refine_lazy_stripe (idx, s);
+			}
+		}
+	}
+
    uint8_t **pPlane;
    int nWidth;
    int nHeight;
@@ -183,6 +265,29 @@ private:
 
 	SlicerReduce	_slicer_reduce;
 	MVPlane *		_redp_ptr;			// The plane where the reduction is rendered.
+
+	// Lazy refine. The state is mutable because the planes are rendered
+	// from the const accessors, possibly from several threads.
+	bool				_lazy_flag;
+	int				_lazy_nbr_stripes;
+	int				_lazy_dep_mask_arr [16];	// Sub-pixel planes each plane is computed from
+	mutable std::vector <conc::AtomicInt <int> >
+						_lazy_done_arr;	// [idx * _lazy_nbr_stripes + stripe], 0 = not rendered yet
+	mutable conc::Mutex
+						_lazy_mutex;
+	mutable std::vector <uint8_t>
+						_lazy_tmp_arr;		// Vertical interpolation with context rows
+	uint8_t *		_lazy_buf_ptr;		// Private sub-pixel planes, the super frame is shared and read-only
+	int				_lazy_buf_size;	// Bytes
+
+	// Integral images for the block sums, (nExtendedWidth + 1) x (nExtendedHeight + 1)
+	// elements per sub-pixel plane. Only allocated for the planes requested.
+	mutable std::vector <uint32_t>
+						_integral_arr [16];
+	mutable conc::AtomicInt <int>
+						_integral_done_arr [16];	// 0 = not built for the current frame
+	mutable conc::Mutex
+						_integral_mutex;
 };
 
 
@@ -148,6 +148,12 @@ MVRecalculate::MVRecalculate(
     nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV,
     cpuFlags, analysisData.xRatioUV, analysisData.yRatioUV, analysisData.pixelsize, analysisData.bits_per_pixel, mt_flag
   );
+  if ((params.param & SuperParams64Bits::PARAM_LAZY_FLAG) != 0)
+  {
+    const int sharp = params.param & SuperParams64Bits::PARAM_SHARP_MASK;
+    pSrcGOF->set_lazy_refine(MVPlaneSet(nSuperModeYUV), sharp);
+    pRefGOF->set_lazy_refine(MVPlaneSet(nSuperModeYUV), sharp);
+  }
   const int nSuperWidth = child->GetVideoInfo().width;
   const int nSuperHeight = child->GetVideoInfo().height;
 
@@ -296,6 +302,10 @@ MVRecalculate::MVRecalculate(
     searchType = VSEARCH;
     nSearchParam = (stp < 1) ? 1 : stp;
     break;
+  case 8:
+    searchType = SEASEARCH;
+    nSearchParam = (stp < 1) ? 1 : stp;
+    break;
   case 2:
   default:
     searchType = LOGARITHMIC;
@@ -43,11 +43,12 @@ int64_t ProfCumulatedResults[MOTION_PROFILE_COUNT * 2];
 MVSuper::MVSuper(
   PClip _child, int _hPad, int _vPad, int _pel, int _levels, bool _chroma,
   int _sharp, int _rfilter, PClip _pelclip, bool _isse, bool _planar,
-  bool mt_flag, IScriptEnvironment* env
+  bool mt_flag, bool lazy_flag, IScriptEnvironment* env
 )
   : GenericVideoFilter(_child)
   , pelclip(_pelclip)
   , _mt_flag(mt_flag)
+  , _lazy_flag(false)
 {
   has_at_least_v8 = true;
   try { env->CheckVersion(8); }
@@ -151,6 +152,15 @@ MVSuper::MVSuper(
   params.nPel = nPel;
   params.nModeYUV = nModeYUV;
   params.nLevels = nLevels;
+  params.param = 0;
+
+  // The clients render the sub-pixel planes themselves, only when required.
+  // Useless with an external pel clip, which is directly copied.
+  _lazy_flag = (lazy_flag && nPel > 1 && !usePelClip);
+  if (_lazy_flag)
+  {
+    params.param = SuperParams64Bits::PARAM_LAZY_FLAG | (sharp & SuperParams64Bits::PARAM_SHARP_MASK);
+  }
 
 
   // pack parameters to fake audio properties
@@ -319,7 +329,7 @@ PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
       }
     }
   }
-  else
+  else if (!_lazy_flag)
   {
     pSrcGOF->Refine(nModeYUV);
   }
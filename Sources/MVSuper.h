@@ -137,13 +137,14 @@ protected:
   bool           isPelClipPadded;
 
   bool           _mt_flag; // PF maybe 2.6.0.5
+  bool           _lazy_flag; // Sub-pixel planes rendered on demand by the clients
 
 public:
 
   MVSuper(
     PClip _child, int _hpad, int _vpad, int pel, int _levels, bool _chroma,
     int _sharp, int _rfilter, PClip _pelclip, bool _isse, bool _planar,
-    bool mt_flag, IScriptEnvironment* env
+    bool mt_flag, bool lazy_flag, IScriptEnvironment* env
   );
   ~MVSuper();
 
@@ -123,6 +123,8 @@ void MakeVectorOcclusionMaskTime(MVClip &mvClip, int nBlkX, int nBlkY, double dM
   // fix: 2.7.19.22: use occMaskPitch instead of nBlkX (result of 30 hours debug)
   // or else we have random garbage on bottom right part
 	MemZoneSet(occMask, 0, nBlkX, nBlkY, 0, 0, occMaskPitch); 
+	const int *vx_arr = mvClip.GetPlane(0).GetArrayVx();
+	const int *vy_arr = mvClip.GetPlane(0).GetArrayVy();
 	int time4096X = time256*16/blkSizeX;
 	int time4096Y = time256*16/blkSizeY;
 #ifndef _M_X64 
@@ -136,15 +138,13 @@ void MakeVectorOcclusionMaskTime(MVClip &mvClip, int nBlkX, int nBlkY, double dM
 		for (int bx=0; bx<nBlkX; bx++)
 		{
 			int i = bx + by*nBlkX; // current block
-			const FakeBlockData &block = mvClip.GetBlock(0, i);
-			int vx = block.GetMV().x;
-			int vy = block.GetMV().y;
+			int vx = vx_arr[i];
+			int vy = vy_arr[i];
 			if (bx < nBlkX-1) // right neighbor
 			{
 				int i1 = i+1;
-				const FakeBlockData &block1 = mvClip.GetBlock(0, i1);
-				int vx1 = block1.GetMV().x;
-				//int vy1 = block1.GetMV().y;
+				int vx1 = vx_arr[i1];
+				//int vy1 = vy_arr[i1];
 				if (vx1<vx) {
 					occlusion = vx-vx1;
 					for (int bxi=bx+vx1*time4096X/4096; bxi<=bx+vx*time4096X/4096+1 && bxi>=0 && bxi<nBlkX; bxi++)
@@ -154,9 +154,8 @@ void MakeVectorOcclusionMaskTime(MVClip &mvClip, int nBlkX, int nBlkY, double dM
 			if (by < nBlkY-1) // bottom neighbor
 			{
 				int i1 = i + nBlkX;
-				const FakeBlockData &block1 = mvClip.GetBlock(0, i1);
-				//int vx1 = block1.GetMV().x;
-				int vy1 = block1.GetMV().y;
+				//int vx1 = vx_arr[i1];
+				int vy1 = vy_arr[i1];
 				if (vy1<vy) {
 					occlusion = vy-vy1;
 					for (int byi=by+vy1*time4096Y/4096; byi<=by+vy*time4096Y/4096+1 && byi>=0 && byi<nBlkY; byi++)
@@ -221,45 +220,42 @@ void MakeVectorOcclusionMask(MVClip &mvClip, int nBlkX, int nBlkY, double dMaskN
   _mm_empty ();
 #endif
 	double occnorm = 10 / dMaskNormFactor/nPel; // empirical
+	const int *vx_arr = mvClip.GetPlane(0).GetArrayVx();
+	const int *vy_arr = mvClip.GetPlane(0).GetArrayVy();
 	for (int by=0; by<nBlkY; by++)
 	{
 		for (int bx=0; bx<nBlkX; bx++)
 		{
 			int occlusion = 0;
 			int i = bx + by*nBlkX; // current block
-			const FakeBlockData &block = mvClip.GetBlock(0, i);
-			int vx = block.GetMV().x;
-			int vy = block.GetMV().y;
+			int vx = vx_arr[i];
+			int vy = vy_arr[i];
 			if (bx > 0) // left neighbor
 			{
 				int i1 = i-1;
-				const FakeBlockData &block1 = mvClip.GetBlock(0, i1);
-				int vx1 = block1.GetMV().x;
-				//int vy1 = block1.GetMV().y;
+				int vx1 = vx_arr[i1];
+				//int vy1 = vy_arr[i1];
 				if (vx1>vx) occlusion += (vx1-vx); // only positive (abs)
 			}
 			if (bx < nBlkX-1) // right neighbor
 			{
 				int i1 = i+1;
-				const FakeBlockData &block1 = mvClip.GetBlock(0, i1);
-				int vx1 = block1.GetMV().x;
-				//int vy1 = block1.GetMV().y;
+				int vx1 = vx_arr[i1];
+				//int vy1 = vy_arr[i1];
 				if (vx1<vx) occlusion += vx-vx1;
 			}
 			if (by > 0) // top neighbor
 			{
 				int i1 = i - nBlkX;
-				const FakeBlockData &block1 = mvClip.GetBlock(0, i1);
-				//int vx1 = block1.GetMV().x;
-				int vy1 = block1.GetMV().y;
+				//int vx1 = vx_arr[i1];
+				int vy1 = vy_arr[i1];
 				if (vy1>vy) occlusion += vy1-vy;
 			}
 			if (by < nBlkY-1) // bottom neighbor
 			{
 				int i1 = i + nBlkX;
-				const FakeBlockData &block1 = mvClip.GetBlock(0, i1);
-				//int vx1 = block1.GetMV().x;
-				int vy1 = block1.GetMV().y;
+				//int vx1 = vx_arr[i1];
+				int vy1 = vy_arr[i1];
 				if (vy1<vy) occlusion += vy-vy1;
 			}
 			if (fGamma == 1.0)
@@ -347,6 +343,9 @@ void MakeSADMaskTime(MVClip &mvClip, int nBlkX, int nBlkY, double dSADNormFactor
   // Make approximate SAD mask at intermediate time
   //    double dSADNormFactor = 4 / (dMaskNormDivider*nBlkSizeX*nBlkSizeY);
   MemZoneSet(Mask, 0, nBlkX, nBlkY, 0, 0, MaskPitch);
+  const int *vx_arr = mvClip.GetPlane(0).GetArrayVx();
+  const int *vy_arr = mvClip.GetPlane(0).GetArrayVy();
+  const sad_t *sad_arr = mvClip.GetPlane(0).GetArraySAD();
   int time4096X = (256 - time256) * 16 / (nBlkStepX*nPel); // blkstep here is really blksize-overlap
   int time4096Y = (256 - time256) * 16 / (nBlkStepY*nPel);
 
@@ -355,9 +354,8 @@ void MakeSADMaskTime(MVClip &mvClip, int nBlkX, int nBlkY, double dSADNormFactor
     for (int bx = 0; bx<nBlkX; bx++)
     {
       int i = bx + by*nBlkX; // current block
-      const FakeBlockData &block = mvClip.GetBlock(0, i);
-      int vx = block.GetMV().x;
-      int vy = block.GetMV().y;
+      int vx = vx_arr[i];
+      int vy = vy_arr[i];
       int bxi = bx - vx*time4096X / 4096; // limits?
       int byi = by - vy*time4096Y / 4096;
       if (bxi <0 || bxi >= nBlkX || byi <0 || byi >= nBlkY)
@@ -366,7 +364,7 @@ void MakeSADMaskTime(MVClip &mvClip, int nBlkX, int nBlkY, double dSADNormFactor
         byi = by;
       }
       int i1 = bxi + byi*nBlkX;
-      sad_t sad = mvClip.GetBlock(0, i1).GetSAD();
+      sad_t sad = sad_arr[i1];
       Mask[bx + by*nBlkX] = ByteNorm(sad, dSADNormFactor, fGamma); // bits_per_pixel scale through dSADNormFactor
     }
   }
@@ -376,16 +374,32 @@ void MakeSADMaskTime(MVClip &mvClip, int nBlkX, int nBlkY, double dSADNormFactor
 void MakeVectorSmallMasks(MVClip &mvClip, int nBlkX, int nBlkY, short *VXSmallY, int pitchVXSmallY, short *VYSmallY, int pitchVYSmallY)
 {
   // make  vector vx and vy small masks
+  // Vectors are bounded by the padded frame size * pel, so packing to 16 bits
+  // with saturation gives the same result as a plain conversion.
+  const int *vx_arr = mvClip.GetPlane(0).GetArrayVx();
+  const int *vy_arr = mvClip.GetPlane(0).GetArrayVy();
   for (int by = 0; by<nBlkY; by++)
   {
-    for (int bx = 0; bx<nBlkX; bx++)
+    const int *vx_row = vx_arr + by*nBlkX;
+    const int *vy_row = vy_arr + by*nBlkX;
+    short *vx_dst = VXSmallY + by*pitchVXSmallY;
+    short *vy_dst = VYSmallY + by*pitchVYSmallY;
+    int bx = 0;
+    for (; bx <= nBlkX - 8; bx += 8)
+    {
+      const __m128i vx = _mm_packs_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(vx_row + bx)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(vx_row + bx + 4)));
+      const __m128i vy = _mm_packs_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(vy_row + bx)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(vy_row + bx + 4)));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(vx_dst + bx), vx); // luma
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(vy_dst + bx), vy); // luma
+    }
+    for (; bx < nBlkX; bx++)
     {
-      int i = bx + by*nBlkX;
-      const FakeBlockData &block = mvClip.GetBlock(0, i);
-      int vx = block.GetMV().x;
-      int vy = block.GetMV().y;
-      VXSmallY[bx + by*pitchVXSmallY] = vx; // luma
-      VYSmallY[bx + by*pitchVYSmallY] = vy; // luma
+      vx_dst[bx] = vx_row[bx]; // luma
+      vy_dst[bx] = vy_row[bx]; // luma
     }
   }
 }
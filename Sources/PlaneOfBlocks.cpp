@@ -76,7 +76,12 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
   , BLITCHROMA(0)
   , SADCHROMA(0)
   , SATD(0)
+  , SADX3(0)
+  , SADX4(0)
+  , SADYUV(0)
+  , SADUV(0)
   , vectors(nBlkCount)
+  , _bad_cnt_arr(nBlkCount)
   , smallestPlane((_nFlags & MOTION_SMALLEST_PLANE) != 0)
   //,	mmx ((_nFlags & MOTION_USE_MMX) != 0)
   , isse((_nFlags & MOTION_USE_ISSE) != 0)
@@ -88,6 +93,9 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
   , dctmode(0)
   , _workarea_fact(nBlkSizeX, nBlkSizeY, dctpitch, nLogxRatioUV, nLogyRatioUV, pixelsize, bits_per_pixel)
   , _workarea_pool()
+  , _sched_wavefront_ptr()
+  , _graph_wavefront()
+  , _wavefront_chunk_w(0)
   , _gvect_estim_ptr(0)
   , _gvect_result_count(0)
   , chromaSADscale(
@@ -104,6 +112,7 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
   bool sse41 = (bool)(nFlags & CPU_SSE4);
   bool avx = (bool)(nFlags & CPU_AVX);
   bool avx2 = (bool)(nFlags & CPU_AVX2);
+  bool avx512 = (bool)(nFlags & CPU_AVX512);
 //  bool ssd = (bool)(nFlags & MOTION_USE_SSD);
 //  bool satd = (bool)(nFlags & MOTION_USE_SATD);
 
@@ -151,7 +160,9 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
                      // OverlapsFunction
                      // in M(V)DegrainX: DenoiseXFunction
   arch_t arch;
-  if (isse && avx2)
+  if (isse && avx512)
+    arch = USE_AVX512;
+  else if (isse && avx2)
     arch = USE_AVX2;
   else if (isse && avx)
     arch = USE_AVX;
@@ -164,6 +175,8 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
 
   SAD = get_sad_function(nBlkSizeX, nBlkSizeY, bits_per_pixel, arch);
   SADCHROMA = get_sad_function(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV, bits_per_pixel, arch);
+  SADX3 = get_sad_x3_function(nBlkSizeX, nBlkSizeY, bits_per_pixel, arch);
+  SADX4 = get_sad_x4_function(nBlkSizeX, nBlkSizeY, bits_per_pixel, arch);
   BLITLUMA = get_copy_function(nBlkSizeX, nBlkSizeY, pixelsize, arch);
   BLITCHROMA = get_copy_function(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV, pixelsize, arch);
   //VAR        = get_var_function(nBlkSizeX/xRatioUV, nBlkSizeY/yRatioUV, pixelsize, arch); // variance.h PF: no VAR
@@ -241,6 +254,17 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
     }
   }
 #endif
+
+  // Fused luma and chroma SAD, only when the luma cost is the plain spatial SAD
+  if (chroma
+#ifdef ALLOW_DCT
+    && dctmode == 0
+#endif
+    )
+  {
+    SADYUV = get_sad_yuv_function(nBlkSizeX, nBlkSizeY, nLogxRatioUV, nLogyRatioUV, bits_per_pixel, arch);
+    SADUV = get_sad_uv_function(nBlkSizeX, nBlkSizeY, nLogxRatioUV, nLogyRatioUV, bits_per_pixel, arch);
+  }
 }
 
 
@@ -259,6 +283,51 @@ void PlaneOfBlocks::SearchMVs(
   short *outfilebuf, int fieldShift, sad_t * pmeanLumaChange,
   int divideExtra, int _pzero, int _pglobal, sad_t _badSAD, int _badrange, bool meander, int *vecPrev, bool _tryMany
 )
+{
+  PrepareSearchMVs(
+    _pSrcFrame, _pRefFrame, st, stp, lambda, lsad, pnew, plevel, flags, out,
+    globalMVec, outfilebuf, fieldShift, pmeanLumaChange, divideExtra,
+    _pzero, _pglobal, _badSAD, _badrange, meander, vecPrev, _tryMany
+  );
+
+  // Without meander, each block only depends on its left, top and top-right
+  // neighbours, so the rows can be processed in parallel as a wavefront and
+  // give the same predictors as the single-threaded scan.
+  // Meander scan is a single dependency chain, so we keep row slicing.
+  if (_mt_flag && !_meander_flag && prepare_wavefront())
+  {
+    SchedulerWavefront &	sched = *_sched_wavefront_ptr;
+    if (bits_per_pixel == 8)
+      sched.start(_graph_wavefront, *this, &PlaneOfBlocks::search_mv_wavefront<uint8_t>);
+    else
+      sched.start(_graph_wavefront, *this, &PlaneOfBlocks::search_mv_wavefront<uint16_t>);
+    sched.wait();
+  }
+  else
+  {
+    Slicer			slicer(_mt_flag); // fixme: mt bug
+    if (bits_per_pixel == 8)
+      slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice<uint8_t>, 4);
+    else
+      slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice<uint16_t>, 4);
+    slicer.wait();
+  }
+
+  FinishSearchMVs(pmeanLumaChange);
+}
+
+
+
+// First part of SearchMVs. Called alone when the rows are searched by the
+// caller (pipelined levels, see GroupOfPlanes::SearchMVs), followed by
+// SearchMVsRows or SearchMVsChunk on all the rows, then FinishSearchMVs.
+void PlaneOfBlocks::PrepareSearchMVs(
+  MVFrame *_pSrcFrame, MVFrame *_pRefFrame,
+  SearchType st, int stp, int lambda, sad_t lsad, int pnew,
+  int plevel, int flags, sad_t *out, const VECTOR * globalMVec,
+  short *outfilebuf, int fieldShift, sad_t * pmeanLumaChange,
+  int divideExtra, int _pzero, int _pglobal, sad_t _badSAD, int _badrange, bool meander, int *vecPrev, bool _tryMany
+)
 {
   // -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -
   // Frame- and plane-related data preparation
@@ -357,21 +426,36 @@ void PlaneOfBlocks::SearchMVs(
 
   penaltyNew = _pnew; // penalty for new vector
   LSAD = _lsad;    // SAD limit for lambda using
+}
 
-  Slicer			slicer(_mt_flag); // fixme: mt bug
-  if(bits_per_pixel == 8)
-    slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice<uint8_t>, 4);
-  else
-    slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice<uint16_t>, 4);
-  slicer.wait();
 
-  // -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -
 
+void PlaneOfBlocks::FinishSearchMVs(sad_t * pmeanLumaChange)
+{
   if (smallestPlane)
   {
     *pmeanLumaChange = (sad_t)(sumLumaChange / nBlkCount); // for all finer planes
   }
+}
 
+
+
+void PlaneOfBlocks::SearchMVsRows(int blky_beg, int blky_end)
+{
+  if (bits_per_pixel == 8)
+    search_mv_rows<uint8_t>(blky_beg, blky_end);
+  else
+    search_mv_rows<uint16_t>(blky_beg, blky_end);
+}
+
+
+
+void PlaneOfBlocks::SearchMVsChunk(int blky, int blkx_beg, int blkx_end)
+{
+  if (bits_per_pixel == 8)
+    search_mv_chunk<uint8_t>(blky, blkx_beg, blkx_end);
+  else
+    search_mv_chunk<uint16_t>(blky, blkx_beg, blkx_end);
 }
 
 
@@ -480,7 +564,7 @@ void PlaneOfBlocks::RecalculateMVs(
 
 
 template<typename safe_sad_t, typename smallOverlapSafeSad_t>
-void PlaneOfBlocks::InterpolatePrediction(const PlaneOfBlocks &pob)
+void PlaneOfBlocks::InterpolatePrediction(const PlaneOfBlocks &pob, int blky_beg, int blky_end)
 {
   int normFactor = 3 - nLogPel + pob.nLogPel;
   int mulFactor = (normFactor < 0) ? -normFactor : 0;
@@ -518,7 +602,7 @@ void PlaneOfBlocks::InterpolatePrediction(const PlaneOfBlocks &pob)
   bool bNoOverlap = (nOverlapX == 0 && nOverlapY == 0);
   bool bSmallOverlap = nOverlapX <= (nBlkSizeX >> 1) && nOverlapY <= (nBlkSizeY >> 1);
 
-  for (int l = 0, index = 0; l < nBlkY; l++)
+  for (int l = blky_beg, index = blky_beg * nBlkX; l < blky_end; l++)
   {
     for (int k = 0; k < nBlkX; k++, index++)
     {
@@ -606,9 +690,9 @@ void PlaneOfBlocks::InterpolatePrediction(const PlaneOfBlocks &pob)
 }
 
 // instantiate
-template void PlaneOfBlocks::InterpolatePrediction<sad_t, sad_t>(const PlaneOfBlocks &pob);
-template void PlaneOfBlocks::InterpolatePrediction<sad_t, bigsad_t>(const PlaneOfBlocks &pob);
-template void PlaneOfBlocks::InterpolatePrediction<bigsad_t, bigsad_t>(const PlaneOfBlocks &pob);
+template void PlaneOfBlocks::InterpolatePrediction<sad_t, sad_t>(const PlaneOfBlocks &pob, int blky_beg, int blky_end);
+template void PlaneOfBlocks::InterpolatePrediction<sad_t, bigsad_t>(const PlaneOfBlocks &pob, int blky_beg, int blky_end);
+template void PlaneOfBlocks::InterpolatePrediction<bigsad_t, bigsad_t>(const PlaneOfBlocks &pob, int blky_beg, int blky_end);
 
 void PlaneOfBlocks::WriteHeaderToArray(int *array)
 {
@@ -812,6 +896,10 @@ void PlaneOfBlocks::Refine(WorkingArea &workarea)
   }
                    break;
 
+  case SEASEARCH:
+    SeaSearch<pixel_t>(workarea, nSearchParam);
+    break;
+
                    //	if ( searchType & SQUARE )
                    //	{
                    //		SquareSearch();
@@ -900,10 +988,17 @@ void PlaneOfBlocks::PseudoEPZSearch(WorkingArea &workarea)
   workarea.globalMVPredictor = ClipMV(workarea, workarea.globalMVPredictor);
   //	if ( workarea.IsVectorOK(workarea.globalMVPredictor.x, workarea.globalMVPredictor.y ) )
   {
-    saduv = (chroma) ? 
-      ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y), nRefPitch[1])
-      + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y), nRefPitch[2]), effective_chromaSADscale) : 0;
-    sad = LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y));
+    if (SADYUV != 0)
+    {
+      sad = LumaChromaSAD(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y, saduv);
+    }
+    else
+    {
+      saduv = (chroma) ?
+        ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y), nRefPitch[1])
+        + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y), nRefPitch[2]), effective_chromaSADscale) : 0;
+      sad = LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y));
+    }
     sad += saduv;
     sad_t cost = sad + ((pglobal*(safe_sad_t)sad) >> 8);
 
@@ -926,9 +1021,16 @@ void PlaneOfBlocks::PseudoEPZSearch(WorkingArea &workarea)
     //	if (   (( workarea.predictor.x != zeroMVfieldShifted.x ) || ( workarea.predictor.y != zeroMVfieldShifted.y ))
     //	    && (( workarea.predictor.x != workarea.globalMVPredictor.x ) || ( workarea.predictor.y != workarea.globalMVPredictor.y )))
     //	{
-    saduv = (chroma) ? ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, workarea.predictor.x, workarea.predictor.y), nRefPitch[1])
-      + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, workarea.predictor.x, workarea.predictor.y), nRefPitch[2]), effective_chromaSADscale) : 0;
-    sad = LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, workarea.predictor.x, workarea.predictor.y));
+    if (SADYUV != 0)
+    {
+      sad = LumaChromaSAD(workarea, workarea.predictor.x, workarea.predictor.y, saduv);
+    }
+    else
+    {
+      saduv = (chroma) ? ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, workarea.predictor.x, workarea.predictor.y), nRefPitch[1])
+        + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, workarea.predictor.x, workarea.predictor.y), nRefPitch[2]), effective_chromaSADscale) : 0;
+      sad = LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, workarea.predictor.x, workarea.predictor.y));
+    }
     sad += saduv;
     cost = sad;
 
@@ -991,16 +1093,27 @@ void PlaneOfBlocks::PseudoEPZSearch(WorkingArea &workarea)
 
   const int		BADCOUNT_LIMIT = 16;
 
-  // fixme note:
-  // MAnalyze mt-inconsistency reason #2
-  // 'badcount' can be increased in different order when multithreaded
-  // (processing vertically sliced vector data parallel)
-  // so the expression in the condition below can be different for each run
-  // depending on the order the parallel tasks increase badcount
+  // With meander, 'badcount' can be increased in different order when
+  // multithreaded (processing vertically sliced vector data parallel), so
+  // the condition below can be different for each run (MAnalyze
+  // mt-inconsistency reason #2).
+  // Without meander, the bad blocks are counted on the blocks which are
+  // always searched before the current one, whatever the scan (raster or
+  // wavefront) and the number of threads.
+  bool bad_flag = false;
+  if (workarea.blkIdx > 1 + workarea.blky_beg * nBlkX && foundSAD > badSAD)
+  {
+    const int bad_cnt = (_meander_flag) ? int(badcount) : count_bad_blocks(workarea);
+    bad_flag = (foundSAD > (badSAD + badSAD*bad_cnt / BADCOUNT_LIMIT));
+  }
+  if (!_meander_flag)
+  {
+    const int prev_cnt = (workarea.blkx > 0) ? _bad_cnt_arr[workarea.blkIdx - 1] : 0;
+    _bad_cnt_arr[workarea.blkIdx] = prev_cnt + (bad_flag ? 1 : 0);
+  }
 
   // bad vector, try wide search
-  if (workarea.blkIdx > 1 + workarea.blky_beg * nBlkX
-    && foundSAD > (badSAD + badSAD*badcount / BADCOUNT_LIMIT))
+  if (bad_flag)
   {
     // with some soft limit (BADCOUNT_LIMIT) of bad cured vectors (time consumed)
     ++badcount;
@@ -1089,6 +1202,28 @@ void PlaneOfBlocks::PseudoEPZSearch(WorkingArea &workarea)
 
 
 
+// Without meander: number of bad blocks among the blocks searched before
+// the current one in any scan order. These are the previous blocks of the
+// row, and on the row k rows above, the blocks up to k columns on the right
+// (the wavefront dependencies: left and top-right neighbours). Rows above the
+// slice are ignored.
+int PlaneOfBlocks::count_bad_blocks(const WorkingArea &workarea) const
+{
+  assert(!_meander_flag);
+
+  const int blkx = workarea.blkx;
+  int bad_cnt = (blkx > 0) ? _bad_cnt_arr[workarea.blkIdx - 1] : 0;
+  for (int k = 1; k <= workarea.blky - workarea.blky_beg; ++k)
+  {
+    const int x = std::min(blkx + k, nBlkX - 1);
+    bad_cnt += _bad_cnt_arr[(workarea.blky - k) * nBlkX + x];
+  }
+
+  return bad_cnt;
+}
+
+
+
 template<typename pixel_t>
 void PlaneOfBlocks::DiamondSearch(WorkingArea &workarea, int length)
 {
@@ -1117,10 +1252,12 @@ void PlaneOfBlocks::DiamondSearch(WorkingArea &workarea, int length)
     // First, we look the directions that were hinted by the previous step
     // of the algorithm. If we find one, we add it to the set of directions
     // we'll test next
-    if (lastDirection & 1) CheckMV2<pixel_t>(workarea, dx + length, dy, &direction, 1);
-    if (lastDirection & 2) CheckMV2<pixel_t>(workarea, dx - length, dy, &direction, 2);
-    if (lastDirection & 4) CheckMV2<pixel_t>(workarea, dx, dy + length, &direction, 4);
-    if (lastDirection & 8) CheckMV2<pixel_t>(workarea, dx, dy - length, &direction, 8);
+    Candidates cand;
+    if (lastDirection & 1) cand.add(dx + length, dy, 1);
+    if (lastDirection & 2) cand.add(dx - length, dy, 2);
+    if (lastDirection & 4) cand.add(dx, dy + length, 4);
+    if (lastDirection & 8) cand.add(dx, dy - length, 8);
+    CheckMV2Many<pixel_t>(workarea, cand, &direction);
 
     // If one of the directions improves the SAD, we make further tests
     // on the diagonals
@@ -1146,53 +1283,55 @@ void PlaneOfBlocks::DiamondSearch(WorkingArea &workarea, int length)
     // diagonals to be checked, because we might be lucky.
     else
     {
+      Candidates diag;
       switch (lastDirection)
       {
       case 1:
-        CheckMV2<pixel_t>(workarea, dx + length, dy + length, &direction, 1 + 4);
-        CheckMV2<pixel_t>(workarea, dx + length, dy - length, &direction, 1 + 8);
+        diag.add(dx + length, dy + length, 1 + 4);
+        diag.add(dx + length, dy - length, 1 + 8);
         break;
       case 2:
-        CheckMV2<pixel_t>(workarea, dx - length, dy + length, &direction, 2 + 4);
-        CheckMV2<pixel_t>(workarea, dx - length, dy - length, &direction, 2 + 8);
+        diag.add(dx - length, dy + length, 2 + 4);
+        diag.add(dx - length, dy - length, 2 + 8);
         break;
       case 4:
-        CheckMV2<pixel_t>(workarea, dx + length, dy + length, &direction, 1 + 4);
-        CheckMV2<pixel_t>(workarea, dx - length, dy + length, &direction, 2 + 4);
+        diag.add(dx + length, dy + length, 1 + 4);
+        diag.add(dx - length, dy + length, 2 + 4);
         break;
       case 8:
-        CheckMV2<pixel_t>(workarea, dx + length, dy - length, &direction, 1 + 8);
-        CheckMV2<pixel_t>(workarea, dx - length, dy - length, &direction, 2 + 8);
+        diag.add(dx + length, dy - length, 1 + 8);
+        diag.add(dx - length, dy - length, 2 + 8);
         break;
       case 1 + 4:
-        CheckMV2<pixel_t>(workarea, dx + length, dy + length, &direction, 1 + 4);
-        CheckMV2<pixel_t>(workarea, dx - length, dy + length, &direction, 2 + 4);
-        CheckMV2<pixel_t>(workarea, dx + length, dy - length, &direction, 1 + 8);
+        diag.add(dx + length, dy + length, 1 + 4);
+        diag.add(dx - length, dy + length, 2 + 4);
+        diag.add(dx + length, dy - length, 1 + 8);
         break;
       case 2 + 4:
-        CheckMV2<pixel_t>(workarea, dx + length, dy + length, &direction, 1 + 4);
-        CheckMV2<pixel_t>(workarea, dx - length, dy + length, &direction, 2 + 4);
-        CheckMV2<pixel_t>(workarea, dx - length, dy - length, &direction, 2 + 8);
+        diag.add(dx + length, dy + length, 1 + 4);
+        diag.add(dx - length, dy + length, 2 + 4);
+        diag.add(dx - length, dy - length, 2 + 8);
         break;
       case 1 + 8:
-        CheckMV2<pixel_t>(workarea, dx + length, dy + length, &direction, 1 + 4);
-        CheckMV2<pixel_t>(workarea, dx - length, dy - length, &direction, 2 + 8);
-        CheckMV2<pixel_t>(workarea, dx + length, dy - length, &direction, 1 + 8);
+        diag.add(dx + length, dy + length, 1 + 4);
+        diag.add(dx - length, dy - length, 2 + 8);
+        diag.add(dx + length, dy - length, 1 + 8);
         break;
       case 2 + 8:
-        CheckMV2<pixel_t>(workarea, dx - length, dy - length, &direction, 2 + 8);
-        CheckMV2<pixel_t>(workarea, dx - length, dy + length, &direction, 2 + 4);
-        CheckMV2<pixel_t>(workarea, dx + length, dy - length, &direction, 1 + 8);
+        diag.add(dx - length, dy - length, 2 + 8);
+        diag.add(dx - length, dy + length, 2 + 4);
+        diag.add(dx + length, dy - length, 1 + 8);
         break;
       default:
         // Even the default case may happen, in the first step of the
         // algorithm for example.
-        CheckMV2<pixel_t>(workarea, dx + length, dy + length, &direction, 1 + 4);
-        CheckMV2<pixel_t>(workarea, dx - length, dy + length, &direction, 2 + 4);
-        CheckMV2<pixel_t>(workarea, dx + length, dy - length, &direction, 1 + 8);
-        CheckMV2<pixel_t>(workarea, dx - length, dy - length, &direction, 2 + 8);
+        diag.add(dx + length, dy + length, 1 + 4);
+        diag.add(dx - length, dy + length, 2 + 4);
+        diag.add(dx + length, dy - length, 1 + 8);
+        diag.add(dx - length, dy - length, 2 + 8);
         break;
       }
+      CheckMV2Many<pixel_t>(workarea, diag, &direction);
     }	// if ! direction
   }	// while direction > 0
 }
@@ -1311,30 +1450,68 @@ void PlaneOfBlocks::OneTimeSearch(WorkingArea &workarea, int length)
 
 
 
-template<typename pixel_t>
+template<typename pixel_t, bool sea_flag>
 void PlaneOfBlocks::ExpandingSearch(WorkingArea &workarea, int r, int s, int mvx, int mvy) // diameter = 2*r + 1, step=s
 { // part of true enhaustive search (thin expanding square) around mvx, mvy
   int i, j;
   //	VECTOR mv = workarea.bestMV; // bug: it was pointer assignent, not values, so iterative! - v2.1
 
     // sides of square without corners
+  // candidates are checked by groups of 4 (3 or 4 with sea_flag), in the original order
+  Candidates cand;
   for (i = -r + s; i < r; i += s) // without corners! - v2.1
   {
-    CheckMV<pixel_t>(workarea, mvx + i, mvy - r);
-    CheckMV<pixel_t>(workarea, mvx + i, mvy + r);
+    AddCandidate<pixel_t, sea_flag>(workarea, cand, mvx + i, mvy - r);
+    AddCandidate<pixel_t, sea_flag>(workarea, cand, mvx + i, mvy + r);
+    if (cand.nbr >= 3) { CheckMVMany<pixel_t>(workarea, cand); cand.clear(); }
   }
 
   for (j = -r + s; j < r; j += s)
   {
-    CheckMV<pixel_t>(workarea, mvx - r, mvy + j);
-    CheckMV<pixel_t>(workarea, mvx + r, mvy + j);
+    AddCandidate<pixel_t, sea_flag>(workarea, cand, mvx - r, mvy + j);
+    AddCandidate<pixel_t, sea_flag>(workarea, cand, mvx + r, mvy + j);
+    if (cand.nbr >= 3) { CheckMVMany<pixel_t>(workarea, cand); cand.clear(); }
   }
+  CheckMVMany<pixel_t>(workarea, cand);
 
   // then corners - they are more far from cenrer
-  CheckMV<pixel_t>(workarea, mvx - r, mvy - r);
-  CheckMV<pixel_t>(workarea, mvx - r, mvy + r);
-  CheckMV<pixel_t>(workarea, mvx + r, mvy - r);
-  CheckMV<pixel_t>(workarea, mvx + r, mvy + r);
+  cand.clear();
+  AddCandidate<pixel_t, sea_flag>(workarea, cand, mvx - r, mvy - r);
+  AddCandidate<pixel_t, sea_flag>(workarea, cand, mvx - r, mvy + r);
+  AddCandidate<pixel_t, sea_flag>(workarea, cand, mvx + r, mvy - r);
+  AddCandidate<pixel_t, sea_flag>(workarea, cand, mvx + r, mvy + r);
+  CheckMVMany<pixel_t>(workarea, cand);
+}
+
+
+
+// Successive elimination: the same vectors as EXHAUSTIVE, in the same order.
+// |sum(src) - sum(ref)| <= SAD(src, ref), so a vector whose cost computed
+// with this lower bound instead of the luma SAD is not below the best cost
+// found so far cannot be selected, and its SAD is not computed.
+// The reference block sums come from the integral images of the planes.
+template<typename pixel_t>
+void PlaneOfBlocks::SeaSearch(WorkingArea &workarea, int radius)
+{
+  int mvx = workarea.bestMV.x;
+  int mvy = workarea.bestMV.y;
+  // The bound is valid for the plain SAD only, and the cost must not
+  // decrease when the SAD increases (pnew >= 0)
+  if (dctmode == 0 && penaltyNew >= 0 && LUMA != 0 && sizeof(pixel_t) <= 2)
+  {
+    workarea.srcLuma = LUMA(workarea.pSrc[0], nSrcPitch[0]);
+    for (int i = 1; i <= radius; i++)// region is same as exhaustive, but ordered by radius (from near to far)
+    {
+      ExpandingSearch<pixel_t, true>(workarea, i, 1, mvx, mvy);
+    }
+  }
+  else
+  {
+    for (int i = 1; i <= radius; i++)
+    {
+      ExpandingSearch<pixel_t>(workarea, i, 1, mvx, mvy);
+    }
+  }
 }
 
 
@@ -1363,12 +1540,16 @@ void PlaneOfBlocks::Hex2Search(WorkingArea &workarea, int i_me_range)
 //		COPY2_IF_LT( bcost, costs[3], dir, 3 );
 //		COPY2_IF_LT( bcost, costs[4], dir, 4 );
 //		COPY2_IF_LT( bcost, costs[5], dir, 5 );
-    CheckMVdir<pixel_t>(workarea, bmx - 2, bmy, &dir, 0);
-    CheckMVdir<pixel_t>(workarea, bmx - 1, bmy + 2, &dir, 1);
-    CheckMVdir<pixel_t>(workarea, bmx + 1, bmy + 2, &dir, 2);
-    CheckMVdir<pixel_t>(workarea, bmx + 2, bmy, &dir, 3);
-    CheckMVdir<pixel_t>(workarea, bmx + 1, bmy - 2, &dir, 4);
-    CheckMVdir<pixel_t>(workarea, bmx - 1, bmy - 2, &dir, 5);
+    Candidates cand;
+    cand.add(bmx - 2, bmy, 0);
+    cand.add(bmx - 1, bmy + 2, 1);
+    cand.add(bmx + 1, bmy + 2, 2);
+    CheckMVdirMany<pixel_t>(workarea, cand, &dir);
+    cand.clear();
+    cand.add(bmx + 2, bmy, 3);
+    cand.add(bmx + 1, bmy - 2, 4);
+    cand.add(bmx - 1, bmy - 2, 5);
+    CheckMVdirMany<pixel_t>(workarea, cand, &dir);
 
 
     if (dir != -2)
@@ -1389,9 +1570,11 @@ void PlaneOfBlocks::Hex2Search(WorkingArea &workarea, int i_me_range)
         //				COPY2_IF_LT( bcost, costs[1], dir, odir   );
         //				COPY2_IF_LT( bcost, costs[2], dir, odir+1 );
 
-        CheckMVdir<pixel_t>(workarea, bmx + hex2[odir + 0][0], bmy + hex2[odir + 0][1], &dir, odir - 1);
-        CheckMVdir<pixel_t>(workarea, bmx + hex2[odir + 1][0], bmy + hex2[odir + 1][1], &dir, odir);
-        CheckMVdir<pixel_t>(workarea, bmx + hex2[odir + 2][0], bmy + hex2[odir + 2][1], &dir, odir + 1);
+        cand.clear();
+        cand.add(bmx + hex2[odir + 0][0], bmy + hex2[odir + 0][1], odir - 1);
+        cand.add(bmx + hex2[odir + 1][0], bmy + hex2[odir + 1][1], odir);
+        cand.add(bmx + hex2[odir + 2][0], bmy + hex2[odir + 2][1], odir + 1);
+        CheckMVdirMany<pixel_t>(workarea, cand, &dir);
         if (dir == -2)
         {
           break;
@@ -1417,17 +1600,22 @@ template<typename pixel_t>
 void PlaneOfBlocks::CrossSearch(WorkingArea &workarea, int start, int x_max, int y_max, int mvx, int mvy)
 {
   // part of umh  search
+  // candidates are checked by groups of 4, in the original order
+  Candidates cand;
   for (int i = start; i < x_max; i += 2)
   {
-    CheckMV<pixel_t>(workarea, mvx - i, mvy);
-    CheckMV<pixel_t>(workarea, mvx + i, mvy);
+    cand.add(mvx - i, mvy);
+    cand.add(mvx + i, mvy);
+    if (cand.full()) { CheckMVMany<pixel_t>(workarea, cand); cand.clear(); }
   }
 
   for (int j = start; j < y_max; j += 2)
   {
-    CheckMV<pixel_t>(workarea, mvx, mvy + j);
-    CheckMV<pixel_t>(workarea, mvx, mvy + j);
+    cand.add(mvx, mvy + j);
+    cand.add(mvx, mvy + j);
+    if (cand.full()) { CheckMVMany<pixel_t>(workarea, cand); cand.clear(); }
   }
+  CheckMVMany<pixel_t>(workarea, cand);
 }
 
 #if 0 // x265
@@ -2286,11 +2474,16 @@ void PlaneOfBlocks::UMHSearch(WorkingArea &workarea, int i_me_range, int omx, in
       {-2,-3}, { 0,-4}, { 2,-3},
     };
 
-    for (int j = 0; j < 16; j++)
+    for (int j = 0; j < 16; j += 4)
     {
-      int mx = omx + hex4[j][0] * i;
-      int my = omy + hex4[j][1] * i;
-      CheckMV<pixel_t>(workarea, mx, my);
+      Candidates cand;
+      for (int k = j; k < j + 4; k++)
+      {
+        int mx = omx + hex4[k][0] * i;
+        int my = omy + hex4[k][1] * i;
+        cand.add(mx, my);
+      }
+      CheckMVMany<pixel_t>(workarea, cand);
     }
   } while (++i <= i_me_range / 4);
 
@@ -2462,6 +2655,11 @@ MV_FORCEINLINE const uint8_t *	PlaneOfBlocks::GetRefBlock(WorkingArea &workarea,
     pRefFrame->GetPlane(YPLANE)->GetAbsolutePointerPel <2>((workarea.x[0] << 2) + nVx, (workarea.y[0] << 2) + nVy);
 }
 
+MV_FORCEINLINE uint32_t	PlaneOfBlocks::GetRefBlockSum(WorkingArea &workarea, int nVx, int nVy)
+{
+  return pRefFrame->GetPlane(YPLANE)->GetAbsoluteBlockSum((workarea.x[0] << nLogPel) + nVx, (workarea.y[0] << nLogPel) + nVy, nBlkSizeX, nBlkSizeY);
+}
+
 MV_FORCEINLINE const uint8_t *	PlaneOfBlocks::GetRefBlockU(WorkingArea &workarea, int nVx, int nVy)
 {
   //	return pRefFrame->GetPlane(UPLANE)->GetAbsolutePointer((workarea.x[1]<<nLogPel) + (nVx >> 1), (workarea.y[1]<<nLogPel) + (yRatioUV==1 ? nVy : nVy>>1) ); //v.1.2.1
@@ -2613,6 +2811,19 @@ MV_FORCEINLINE sad_t	PlaneOfBlocks::LumaSAD(WorkingArea &workarea, const unsigne
 #endif
 }
 
+/* luma sad, and scaled chroma sad in saduv, with a single SADYUV call (chroma and dctmode == 0 only) */
+MV_FORCEINLINE sad_t	PlaneOfBlocks::LumaChromaSAD(WorkingArea &workarea, int vx, int vy, sad_t &saduv)
+{
+#ifdef MOTION_DEBUG
+  workarea.iter++;
+#endif
+  const uint8_t *pRef[3] = { GetRefBlock(workarea, vx, vy), GetRefBlockU(workarea, vx, vy), GetRefBlockV(workarea, vx, vy) };
+  unsigned int sad_uv;
+  const sad_t sad = SADYUV(workarea.pSrc, nSrcPitch, pRef, nRefPitch, effective_chromaSADscale, &sad_uv);
+  saduv = sad_uv;
+  return sad;
+}
+
 
 /* check if the vector (vx, vy) is better than the best vector found so far without penalty new - renamed in v.2.11*/
 template<typename pixel_t>
@@ -2646,12 +2857,16 @@ MV_FORCEINLINE void	PlaneOfBlocks::CheckMV0(WorkingArea &workarea, int vx, int v
     sad_t cost=workarea.MotionDistorsion<pixel_t>(vx, vy);
     if(cost>=workarea.nMinCost) return;
 
-    sad_t sad=LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, vx, vy));
+    sad_t saduv = 0;
+    sad_t sad = (SADYUV != 0) ? LumaChromaSAD(workarea, vx, vy, saduv) : LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, vx, vy));
     cost+=sad;
     if(cost>=workarea.nMinCost) return;
 
-    sad_t saduv = (chroma) ? ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
-      + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]), effective_chromaSADscale) : 0;
+    if (chroma && SADYUV == 0)
+    {
+      saduv = ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
+        + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]), effective_chromaSADscale);
+    }
     cost += saduv;
     if(cost>=workarea.nMinCost) return;
 
@@ -2700,12 +2915,16 @@ MV_FORCEINLINE void	PlaneOfBlocks::CheckMV(WorkingArea &workarea, int vx, int vy
 
     typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
 
-    sad_t sad=LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, vx, vy));
+    sad_t saduv = 0;
+    sad_t sad = (SADYUV != 0) ? LumaChromaSAD(workarea, vx, vy, saduv) : LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, vx, vy));
     cost += sad + ((penaltyNew*(safe_sad_t)sad) >> 8);
     if(cost>=workarea.nMinCost) return;
 
-    sad_t saduv = (chroma) ? ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
-      + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]), effective_chromaSADscale) : 0;
+    if (chroma && SADYUV == 0)
+    {
+      saduv = ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
+        + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]), effective_chromaSADscale);
+    }
     cost += saduv + ((penaltyNew*(safe_sad_t)saduv) >> 8);
     if(cost>=workarea.nMinCost) return;
 
@@ -2754,12 +2973,16 @@ MV_FORCEINLINE void	PlaneOfBlocks::CheckMV2(WorkingArea &workarea, int vx, int v
 
     typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
 
-    sad_t sad=LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, vx, vy));
+    sad_t saduv = 0;
+    sad_t sad = (SADYUV != 0) ? LumaChromaSAD(workarea, vx, vy, saduv) : LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, vx, vy));
     cost += sad + ((penaltyNew*(safe_sad_t)sad) >> 8);
     if(cost>=workarea.nMinCost) return;
 
-    sad_t saduv = (chroma) ? ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
-      + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]), effective_chromaSADscale) : 0;
+    if (chroma && SADYUV == 0)
+    {
+      saduv = ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
+        + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]), effective_chromaSADscale);
+    }
     cost += saduv+((penaltyNew*(safe_sad_t)saduv) >> 8);
     if(cost>=workarea.nMinCost) return;
 
@@ -2805,12 +3028,16 @@ MV_FORCEINLINE void	PlaneOfBlocks::CheckMVdir(WorkingArea &workarea, int vx, int
 
     typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
 
-    sad_t sad=LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, vx, vy));
+    sad_t saduv = 0;
+    sad_t sad = (SADYUV != 0) ? LumaChromaSAD(workarea, vx, vy, saduv) : LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, vx, vy));
     cost += sad + ((penaltyNew*(safe_sad_t)sad) >> 8);
     if(cost>=workarea.nMinCost) return;
 
-    sad_t saduv = (chroma) ? ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
-      + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]), effective_chromaSADscale) : 0;
+    if (chroma && SADYUV == 0)
+    {
+      saduv = ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
+        + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]), effective_chromaSADscale);
+    }
     cost += saduv+((penaltyNew*(safe_sad_t)saduv) >> 8);
     if(cost>=workarea.nMinCost) return;
 
@@ -2821,6 +3048,150 @@ MV_FORCEINLINE void	PlaneOfBlocks::CheckMVdir(WorkingArea &workarea, int vx, int
   }
 }
 
+template<typename pixel_t>
+MV_FORCEINLINE void	PlaneOfBlocks::CheckMVMany(WorkingArea &workarea, const Candidates &cand)
+{
+  CheckMVBatch<pixel_t, false, true>(workarea, cand, 0);
+}
+
+template<typename pixel_t>
+MV_FORCEINLINE void	PlaneOfBlocks::CheckMV2Many(WorkingArea &workarea, const Candidates &cand, int *dir)
+{
+  CheckMVBatch<pixel_t, true, true>(workarea, cand, dir);
+}
+
+template<typename pixel_t>
+MV_FORCEINLINE void	PlaneOfBlocks::CheckMVdirMany(WorkingArea &workarea, const Candidates &cand, int *dir)
+{
+  CheckMVBatch<pixel_t, true, false>(workarea, cand, dir);
+}
+
+/* check up to 4 vectors, computing the luma SADs of the valid ones in a single pass.
+   dir_flag: update dir like CheckMV2 and CheckMVdir
+   xy_flag: update workarea.bestMV.x, y (CheckMVdir does not) */
+template<typename pixel_t, bool dir_flag, bool xy_flag>
+void	PlaneOfBlocks::CheckMVBatch(WorkingArea &workarea, const Candidates &cand, int *dir)
+{
+  assert(cand.nbr <= 4);
+
+  int idx[4];
+  int nbr_ok = 0;
+  for (int i = 0; i < cand.nbr; i++)
+  {
+    if (
+#ifdef ONLY_CHECK_NONDEFAULT_MV
+    ((cand.vx[i] != 0) || (cand.vy[i] != zeroMVfieldShifted.y)) &&
+      ((cand.vx[i] != workarea.predictor.x) || (cand.vy[i] != workarea.predictor.y)) &&
+      ((cand.vx[i] != workarea.globalMVPredictor.x) || (cand.vy[i] != workarea.globalMVPredictor.y)) &&
+#endif
+      workarea.IsVectorOK(cand.vx[i], cand.vy[i]))
+    {
+      idx[nbr_ok++] = i;
+    }
+  }
+
+  // Batched SADs only for plain SAD and when it saves something
+  if (nbr_ok < 3 || dctmode != 0 || SADX3 == 0 || SADX4 == 0)
+  {
+    for (int i = 0; i < cand.nbr; i++)
+    {
+      if (dir_flag && xy_flag)
+        CheckMV2<pixel_t>(workarea, cand.vx[i], cand.vy[i], dir, cand.val[i]);
+      else if (dir_flag)
+        CheckMVdir<pixel_t>(workarea, cand.vx[i], cand.vy[i], dir, cand.val[i]);
+      else
+        CheckMV<pixel_t>(workarea, cand.vx[i], cand.vy[i]);
+    }
+    return;
+  }
+
+  const uint8_t *pRef[4];
+  for (int j = 0; j < nbr_ok; j++)
+  {
+    pRef[j] = GetRefBlock(workarea, cand.vx[idx[j]], cand.vy[idx[j]]);
+  }
+  unsigned int sads[4];
+  if (nbr_ok == 4)
+    SADX4(workarea.pSrc[0], nSrcPitch[0], pRef[0], pRef[1], pRef[2], pRef[3], nRefPitch[0], sads);
+  else
+    SADX3(workarea.pSrc[0], nSrcPitch[0], pRef[0], pRef[1], pRef[2], nRefPitch[0], sads);
+#ifdef MOTION_DEBUG
+  workarea.iter += nbr_ok;
+#endif
+
+  for (int j = 0; j < nbr_ok; j++)
+  {
+    const int i = idx[j];
+    CheckMVWithSad<pixel_t, dir_flag, xy_flag>(workarea, cand.vx[i], cand.vy[i], sad_t(sads[j]), dir, cand.val[i]);
+  }
+}
+
+/* same as CheckMV, CheckMV2 or CheckMVdir, with the luma SAD already computed */
+template<typename pixel_t, bool dir_flag, bool xy_flag>
+MV_FORCEINLINE void	PlaneOfBlocks::CheckMVWithSad(WorkingArea &workarea, int vx, int vy, sad_t sad, int *dir, int val)
+{
+  sad_t cost=workarea.MotionDistorsion<pixel_t>(vx, vy);
+  if(cost>=workarea.nMinCost) return;
+
+  typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
+
+  cost += sad + ((penaltyNew*(safe_sad_t)sad) >> 8);
+  if(cost>=workarea.nMinCost) return;
+
+  // chroma only for the candidates still in the race after luma, U and V in a single SADUV call when available
+  sad_t saduv = 0;
+  if (SADUV != 0)
+  {
+    const uint8_t *pRef[3] = { nullptr, GetRefBlockU(workarea, vx, vy), GetRefBlockV(workarea, vx, vy) };
+    saduv = SADUV(workarea.pSrc, nSrcPitch, pRef, nRefPitch, effective_chromaSADscale);
+  }
+  else if (chroma)
+  {
+    saduv = ScaleSadChroma(SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
+      + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]), effective_chromaSADscale);
+  }
+  cost += saduv+((penaltyNew*(safe_sad_t)saduv) >> 8);
+  if(cost>=workarea.nMinCost) return;
+
+  if (xy_flag)
+  {
+    workarea.bestMV.x = vx;
+    workarea.bestMV.y = vy;
+  }
+  workarea.nMinCost = cost;
+  workarea.bestMV.sad = sad + saduv;
+  if (dir_flag)
+  {
+    *dir = val;
+  }
+}
+
+/* false if the vector cannot beat the best one, using the block sum difference as a lower bound of the luma SAD (see SeaSearch) */
+template<typename pixel_t>
+MV_FORCEINLINE bool	PlaneOfBlocks::IsSeaCandidate(WorkingArea &workarea, int vx, int vy)
+{
+  // Invalid vectors are rejected by CheckMV anyway, and their block is out of the integral image
+  if (!workarea.IsVectorOK(vx, vy)) return false;
+
+  sad_t cost=workarea.MotionDistorsion<pixel_t>(vx, vy);
+  if(cost>=workarea.nMinCost) return false;
+
+  typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
+
+  const sad_t bound = sad_t(std::abs(workarea.srcLuma - int(GetRefBlockSum(workarea, vx, vy))));
+  cost += bound + ((penaltyNew*(safe_sad_t)bound) >> 8);
+  return (cost < workarea.nMinCost);
+}
+
+template<typename pixel_t, bool sea_flag>
+MV_FORCEINLINE void	PlaneOfBlocks::AddCandidate(WorkingArea &workarea, Candidates &cand, int vx, int vy)
+{
+  if (!sea_flag || IsSeaCandidate<pixel_t>(workarea, vx, vy))
+  {
+    cand.add(vx, vy);
+  }
+}
+
 /* clip a vector to the horizontal boundaries */
 MV_FORCEINLINE int	PlaneOfBlocks::ClipMVx(WorkingArea &workarea, int vx)
 {
@@ -2891,18 +3262,158 @@ MV_FORCEINLINE bool	PlaneOfBlocks::IsInFrame(int i)
 
 
 
+// Searches the vector of a single block.
+// workarea.x, y, blkx, blky, blkIdx and blkScanDir must be set.
+// pBlkData and outfilebuf point on the beginning of the current block row.
+template<typename pixel_t>
+void	PlaneOfBlocks::search_mv_block(WorkingArea &workarea, int *pBlkData, short *outfilebuf)
+{
+  workarea.iter = 0;
+  //			DebugPrintf("BlkIdx = %d \n", workarea.blkIdx);
+  PROFILE_START(MOTION_PROFILE_ME);
+
+  // Resets the global predictor (it may have been clipped during the
+  // previous block scan)
+
+  // fixme: why recalc is resetting only outside, why, maybe recalc is not using that at all?
+  workarea.globalMVPredictor = _glob_mv_pred_def;
+
+#if (ALIGN_SOURCEBLOCK > 1)
+  //store the pitch
+  const BYTE *pY = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(workarea.x[0], workarea.y[0]);
+  //create aligned copy
+  BLITLUMA(workarea.pSrc_temp[0], nSrcPitch[0], pY, nSrcPitch_plane[0]);
+  //set the to the aligned copy
+  workarea.pSrc[0] = workarea.pSrc_temp[0];
+  if (chroma)
+  {
+    workarea.pSrc[1] = pSrcFrame->GetPlane(UPLANE)->GetAbsolutePelPointer(workarea.x[1], workarea.y[1]);
+    BLITCHROMA(workarea.pSrc_temp[1], nSrcPitch[1], workarea.pSrc[1], nSrcPitch_plane[1]);
+    workarea.pSrc[1] = workarea.pSrc_temp[1];
+    workarea.pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(workarea.x[2], workarea.y[2]);
+    BLITCHROMA(workarea.pSrc_temp[2], nSrcPitch[2], workarea.pSrc[2], nSrcPitch_plane[2]);
+    workarea.pSrc[2] = workarea.pSrc_temp[2];
+  }
+#else	// ALIGN_SOURCEBLOCK
+  workarea.pSrc[0] = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(workarea.x[0], workarea.y[0]);
+  if (chroma)
+  {
+    workarea.pSrc[1] = pSrcFrame->GetPlane(UPLANE)->GetAbsolutePelPointer(workarea.x[1], workarea.y[1]);
+    workarea.pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(workarea.x[2], workarea.y[2]);
+  }
+#endif	// ALIGN_SOURCEBLOCK
+
+  // fixme note:
+  // MAnalyze mt-inconsistency reason #3
+  // this is _not_ internal mt friendly
+  // because workarea.nLambda is set to 0 differently:
+  // In vertically sliced multithreaded case it happens an _each_ top of the sliced block
+  // In non-mt: only for the most top blocks
+
+  if (workarea.blky == workarea.blky_beg)
+  {
+    workarea.nLambda = 0;
+  }
+  else
+  {
+    workarea.nLambda = _lambda_level;
+  }
+
+  // fixme:
+  // not exacly nice, but works
+  // different threads are writing, but the are the same always and come from parameters _pnew, _lsad
+  penaltyNew = _pnew; // penalty for new vector
+  LSAD = _lsad;    // SAD limit for lambda using
+  // may be they must be scaled by nPel ?
+
+  // decreased padding of coarse levels
+  int nHPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetHPadding() >> nLogScale;
+  int nVPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetVPadding() >> nLogScale;
+  /* computes search boundaries */
+  workarea.nDxMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedWidth() - workarea.x[0] - nBlkSizeX - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled);
+  workarea.nDyMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedHeight() - workarea.y[0] - nBlkSizeY - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled);
+  workarea.nDxMin = -nPel * (workarea.x[0] - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled);
+  workarea.nDyMin = -nPel * (workarea.y[0] - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled);
+
+  /* search the mv */
+  workarea.predictor = ClipMV(workarea, vectors[workarea.blkIdx]);
+  if (temporal)
+  {
+    workarea.predictors[4] = ClipMV(workarea, *reinterpret_cast<VECTOR*>(&_vecPrev[workarea.blkIdx*N_PER_BLOCK])); // temporal predictor
+  }
+  else
+  {
+    workarea.predictors[4] = ClipMV(workarea, zeroMV);
+  }
+
+  PseudoEPZSearch<pixel_t>(workarea);
+  //			workarea.bestMV = zeroMV; // debug
+
+  if (outfilebuf != NULL) // write vector to outfile
+  {
+    outfilebuf[workarea.blkx * 4 + 0] = workarea.bestMV.x;
+    outfilebuf[workarea.blkx * 4 + 1] = workarea.bestMV.y;
+    outfilebuf[workarea.blkx * 4 + 2] = (*(uint32_t *)(&workarea.bestMV.sad) & 0x0000ffff); // low word
+    outfilebuf[workarea.blkx * 4 + 3] = (*(uint32_t *)(&workarea.bestMV.sad) >> 16);     // high word, usually null
+  }
+
+  /* write the results */
+  pBlkData[workarea.blkx*N_PER_BLOCK + 0] = workarea.bestMV.x;
+  pBlkData[workarea.blkx*N_PER_BLOCK + 1] = workarea.bestMV.y;
+  pBlkData[workarea.blkx*N_PER_BLOCK + 2] = *(uint32_t *)(&workarea.bestMV.sad);
+
+  PROFILE_STOP(MOTION_PROFILE_ME);
+
+
+  if (smallestPlane)
+  {
+    /*
+    int64_t i64_1 = 0;
+    int64_t i64_2 = 0;
+    int32_t i32 = 0;
+    unsigned int a1 = 200;
+    unsigned int a2 = 201;
+
+    i64_1 += a1 - a2; // 0x00000000 FFFFFFFF   !!!!!
+    i64_2 = i64_2 + a1 - a2; // 0xFFFFFFFF FFFFFFFF O.K.!
+    i32 += a1 - a2; // 0xFFFFFFFF
+    */
+
+    // int64_t += uint32_t - uint32_t is not ok, if diff would be negative
+    // LUMA diff can be negative! we should cast from uint32_t
+    // 64 bit cast or else: int64_t += uint32t - uint32_t results in int64_t += (uint32_t)(uint32t - uint32_t)
+    // which is baaaad 0x00000000 FFFFFFFF instead of 0xFFFFFFFF FFFFFFFF
+
+    // 161204 todo check: why is it not abs(lumadiff)?
+    typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
+    workarea.sumLumaChange += (safe_sad_t)LUMA(GetRefBlock(workarea, 0, 0), nRefPitch[0]) - (safe_sad_t)LUMA(workarea.pSrc[0], nSrcPitch[0]);
+  }
+}
+
+
+
 template<typename pixel_t>
 void	PlaneOfBlocks::search_mv_slice(Slicer::TaskData &td)
 {
   assert(&td != 0);
 
+  search_mv_rows<pixel_t>(td._y_beg, td._y_end);
+}
+
+
+
+// Searches a horizontal slice of the plane. The top and bottom rows of the
+// slice don't use the predictors of the neighbouring slices.
+template<typename pixel_t>
+void	PlaneOfBlocks::search_mv_rows(int blky_beg, int blky_end)
+{
   short *outfilebuf = _outfilebuf;
 
   WorkingArea &	workarea = *(_workarea_pool.take_obj());
   assert(&workarea != 0);
 
-  workarea.blky_beg = td._y_beg;
-  workarea.blky_end = td._y_end;
+  workarea.blky_beg = blky_beg;
+  workarea.blky_end = blky_end;
 
   workarea.DCT = 0;
 #ifdef ALLOW_DCT
@@ -2967,126 +3478,8 @@ void	PlaneOfBlocks::search_mv_slice(Slicer::TaskData &td)
     {
       workarea.blkx = blkxStart + iblkx*workarea.blkScanDir;
       workarea.blkIdx = workarea.blky*nBlkX + workarea.blkx;
-      workarea.iter = 0;
-      //			DebugPrintf("BlkIdx = %d \n", workarea.blkIdx);
-      PROFILE_START(MOTION_PROFILE_ME);
-
-      // Resets the global predictor (it may have been clipped during the
-      // previous block scan)
-
-      // fixme: why recalc is resetting only outside, why, maybe recalc is not using that at all?
-      workarea.globalMVPredictor = _glob_mv_pred_def;
-
-#if (ALIGN_SOURCEBLOCK > 1)
-      //store the pitch
-      const BYTE *pY = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(workarea.x[0], workarea.y[0]);
-      //create aligned copy
-      BLITLUMA(workarea.pSrc_temp[0], nSrcPitch[0], pY, nSrcPitch_plane[0]);
-      //set the to the aligned copy
-      workarea.pSrc[0] = workarea.pSrc_temp[0];
-      if (chroma)
-      {
-        workarea.pSrc[1] = pSrcFrame->GetPlane(UPLANE)->GetAbsolutePelPointer(workarea.x[1], workarea.y[1]);
-        BLITCHROMA(workarea.pSrc_temp[1], nSrcPitch[1], workarea.pSrc[1], nSrcPitch_plane[1]);
-        workarea.pSrc[1] = workarea.pSrc_temp[1];
-        workarea.pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(workarea.x[2], workarea.y[2]);
-        BLITCHROMA(workarea.pSrc_temp[2], nSrcPitch[2], workarea.pSrc[2], nSrcPitch_plane[2]);
-        workarea.pSrc[2] = workarea.pSrc_temp[2];
-      }
-#else	// ALIGN_SOURCEBLOCK
-      workarea.pSrc[0] = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(workarea.x[0], workarea.y[0]);
-      if (chroma)
-      {
-        workarea.pSrc[1] = pSrcFrame->GetPlane(UPLANE)->GetAbsolutePelPointer(workarea.x[1], workarea.y[1]);
-        workarea.pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(workarea.x[2], workarea.y[2]);
-      }
-#endif	// ALIGN_SOURCEBLOCK
-
-      // fixme note:
-      // MAnalyze mt-inconsistency reason #3
-      // this is _not_ internal mt friendly
-      // because workarea.nLambda is set to 0 differently:
-      // In vertically sliced multithreaded case it happens an _each_ top of the sliced block
-      // In non-mt: only for the most top blocks
-
-      if (workarea.blky == workarea.blky_beg)
-      {
-        workarea.nLambda = 0;
-      }
-      else
-      {
-        workarea.nLambda = _lambda_level;
-      }
-
-      // fixme:
-      // not exacly nice, but works
-      // different threads are writing, but the are the same always and come from parameters _pnew, _lsad
-      penaltyNew = _pnew; // penalty for new vector
-      LSAD = _lsad;    // SAD limit for lambda using
-      // may be they must be scaled by nPel ?
-
-      // decreased padding of coarse levels
-      int nHPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetHPadding() >> nLogScale;
-      int nVPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetVPadding() >> nLogScale;
-      /* computes search boundaries */
-      workarea.nDxMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedWidth() - workarea.x[0] - nBlkSizeX - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled);
-      workarea.nDyMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedHeight() - workarea.y[0] - nBlkSizeY - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled);
-      workarea.nDxMin = -nPel * (workarea.x[0] - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled);
-      workarea.nDyMin = -nPel * (workarea.y[0] - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled);
-
-      /* search the mv */
-      workarea.predictor = ClipMV(workarea, vectors[workarea.blkIdx]);
-      if (temporal)
-      {
-        workarea.predictors[4] = ClipMV(workarea, *reinterpret_cast<VECTOR*>(&_vecPrev[workarea.blkIdx*N_PER_BLOCK])); // temporal predictor
-      }
-      else
-      {
-        workarea.predictors[4] = ClipMV(workarea, zeroMV);
-      }
-
-      PseudoEPZSearch<pixel_t>(workarea);
-      //			workarea.bestMV = zeroMV; // debug
-
-      if (outfilebuf != NULL) // write vector to outfile
-      {
-        outfilebuf[workarea.blkx * 4 + 0] = workarea.bestMV.x;
-        outfilebuf[workarea.blkx * 4 + 1] = workarea.bestMV.y;
-        outfilebuf[workarea.blkx * 4 + 2] = (*(uint32_t *)(&workarea.bestMV.sad) & 0x0000ffff); // low word
-        outfilebuf[workarea.blkx * 4 + 3] = (*(uint32_t *)(&workarea.bestMV.sad) >> 16);     // high word, usually null
-      }
-
-      /* write the results */
-      pBlkData[workarea.blkx*N_PER_BLOCK + 0] = workarea.bestMV.x;
-      pBlkData[workarea.blkx*N_PER_BLOCK + 1] = workarea.bestMV.y;
-      pBlkData[workarea.blkx*N_PER_BLOCK + 2] = *(uint32_t *)(&workarea.bestMV.sad);
-
-      PROFILE_STOP(MOTION_PROFILE_ME);
-
 
-      if (smallestPlane)
-      {
-        /*
-        int64_t i64_1 = 0;
-        int64_t i64_2 = 0;
-        int32_t i32 = 0;
-        unsigned int a1 = 200;
-        unsigned int a2 = 201;
-
-        i64_1 += a1 - a2; // 0x00000000 FFFFFFFF   !!!!!
-        i64_2 = i64_2 + a1 - a2; // 0xFFFFFFFF FFFFFFFF O.K.!
-        i32 += a1 - a2; // 0xFFFFFFFF
-        */
-
-        // int64_t += uint32_t - uint32_t is not ok, if diff would be negative
-        // LUMA diff can be negative! we should cast from uint32_t
-        // 64 bit cast or else: int64_t += uint32t - uint32_t results in int64_t += (uint32_t)(uint32t - uint32_t)
-        // which is baaaad 0x00000000 FFFFFFFF instead of 0xFFFFFFFF FFFFFFFF
-
-        // 161204 todo check: why is it not abs(lumadiff)?
-        typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
-        workarea.sumLumaChange += (safe_sad_t)LUMA(GetRefBlock(workarea, 0, 0), nRefPitch[0]) - (safe_sad_t)LUMA(workarea.pSrc[0], nSrcPitch[0]);
-      }
+      search_mv_block<pixel_t>(workarea, pBlkData, outfilebuf);
 
       /* increment indexes & pointers */
       if (iblkx < nBlkX - 1)
@@ -3127,7 +3520,167 @@ void	PlaneOfBlocks::search_mv_slice(Slicer::TaskData &td)
 #endif
 
   _workarea_pool.return_obj(workarea);
-} // search_mv_slice
+} // search_mv_rows
+
+
+
+// Chooses the wavefront grid for the current plane and allocates the
+// scheduler. Returns false if the wavefront cannot be used or is not worth it,
+// the caller should fall back on the row slicer.
+bool	PlaneOfBlocks::prepare_wavefront()
+{
+  int chunk_w;
+  int nbr_cols;
+  if (!GetWavefrontGrid(nbr_cols, chunk_w))
+  {
+    return (false);
+  }
+
+  if (_sched_wavefront_ptr.get() == 0)
+  {
+    _sched_wavefront_ptr = std::unique_ptr <SchedulerWavefront>(
+      new SchedulerWavefront(true)
+    );
+  }
+  _wavefront_chunk_w = chunk_w;
+  _graph_wavefront.set_grid(nBlkY, nbr_cols);
+
+  return (true);
+}
+
+
+
+// Wavefront grid of the plane: nBlkY rows of nbr_cols tasks, chunk_w blocks
+// per task (the last one may be shorter).
+// Returns false if the wavefront cannot be used or is not worth it.
+bool	PlaneOfBlocks::GetWavefrontGrid(int &nbr_cols, int &chunk_w) const
+{
+  const int nbr_threads = AvstpWrapper::use_instance().get_nbr_threads();
+  if (nbr_threads <= 1 || nBlkY < 2 || nBlkY >= MAX_WAVEFRONT_TASKS)
+  {
+    return (false);
+  }
+
+  // About 2 tasks per thread on a row keeps all threads busy once the
+  // wavefront is established. A few blocks per task amortize the scheduling.
+  const int min_chunk_w = 4;
+  const int max_nbr_cols = (MAX_WAVEFRONT_TASKS - 1) / nBlkY;
+  chunk_w = (nBlkX + nbr_threads * 2 - 1) / (nbr_threads * 2);
+  chunk_w = std::max(chunk_w, min_chunk_w);
+  chunk_w = std::max(chunk_w, (nBlkX + max_nbr_cols - 1) / max_nbr_cols);
+  nbr_cols = (nBlkX + chunk_w - 1) / chunk_w;
+
+  return (nbr_cols >= 2);
+}
+
+
+
+// A wavefront task processes a chunk of contiguous blocks on a single row,
+// left to right. The dependencies guarantee that the left, top and top-right
+// predictors are ready, and that the bottom-right (coarse level) predictor
+// has not been overwritten yet, exactly like in the single-threaded scan.
+template<typename pixel_t>
+void	PlaneOfBlocks::search_mv_wavefront(SchedulerWavefront::TaskData &td)
+{
+  assert(&td != 0);
+
+  if (td._task_index == 0)
+  {
+    return;	// Nothing on the root node
+  }
+
+  const int blky = _graph_wavefront.get_row(td._task_index);
+  const int blkx_beg = _graph_wavefront.get_col(td._task_index) * _wavefront_chunk_w;
+  const int blkx_end = std::min(blkx_beg + _wavefront_chunk_w, nBlkX);
+  search_mv_chunk<pixel_t>(blky, blkx_beg, blkx_end);
+}
+
+
+
+// Searches the blocks [blkx_beg ; blkx_end[ of a row, left to right.
+// The left, top and top-right blocks must be already searched.
+template<typename pixel_t>
+void	PlaneOfBlocks::search_mv_chunk(int blky, int blkx_beg, int blkx_end)
+{
+  WorkingArea &	workarea = *(_workarea_pool.take_obj());
+  assert(&workarea != 0);
+
+  // Whole plane, so top and bottom rows are detected like in the
+  // single-threaded scan.
+  workarea.blky_beg = 0;
+  workarea.blky_end = nBlkY;
+
+  workarea.DCT = 0;
+#ifdef ALLOW_DCT
+  if (_dct_pool_ptr != 0)
+  {
+    workarea.DCT = _dct_pool_ptr->take_obj();
+  }
+#endif	// ALLOW_DCT
+
+  workarea.blky = blky;
+  workarea.blkScanDir = 1;
+
+  int *pBlkData = _out + 1 + workarea.blky * nBlkX*N_PER_BLOCK;
+  short *outfilebuf = _outfilebuf;
+  if (outfilebuf != NULL)
+  {
+    outfilebuf += workarea.blky * nBlkX * 4;// 4 short word per block
+  }
+
+  const int nBlkSizeX_Ovr[3] = { (nBlkSizeX - nOverlapX), (nBlkSizeX - nOverlapX) >> nLogxRatioUV, (nBlkSizeX - nOverlapX) >> nLogxRatioUV };
+  const int nBlkSizeY_Ovr[3] = { (nBlkSizeY - nOverlapY), (nBlkSizeY - nOverlapY) >> nLogyRatioUV, (nBlkSizeY - nOverlapY) >> nLogyRatioUV };
+
+  workarea.x[0] = pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nBlkSizeX_Ovr[0] * blkx_beg;
+  workarea.y[0] = pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nBlkSizeY_Ovr[0] * workarea.blky;
+  if (chroma)
+  {
+    workarea.x[1] = pSrcFrame->GetPlane(UPLANE)->GetHPadding() + nBlkSizeX_Ovr[1] * blkx_beg;
+    workarea.x[2] = pSrcFrame->GetPlane(VPLANE)->GetHPadding() + nBlkSizeX_Ovr[2] * blkx_beg;
+  }
+  if (pSrcFrame->GetMode() & UPLANE)
+  {
+    workarea.y[1] = pSrcFrame->GetPlane(UPLANE)->GetVPadding() + nBlkSizeY_Ovr[1] * workarea.blky;
+  }
+  if (pSrcFrame->GetMode() & VPLANE)
+  {
+    workarea.y[2] = pSrcFrame->GetPlane(VPLANE)->GetVPadding() + nBlkSizeY_Ovr[2] * workarea.blky;
+  }
+
+  workarea.planeSAD = 0;
+  workarea.sumLumaChange = 0;
+
+  for (workarea.blkx = blkx_beg; workarea.blkx < blkx_end; workarea.blkx++)
+  {
+    workarea.blkIdx = workarea.blky*nBlkX + workarea.blkx;
+
+    search_mv_block<pixel_t>(workarea, pBlkData, outfilebuf);
+
+    workarea.x[0] += nBlkSizeX_Ovr[0];
+    workarea.x[1] += nBlkSizeX_Ovr[1];
+    workarea.x[2] += nBlkSizeX_Ovr[2];
+  }
+
+  planeSAD += workarea.planeSAD;
+  sumLumaChange += workarea.sumLumaChange;
+
+  if (isse)
+  {
+#ifndef _M_X64
+    _mm_empty();
+#endif
+  }
+
+#ifdef ALLOW_DCT
+  if (_dct_pool_ptr != 0)
+  {
+    _dct_pool_ptr->return_obj(*(workarea.DCT));
+    workarea.DCT = 0;
+  }
+#endif
+
+  _workarea_pool.return_obj(workarea);
+} // search_mv_chunk
 
 
 
@@ -3416,6 +3969,11 @@ void	PlaneOfBlocks::recalculate_mv_slice(Slicer::TaskData &td)
           }
         }
 
+        if (searchType & SEASEARCH)
+        {
+          SeaSearch<pixel_t>(workarea, nSearchParam);
+        }
+
         if (searchType & HEX2SEARCH)
         {
           Hex2Search<pixel_t>(workarea, nSearchParam);
@@ -20,6 +20,8 @@
 
 #include "conc/ObjPool.h"
 #include "CopyCode.h"
+#include "MTFlowGraphSched.h"
+#include "MTFlowGraphWavefront.h"
 #include "MTSlicer.h"
 #include	"MVInterface.h"	// Required for ALIGN_SOURCEBLOCK
 #include "SADFunctions.h"
@@ -30,6 +32,7 @@
 #include "AllocAlign.h"
 #endif	// ALIGN_SOURCEBLOCK
 
+#include	<memory>
 #include	<vector>
 #include "avisynth.h"
 #include <atomic>
@@ -39,6 +42,9 @@
 // right now 5 should be enough (TSchniede)
 #define MAX_PREDICTOR (20)
 
+// Maximum number of tasks (root included) for the wavefront search
+#define MAX_WAVEFRONT_TASKS (8192)
+
 
 
 class DCTClass;
@@ -56,6 +62,8 @@ class PlaneOfBlocks
 public:
 
   typedef	MTSlicer <PlaneOfBlocks>	Slicer;
+  typedef	MTFlowGraphWavefront <MAX_WAVEFRONT_TASKS>	GraphWavefront;
+  typedef	MTFlowGraphSched <PlaneOfBlocks, GraphWavefront, PlaneOfBlocks, MAX_WAVEFRONT_TASKS>	SchedulerWavefront;
 
   PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSizeY, int _nPel, int _nLevel, int _nFlags, int _nOverlapX, int _nOverlapY, int _xRatioUV, int _yRatioUV, int _pixelsize, int _bits_per_pixel, conc::ObjPool <DCTClass> *dct_pool_ptr, bool mt_flag, int _chromaSADscale, IScriptEnvironment* env);
 
@@ -68,12 +76,23 @@ public:
     int * _meanLumaChange, int _divideExtra,
     int _pzero, int _pglobal, sad_t _badSAD, int _badrange, bool meander, int *vecPrev, bool _tryMany);
 
+  /* SearchMVs in parts, the caller schedules the rows */
+  void PrepareSearchMVs(MVFrame *_pSrcFrame, MVFrame *_pRefFrame, SearchType st,
+    int stp, int _lambda, sad_t _lSAD, int _pennew, int _plevel,
+    int flags, sad_t *out, const VECTOR *globalMVec, short * outfilebuf, int _fieldShiftCur,
+    int * _meanLumaChange, int _divideExtra,
+    int _pzero, int _pglobal, sad_t _badSAD, int _badrange, bool meander, int *vecPrev, bool _tryMany);
+  void SearchMVsRows(int blky_beg, int blky_end);             // as a slice of the row slicer
+  void SearchMVsChunk(int blky, int blkx_beg, int blkx_end);  // as a wavefront task
+  void FinishSearchMVs(int * _meanLumaChange);
+  bool GetWavefrontGrid(int &nbr_cols, int &chunk_w) const;
+
 
   /* plane initialisation */
 
-    /* compute the predictors from the upper plane */
+    /* compute the predictors of the rows [blky_beg ; blky_end[ from the upper plane */
   template<typename safe_sad_t, typename smallOverlapSafeSad_t>
-  void InterpolatePrediction(const PlaneOfBlocks &pob);
+  void InterpolatePrediction(const PlaneOfBlocks &pob, int blky_beg, int blky_end);
 
 
   void WriteHeaderToArray(int *array);
@@ -127,11 +146,21 @@ private:
   COPYFunction * BLITCHROMA;
   SADFunction *  SADCHROMA;
   SADFunction *  SATD;              /* SATD function, (similar to SAD), used as replacement to dct */
+  SADx3Function * SADX3;           /* sad of 3 candidates in a single pass */
+  SADx4Function * SADX4;           /* sad of 4 candidates in a single pass */
+  SADYUVFunction * SADYUV;         /* luma and scaled chroma sads in a single pass, 0 if not available */
+  SADUVFunction * SADUV;           /* scaled chroma sad of SADYUV alone, set together with SADYUV */
 
   std::vector <VECTOR>              /* motion vectors of the blocks */
     vectors;           /* before the search, contains the hierachal predictor */
                        /* after the search, contains the best motion vector */
 
+  // Without meander: for each block, number of bad blocks of its row up to
+  // the block included. Gives a badcount independent from the order of the
+  // parallel tasks, see count_bad_blocks().
+  std::vector <int>
+    _bad_cnt_arr;
+
   bool           smallestPlane;     /* say whether vectors can used predictors from a smaller plane */
 //	bool           mmx;               /* can we use mmx asm code */
   bool           isse;              /* can we use isse asm code */
@@ -240,7 +269,7 @@ private:
 
     int nLambda;                /* vector cost factor */
     int iter;                   // MOTION_DEBUG only?
-    int srcLuma;
+    int srcLuma;                // Luma sum of the source block, for dct >= 3 and SeaSearch
 
     int pixelsize;
     int bits_per_pixel;
@@ -287,6 +316,14 @@ private:
   WorkingAreaPool
     _workarea_pool;
 
+  // Wavefront search (mt without meander). The scheduler is large, so it is
+  // allocated on the first use.
+  std::unique_ptr <SchedulerWavefront>
+    _sched_wavefront_ptr;
+  GraphWavefront
+    _graph_wavefront;
+  int _wavefront_chunk_w;     // Width of a wavefront task, in blocks
+
   VECTOR *_gvect_estim_ptr;	// Points on the global motion vector estimation result. 0 when not used.
   std::atomic<int> _gvect_result_count;
 
@@ -318,12 +355,18 @@ private:
   template<typename pixel_t>
   void PseudoEPZSearch(WorkingArea &workarea);
 
+  int count_bad_blocks(const WorkingArea &workarea) const;
+
   //	void PhaseShiftSearch(int vx, int vy);
 
   /* performs an exhaustive search */
-  template<typename pixel_t>
+  template<typename pixel_t, bool sea_flag = false>
   void ExpandingSearch(WorkingArea &workarea, int radius, int step, int mvx, int mvy); // diameter = 2*radius + 1
 
+  /* performs an exhaustive search, skipping the vectors eliminated by the block sums */
+  template<typename pixel_t>
+  void SeaSearch(WorkingArea &workarea, int radius);
+
   template<typename pixel_t>
   void Hex2Search(WorkingArea &workarea, int i_me_range);
   template<typename pixel_t>
@@ -336,11 +379,13 @@ private:
   MV_FORCEINLINE const uint8_t *GetRefBlockU(WorkingArea &workarea, int nVx, int nVy);
   MV_FORCEINLINE const uint8_t *GetRefBlockV(WorkingArea &workarea, int nVx, int nVy);
   MV_FORCEINLINE const uint8_t *GetSrcBlock(int nX, int nY);
+  MV_FORCEINLINE uint32_t GetRefBlockSum(WorkingArea &workarea, int nVx, int nVy);
   //	MV_FORCEINLINE int LengthPenalty(int vx, int vy);
   template<typename pixel_t>
   sad_t LumaSADx(WorkingArea &workarea, const unsigned char *pRef0);
   template<typename pixel_t>
   MV_FORCEINLINE sad_t LumaSAD(WorkingArea &workarea, const unsigned char *pRef0);
+  MV_FORCEINLINE sad_t LumaChromaSAD(WorkingArea &workarea, int vx, int vy, sad_t &saduv);
   template<typename pixel_t>
   MV_FORCEINLINE void CheckMV0(WorkingArea &workarea, int vx, int vy);
   template<typename pixel_t>
@@ -349,6 +394,36 @@ private:
   MV_FORCEINLINE void CheckMV2(WorkingArea &workarea, int vx, int vy, int *dir, int val);
   template<typename pixel_t>
   MV_FORCEINLINE void CheckMVdir(WorkingArea &workarea, int vx, int vy, int *dir, int val);
+  // Up to 4 candidate vectors checked together
+  class Candidates
+  {
+  public:
+    int vx[4];
+    int vy[4];
+    int val[4];                 // direction values for CheckMV2 and CheckMVdir
+    int nbr;
+    Candidates() : nbr(0) {}
+    MV_FORCEINLINE void add(int x, int y, int v = 0) { assert(nbr < 4); vx[nbr] = x; vy[nbr] = y; val[nbr] = v; ++nbr; }
+    MV_FORCEINLINE bool full() const { return nbr == 4; }
+    MV_FORCEINLINE void clear() { nbr = 0; }
+  };
+  // Batched versions of CheckMV, CheckMV2 and CheckMVdir.
+  // The luma SADs are computed in a single pass, then the candidates are
+  // evaluated in order, so the result is the same as the sequential calls.
+  template<typename pixel_t>
+  MV_FORCEINLINE void CheckMVMany(WorkingArea &workarea, const Candidates &cand);
+  template<typename pixel_t>
+  MV_FORCEINLINE void CheckMV2Many(WorkingArea &workarea, const Candidates &cand, int *dir);
+  template<typename pixel_t>
+  MV_FORCEINLINE void CheckMVdirMany(WorkingArea &workarea, const Candidates &cand, int *dir);
+  template<typename pixel_t, bool dir_flag, bool xy_flag>
+  void CheckMVBatch(WorkingArea &workarea, const Candidates &cand, int *dir);
+  template<typename pixel_t, bool dir_flag, bool xy_flag>
+  MV_FORCEINLINE void CheckMVWithSad(WorkingArea &workarea, int vx, int vy, sad_t sad, int *dir, int val);
+  template<typename pixel_t>
+  MV_FORCEINLINE bool IsSeaCandidate(WorkingArea &workarea, int vx, int vy);
+  template<typename pixel_t, bool sea_flag>
+  MV_FORCEINLINE void AddCandidate(WorkingArea &workarea, Candidates &cand, int vx, int vy);
   MV_FORCEINLINE int ClipMVx(WorkingArea &workarea, int vx);
   MV_FORCEINLINE int ClipMVy(WorkingArea &workarea, int vy);
   MV_FORCEINLINE VECTOR ClipMV(WorkingArea &workarea, VECTOR v);
@@ -360,9 +435,18 @@ private:
   template<typename pixel_t>
   void Refine(WorkingArea &workarea);
 
+  template<typename pixel_t>
+  void	search_mv_block(WorkingArea &workarea, int *pBlkData, short *outfilebuf);
   template<typename pixel_t>
   void	search_mv_slice(Slicer::TaskData &td);
   template<typename pixel_t>
+  void	search_mv_wavefront(SchedulerWavefront::TaskData &td);
+  template<typename pixel_t>
+  void	search_mv_rows(int blky_beg, int blky_end);
+  template<typename pixel_t>
+  void	search_mv_chunk(int blky, int blkx_beg, int blkx_end);
+  bool	prepare_wavefront();
+  template<typename pixel_t>
   void	recalculate_mv_slice(Slicer::TaskData &td);
 
   void	estimate_global_mv_doubled_slice(Slicer::TaskData &td);
@@ -1,5 +1,6 @@
 #include "SADFunctions.h"
 #include "SADFunctions_avx2.h"
+#include "SADFunctions_avx512.h"
 #include "overlap.h"
 #include <map>
 #include <tuple>
@@ -1050,9 +1051,35 @@ func_sad[make_tuple(x, y, 16, USE_SSE2)] = Sad16_sse2_##x##xN<y>;
       //MAKE_SAD_FN(2, 1)
 #undef MAKE_SAD_FN
 
+    //---------------- AVX512
+    // templates in SADFunctions_avx512, rows of 16, 32 or 64*n bytes
+    // 10 bit has its own AVX2 entry, so register it here too
+#define MAKE_SAD_FN(x, y) func_sad[make_tuple(x, y, 8, USE_AVX512)] = Sad_avx512<x, y, uint8_t>; \
+      func_sad[make_tuple(x, y, 10, USE_AVX512)] = Sad_avx512<x, y, uint16_t>; \
+      func_sad[make_tuple(x, y, 16, USE_AVX512)] = Sad_avx512<x, y, uint16_t>;
+      MAKE_SAD_FN(64, 64)
+      MAKE_SAD_FN(64, 48)
+      MAKE_SAD_FN(64, 32)
+      MAKE_SAD_FN(64, 16)
+      // 48: 48 and 96 bytes, AVX2 is used
+      MAKE_SAD_FN(32, 64)
+      MAKE_SAD_FN(32, 32)
+      MAKE_SAD_FN(32, 24)
+      MAKE_SAD_FN(32, 16)
+      MAKE_SAD_FN(32, 8)
+      MAKE_SAD_FN(16, 64)
+      MAKE_SAD_FN(16, 32)
+      MAKE_SAD_FN(16, 16)
+      MAKE_SAD_FN(16, 12)
+      MAKE_SAD_FN(16, 8)
+      MAKE_SAD_FN(16, 4)
+#undef MAKE_SAD_FN
+    func_sad[make_tuple(16, 2, 10, USE_AVX512)] = Sad_avx512<16, 2, uint16_t>;
+    func_sad[make_tuple(16, 2, 16, USE_AVX512)] = Sad_avx512<16, 2, uint16_t>;
+
 
     SADFunction *result = nullptr;
-    arch_t archlist[] = { USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
+    arch_t archlist[] = { USE_AVX512, USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
     int index = 0;
     while (result == nullptr) {
       arch_t current_arch_try = archlist[index++];
@@ -1421,8 +1448,49 @@ SADFunction* get_satd_function(int BlockX, int BlockY, int pixelsize, arch_t arc
       MAKE_FN(4, 4)
 #undef MAKE_FN
 
+    // AVX512 templates in SADFunctions_avx512
+    // 8 bit: widths 32 and 64, 16 with height mod 8. 16 bit: widths mod 16
+#define MAKE_FN(w, h) func_satd[make_tuple(w, h, 1, USE_AVX512)] = Satd_avx512<w, h, uint8_t>;
+      MAKE_FN(64, 64)
+      MAKE_FN(64, 48)
+      MAKE_FN(64, 32)
+      MAKE_FN(64, 16)
+      MAKE_FN(32, 64)
+      MAKE_FN(32, 32)
+      MAKE_FN(32, 24)
+      MAKE_FN(32, 16)
+      MAKE_FN(32, 8)
+      MAKE_FN(32, 4)
+      MAKE_FN(16, 64)
+      MAKE_FN(16, 32)
+      MAKE_FN(16, 16)
+      MAKE_FN(16, 8)
+#undef MAKE_FN
+#define MAKE_FN(w, h) func_satd[make_tuple(w, h, 2, USE_AVX512)] = Satd_avx512<w, h, uint16_t>;
+      MAKE_FN(64, 64)
+      MAKE_FN(64, 48)
+      MAKE_FN(64, 32)
+      MAKE_FN(64, 16)
+      MAKE_FN(48, 64)
+      MAKE_FN(48, 48)
+      MAKE_FN(48, 24)
+      MAKE_FN(48, 12)
+      MAKE_FN(32, 64)
+      MAKE_FN(32, 32)
+      MAKE_FN(32, 24)
+      MAKE_FN(32, 16)
+      MAKE_FN(32, 8)
+      MAKE_FN(32, 4)
+      MAKE_FN(16, 64)
+      MAKE_FN(16, 32)
+      MAKE_FN(16, 16)
+      MAKE_FN(16, 12)
+      MAKE_FN(16, 8)
+      MAKE_FN(16, 4)
+#undef MAKE_FN
+
     SADFunction *result = nullptr;
-    arch_t archlist[] = { USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
+    arch_t archlist[] = { USE_AVX512, USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
     int index = 0;
     while (result == nullptr) {
       arch_t current_arch_try = archlist[index++];
@@ -1441,3 +1509,550 @@ SADFunction* get_satd_function(int BlockX, int BlockY, int pixelsize, arch_t arc
 }
 
 
+
+
+
+//------------------
+// Multi-candidate SAD: 3 or 4 reference blocks against the same source block.
+// Source rows are loaded once and reused for every candidate.
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+static void Sad_x3_C(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef0, const uint8_t *pRef1, const uint8_t *pRef2, int nRefPitch, unsigned int *sads)
+{
+  sads[0] = Sad_C<nBlkWidth, nBlkHeight, pixel_t>(pSrc, nSrcPitch, pRef0, nRefPitch);
+  sads[1] = Sad_C<nBlkWidth, nBlkHeight, pixel_t>(pSrc, nSrcPitch, pRef1, nRefPitch);
+  sads[2] = Sad_C<nBlkWidth, nBlkHeight, pixel_t>(pSrc, nSrcPitch, pRef2, nRefPitch);
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+static void Sad_x4_C(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef0, const uint8_t *pRef1, const uint8_t *pRef2, const uint8_t *pRef3, int nRefPitch, unsigned int *sads)
+{
+  sads[0] = Sad_C<nBlkWidth, nBlkHeight, pixel_t>(pSrc, nSrcPitch, pRef0, nRefPitch);
+  sads[1] = Sad_C<nBlkWidth, nBlkHeight, pixel_t>(pSrc, nSrcPitch, pRef1, nRefPitch);
+  sads[2] = Sad_C<nBlkWidth, nBlkHeight, pixel_t>(pSrc, nSrcPitch, pRef2, nRefPitch);
+  sads[3] = Sad_C<nBlkWidth, nBlkHeight, pixel_t>(pSrc, nSrcPitch, pRef3, nRefPitch);
+}
+
+template<typename pixel_t>
+MV_FORCEINLINE __m128i sad_x_accumulate_sse2(__m128i sum, __m128i src, __m128i ref, __m128i zero)
+{
+  if constexpr(sizeof(pixel_t) == 1) {
+    return _mm_add_epi32(sum, _mm_sad_epu8(src, ref));
+  }
+  else {
+    __m128i greater_t = _mm_subs_epu16(src, ref); // unsigned sub with saturation
+    __m128i smaller_t = _mm_subs_epu16(ref, src);
+    __m128i absdiff = _mm_or_si128(greater_t, smaller_t); //abs(s1-s2)  == (satsub(s1,s2) | satsub(s2,s1))
+    sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(absdiff, zero));
+    return _mm_add_epi32(sum, _mm_unpackhi_epi16(absdiff, zero));
+  }
+}
+
+// Any width which is a multiple of 4 bytes: 16, 8 then 4 bytes per row step.
+// Unused parts of the partial loads are zero in both source and reference.
+template<int nBlkWidth, int nBlkHeight, typename pixel_t, int nRef>
+static MV_FORCEINLINE void Sad_xN_sse2(const uint8_t *pSrc, int nSrcPitch, const uint8_t * const *pRefArr, int nRefPitch, unsigned int *sads)
+{
+  constexpr int width_b = nBlkWidth * sizeof(pixel_t);
+  static_assert(width_b % 4 == 0, "Sad_xN_sse2: width must be a multiple of 4 bytes");
+
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sum[nRef];
+  const uint8_t *pRef[nRef];
+  for (int k = 0; k < nRef; k++) {
+    sum[k] = zero;
+    pRef[k] = pRefArr[k];
+  }
+
+  for (int y = 0; y < nBlkHeight; y++)
+  {
+    int x = 0;
+    for (; x + 16 <= width_b; x += 16)
+    {
+      const __m128i src = _mm_loadu_si128((const __m128i *) (pSrc + x));
+      for (int k = 0; k < nRef; k++)
+        sum[k] = sad_x_accumulate_sse2<pixel_t>(sum[k], src, _mm_loadu_si128((const __m128i *) (pRef[k] + x)), zero);
+    }
+    if constexpr(width_b % 16 >= 8) {
+      const __m128i src = _mm_loadl_epi64((const __m128i *) (pSrc + x));
+      for (int k = 0; k < nRef; k++)
+        sum[k] = sad_x_accumulate_sse2<pixel_t>(sum[k], src, _mm_loadl_epi64((const __m128i *) (pRef[k] + x)), zero);
+      x += 8;
+    }
+    if constexpr(width_b % 8 == 4) {
+      const __m128i src = _mm_cvtsi32_si128(*reinterpret_cast<const int *>(pSrc + x));
+      for (int k = 0; k < nRef; k++)
+        sum[k] = sad_x_accumulate_sse2<pixel_t>(sum[k], src, _mm_cvtsi32_si128(*reinterpret_cast<const int *>(pRef[k] + x)), zero);
+    }
+    pSrc += nSrcPitch;
+    for (int k = 0; k < nRef; k++)
+      pRef[k] += nRefPitch;
+  }
+
+  for (int k = 0; k < nRef; k++)
+  {
+    __m128i s = _mm_add_epi32(sum[k], _mm_unpackhi_epi64(sum[k], sum[k]));
+    if constexpr(sizeof(pixel_t) == 2) {
+      // 4 partial sums, _mm_sad_epu8 only fills 2 of them
+      s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 1, 1, 1)));
+    }
+    sads[k] = _mm_cvtsi128_si32(s);
+  }
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+static void Sad_x3_sse2(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef0, const uint8_t *pRef1, const uint8_t *pRef2, int nRefPitch, unsigned int *sads)
+{
+  const uint8_t *pRef[3] = { pRef0, pRef1, pRef2 };
+  Sad_xN_sse2<nBlkWidth, nBlkHeight, pixel_t, 3>(pSrc, nSrcPitch, pRef, nRefPitch, sads);
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+static void Sad_x4_sse2(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef0, const uint8_t *pRef1, const uint8_t *pRef2, const uint8_t *pRef3, int nRefPitch, unsigned int *sads)
+{
+  const uint8_t *pRef[4] = { pRef0, pRef1, pRef2, pRef3 };
+  Sad_xN_sse2<nBlkWidth, nBlkHeight, pixel_t, 4>(pSrc, nSrcPitch, pRef, nRefPitch, sads);
+}
+
+#define MAKE_SAD_X_FN_C(x, y) \
+func_sad_x3[make_tuple(x, y, 8, NO_SIMD)] = Sad_x3_C<x, y, uint8_t>; \
+func_sad_x3[make_tuple(x, y, 16, NO_SIMD)] = Sad_x3_C<x, y, uint16_t>; \
+func_sad_x4[make_tuple(x, y, 8, NO_SIMD)] = Sad_x4_C<x, y, uint8_t>; \
+func_sad_x4[make_tuple(x, y, 16, NO_SIMD)] = Sad_x4_C<x, y, uint16_t>;
+#define MAKE_SAD_X_FN_SSE2_8(x, y) \
+func_sad_x3[make_tuple(x, y, 8, USE_SSE2)] = Sad_x3_sse2<x, y, uint8_t>; \
+func_sad_x4[make_tuple(x, y, 8, USE_SSE2)] = Sad_x4_sse2<x, y, uint8_t>;
+#define MAKE_SAD_X_FN_SSE2_16(x, y) \
+func_sad_x3[make_tuple(x, y, 16, USE_SSE2)] = Sad_x3_sse2<x, y, uint16_t>; \
+func_sad_x4[make_tuple(x, y, 16, USE_SSE2)] = Sad_x4_sse2<x, y, uint16_t>;
+#define MAKE_SAD_X_FN_AVX2_8(x, y) \
+func_sad_x3[make_tuple(x, y, 8, USE_AVX2)] = Sad_x3_avx2<x, y, uint8_t>; \
+func_sad_x4[make_tuple(x, y, 8, USE_AVX2)] = Sad_x4_avx2<x, y, uint8_t>;
+#define MAKE_SAD_X_FN_AVX2_16(x, y) \
+func_sad_x3[make_tuple(x, y, 16, USE_AVX2)] = Sad_x3_avx2<x, y, uint16_t>; \
+func_sad_x4[make_tuple(x, y, 16, USE_AVX2)] = Sad_x4_avx2<x, y, uint16_t>;
+
+// Fills the function tables for both the x3 and x4 variants.
+// Block sizes match the get_sad_function list.
+static void fill_sad_x_functions(
+  std::map<std::tuple<int, int, int, arch_t>, SADx3Function*> &func_sad_x3,
+  std::map<std::tuple<int, int, int, arch_t>, SADx4Function*> &func_sad_x4)
+{
+  using std::make_tuple;
+
+  MAKE_SAD_X_FN_C(64, 64)
+  MAKE_SAD_X_FN_C(64, 48)
+  MAKE_SAD_X_FN_C(64, 32)
+  MAKE_SAD_X_FN_C(64, 16)
+  MAKE_SAD_X_FN_C(48, 64)
+  MAKE_SAD_X_FN_C(48, 48)
+  MAKE_SAD_X_FN_C(48, 24)
+  MAKE_SAD_X_FN_C(48, 12)
+  MAKE_SAD_X_FN_C(32, 64)
+  MAKE_SAD_X_FN_C(32, 32)
+  MAKE_SAD_X_FN_C(32, 24)
+  MAKE_SAD_X_FN_C(32, 16)
+  MAKE_SAD_X_FN_C(32, 8)
+  MAKE_SAD_X_FN_C(24, 48)
+  MAKE_SAD_X_FN_C(24, 32)
+  MAKE_SAD_X_FN_C(24, 24)
+  MAKE_SAD_X_FN_C(24, 12)
+  MAKE_SAD_X_FN_C(24, 6)
+  MAKE_SAD_X_FN_C(16, 64)
+  MAKE_SAD_X_FN_C(16, 32)
+  MAKE_SAD_X_FN_C(16, 16)
+  MAKE_SAD_X_FN_C(16, 12)
+  MAKE_SAD_X_FN_C(16, 8)
+  MAKE_SAD_X_FN_C(16, 4)
+  MAKE_SAD_X_FN_C(16, 2)
+  MAKE_SAD_X_FN_C(16, 1)
+  MAKE_SAD_X_FN_C(12, 48)
+  MAKE_SAD_X_FN_C(12, 24)
+  MAKE_SAD_X_FN_C(12, 16)
+  MAKE_SAD_X_FN_C(12, 12)
+  MAKE_SAD_X_FN_C(12, 6)
+  MAKE_SAD_X_FN_C(12, 3)
+  MAKE_SAD_X_FN_C(8, 32)
+  MAKE_SAD_X_FN_C(8, 16)
+  MAKE_SAD_X_FN_C(8, 8)
+  MAKE_SAD_X_FN_C(8, 4)
+  MAKE_SAD_X_FN_C(8, 2)
+  MAKE_SAD_X_FN_C(8, 1)
+  MAKE_SAD_X_FN_C(6, 24)
+  MAKE_SAD_X_FN_C(6, 12)
+  MAKE_SAD_X_FN_C(6, 6)
+  MAKE_SAD_X_FN_C(6, 3)
+  MAKE_SAD_X_FN_C(4, 8)
+  MAKE_SAD_X_FN_C(4, 4)
+  MAKE_SAD_X_FN_C(4, 2)
+  MAKE_SAD_X_FN_C(4, 1)
+  MAKE_SAD_X_FN_C(3, 6)
+  MAKE_SAD_X_FN_C(3, 3)
+  MAKE_SAD_X_FN_C(2, 4)
+  MAKE_SAD_X_FN_C(2, 2)
+  MAKE_SAD_X_FN_C(2, 1)
+
+  // SSE2, 8 bits: widths multiple of 4 pixels
+  MAKE_SAD_X_FN_SSE2_8(64, 64)
+  MAKE_SAD_X_FN_SSE2_8(64, 48)
+  MAKE_SAD_X_FN_SSE2_8(64, 32)
+  MAKE_SAD_X_FN_SSE2_8(64, 16)
+  MAKE_SAD_X_FN_SSE2_8(48, 64)
+  MAKE_SAD_X_FN_SSE2_8(48, 48)
+  MAKE_SAD_X_FN_SSE2_8(48, 24)
+  MAKE_SAD_X_FN_SSE2_8(48, 12)
+  MAKE_SAD_X_FN_SSE2_8(32, 64)
+  MAKE_SAD_X_FN_SSE2_8(32, 32)
+  MAKE_SAD_X_FN_SSE2_8(32, 24)
+  MAKE_SAD_X_FN_SSE2_8(32, 16)
+  MAKE_SAD_X_FN_SSE2_8(32, 8)
+  MAKE_SAD_X_FN_SSE2_8(24, 48)
+  MAKE_SAD_X_FN_SSE2_8(24, 32)
+  MAKE_SAD_X_FN_SSE2_8(24, 24)
+  MAKE_SAD_X_FN_SSE2_8(24, 12)
+  MAKE_SAD_X_FN_SSE2_8(24, 6)
+  MAKE_SAD_X_FN_SSE2_8(16, 64)
+  MAKE_SAD_X_FN_SSE2_8(16, 32)
+  MAKE_SAD_X_FN_SSE2_8(16, 16)
+  MAKE_SAD_X_FN_SSE2_8(16, 12)
+  MAKE_SAD_X_FN_SSE2_8(16, 8)
+  MAKE_SAD_X_FN_SSE2_8(16, 4)
+  MAKE_SAD_X_FN_SSE2_8(16, 2)
+  MAKE_SAD_X_FN_SSE2_8(16, 1)
+  MAKE_SAD_X_FN_SSE2_8(12, 48)
+  MAKE_SAD_X_FN_SSE2_8(12, 24)
+  MAKE_SAD_X_FN_SSE2_8(12, 16)
+  MAKE_SAD_X_FN_SSE2_8(12, 12)
+  MAKE_SAD_X_FN_SSE2_8(12, 6)
+  MAKE_SAD_X_FN_SSE2_8(12, 3)
+  MAKE_SAD_X_FN_SSE2_8(8, 32)
+  MAKE_SAD_X_FN_SSE2_8(8, 16)
+  MAKE_SAD_X_FN_SSE2_8(8, 8)
+  MAKE_SAD_X_FN_SSE2_8(8, 4)
+  MAKE_SAD_X_FN_SSE2_8(8, 2)
+  MAKE_SAD_X_FN_SSE2_8(8, 1)
+  MAKE_SAD_X_FN_SSE2_8(4, 8)
+  MAKE_SAD_X_FN_SSE2_8(4, 4)
+  MAKE_SAD_X_FN_SSE2_8(4, 2)
+  MAKE_SAD_X_FN_SSE2_8(4, 1)
+
+  // SSE2, 16 bits: even widths
+  MAKE_SAD_X_FN_SSE2_16(64, 64)
+  MAKE_SAD_X_FN_SSE2_16(64, 48)
+  MAKE_SAD_X_FN_SSE2_16(64, 32)
+  MAKE_SAD_X_FN_SSE2_16(64, 16)
+  MAKE_SAD_X_FN_SSE2_16(48, 64)
+  MAKE_SAD_X_FN_SSE2_16(48, 48)
+  MAKE_SAD_X_FN_SSE2_16(48, 24)
+  MAKE_SAD_X_FN_SSE2_16(48, 12)
+  MAKE_SAD_X_FN_SSE2_16(32, 64)
+  MAKE_SAD_X_FN_SSE2_16(32, 32)
+  MAKE_SAD_X_FN_SSE2_16(32, 24)
+  MAKE_SAD_X_FN_SSE2_16(32, 16)
+  MAKE_SAD_X_FN_SSE2_16(32, 8)
+  MAKE_SAD_X_FN_SSE2_16(24, 48)
+  MAKE_SAD_X_FN_SSE2_16(24, 32)
+  MAKE_SAD_X_FN_SSE2_16(24, 24)
+  MAKE_SAD_X_FN_SSE2_16(24, 12)
+  MAKE_SAD_X_FN_SSE2_16(24, 6)
+  MAKE_SAD_X_FN_SSE2_16(16, 64)
+  MAKE_SAD_X_FN_SSE2_16(16, 32)
+  MAKE_SAD_X_FN_SSE2_16(16, 16)
+  MAKE_SAD_X_FN_SSE2_16(16, 12)
+  MAKE_SAD_X_FN_SSE2_16(16, 8)
+  MAKE_SAD_X_FN_SSE2_16(16, 4)
+  MAKE_SAD_X_FN_SSE2_16(16, 2)
+  MAKE_SAD_X_FN_SSE2_16(16, 1)
+  MAKE_SAD_X_FN_SSE2_16(12, 48)
+  MAKE_SAD_X_FN_SSE2_16(12, 24)
+  MAKE_SAD_X_FN_SSE2_16(12, 16)
+  MAKE_SAD_X_FN_SSE2_16(12, 12)
+  MAKE_SAD_X_FN_SSE2_16(12, 6)
+  MAKE_SAD_X_FN_SSE2_16(12, 3)
+  MAKE_SAD_X_FN_SSE2_16(8, 32)
+  MAKE_SAD_X_FN_SSE2_16(8, 16)
+  MAKE_SAD_X_FN_SSE2_16(8, 8)
+  MAKE_SAD_X_FN_SSE2_16(8, 4)
+  MAKE_SAD_X_FN_SSE2_16(8, 2)
+  MAKE_SAD_X_FN_SSE2_16(8, 1)
+  MAKE_SAD_X_FN_SSE2_16(6, 24)
+  MAKE_SAD_X_FN_SSE2_16(6, 12)
+  MAKE_SAD_X_FN_SSE2_16(6, 6)
+  MAKE_SAD_X_FN_SSE2_16(6, 3)
+  MAKE_SAD_X_FN_SSE2_16(4, 8)
+  MAKE_SAD_X_FN_SSE2_16(4, 4)
+  MAKE_SAD_X_FN_SSE2_16(4, 2)
+  MAKE_SAD_X_FN_SSE2_16(4, 1)
+  MAKE_SAD_X_FN_SSE2_16(2, 4)
+  MAKE_SAD_X_FN_SSE2_16(2, 2)
+  MAKE_SAD_X_FN_SSE2_16(2, 1)
+
+  // AVX2: widths multiple of 32 bytes, templates in SADFunctions_avx2
+  MAKE_SAD_X_FN_AVX2_8(64, 64)
+  MAKE_SAD_X_FN_AVX2_8(64, 48)
+  MAKE_SAD_X_FN_AVX2_8(64, 32)
+  MAKE_SAD_X_FN_AVX2_8(64, 16)
+  MAKE_SAD_X_FN_AVX2_8(32, 64)
+  MAKE_SAD_X_FN_AVX2_8(32, 32)
+  MAKE_SAD_X_FN_AVX2_8(32, 24)
+  MAKE_SAD_X_FN_AVX2_8(32, 16)
+  MAKE_SAD_X_FN_AVX2_8(32, 8)
+  MAKE_SAD_X_FN_AVX2_16(64, 64)
+  MAKE_SAD_X_FN_AVX2_16(64, 48)
+  MAKE_SAD_X_FN_AVX2_16(64, 32)
+  MAKE_SAD_X_FN_AVX2_16(64, 16)
+  MAKE_SAD_X_FN_AVX2_16(48, 64)
+  MAKE_SAD_X_FN_AVX2_16(48, 48)
+  MAKE_SAD_X_FN_AVX2_16(48, 24)
+  MAKE_SAD_X_FN_AVX2_16(48, 12)
+  MAKE_SAD_X_FN_AVX2_16(32, 64)
+  MAKE_SAD_X_FN_AVX2_16(32, 32)
+  MAKE_SAD_X_FN_AVX2_16(32, 24)
+  MAKE_SAD_X_FN_AVX2_16(32, 16)
+  MAKE_SAD_X_FN_AVX2_16(32, 8)
+  MAKE_SAD_X_FN_AVX2_16(16, 64)
+  MAKE_SAD_X_FN_AVX2_16(16, 32)
+  MAKE_SAD_X_FN_AVX2_16(16, 16)
+  MAKE_SAD_X_FN_AVX2_16(16, 12)
+  MAKE_SAD_X_FN_AVX2_16(16, 8)
+  MAKE_SAD_X_FN_AVX2_16(16, 4)
+  MAKE_SAD_X_FN_AVX2_16(16, 2)
+  MAKE_SAD_X_FN_AVX2_16(16, 1)
+}
+
+#undef MAKE_SAD_X_FN_C
+#undef MAKE_SAD_X_FN_SSE2_8
+#undef MAKE_SAD_X_FN_SSE2_16
+#undef MAKE_SAD_X_FN_AVX2_8
+#undef MAKE_SAD_X_FN_AVX2_16
+
+template<typename F>
+static F* select_sad_x_function(std::map<std::tuple<int, int, int, arch_t>, F*> &func_sad_x, int BlockX, int BlockY, int bits_per_pixel, arch_t arch)
+{
+  using std::make_tuple;
+
+  // 10-16 bits share the same code, no specific 10 bit versions
+  if (bits_per_pixel > 16)
+    return nullptr;
+  const int bits = (bits_per_pixel == 8) ? 8 : 16;
+
+  F *result = nullptr;
+  arch_t archlist[] = { USE_AVX512, USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
+  for (int index = 0; result == nullptr && index < int(sizeof(archlist) / sizeof(archlist[0])); index++) {
+    arch_t current_arch_try = archlist[index];
+    if (current_arch_try > arch) continue;
+    result = func_sad_x[make_tuple(BlockX, BlockY, bits, current_arch_try)];
+  }
+  return result;
+}
+
+SADx3Function* get_sad_x3_function(int BlockX, int BlockY, int bits_per_pixel, arch_t arch)
+{
+  std::map<std::tuple<int, int, int, arch_t>, SADx3Function*> func_sad_x3;
+  std::map<std::tuple<int, int, int, arch_t>, SADx4Function*> func_sad_x4;
+  fill_sad_x_functions(func_sad_x3, func_sad_x4);
+  return select_sad_x_function(func_sad_x3, BlockX, BlockY, bits_per_pixel, arch);
+}
+
+SADx4Function* get_sad_x4_function(int BlockX, int BlockY, int bits_per_pixel, arch_t arch)
+{
+  std::map<std::tuple<int, int, int, arch_t>, SADx3Function*> func_sad_x3;
+  std::map<std::tuple<int, int, int, arch_t>, SADx4Function*> func_sad_x4;
+  fill_sad_x_functions(func_sad_x3, func_sad_x4);
+  return select_sad_x_function(func_sad_x4, BlockX, BlockY, bits_per_pixel, arch);
+}
+
+//------------------
+// Fused luma + chroma SAD for chroma=true motion search.
+// The three planes of the candidate are scored in a single call, the chroma
+// SAD is scaled here as well. Same results as SAD + 2 x SADCHROMA.
+
+// Accumulates the SAD of a block, any width which is a multiple of 4 bytes
+template<int width_b, int nBlkHeight, typename pixel_t>
+static MV_FORCEINLINE __m128i sad_plane_sse2(__m128i sum, const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch)
+{
+  static_assert(width_b % 4 == 0, "sad_plane_sse2: width must be a multiple of 4 bytes");
+
+  const __m128i zero = _mm_setzero_si128();
+  for (int y = 0; y < nBlkHeight; y++)
+  {
+    int x = 0;
+    for (; x + 16 <= width_b; x += 16)
+      sum = sad_x_accumulate_sse2<pixel_t>(sum, _mm_loadu_si128((const __m128i *) (pSrc + x)), _mm_loadu_si128((const __m128i *) (pRef + x)), zero);
+    if constexpr(width_b % 16 >= 8) {
+      sum = sad_x_accumulate_sse2<pixel_t>(sum, _mm_loadl_epi64((const __m128i *) (pSrc + x)), _mm_loadl_epi64((const __m128i *) (pRef + x)), zero);
+      x += 8;
+    }
+    if constexpr(width_b % 8 == 4) {
+      sum = sad_x_accumulate_sse2<pixel_t>(sum, _mm_cvtsi32_si128(*reinterpret_cast<const int *>(pSrc + x)), _mm_cvtsi32_si128(*reinterpret_cast<const int *>(pRef + x)), zero);
+    }
+    pSrc += nSrcPitch;
+    pRef += nRefPitch;
+  }
+  return sum;
+}
+
+template<typename pixel_t>
+static MV_FORCEINLINE unsigned int sad_hsum_sse2(__m128i sum)
+{
+  __m128i s = _mm_add_epi32(sum, _mm_unpackhi_epi64(sum, sum));
+  if constexpr(sizeof(pixel_t) == 2) {
+    // 4 partial sums, _mm_sad_epu8 only fills 2 of them
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 1, 1, 1)));
+  }
+  return _mm_cvtsi128_si32(s);
+}
+
+template<int nBlkWidth, int nBlkHeight, int nLogxRatioUV, int nLogyRatioUV, typename pixel_t>
+static unsigned int Sad_yuv_sse2(const uint8_t * const *pSrc, const int *nSrcPitch, const uint8_t * const *pRef, const int *nRefPitch, int chroma_scale, unsigned int *sad_uv)
+{
+  constexpr int width_b = nBlkWidth * int(sizeof(pixel_t));
+  constexpr int width_uv_b = (nBlkWidth >> nLogxRatioUV) * int(sizeof(pixel_t));
+  constexpr int height_uv = nBlkHeight >> nLogyRatioUV;
+
+  const __m128i zero = _mm_setzero_si128();
+  const unsigned int sad = sad_hsum_sse2<pixel_t>(sad_plane_sse2<width_b, nBlkHeight, pixel_t>(zero, pSrc[0], nSrcPitch[0], pRef[0], nRefPitch[0]));
+  __m128i sum_uv = sad_plane_sse2<width_uv_b, height_uv, pixel_t>(zero, pSrc[1], nSrcPitch[1], pRef[1], nRefPitch[1]);
+  sum_uv = sad_plane_sse2<width_uv_b, height_uv, pixel_t>(sum_uv, pSrc[2], nSrcPitch[2], pRef[2], nRefPitch[2]);
+  *sad_uv = ScaleSadChroma(sad_t(sad_hsum_sse2<pixel_t>(sum_uv)), chroma_scale);
+  return sad;
+}
+
+template<int nBlkWidth, int nBlkHeight, int nLogxRatioUV, int nLogyRatioUV, typename pixel_t>
+static unsigned int Sad_uv_sse2(const uint8_t * const *pSrc, const int *nSrcPitch, const uint8_t * const *pRef, const int *nRefPitch, int chroma_scale)
+{
+  constexpr int width_uv_b = (nBlkWidth >> nLogxRatioUV) * int(sizeof(pixel_t));
+  constexpr int height_uv = nBlkHeight >> nLogyRatioUV;
+
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sum_uv = sad_plane_sse2<width_uv_b, height_uv, pixel_t>(zero, pSrc[1], nSrcPitch[1], pRef[1], nRefPitch[1]);
+  sum_uv = sad_plane_sse2<width_uv_b, height_uv, pixel_t>(sum_uv, pSrc[2], nSrcPitch[2], pRef[2], nRefPitch[2]);
+  return ScaleSadChroma(sad_t(sad_hsum_sse2<pixel_t>(sum_uv)), chroma_scale);
+}
+
+typedef std::map<std::tuple<int, int, int, int, int, arch_t>, SADYUVFunction*> SadYuvMap;
+typedef std::map<std::tuple<int, int, int, int, int, arch_t>, SADUVFunction*> SadUvMap;
+
+// Registers the 8 and 16 bit versions of a block size for a chroma format.
+// Luma and chroma widths must be multiples of 4 bytes, and the block must
+// be divisible by the subsampling ratios.
+template<int nBlkWidth, int nBlkHeight, int nLogxRatioUV, int nLogyRatioUV, typename pixel_t>
+static void add_sad_yuv_function(SadYuvMap &func_sad_yuv, SadUvMap &func_sad_uv)
+{
+  using std::make_tuple;
+  constexpr int bits = (sizeof(pixel_t) == 1) ? 8 : 16;
+  constexpr int width_b = nBlkWidth * int(sizeof(pixel_t));
+  constexpr int width_uv_b = (nBlkWidth >> nLogxRatioUV) * int(sizeof(pixel_t));
+  constexpr bool supported =
+    width_b % 4 == 0 && width_uv_b > 0 && width_uv_b % 4 == 0 &&
+    ((nBlkWidth >> nLogxRatioUV) << nLogxRatioUV) == nBlkWidth &&
+    ((nBlkHeight >> nLogyRatioUV) << nLogyRatioUV) == nBlkHeight;
+  if constexpr(supported) {
+    func_sad_yuv[make_tuple(nBlkWidth, nBlkHeight, nLogxRatioUV, nLogyRatioUV, bits, USE_SSE2)] =
+      Sad_yuv_sse2<nBlkWidth, nBlkHeight, nLogxRatioUV, nLogyRatioUV, pixel_t>;
+    func_sad_uv[make_tuple(nBlkWidth, nBlkHeight, nLogxRatioUV, nLogyRatioUV, bits, USE_SSE2)] =
+      Sad_uv_sse2<nBlkWidth, nBlkHeight, nLogxRatioUV, nLogyRatioUV, pixel_t>;
+  }
+}
+
+// 4:2:0, 4:2:2 and 4:4:4
+#define MAKE_SAD_YUV_FN(x, y) \
+add_sad_yuv_function<x, y, 1, 1, uint8_t>(func_sad_yuv, func_sad_uv); \
+add_sad_yuv_function<x, y, 1, 0, uint8_t>(func_sad_yuv, func_sad_uv); \
+add_sad_yuv_function<x, y, 0, 0, uint8_t>(func_sad_yuv, func_sad_uv); \
+add_sad_yuv_function<x, y, 1, 1, uint16_t>(func_sad_yuv, func_sad_uv); \
+add_sad_yuv_function<x, y, 1, 0, uint16_t>(func_sad_yuv, func_sad_uv); \
+add_sad_yuv_function<x, y, 0, 0, uint16_t>(func_sad_yuv, func_sad_uv);
+
+// BlkSizeX, BlkSizeY, nLogxRatioUV, nLogyRatioUV, bits, arch_t
+static void fill_sad_yuv_functions(SadYuvMap &func_sad_yuv, SadUvMap &func_sad_uv)
+{
+  // same list as in fill_sad_x_functions, unsupported sizes are skipped
+  MAKE_SAD_YUV_FN(64, 64)
+  MAKE_SAD_YUV_FN(64, 48)
+  MAKE_SAD_YUV_FN(64, 32)
+  MAKE_SAD_YUV_FN(64, 16)
+  MAKE_SAD_YUV_FN(48, 64)
+  MAKE_SAD_YUV_FN(48, 48)
+  MAKE_SAD_YUV_FN(48, 24)
+  MAKE_SAD_YUV_FN(48, 12)
+  MAKE_SAD_YUV_FN(32, 64)
+  MAKE_SAD_YUV_FN(32, 32)
+  MAKE_SAD_YUV_FN(32, 24)
+  MAKE_SAD_YUV_FN(32, 16)
+  MAKE_SAD_YUV_FN(32, 8)
+  MAKE_SAD_YUV_FN(24, 48)
+  MAKE_SAD_YUV_FN(24, 32)
+  MAKE_SAD_YUV_FN(24, 24)
+  MAKE_SAD_YUV_FN(24, 12)
+  MAKE_SAD_YUV_FN(24, 6)
+  MAKE_SAD_YUV_FN(16, 64)
+  MAKE_SAD_YUV_FN(16, 32)
+  MAKE_SAD_YUV_FN(16, 16)
+  MAKE_SAD_YUV_FN(16, 12)
+  MAKE_SAD_YUV_FN(16, 8)
+  MAKE_SAD_YUV_FN(16, 4)
+  MAKE_SAD_YUV_FN(16, 2)
+  MAKE_SAD_YUV_FN(16, 1)
+  MAKE_SAD_YUV_FN(12, 48)
+  MAKE_SAD_YUV_FN(12, 24)
+  MAKE_SAD_YUV_FN(12, 16)
+  MAKE_SAD_YUV_FN(12, 12)
+  MAKE_SAD_YUV_FN(12, 6)
+  MAKE_SAD_YUV_FN(12, 3)
+  MAKE_SAD_YUV_FN(8, 32)
+  MAKE_SAD_YUV_FN(8, 16)
+  MAKE_SAD_YUV_FN(8, 8)
+  MAKE_SAD_YUV_FN(8, 4)
+  MAKE_SAD_YUV_FN(8, 2)
+  MAKE_SAD_YUV_FN(8, 1)
+  MAKE_SAD_YUV_FN(6, 24)
+  MAKE_SAD_YUV_FN(6, 12)
+  MAKE_SAD_YUV_FN(6, 6)
+  MAKE_SAD_YUV_FN(6, 3)
+  MAKE_SAD_YUV_FN(4, 8)
+  MAKE_SAD_YUV_FN(4, 4)
+  MAKE_SAD_YUV_FN(4, 2)
+  MAKE_SAD_YUV_FN(4, 1)
+
+  // AVX2: luma widths multiple of 32 bytes, templates in SADFunctions_avx2
+  fill_sad_yuv_functions_avx2(func_sad_yuv, func_sad_uv);
+}
+
+template<typename F>
+static F* select_sad_yuv_function(std::map<std::tuple<int, int, int, int, int, arch_t>, F*> &func_sad_yuv, int BlockX, int BlockY, int nLogxRatioUV, int nLogyRatioUV, int bits_per_pixel, arch_t arch)
+{
+  using std::make_tuple;
+
+  // 10-16 bits share the same code, no float
+  if (bits_per_pixel > 16)
+    return nullptr;
+  const int bits = (bits_per_pixel == 8) ? 8 : 16;
+
+  F *result = nullptr;
+  arch_t archlist[] = { USE_AVX512, USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
+  for (int index = 0; result == nullptr && index < int(sizeof(archlist) / sizeof(archlist[0])); index++) {
+    arch_t current_arch_try = archlist[index];
+    if (current_arch_try > arch) continue;
+    result = func_sad_yuv[make_tuple(BlockX, BlockY, nLogxRatioUV, nLogyRatioUV, bits, current_arch_try)];
+  }
+  return result;
+}
+
+SADYUVFunction* get_sad_yuv_function(int BlockX, int BlockY, int nLogxRatioUV, int nLogyRatioUV, int bits_per_pixel, arch_t arch)
+{
+  SadYuvMap func_sad_yuv;
+  SadUvMap func_sad_uv;
+  fill_sad_yuv_functions(func_sad_yuv, func_sad_uv);
+  return select_sad_yuv_function(func_sad_yuv, BlockX, BlockY, nLogxRatioUV, nLogyRatioUV, bits_per_pixel, arch);
+}
+
+SADUVFunction* get_sad_uv_function(int BlockX, int BlockY, int nLogxRatioUV, int nLogyRatioUV, int bits_per_pixel, arch_t arch)
+{
+  SadYuvMap func_sad_yuv;
+  SadUvMap func_sad_uv;
+  fill_sad_yuv_functions(func_sad_yuv, func_sad_uv);
+  return select_sad_yuv_function(func_sad_uv, BlockX, BlockY, nLogxRatioUV, nLogyRatioUV, bits_per_pixel, arch);
+}
+
+#undef MAKE_SAD_YUV_FN
@@ -39,6 +39,13 @@
 
 SADFunction* get_sad_function(int BlockX, int BlockY, int bits_per_pixel, arch_t arch);
 SADFunction* get_satd_function(int BlockX, int BlockY, int pixelsize, arch_t arch);
+// Return nullptr if there is no suitable function (float)
+SADx3Function* get_sad_x3_function(int BlockX, int BlockY, int bits_per_pixel, arch_t arch);
+SADx4Function* get_sad_x4_function(int BlockX, int BlockY, int bits_per_pixel, arch_t arch);
+// Fused luma + chroma SAD, nullptr if the block size or format has no such function
+SADYUVFunction* get_sad_yuv_function(int BlockX, int BlockY, int nLogxRatioUV, int nLogyRatioUV, int bits_per_pixel, arch_t arch);
+// Chroma part of the above, for the candidates whose luma SAD is already known
+SADUVFunction* get_sad_uv_function(int BlockX, int BlockY, int nLogxRatioUV, int nLogyRatioUV, int bits_per_pixel, arch_t arch);
 
 #define MK_CFUNC(functionname) extern "C" unsigned int __cdecl functionname (const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch)
 
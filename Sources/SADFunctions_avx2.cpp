@@ -300,6 +300,76 @@ unsigned int Sad16_avx2(const uint8_t *pSrc, int nSrcPitch,const uint8_t *pRef,
   return result;
 }
 
+// Multi-candidate SAD, widths multiple of 32 bytes.
+// The source row is loaded once and reused for every candidate.
+template<int nBlkWidth, int nBlkHeight, typename pixel_t, int nRef>
+static MV_FORCEINLINE void Sad_xN_avx2(const uint8_t *pSrc, int nSrcPitch, const uint8_t * const *pRefArr, int nRefPitch, unsigned int *sads)
+{
+  constexpr int width_b = nBlkWidth * sizeof(pixel_t);
+  static_assert(width_b % 32 == 0, "Sad_xN_avx2: width must be a multiple of 32 bytes");
+
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i sum[nRef];
+  const uint8_t *pRef[nRef];
+  for (int k = 0; k < nRef; k++) {
+    sum[k] = zero;
+    pRef[k] = pRefArr[k];
+  }
+
+  for (int y = 0; y < nBlkHeight; y++)
+  {
+    for (int x = 0; x < width_b; x += 32)
+    {
+      const __m256i src = _mm256_loadu_si256((const __m256i *) (pSrc + x));
+      for (int k = 0; k < nRef; k++)
+      {
+        const __m256i ref = _mm256_loadu_si256((const __m256i *) (pRef[k] + x));
+        if constexpr(sizeof(pixel_t) == 1) {
+          sum[k] = _mm256_add_epi32(sum[k], _mm256_sad_epu8(src, ref));
+        }
+        else {
+          __m256i greater_t = _mm256_subs_epu16(src, ref); // unsigned sub with saturation
+          __m256i smaller_t = _mm256_subs_epu16(ref, src);
+          __m256i absdiff = _mm256_or_si256(greater_t, smaller_t); //abs(s1-s2)  == (satsub(s1,s2) | satsub(s2,s1))
+          sum[k] = _mm256_add_epi32(sum[k], _mm256_unpacklo_epi16(absdiff, zero));
+          sum[k] = _mm256_add_epi32(sum[k], _mm256_unpackhi_epi16(absdiff, zero));
+        }
+      }
+    }
+    pSrc += nSrcPitch;
+    for (int k = 0; k < nRef; k++)
+      pRef[k] += nRefPitch;
+  }
+
+  for (int k = 0; k < nRef; k++)
+  {
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum[k]), _mm256_extractf128_si256(sum[k], 1));
+    s = _mm_add_epi32(s, _mm_unpackhi_epi64(s, s));
+    if constexpr(sizeof(pixel_t) == 2) {
+      // 4 partial sums, _mm256_sad_epu8 only fills 2 of them
+      s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 1, 1, 1)));
+    }
+    sads[k] = _mm_cvtsi128_si32(s);
+  }
+
+  _mm256_zeroupper();
+  /* Use VZEROUPPER to avoid the penalty of switching from AVX to SSE */
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void Sad_x3_avx2(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef0, const uint8_t *pRef1, const uint8_t *pRef2, int nRefPitch, unsigned int *sads)
+{
+  const uint8_t *pRef[3] = { pRef0, pRef1, pRef2 };
+  Sad_xN_avx2<nBlkWidth, nBlkHeight, pixel_t, 3>(pSrc, nSrcPitch, pRef, nRefPitch, sads);
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void Sad_x4_avx2(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef0, const uint8_t *pRef1, const uint8_t *pRef2, const uint8_t *pRef3, int nRefPitch, unsigned int *sads)
+{
+  const uint8_t *pRef[4] = { pRef0, pRef1, pRef2, pRef3 };
+  Sad_xN_avx2<nBlkWidth, nBlkHeight, pixel_t, 4>(pSrc, nSrcPitch, pRef, nRefPitch, sads);
+}
+
 // Instantiate
 // match with SADFunctions.cpp
 #define MAKE_SAD_FN(x, y) template unsigned int Sad16_avx2<x, y, uint16_t>(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch); \
@@ -344,4 +414,200 @@ MAKE_SAD_FN(8, 2)
 //MAKE_SAD_FN(2, 1)
 #undef MAKE_SAD_FN
 
+// match with fill_sad_x_functions in SADFunctions.cpp
+#define MAKE_SAD_X_FN(x, y, pixel_t) \
+template void Sad_x3_avx2<x, y, pixel_t>(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef0, const uint8_t *pRef1, const uint8_t *pRef2, int nRefPitch, unsigned int *sads); \
+template void Sad_x4_avx2<x, y, pixel_t>(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef0, const uint8_t *pRef1, const uint8_t *pRef2, const uint8_t *pRef3, int nRefPitch, unsigned int *sads);
+MAKE_SAD_X_FN(64, 64, uint8_t)
+MAKE_SAD_X_FN(64, 48, uint8_t)
+MAKE_SAD_X_FN(64, 32, uint8_t)
+MAKE_SAD_X_FN(64, 16, uint8_t)
+MAKE_SAD_X_FN(32, 64, uint8_t)
+MAKE_SAD_X_FN(32, 32, uint8_t)
+MAKE_SAD_X_FN(32, 24, uint8_t)
+MAKE_SAD_X_FN(32, 16, uint8_t)
+MAKE_SAD_X_FN(32, 8, uint8_t)
+MAKE_SAD_X_FN(64, 64, uint16_t)
+MAKE_SAD_X_FN(64, 48, uint16_t)
+MAKE_SAD_X_FN(64, 32, uint16_t)
+MAKE_SAD_X_FN(64, 16, uint16_t)
+MAKE_SAD_X_FN(48, 64, uint16_t)
+MAKE_SAD_X_FN(48, 48, uint16_t)
+MAKE_SAD_X_FN(48, 24, uint16_t)
+MAKE_SAD_X_FN(48, 12, uint16_t)
+MAKE_SAD_X_FN(32, 64, uint16_t)
+MAKE_SAD_X_FN(32, 32, uint16_t)
+MAKE_SAD_X_FN(32, 24, uint16_t)
+MAKE_SAD_X_FN(32, 16, uint16_t)
+MAKE_SAD_X_FN(32, 8, uint16_t)
+MAKE_SAD_X_FN(16, 64, uint16_t)
+MAKE_SAD_X_FN(16, 32, uint16_t)
+MAKE_SAD_X_FN(16, 16, uint16_t)
+MAKE_SAD_X_FN(16, 12, uint16_t)
+MAKE_SAD_X_FN(16, 8, uint16_t)
+MAKE_SAD_X_FN(16, 4, uint16_t)
+MAKE_SAD_X_FN(16, 2, uint16_t)
+MAKE_SAD_X_FN(16, 1, uint16_t)
+#undef MAKE_SAD_X_FN
+
+template<typename pixel_t>
+static MV_FORCEINLINE __m128i sad_accumulate_sse2(__m128i sum, __m128i src, __m128i ref)
+{
+  if constexpr(sizeof(pixel_t) == 1) {
+    return _mm_add_epi32(sum, _mm_sad_epu8(src, ref));
+  }
+  else {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i absdiff = _mm_or_si128(_mm_subs_epu16(src, ref), _mm_subs_epu16(ref, src));
+    sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(absdiff, zero));
+    return _mm_add_epi32(sum, _mm_unpackhi_epi16(absdiff, zero));
+  }
+}
+
+// Fused luma + chroma SAD, see get_sad_yuv_function.
+// 32 byte steps, then the remaining 16, 8 and 4 bytes of the row into a separate xmm sum.
+template<int width_b, int nBlkHeight, typename pixel_t>
+static MV_FORCEINLINE void sad_plane_avx2(__m256i &sum, __m128i &sum_tail, const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch)
+{
+  static_assert(width_b % 4 == 0, "sad_plane_avx2: width must be a multiple of 4 bytes");
+
+  const __m256i zero = _mm256_setzero_si256();
+  for (int y = 0; y < nBlkHeight; y++)
+  {
+    int x = 0;
+    for (; x + 32 <= width_b; x += 32)
+    {
+      const __m256i src = _mm256_loadu_si256((const __m256i *) (pSrc + x));
+      const __m256i ref = _mm256_loadu_si256((const __m256i *) (pRef + x));
+      if constexpr(sizeof(pixel_t) == 1) {
+        sum = _mm256_add_epi32(sum, _mm256_sad_epu8(src, ref));
+      }
+      else {
+        __m256i greater_t = _mm256_subs_epu16(src, ref); // unsigned sub with saturation
+        __m256i smaller_t = _mm256_subs_epu16(ref, src);
+        __m256i absdiff = _mm256_or_si256(greater_t, smaller_t); //abs(s1-s2)  == (satsub(s1,s2) | satsub(s2,s1))
+        sum = _mm256_add_epi32(sum, _mm256_unpacklo_epi16(absdiff, zero));
+        sum = _mm256_add_epi32(sum, _mm256_unpackhi_epi16(absdiff, zero));
+      }
+    }
+    if constexpr(width_b % 32 >= 16) {
+      sum_tail = sad_accumulate_sse2<pixel_t>(sum_tail, _mm_loadu_si128((const __m128i *) (pSrc + x)), _mm_loadu_si128((const __m128i *) (pRef + x)));
+      x += 16;
+    }
+    if constexpr(width_b % 16 >= 8) {
+      sum_tail = sad_accumulate_sse2<pixel_t>(sum_tail, _mm_loadl_epi64((const __m128i *) (pSrc + x)), _mm_loadl_epi64((const __m128i *) (pRef + x)));
+      x += 8;
+    }
+    if constexpr(width_b % 8 == 4) {
+      sum_tail = sad_accumulate_sse2<pixel_t>(sum_tail, _mm_cvtsi32_si128(*reinterpret_cast<const int *>(pSrc + x)), _mm_cvtsi32_si128(*reinterpret_cast<const int *>(pRef + x)));
+    }
+    pSrc += nSrcPitch;
+    pRef += nRefPitch;
+  }
+}
+
+template<typename pixel_t>
+static MV_FORCEINLINE unsigned int sad_hsum_avx2(__m256i sum, __m128i sum_tail)
+{
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extractf128_si256(sum, 1));
+  s = _mm_add_epi32(s, sum_tail);
+  s = _mm_add_epi32(s, _mm_unpackhi_epi64(s, s));
+  if constexpr(sizeof(pixel_t) == 2) {
+    // 4 partial sums, _mm256_sad_epu8 only fills 2 of them
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 1, 1, 1)));
+  }
+  return _mm_cvtsi128_si32(s);
+}
+
+template<int nBlkWidth, int nBlkHeight, int nLogxRatioUV, int nLogyRatioUV, typename pixel_t>
+static unsigned int Sad_yuv_avx2(const uint8_t * const *pSrc, const int *nSrcPitch, const uint8_t * const *pRef, const int *nRefPitch, int chroma_scale, unsigned int *sad_uv)
+{
+  constexpr int width_b = nBlkWidth * int(sizeof(pixel_t));
+  constexpr int width_uv_b = (nBlkWidth >> nLogxRatioUV) * int(sizeof(pixel_t));
+  constexpr int height_uv = nBlkHeight >> nLogyRatioUV;
+  static_assert(width_b % 32 == 0, "Sad_yuv_avx2: luma width must be a multiple of 32 bytes");
+
+  __m256i sum = _mm256_setzero_si256();
+  __m128i sum_tail = _mm_setzero_si128();
+  sad_plane_avx2<width_b, nBlkHeight, pixel_t>(sum, sum_tail, pSrc[0], nSrcPitch[0], pRef[0], nRefPitch[0]);
+  const unsigned int sad = sad_hsum_avx2<pixel_t>(sum, sum_tail);
+
+  sum = _mm256_setzero_si256();
+  sad_plane_avx2<width_uv_b, height_uv, pixel_t>(sum, sum_tail, pSrc[1], nSrcPitch[1], pRef[1], nRefPitch[1]);
+  sad_plane_avx2<width_uv_b, height_uv, pixel_t>(sum, sum_tail, pSrc[2], nSrcPitch[2], pRef[2], nRefPitch[2]);
+  *sad_uv = ScaleSadChroma(sad_t(sad_hsum_avx2<pixel_t>(sum, sum_tail)), chroma_scale);
+
+  _mm256_zeroupper();
+  /* Use VZEROUPPER to avoid the penalty of switching from AVX to SSE */
+  return sad;
+}
+
+template<int nBlkWidth, int nBlkHeight, int nLogxRatioUV, int nLogyRatioUV, typename pixel_t>
+static unsigned int Sad_uv_avx2(const uint8_t * const *pSrc, const int *nSrcPitch, const uint8_t * const *pRef, const int *nRefPitch, int chroma_scale)
+{
+  constexpr int width_uv_b = (nBlkWidth >> nLogxRatioUV) * int(sizeof(pixel_t));
+  constexpr int height_uv = nBlkHeight >> nLogyRatioUV;
+
+  __m256i sum = _mm256_setzero_si256();
+  __m128i sum_tail = _mm_setzero_si128();
+  sad_plane_avx2<width_uv_b, height_uv, pixel_t>(sum, sum_tail, pSrc[1], nSrcPitch[1], pRef[1], nRefPitch[1]);
+  sad_plane_avx2<width_uv_b, height_uv, pixel_t>(sum, sum_tail, pSrc[2], nSrcPitch[2], pRef[2], nRefPitch[2]);
+  const unsigned int sad_uv = ScaleSadChroma(sad_t(sad_hsum_avx2<pixel_t>(sum, sum_tail)), chroma_scale);
+
+  _mm256_zeroupper();
+  /* Use VZEROUPPER to avoid the penalty of switching from AVX to SSE */
+  return sad_uv;
+}
+
+// 4:2:0, 4:2:2 and 4:4:4, the block height must be even for 4:2:0
+#define MAKE_SAD_YUV_FN(x, y, bits, pixel_t) \
+func_sad_yuv[make_tuple(x, y, 1, 1, bits, USE_AVX2)] = Sad_yuv_avx2<x, y, 1, 1, pixel_t>; \
+func_sad_yuv[make_tuple(x, y, 1, 0, bits, USE_AVX2)] = Sad_yuv_avx2<x, y, 1, 0, pixel_t>; \
+func_sad_yuv[make_tuple(x, y, 0, 0, bits, USE_AVX2)] = Sad_yuv_avx2<x, y, 0, 0, pixel_t>; \
+func_sad_uv[make_tuple(x, y, 1, 1, bits, USE_AVX2)] = Sad_uv_avx2<x, y, 1, 1, pixel_t>; \
+func_sad_uv[make_tuple(x, y, 1, 0, bits, USE_AVX2)] = Sad_uv_avx2<x, y, 1, 0, pixel_t>; \
+func_sad_uv[make_tuple(x, y, 0, 0, bits, USE_AVX2)] = Sad_uv_avx2<x, y, 0, 0, pixel_t>;
+
+void fill_sad_yuv_functions_avx2(std::map<std::tuple<int, int, int, int, int, arch_t>, SADYUVFunction*> &func_sad_yuv,
+  std::map<std::tuple<int, int, int, int, int, arch_t>, SADUVFunction*> &func_sad_uv)
+{
+  using std::make_tuple;
+
+  // match with get_sad_yuv_function in SADFunctions.cpp
+  MAKE_SAD_YUV_FN(64, 64, 8, uint8_t)
+  MAKE_SAD_YUV_FN(64, 48, 8, uint8_t)
+  MAKE_SAD_YUV_FN(64, 32, 8, uint8_t)
+  MAKE_SAD_YUV_FN(64, 16, 8, uint8_t)
+  MAKE_SAD_YUV_FN(32, 64, 8, uint8_t)
+  MAKE_SAD_YUV_FN(32, 32, 8, uint8_t)
+  MAKE_SAD_YUV_FN(32, 24, 8, uint8_t)
+  MAKE_SAD_YUV_FN(32, 16, 8, uint8_t)
+  MAKE_SAD_YUV_FN(32, 8, 8, uint8_t)
+  MAKE_SAD_YUV_FN(64, 64, 16, uint16_t)
+  MAKE_SAD_YUV_FN(64, 48, 16, uint16_t)
+  MAKE_SAD_YUV_FN(64, 32, 16, uint16_t)
+  MAKE_SAD_YUV_FN(64, 16, 16, uint16_t)
+  MAKE_SAD_YUV_FN(48, 64, 16, uint16_t)
+  MAKE_SAD_YUV_FN(48, 48, 16, uint16_t)
+  MAKE_SAD_YUV_FN(48, 24, 16, uint16_t)
+  MAKE_SAD_YUV_FN(48, 12, 16, uint16_t)
+  MAKE_SAD_YUV_FN(32, 64, 16, uint16_t)
+  MAKE_SAD_YUV_FN(32, 32, 16, uint16_t)
+  MAKE_SAD_YUV_FN(32, 24, 16, uint16_t)
+  MAKE_SAD_YUV_FN(32, 16, 16, uint16_t)
+  MAKE_SAD_YUV_FN(32, 8, 16, uint16_t)
+  MAKE_SAD_YUV_FN(16, 64, 16, uint16_t)
+  MAKE_SAD_YUV_FN(16, 32, 16, uint16_t)
+  MAKE_SAD_YUV_FN(16, 16, 16, uint16_t)
+  MAKE_SAD_YUV_FN(16, 12, 16, uint16_t)
+  MAKE_SAD_YUV_FN(16, 8, 16, uint16_t)
+  MAKE_SAD_YUV_FN(16, 4, 16, uint16_t)
+  MAKE_SAD_YUV_FN(16, 2, 16, uint16_t)
+  // 16x1: no 4:2:0
+  func_sad_yuv[make_tuple(16, 1, 1, 0, 16, USE_AVX2)] = Sad_yuv_avx2<16, 1, 1, 0, uint16_t>;
+  func_sad_yuv[make_tuple(16, 1, 0, 0, 16, USE_AVX2)] = Sad_yuv_avx2<16, 1, 0, 0, uint16_t>;
+  func_sad_uv[make_tuple(16, 1, 1, 0, 16, USE_AVX2)] = Sad_uv_avx2<16, 1, 1, 0, uint16_t>;
+  func_sad_uv[make_tuple(16, 1, 0, 0, 16, USE_AVX2)] = Sad_uv_avx2<16, 1, 0, 0, uint16_t>;
+}
 
+#undef MAKE_SAD_YUV_FN
@@ -32,6 +32,8 @@
 #include <stdint.h>
 #include <immintrin.h>
 #include <cassert>
+#include <map>
+#include <tuple>
 
 template<int nBlkWidth, int nBlkHeight, typename pixel_t>
 unsigned int Sad16_avx2(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch);
@@ -39,4 +41,17 @@ unsigned int Sad16_avx2(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef,
 template<int nBlkWidth, int nBlkHeight>
 unsigned int Sad10_avx2(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch);
 
+// Multi-candidate versions, for widths multiple of 32 bytes
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void Sad_x3_avx2(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef0, const uint8_t *pRef1, const uint8_t *pRef2, int nRefPitch, unsigned int *sads);
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void Sad_x4_avx2(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef0, const uint8_t *pRef1, const uint8_t *pRef2, const uint8_t *pRef3, int nRefPitch, unsigned int *sads);
+
+// Fused luma + chroma SAD for luma widths multiple of 32 bytes.
+// Adds the AVX2 entries to the tables of get_sad_yuv_function and get_sad_uv_function,
+// key: BlkSizeX, BlkSizeY, nLogxRatioUV, nLogyRatioUV, bits (8 or 16), arch_t
+void fill_sad_yuv_functions_avx2(std::map<std::tuple<int, int, int, int, int, arch_t>, SADYUVFunction*> &func_sad_yuv,
+  std::map<std::tuple<int, int, int, int, int, arch_t>, SADUVFunction*> &func_sad_uv);
+
 #endif
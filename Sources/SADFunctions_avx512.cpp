@@ -0,0 +1,357 @@
+#include "SADFunctions_avx512.h"
+#include <immintrin.h>
+#include <stdint.h>
+#include <cassert>
+#include "def.h"
+
+// A zmm register always holds 64 bytes: one row of 64 bytes, two rows of 32
+// bytes or four rows of 16 bytes.
+template<int nBytes>
+static MV_FORCEINLINE __m512i load_rows_avx512(const uint8_t *p, int pitch)
+{
+  if constexpr (nBytes == 16) {
+    __m512i r = _mm512_castsi128_si512(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+    r = _mm512_inserti32x4(r, _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + pitch)), 1);
+    r = _mm512_inserti32x4(r, _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + pitch * 2)), 2);
+    r = _mm512_inserti32x4(r, _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + pitch * 3)), 3);
+    return r;
+  }
+  else if constexpr (nBytes == 32) {
+    __m512i r = _mm512_castsi256_si512(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+    return _mm512_inserti64x4(r, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + pitch)), 1);
+  }
+  else {
+    return _mm512_loadu_si512(p);
+  }
+}
+
+static MV_FORCEINLINE __m128i hsum_epi64_avx512(__m512i x)
+{
+  __m256i s = _mm256_add_epi64(_mm512_castsi512_si256(x), _mm512_extracti64x4_epi64(x, 1));
+  __m128i s2 = _mm_add_epi64(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+  return _mm_add_epi64(s2, _mm_unpackhi_epi64(s2, s2));
+}
+
+static MV_FORCEINLINE unsigned int hsum_epi32_avx512(__m512i x)
+{
+  __m256i s = _mm256_add_epi32(_mm512_castsi512_si256(x), _mm512_extracti64x4_epi64(x, 1));
+  __m128i s2 = _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+  s2 = _mm_add_epi32(s2, _mm_srli_si128(s2, 8));
+  s2 = _mm_add_epi32(s2, _mm_srli_si128(s2, 4));
+  return (unsigned int)_mm_cvtsi128_si32(s2);
+}
+
+// 16 bit words to 32 bit sums: low word + high word of each dword, no overflow
+static MV_FORCEINLINE __m512i add_words_epi32_avx512(__m512i x)
+{
+  return _mm512_add_epi32(_mm512_and_si512(x, _mm512_set1_epi32(0xFFFF)), _mm512_srli_epi32(x, 16));
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+unsigned int Sad_avx512(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch)
+{
+  constexpr int row_bytes = nBlkWidth * sizeof(pixel_t);
+  static_assert(row_bytes == 16 || row_bytes == 32 || row_bytes % 64 == 0, "Sad_avx512: unsupported width");
+  constexpr int load_bytes = (row_bytes < 64) ? row_bytes : 64;
+  constexpr int rows_per_load = (row_bytes < 64) ? 64 / row_bytes : 1;
+  static_assert(nBlkHeight % rows_per_load == 0, "Sad_avx512: unsupported height");
+
+  __m512i sum = _mm512_setzero_si512();
+  for (int y = 0; y < nBlkHeight; y += rows_per_load)
+  {
+    for (int x = 0; x < row_bytes; x += load_bytes)
+    {
+      const __m512i src = load_rows_avx512<load_bytes>(pSrc + x, nSrcPitch);
+      const __m512i ref = load_rows_avx512<load_bytes>(pRef + x, nRefPitch);
+      if constexpr (sizeof(pixel_t) == 1) {
+        sum = _mm512_add_epi64(sum, _mm512_sad_epu8(src, ref));
+      }
+      else {
+        const __m512i diff = _mm512_or_si512(_mm512_subs_epu16(src, ref), _mm512_subs_epu16(ref, src));
+        sum = _mm512_add_epi32(sum, add_words_epi32_avx512(diff));
+      }
+    }
+    pSrc += nSrcPitch * rows_per_load;
+    pRef += nRefPitch * rows_per_load;
+  }
+
+  if constexpr (sizeof(pixel_t) == 1)
+    return (unsigned int)_mm_cvtsi128_si32(hsum_epi64_avx512(sum));
+  else
+    return hsum_epi32_avx512(sum);
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+unsigned int Luma_avx512(const unsigned char *pSrc, int nSrcPitch)
+{
+  constexpr int row_bytes = nBlkWidth * sizeof(pixel_t);
+  static_assert(row_bytes == 16 || row_bytes == 32 || row_bytes % 64 == 0, "Luma_avx512: unsupported width");
+  constexpr int load_bytes = (row_bytes < 64) ? row_bytes : 64;
+  constexpr int rows_per_load = (row_bytes < 64) ? 64 / row_bytes : 1;
+  static_assert(nBlkHeight % rows_per_load == 0, "Luma_avx512: unsupported height");
+
+  const __m512i zero = _mm512_setzero_si512();
+  __m512i sum = _mm512_setzero_si512();
+  for (int y = 0; y < nBlkHeight; y += rows_per_load)
+  {
+    for (int x = 0; x < row_bytes; x += load_bytes)
+    {
+      const __m512i src = load_rows_avx512<load_bytes>(pSrc + x, nSrcPitch);
+      if constexpr (sizeof(pixel_t) == 1)
+        sum = _mm512_add_epi64(sum, _mm512_sad_epu8(src, zero));
+      else
+        sum = _mm512_add_epi32(sum, add_words_epi32_avx512(src));
+    }
+    pSrc += nSrcPitch * rows_per_load;
+  }
+
+  if constexpr (sizeof(pixel_t) == 1)
+    return (unsigned int)_mm_cvtsi128_si32(hsum_epi64_avx512(sum));
+  else
+    return hsum_epi32_avx512(sum);
+}
+
+// SATD: sum of the absolute 4x4 Hadamard transformed differences, halved.
+// Each 4x4 sum is even, so halving the total gives the same result as x264
+// and mvtools_satd_uint16_c which halve per 8x4 block.
+// The vertical transform is done between the 4 row registers, the horizontal
+// one inside each group of 4 lanes. The coefficients come out permuted and
+// with different signs, this does not change the sum of their absolute values.
+
+// 4-point Hadamard inside each group of 4 dwords
+static MV_FORCEINLINE __m512i hadamard4_h_epi32_avx512(__m512i x)
+{
+  __m512i t = _mm512_shuffle_epi32(x, _MM_PERM_CDAB);
+  x = _mm512_mask_sub_epi32(_mm512_add_epi32(x, t), 0xAAAA, t, x);
+  t = _mm512_shuffle_epi32(x, _MM_PERM_BADC);
+  return _mm512_mask_sub_epi32(_mm512_add_epi32(x, t), 0xCCCC, t, x);
+}
+
+// 4-point Hadamard inside each group of 4 words
+static MV_FORCEINLINE __m512i hadamard4_h_epi16_avx512(__m512i x)
+{
+  __m512i t = _mm512_shufflehi_epi16(_mm512_shufflelo_epi16(x, 0xB1), 0xB1);
+  x = _mm512_mask_sub_epi16(_mm512_add_epi16(x, t), 0xAAAAAAAA, t, x);
+  t = _mm512_shufflehi_epi16(_mm512_shufflelo_epi16(x, 0x4E), 0x4E);
+  return _mm512_mask_sub_epi16(_mm512_add_epi16(x, t), 0xCCCCCCCC, t, x);
+}
+
+// 8 bit pixels: differences and coefficients fit in int16 (max 16 * 255)
+static MV_FORCEINLINE __m512i satd4_epi16_avx512(__m512i d0, __m512i d1, __m512i d2, __m512i d3)
+{
+  const __m512i a0 = _mm512_add_epi16(d0, d1);
+  const __m512i a1 = _mm512_sub_epi16(d0, d1);
+  const __m512i a2 = _mm512_add_epi16(d2, d3);
+  const __m512i a3 = _mm512_sub_epi16(d2, d3);
+  const __m512i b0 = hadamard4_h_epi16_avx512(_mm512_add_epi16(a0, a2));
+  const __m512i b1 = hadamard4_h_epi16_avx512(_mm512_add_epi16(a1, a3));
+  const __m512i b2 = hadamard4_h_epi16_avx512(_mm512_sub_epi16(a0, a2));
+  const __m512i b3 = hadamard4_h_epi16_avx512(_mm512_sub_epi16(a1, a3));
+  const __m512i s = _mm512_add_epi16(
+    _mm512_add_epi16(_mm512_abs_epi16(b0), _mm512_abs_epi16(b1)),
+    _mm512_add_epi16(_mm512_abs_epi16(b2), _mm512_abs_epi16(b3)));
+  return _mm512_madd_epi16(s, _mm512_set1_epi16(1));
+}
+
+// 16 bit pixels: int32 lanes
+static MV_FORCEINLINE __m512i satd4_epi32_avx512(__m512i d0, __m512i d1, __m512i d2, __m512i d3)
+{
+  const __m512i a0 = _mm512_add_epi32(d0, d1);
+  const __m512i a1 = _mm512_sub_epi32(d0, d1);
+  const __m512i a2 = _mm512_add_epi32(d2, d3);
+  const __m512i a3 = _mm512_sub_epi32(d2, d3);
+  const __m512i b0 = hadamard4_h_epi32_avx512(_mm512_add_epi32(a0, a2));
+  const __m512i b1 = hadamard4_h_epi32_avx512(_mm512_add_epi32(a1, a3));
+  const __m512i b2 = hadamard4_h_epi32_avx512(_mm512_sub_epi32(a0, a2));
+  const __m512i b3 = hadamard4_h_epi32_avx512(_mm512_sub_epi32(a1, a3));
+  return _mm512_add_epi32(
+    _mm512_add_epi32(_mm512_abs_epi32(b0), _mm512_abs_epi32(b1)),
+    _mm512_add_epi32(_mm512_abs_epi32(b2), _mm512_abs_epi32(b3)));
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+unsigned int Satd_avx512(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch)
+{
+  static_assert(nBlkHeight % 4 == 0, "Satd_avx512: unsupported height");
+
+  __m512i sum = _mm512_setzero_si512();
+  if constexpr (sizeof(pixel_t) == 1 && nBlkWidth == 16) {
+    // two 4-row bands in a register: rows y+r and y+4+r
+    static_assert(nBlkHeight % 8 == 0, "Satd_avx512: unsupported height");
+    for (int y = 0; y < nBlkHeight; y += 8)
+    {
+      __m512i d[4];
+      for (int r = 0; r < 4; r++)
+      {
+        const __m256i src = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + nSrcPitch * r))),
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + nSrcPitch * (r + 4))), 1);
+        const __m256i ref = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pRef + nRefPitch * r))),
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(pRef + nRefPitch * (r + 4))), 1);
+        d[r] = _mm512_sub_epi16(_mm512_cvtepu8_epi16(src), _mm512_cvtepu8_epi16(ref));
+      }
+      sum = _mm512_add_epi32(sum, satd4_epi16_avx512(d[0], d[1], d[2], d[3]));
+      pSrc += nSrcPitch * 8;
+      pRef += nRefPitch * 8;
+    }
+  }
+  else {
+    // 32 pixels (8 bit) or 16 pixels (16 bit) of a row in a register
+    constexpr int pix_per_reg = (sizeof(pixel_t) == 1) ? 32 : 16;
+    static_assert(nBlkWidth % pix_per_reg == 0, "Satd_avx512: unsupported width");
+    for (int y = 0; y < nBlkHeight; y += 4)
+    {
+      for (int x = 0; x < nBlkWidth * (int)sizeof(pixel_t); x += 32)
+      {
+        __m512i d[4];
+        for (int r = 0; r < 4; r++)
+        {
+          const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pSrc + nSrcPitch * r + x));
+          const __m256i ref = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pRef + nRefPitch * r + x));
+          if constexpr (sizeof(pixel_t) == 1)
+            d[r] = _mm512_sub_epi16(_mm512_cvtepu8_epi16(src), _mm512_cvtepu8_epi16(ref));
+          else
+            d[r] = _mm512_sub_epi32(_mm512_cvtepu16_epi32(src), _mm512_cvtepu16_epi32(ref));
+        }
+        if constexpr (sizeof(pixel_t) == 1)
+          sum = _mm512_add_epi32(sum, satd4_epi16_avx512(d[0], d[1], d[2], d[3]));
+        else
+          sum = _mm512_add_epi32(sum, satd4_epi32_avx512(d[0], d[1], d[2], d[3]));
+      }
+      pSrc += nSrcPitch * 4;
+      pRef += nRefPitch * 4;
+    }
+  }
+
+  // 16 bit 64x64 totals may exceed 32 bits before halving
+  const __m512i sum64 = _mm512_add_epi64(
+    _mm512_cvtepu32_epi64(_mm512_castsi512_si256(sum)),
+    _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(sum, 1)));
+  return (unsigned int)_mm_cvtsi128_si32(_mm_srli_epi64(hsum_epi64_avx512(sum64), 1));
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void Copy_avx512(uint8_t *pDst, int nDstPitch, const uint8_t *pSrc, int nSrcPitch)
+{
+  constexpr int row_bytes = nBlkWidth * sizeof(pixel_t);
+  static_assert(row_bytes % 16 == 0, "Copy_avx512: unsupported width");
+  constexpr int end64 = row_bytes & ~63;
+
+  for (int y = 0; y < nBlkHeight; y++)
+  {
+    for (int x = 0; x < end64; x += 64)
+      _mm512_storeu_si512(pDst + x, _mm512_loadu_si512(pSrc + x));
+    if constexpr ((row_bytes & 32) != 0)
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(pDst + end64), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pSrc + end64)));
+    if constexpr ((row_bytes & 16) != 0)
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + (row_bytes & ~31)), _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + (row_bytes & ~31))));
+    pDst += nDstPitch;
+    pSrc += nSrcPitch;
+  }
+}
+
+// match with get_sad_function in SADFunctions.cpp and get_luma_function in Variance.cpp
+#define MAKE_SAD_FN(x, y, pixel_t) \
+template unsigned int Sad_avx512<x, y, pixel_t>(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch); \
+template unsigned int Luma_avx512<x, y, pixel_t>(const unsigned char *pSrc, int nSrcPitch);
+MAKE_SAD_FN(64, 64, uint8_t)
+MAKE_SAD_FN(64, 48, uint8_t)
+MAKE_SAD_FN(64, 32, uint8_t)
+MAKE_SAD_FN(64, 16, uint8_t)
+MAKE_SAD_FN(32, 64, uint8_t)
+MAKE_SAD_FN(32, 32, uint8_t)
+MAKE_SAD_FN(32, 24, uint8_t)
+MAKE_SAD_FN(32, 16, uint8_t)
+MAKE_SAD_FN(32, 8, uint8_t)
+MAKE_SAD_FN(16, 64, uint8_t)
+MAKE_SAD_FN(16, 32, uint8_t)
+MAKE_SAD_FN(16, 16, uint8_t)
+MAKE_SAD_FN(16, 12, uint8_t)
+MAKE_SAD_FN(16, 8, uint8_t)
+MAKE_SAD_FN(16, 4, uint8_t)
+// 48 (8 bit) and 48 (16 bit) are not mod 64 bytes, AVX2 is used
+MAKE_SAD_FN(64, 64, uint16_t)
+MAKE_SAD_FN(64, 48, uint16_t)
+MAKE_SAD_FN(64, 32, uint16_t)
+MAKE_SAD_FN(64, 16, uint16_t)
+MAKE_SAD_FN(32, 64, uint16_t)
+MAKE_SAD_FN(32, 32, uint16_t)
+MAKE_SAD_FN(32, 24, uint16_t)
+MAKE_SAD_FN(32, 16, uint16_t)
+MAKE_SAD_FN(32, 8, uint16_t)
+MAKE_SAD_FN(16, 64, uint16_t)
+MAKE_SAD_FN(16, 32, uint16_t)
+MAKE_SAD_FN(16, 16, uint16_t)
+MAKE_SAD_FN(16, 12, uint16_t)
+MAKE_SAD_FN(16, 8, uint16_t)
+MAKE_SAD_FN(16, 4, uint16_t)
+MAKE_SAD_FN(16, 2, uint16_t)
+#undef MAKE_SAD_FN
+
+// match with get_satd_function in SADFunctions.cpp
+#define MAKE_SATD_FN(x, y, pixel_t) \
+template unsigned int Satd_avx512<x, y, pixel_t>(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch);
+MAKE_SATD_FN(64, 64, uint8_t)
+MAKE_SATD_FN(64, 48, uint8_t)
+MAKE_SATD_FN(64, 32, uint8_t)
+MAKE_SATD_FN(64, 16, uint8_t)
+MAKE_SATD_FN(32, 64, uint8_t)
+MAKE_SATD_FN(32, 32, uint8_t)
+MAKE_SATD_FN(32, 24, uint8_t)
+MAKE_SATD_FN(32, 16, uint8_t)
+MAKE_SATD_FN(32, 8, uint8_t)
+MAKE_SATD_FN(32, 4, uint8_t)
+MAKE_SATD_FN(16, 64, uint8_t)
+MAKE_SATD_FN(16, 32, uint8_t)
+MAKE_SATD_FN(16, 16, uint8_t)
+MAKE_SATD_FN(16, 8, uint8_t)
+MAKE_SATD_FN(64, 64, uint16_t)
+MAKE_SATD_FN(64, 48, uint16_t)
+MAKE_SATD_FN(64, 32, uint16_t)
+MAKE_SATD_FN(64, 16, uint16_t)
+MAKE_SATD_FN(48, 64, uint16_t)
+MAKE_SATD_FN(48, 48, uint16_t)
+MAKE_SATD_FN(48, 24, uint16_t)
+MAKE_SATD_FN(48, 12, uint16_t)
+MAKE_SATD_FN(32, 64, uint16_t)
+MAKE_SATD_FN(32, 32, uint16_t)
+MAKE_SATD_FN(32, 24, uint16_t)
+MAKE_SATD_FN(32, 16, uint16_t)
+MAKE_SATD_FN(32, 8, uint16_t)
+MAKE_SATD_FN(32, 4, uint16_t)
+MAKE_SATD_FN(16, 64, uint16_t)
+MAKE_SATD_FN(16, 32, uint16_t)
+MAKE_SATD_FN(16, 16, uint16_t)
+MAKE_SATD_FN(16, 12, uint16_t)
+MAKE_SATD_FN(16, 8, uint16_t)
+MAKE_SATD_FN(16, 4, uint16_t)
+#undef MAKE_SATD_FN
+
+// match with get_copy_function in CopyCode.cpp
+#define MAKE_COPY_FN(x, y) \
+template void Copy_avx512<x, y, uint8_t>(uint8_t *pDst, int nDstPitch, const uint8_t *pSrc, int nSrcPitch); \
+template void Copy_avx512<x, y, uint16_t>(uint8_t *pDst, int nDstPitch, const uint8_t *pSrc, int nSrcPitch);
+MAKE_COPY_FN(64, 64)
+MAKE_COPY_FN(64, 48)
+MAKE_COPY_FN(64, 32)
+MAKE_COPY_FN(64, 16)
+MAKE_COPY_FN(48, 64)
+MAKE_COPY_FN(48, 48)
+MAKE_COPY_FN(48, 24)
+MAKE_COPY_FN(48, 12)
+MAKE_COPY_FN(32, 64)
+MAKE_COPY_FN(32, 32)
+MAKE_COPY_FN(32, 24)
+MAKE_COPY_FN(32, 16)
+MAKE_COPY_FN(32, 8)
+MAKE_COPY_FN(32, 4)
+MAKE_COPY_FN(16, 64)
+MAKE_COPY_FN(16, 32)
+MAKE_COPY_FN(16, 16)
+MAKE_COPY_FN(16, 12)
+MAKE_COPY_FN(16, 8)
+MAKE_COPY_FN(16, 4)
+MAKE_COPY_FN(16, 2)
+MAKE_COPY_FN(16, 1)
+#undef MAKE_COPY_FN
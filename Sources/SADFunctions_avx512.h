@@ -0,0 +1,51 @@
+// Functions that computes distances between blocks, AVX-512BW versions
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+/*! \file SADFunctions_avx512.h
+ *  \brief SAD, SATD, luma sum and block copy with AVX-512F/BW intrinsics.
+ *
+ *	Block widths from 16 to 64 pixels, 8 and 16 bit pixels. A zmm register
+ *	processes 64 bytes: one row of 64 bytes, two rows of 32 bytes or four rows
+ *	of 16 bytes, depending on the block width.
+ *	The results are identical to the C and x264 versions.
+ */
+
+#ifndef __SAD_FUNC_AVX512__
+#define __SAD_FUNC_AVX512__
+
+#include "types.h"
+#include <stdint.h>
+
+// Row size in bytes: 16, 32 or multiple of 64. Height: multiple of 64 / row size
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+unsigned int Sad_avx512(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch);
+
+// Width: multiple of 32 (8 bit) or 16 (16 bit). 8 bit 16xN needs a height multiple of 8
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+unsigned int Satd_avx512(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch);
+
+// Same constraints as Sad_avx512
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+unsigned int Luma_avx512(const unsigned char *pSrc, int nSrcPitch);
+
+// Row size in bytes: multiple of 16
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void Copy_avx512(uint8_t *pDst, int nDstPitch, const uint8_t *pSrc, int nSrcPitch);
+
+#endif
@@ -32,7 +32,8 @@ enum SearchType
 	HEX2SEARCH  = 16,   // v.2
 	UMHSEARCH   = 32,   // v.2
 	HSEARCH     = 64,   // v.2.5.11
-	VSEARCH     = 128   // v.2.5.11
+	VSEARCH     = 128,  // v.2.5.11
+	SEASEARCH   = 256   // v.2.7.44 exhaustive with successive elimination
 };
 
 
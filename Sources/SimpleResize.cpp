@@ -87,12 +87,9 @@ SimpleResize::SimpleResize(int _newwidth, int _newheight, int _oldwidth, int _ol
 
   // 2 qwords, 2 offsets, and prefetch slack
   hControl = (unsigned int*)_aligned_malloc(newwidth * 12 + 128, 128);   // aligned for P4 cache line
-  vWorkY = (unsigned char*)_aligned_malloc(2 * oldwidth + 128, 128); // for unsigned char type resize
   vOffsets = (unsigned int*)_aligned_malloc(newheight * 4, 128);
   vWeights = (unsigned int*)_aligned_malloc(newheight * 4, 128);
 
-  vWorkY2 = (short*)_aligned_malloc(2 * oldwidth + 128, 128); // for short type resize
-
   //		if (!hControl || !vWeights)
   {
     //			env->ThrowError("SimpleResize: memory allocation error");
@@ -104,12 +101,16 @@ SimpleResize::SimpleResize(int _newwidth, int _newheight, int _oldwidth, int _ol
 SimpleResize::~SimpleResize()
 {
   _aligned_free(hControl);
-  _aligned_free(vWorkY);
-  _aligned_free(vWorkY2);
   _aligned_free(vOffsets);
   _aligned_free(vWeights);
 }
 
+// Work line for the vertical pass, 2 * oldwidth + 128 bytes (uchar or short type),
+// 64 byte aligned for the streaming stores. On the stack instead of a class member
+// so that row ranges of the same resizer can run in parallel.
+#define SIMPLERESIZE_WORK_LINE(oldwidth) \
+  reinterpret_cast<void *>((reinterpret_cast<uintptr_t>(_alloca(2 * (oldwidth) + 128 + 64)) + 63) & ~uintptr_t(63))
+
 template<int cpuflags>
 static MV_FORCEINLINE __m128i simd_blend_epi8(__m128i const &selector, __m128i const &a, __m128i const &b) {
   if (cpuflags >= CPUF_SSE4_1) {
@@ -128,9 +129,10 @@ static MV_FORCEINLINE __m128i simd_blend_epi8(__m128i const &selector, __m128i c
 // for non 16->16 bit: limitIt = false, nPelLog1 and isXpart are n/a (e.g. 0, true)
 template<typename src_type, typename dst_type, bool limitIt, int nPel, bool isXpart>
 void SimpleResize::SimpleResizeDo_New(uint8_t *dstp8, int row_size, int height, int dst_pitch,
-  const uint8_t* srcp8, int src_row_size, int src_pitch, int bits_per_pixel, int real_width, int real_height)
+  const uint8_t* srcp8, int src_row_size, int src_pitch, int bits_per_pixel, int real_width, int real_height,
+  int y_beg, int y_end, void *work)
 {
-  dst_type *dstp = reinterpret_cast<dst_type *>(dstp8);
+  dst_type *dstp = reinterpret_cast<dst_type *>(dstp8) + y_beg * dst_pitch;
   const src_type *srcp = reinterpret_cast<const src_type *>(srcp8);
   // Note: PlanarType is dummy, I (Fizick) do not use croma planes code for resize in MVTools
   /*
@@ -149,7 +151,7 @@ void SimpleResize::SimpleResizeDo_New(uint8_t *dstp8, int row_size, int height,
 
   const src_type * srcp1;
   const src_type * srcp2;
-  workY_type * vWorkYW = sizeof(workY_type) == 1 ? (workY_type *)vWorkY : (workY_type *)vWorkY2;
+  workY_type * vWorkYW = reinterpret_cast<workY_type *>(work);
 
   unsigned int* vOffsetsW = vOffsets;
   unsigned int* vWeightsW = vWeights;
@@ -193,13 +195,14 @@ void SimpleResize::SimpleResizeDo_New(uint8_t *dstp8, int row_size, int height,
 
   if constexpr (limitIt && !isXpart)
   {
-    maxRelY_c = (real_height << nPelLog2) - 1;
-    minRelY_c = 0;
+    // limits are decremented by nPel on each row, start at the first row of the range
+    maxRelY_c = (real_height << nPelLog2) - 1 - y_beg * relInc_c;
+    minRelY_c = -y_beg * relInc_c;
     maxRelY = _mm_set1_epi16(maxRelY_c);
-    minRelY = _mm_set1_epi16(0);
+    minRelY = _mm_set1_epi16(minRelY_c);
   }
 
-  for (int y = 0; y < height; y++)
+  for (int y = y_beg; y < y_end; y++)
   {
 
     __m128i minRelX, maxRelX;
@@ -498,20 +501,24 @@ void SimpleResize::SimpleResizeDo_New(uint8_t *dstp8, int row_size, int height,
 }
 
 void SimpleResize::SimpleResizeDo_uint8_to_uint16(uint8_t *dstp, int row_size, int height, int dst_pitch,
-  const uint8_t* srcp, int src_row_size, int src_pitch, int bits_per_pixel) {
+  const uint8_t* srcp, int src_row_size, int src_pitch, int bits_per_pixel, int y_beg, int y_end) {
+  if (y_end < 0)
+    y_end = height;
   dst_pitch /= sizeof(uint16_t);  // pitch from byte granularity to uint16 for SimpleResizeDo
   SimpleResizeDo_New<uint8_t, uint16_t, false, 0, true>(dstp, row_size, height, dst_pitch, srcp, src_row_size, src_pitch, bits_per_pixel,
-    row_size, height); // n/a: no limiting in 8->16;
+    row_size, height, y_beg, y_end, SIMPLERESIZE_WORK_LINE(oldwidth)); // n/a: no limiting in 8->16;
   return;
 }
 
 void SimpleResize::SimpleResizeDo_uint8(uint8_t *dstp, int row_size, int height, int dst_pitch,
-  const uint8_t* srcp, int src_row_size, int src_pitch)
+  const uint8_t* srcp, int src_row_size, int src_pitch, int y_beg, int y_end)
 {
+  if (y_end < 0)
+    y_end = height;
 
   if (SSE2enabled) {
     SimpleResizeDo_New<uint8_t, uint8_t, false, 0, true>(dstp, row_size, height, dst_pitch, srcp, src_row_size, src_pitch, 8, 
-      row_size, height); // n/a: no limiting in 8->8;
+      row_size, height, y_beg, y_end, SIMPLERESIZE_WORK_LINE(oldwidth)); // n/a: no limiting in 8->8;
     return;
   }
   // C-only
@@ -523,14 +530,15 @@ void SimpleResize::SimpleResizeDo_uint8(uint8_t *dstp, int row_size, int height,
 
   const src_type * srcp1;
   const src_type * srcp2;
-  workY_type * vWorkYW = sizeof(workY_type) == 1 ? (workY_type *)vWorkY : (workY_type *)vWorkY2;
+  workY_type * vWorkYW = reinterpret_cast<workY_type *>(SIMPLERESIZE_WORK_LINE(oldwidth));
 
   unsigned int* vOffsetsW = vOffsets;
   unsigned int* vWeightsW = vWeights;
 
   unsigned int last_vOffsetsW = vOffsetsW[height - 1];
 
-  for (int y = 0; y < height; y++)
+  dstp += y_beg * dst_pitch;
+  for (int y = y_beg; y < y_end; y++)
   {
     int CurrentWeight = vWeightsW[y];
     int invCurrentWeight = 256 - CurrentWeight;
@@ -570,14 +578,15 @@ void SimpleResize::SimpleResizeDo_uint8(uint8_t *dstp, int row_size, int height,
 
 }
 
-static void MakeVectorsSafe_c(short *dstp, int row_size, int height, int dst_pitch, int nPel, bool isXpart)
+static void MakeVectorsSafe_c(short *dstp, int row_size, int height, int dst_pitch, int nPel, bool isXpart, int y_beg, int y_end)
 {
   const int nPelLog2 = nPel == 1 ? 0 : nPel == 2 ? 1 : nPel == 4 ? 2 : 0; // convert to needed shift count
+  y_end = std::min(y_end, height);
   if (isXpart) {
     // dealing with the horizontal part of motion vectors
-    short *VXFull = dstp;
+    short *VXFull = dstp + y_beg * dst_pitch;
     const int width = row_size;
-    for (int h = 0; h < height; h++)
+    for (int h = y_beg; h < y_end; h++)
     {
       // todo: what about the vectors in a future 8K era?! with nPel=4 (<<2) they may not be safe anymore
       short maxRelX = ((width - 0) << nPelLog2) - 1;
@@ -603,14 +612,14 @@ static void MakeVectorsSafe_c(short *dstp, int row_size, int height, int dst_pit
   }
   else {
     // dealing with the vertical part of motion vectors
-    short *VYFull = dstp;
+    short *VYFull = dstp + y_beg * dst_pitch;
     const int width = row_size;
 
-    short maxRelY = ((height - 0) << nPelLog2) - 1;
-    short minRelY = 0;
+    short maxRelY = ((height - y_beg) << nPelLog2) - 1;
+    short minRelY = -(y_beg << nPelLog2);
     short diff = 1 << nPelLog2;
 
-    for (int h = 0; h < height; h++)
+    for (int h = y_beg; h < y_end; h++)
     {
       //short maxRelY = ((height - h) << nPelLog2) - 1;
       //short minRelY = -(h << nPelLog2);
@@ -647,34 +656,38 @@ static void MakeVectorsSafe_c(short *dstp, int row_size, int height, int dst_pit
 // Though the vectors are enlarged to frame size, they may point to an enlarged (frame size << nPel) reference frame, the limits should
 // take nPel into account.
 void SimpleResize::SimpleResizeDo_int16(short *dstp, int row_size, int height, int dst_pitch,
-  const short* srcp, int src_row_size, int src_pitch, int nPel, bool isXpart, int real_width, int real_height)
+  const short* srcp, int src_row_size, int src_pitch, int nPel, bool isXpart, int real_width, int real_height,
+  int y_beg, int y_end)
 {
   const bool limitVectors = true;
+  if (y_end < 0)
+    y_end = height;
+  void *work = SIMPLERESIZE_WORK_LINE(oldwidth);
 
   if (SSE2enabled) {
     if (limitVectors)
     {
       if (isXpart) {
         if (nPel == 1)
-          SimpleResizeDo_New<short, short, true, 1, true>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height);
+          SimpleResizeDo_New<short, short, true, 1, true>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height, y_beg, y_end, work);
         else if (nPel == 2)
-          SimpleResizeDo_New<short, short, true, 2, true>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height);
+          SimpleResizeDo_New<short, short, true, 2, true>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height, y_beg, y_end, work);
         else if (nPel == 4)
-          SimpleResizeDo_New<short, short, true, 4, true>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height);
+          SimpleResizeDo_New<short, short, true, 4, true>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height, y_beg, y_end, work);
       }
       else {
         if (nPel == 1)
-          SimpleResizeDo_New<short, short, true, 1, false>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height);
+          SimpleResizeDo_New<short, short, true, 1, false>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height, y_beg, y_end, work);
         else if (nPel == 2)
-          SimpleResizeDo_New<short, short, true, 2, false>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height);
+          SimpleResizeDo_New<short, short, true, 2, false>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height, y_beg, y_end, work);
         else if (nPel == 4)
-          SimpleResizeDo_New<short, short, true, 4, false>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height);
+          SimpleResizeDo_New<short, short, true, 4, false>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height, y_beg, y_end, work);
       }
     }
     else
     {
       // we really do not have yet int16->int16 resize which needs no limiting, but for the sake of completeness
-      SimpleResizeDo_New<short, short, false, 0, true>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height);
+      SimpleResizeDo_New<short, short, false, 0, true>((uint8_t *)dstp, row_size, height, dst_pitch, (uint8_t *)srcp, src_row_size, src_pitch, 16, real_width, real_height, y_beg, y_end, work);
     }
     
     // it's done in SimpleResizeDo_New sse2 version
@@ -688,7 +701,7 @@ void SimpleResize::SimpleResizeDo_int16(short *dstp, int row_size, int height, i
 
   const  short* srcp1;
   const  short* srcp2;
-  short* vWorkYW = vWorkY2;
+  short* vWorkYW = reinterpret_cast<short *>(work);
 
   unsigned int* vOffsetsW = vOffsets;
 
@@ -696,7 +709,9 @@ void SimpleResize::SimpleResizeDo_int16(short *dstp, int row_size, int height, i
 
   unsigned int last_vOffsetsW = vOffsetsW[height - 1];
 
-  for (int y = 0; y < height; y++)
+  short *dstp0 = dstp;
+  dstp += y_beg * dst_pitch;
+  for (int y = y_beg; y < y_end; y++)
   {
     int CurrentWeight = vWeightsW[y];
     int invCurrentWeight = 256 - CurrentWeight;
@@ -732,7 +747,7 @@ void SimpleResize::SimpleResizeDo_int16(short *dstp, int row_size, int height, i
   }
 
   // for reference. We don't try to integrate it to the C code above
-  if (limitVectors) MakeVectorsSafe_c(dstp, real_width, real_height, dst_pitch, nPel, isXpart); // use real_width, real_height instead of row_size, height
+  if (limitVectors) MakeVectorsSafe_c(dstp0, real_width, real_height, dst_pitch, nPel, isXpart, y_beg, y_end); // use real_width, real_height instead of row_size, height
 
 }
 
@@ -34,8 +34,6 @@ class SimpleResize
 								// 1 qword for mask, 1 dword for src offset, 1 unused dword
 	unsigned int* vOffsets;		// Vertical offsets of the source lines we will use
 	unsigned int* vWeights;		// weighting masks, alternating dwords for Y & UV
-  unsigned char* vWorkY;		// weighting masks 0Y0Y 0Y0Y...
-  short* vWorkY2;		//  work array for shorts
   bool SSE2enabled;
 
   void InitTables(void);
@@ -46,16 +44,22 @@ public:
 
   template<typename src_type, typename dst_type, bool limitIt, int nPel, bool isXpart>
   void SimpleResizeDo_New(uint8_t *dstp8, int row_size, int height, int dst_pitch,
-    const uint8_t* srcp8, int src_row_size, int src_pitch, int bits_per_pixel, int real_width, int real_height);
+    const uint8_t* srcp8, int src_row_size, int src_pitch, int bits_per_pixel, int real_width, int real_height,
+    int y_beg, int y_end, void *work);
 
+  // y_beg, y_end: range of destination rows to compute (y_end = -1: up to dst_height).
+  // dstp always points to the first row of the whole destination.
+  // The work line lives on the stack, so different row ranges of the same
+  // resizer can be processed in parallel.
   void SimpleResizeDo_uint8_to_uint16(uint8_t *dstp, int dst_row_size, int dst_height, int dst_pitch,
-    const uint8_t* srcp, int src_row_size, int src_pitch, int bits_per_pixel);
+    const uint8_t* srcp, int src_row_size, int src_pitch, int bits_per_pixel, int y_beg = 0, int y_end = -1);
 
   void SimpleResizeDo_uint8(uint8_t *dstp,  int dst_row_size, int dst_height, int dst_pitch, 
-    const uint8_t* srcp, int src_row_size, int src_pitch); 
+    const uint8_t* srcp, int src_row_size, int src_pitch, int y_beg = 0, int y_end = -1);
 
   void SimpleResizeDo_int16(short *dstp, int dst_row_size, int dst_height, int dst_pitch,
-    const short* srcp, int src_row_size, int src_pitch, int nPel, bool isXpart, int real_width, int real_height);
+    const short* srcp, int src_row_size, int src_pitch, int nPel, bool isXpart, int real_width, int real_height,
+    int y_beg = 0, int y_end = -1);
 
 };
 
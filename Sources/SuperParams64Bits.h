@@ -25,6 +25,13 @@
 class SuperParams64Bits
 {
 public:
+  // param bits
+  enum
+  {
+    PARAM_SHARP_MASK = 0x03,  // Sub-pixel interpolation (MSuper sharp)
+    PARAM_LAZY_FLAG  = 0x04   // Sub-pixel planes not rendered, see MVPlane::set_lazy_refine()
+  };
+
   uint16_t nHeight;
   unsigned char nHPad;
   unsigned char nVPad;
@@ -0,0 +1,191 @@
+/*****************************************************************************
+
+        TemporalPredCache.cpp
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"TemporalPredCache.h"
+
+#include	<cassert>
+#include	<cstring>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+TemporalPredCache::TemporalPredCache (int nbr_pairs, int arr_size)
+:	_nbr_pairs (nbr_pairs)
+,	_arr_size (arr_size)
+,	_entry_arr (nbr_pairs * NBR_FRAMES)
+,	_date_cnt (0)
+,	_mutex ()
+{
+	assert (nbr_pairs > 0);
+	assert (arr_size > 0);
+
+	for (auto &entry : _entry_arr)
+	{
+		entry._nsrc = -1;
+		entry._date = 0;
+	}
+}
+
+
+
+// Returns the cache shared by all the filter instances working on the same
+// clip with the same parameters (sig), or creates it.
+TemporalPredCache::SPtr	TemporalPredCache::use_shared (const void *clip_ptr, const std::string &sig, int nbr_pairs, int arr_size)
+{
+	assert (clip_ptr != 0);
+
+	std::lock_guard <std::mutex>	lock (_reg_mutex);
+
+	// Removes the caches not used any more
+	for (auto it = _registry.begin (); it != _registry.end (); )
+	{
+		if (it->second.expired ())
+		{
+			it = _registry.erase (it);
+		}
+		else
+		{
+			++ it;
+		}
+	}
+
+	const Key		key (clip_ptr, sig);
+	SPtr				cache_sptr;
+	auto				it = _registry.find (key);
+	if (it != _registry.end ())
+	{
+		cache_sptr = it->second.lock ();
+	}
+	if (! cache_sptr)
+	{
+		cache_sptr = SPtr (new TemporalPredCache (nbr_pairs, arr_size));
+		_registry [key] = cache_sptr;
+	}
+	assert (cache_sptr->_nbr_pairs == nbr_pairs);
+	assert (cache_sptr->_arr_size == arr_size);
+
+	return cache_sptr;
+}
+
+
+
+// Stores the final vectors of a source frame. The oldest stored field of
+// the pair is replaced.
+void	TemporalPredCache::store (int nsrc, int pair_index, const int *vect_ptr)
+{
+	assert (nsrc >= 0);
+	assert (pair_index >= 0);
+	assert (pair_index < _nbr_pairs);
+	assert (vect_ptr != 0);
+
+	std::lock_guard <std::mutex>	lock (_mutex);
+
+	Entry *			entry_ptr = find (nsrc, pair_index);
+	if (entry_ptr == 0)
+	{
+		Entry *			pair_ptr = &_entry_arr [pair_index * NBR_FRAMES];
+		entry_ptr = pair_ptr;
+		for (int pos = 1; pos < NBR_FRAMES; ++pos)
+		{
+			if (pair_ptr [pos]._date < entry_ptr->_date)
+			{
+				entry_ptr = pair_ptr + pos;
+			}
+		}
+	}
+
+	entry_ptr->_vect_arr.resize (_arr_size);
+	memcpy (&entry_ptr->_vect_arr [0], vect_ptr, _arr_size * sizeof (vect_ptr [0]));
+	entry_ptr->_nsrc = nsrc;
+	++ _date_cnt;
+	entry_ptr->_date = _date_cnt;
+}
+
+
+
+// Copies the predictor of the frame nsrc: the vectors of the closest frame
+// within RADIUS, the previous frame first.
+// Returns false if no neighbour has been analysed yet.
+bool	TemporalPredCache::fetch (int nsrc, int pair_index, int *vect_ptr)
+{
+	assert (nsrc >= 0);
+	assert (pair_index >= 0);
+	assert (pair_index < _nbr_pairs);
+	assert (vect_ptr != 0);
+
+	std::lock_guard <std::mutex>	lock (_mutex);
+
+	for (int dist = 1; dist <= RADIUS; ++dist)
+	{
+		for (int n = nsrc - dist; n <= nsrc + dist; n += dist * 2)
+		{
+			const Entry *	entry_ptr = (n >= 0) ? find (n, pair_index) : 0;
+			if (entry_ptr != 0)
+			{
+				memcpy (vect_ptr, &entry_ptr->_vect_arr [0], _arr_size * sizeof (vect_ptr [0]));
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// Caller must lock _mutex
+TemporalPredCache::Entry *	TemporalPredCache::find (int nsrc, int pair_index)
+{
+	Entry *			pair_ptr = &_entry_arr [pair_index * NBR_FRAMES];
+	for (int pos = 0; pos < NBR_FRAMES; ++pos)
+	{
+		if (pair_ptr [pos]._nsrc == nsrc)
+		{
+			return pair_ptr + pos;
+		}
+	}
+
+	return 0;
+}
+
+
+
+std::mutex	TemporalPredCache::_reg_mutex;
+TemporalPredCache::Registry	TemporalPredCache::_registry;
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,133 @@
+/*****************************************************************************
+
+        TemporalPredCache.h
+
+Recent final vector fields of MAnalyse, used as temporal predictors
+(temporal=true). The fields are keyed by source frame and Src/Ref pair, so
+the predictor of a frame can be taken from any neighbour frame already
+analysed, whatever the order of the requests.
+
+The cache is thread-safe. The MAnalyse instances created by Avisynth+ for
+the same call in MT_MULTI_INSTANCE mode share the same cache, identified by
+the super clip and a signature of the analysis parameters.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (TemporalPredCache_HEADER_INCLUDED)
+#define	TemporalPredCache_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	<map>
+#include	<memory>
+#include	<mutex>
+#include	<string>
+#include	<utility>
+#include	<vector>
+
+#include	<stdint.h>
+
+
+
+class TemporalPredCache
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	enum {			NBR_FRAMES = 8 };	// Vector fields kept per Src/Ref pair
+	enum {			RADIUS     = 2 };	// Max distance between a frame and its predictor
+
+	typedef	std::shared_ptr <TemporalPredCache>	SPtr;
+
+						TemporalPredCache (int nbr_pairs, int arr_size);
+	virtual			~TemporalPredCache () {}
+
+	static SPtr		use_shared (const void *clip_ptr, const std::string &sig, int nbr_pairs, int arr_size);
+
+	void				store (int nsrc, int pair_index, const int *vect_ptr);
+	bool				fetch (int nsrc, int pair_index, int *vect_ptr);
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	class Entry
+	{
+	public:
+		int				_nsrc;		// -1 = empty
+		int64_t			_date;		// Value of _date_cnt when stored
+		std::vector <int>
+							_vect_arr;	// Allocated on first use
+	};
+
+	typedef	std::vector <Entry>	EntryArray;
+
+	typedef	std::pair <const void *, std::string>	Key;
+	typedef	std::map <Key, std::weak_ptr <TemporalPredCache> >	Registry;
+
+	Entry *			find (int nsrc, int pair_index);
+
+	const int		_nbr_pairs;
+	const int		_arr_size;		// ints
+	EntryArray		_entry_arr;		// [pair_index * NBR_FRAMES + pos]
+	int64_t			_date_cnt;
+	std::mutex		_mutex;
+
+	static std::mutex
+						_reg_mutex;
+	static Registry
+						_registry;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						TemporalPredCache ();
+						TemporalPredCache (const TemporalPredCache &other);
+	TemporalPredCache &
+						operator = (const TemporalPredCache &other);
+	bool				operator == (const TemporalPredCache &other) const;
+	bool				operator != (const TemporalPredCache &other) const;
+
+};	// class TemporalPredCache
+
+
+
+//#include	"TemporalPredCache.hpp"
+
+
+
+#endif	// TemporalPredCache_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -21,6 +21,7 @@
 #include <tuple>
 #include <map>
 #include "def.h"
+#include "SADFunctions_avx512.h"
 #include <cassert>
 #include <emmintrin.h>
 
@@ -297,8 +298,28 @@ func_luma[make_tuple(x, y, 2, NO_SIMD)] = Luma_C<x, y, uint16_t>;
       //MAKE_LUMA_FN(2, 1)
 #undef MAKE_LUMA_FN
 
+    // templates in SADFunctions_avx512
+#define MAKE_LUMA_FN(x, y) func_luma[make_tuple(x, y, 1, USE_AVX512)] = Luma_avx512<x, y, uint8_t>; \
+func_luma[make_tuple(x, y, 2, USE_AVX512)] = Luma_avx512<x, y, uint16_t>;
+      MAKE_LUMA_FN(64, 64)
+      MAKE_LUMA_FN(64, 48)
+      MAKE_LUMA_FN(64, 32)
+      MAKE_LUMA_FN(64, 16)
+      MAKE_LUMA_FN(32, 64)
+      MAKE_LUMA_FN(32, 32)
+      MAKE_LUMA_FN(32, 24)
+      MAKE_LUMA_FN(32, 16)
+      MAKE_LUMA_FN(32, 8)
+      MAKE_LUMA_FN(16, 64)
+      MAKE_LUMA_FN(16, 32)
+      MAKE_LUMA_FN(16, 16)
+      MAKE_LUMA_FN(16, 12)
+      MAKE_LUMA_FN(16, 8)
+      MAKE_LUMA_FN(16, 4)
+#undef MAKE_LUMA_FN
+
     LUMAFunction *result = nullptr;
-    arch_t archlist[] = { USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
+    arch_t archlist[] = { USE_AVX512, USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
     int index = 0;
     while (result == nullptr) {
       arch_t current_arch_try = archlist[index++];
@@ -0,0 +1,137 @@
+/*****************************************************************************
+
+        VectFile.h
+
+Layout of the vector files written by MAnalyse (vectfile parameter) and read
+back by MLoadVect.
+
+The file stores the frames of the vector clip verbatim, so a stored frame can
+be served to MVClip::Update() without any conversion. All the frames have the
+same size, therefore their position in the file is a direct function of the
+frame number.
+
+Offset                     Content
+0                          Header
+_header_size               Index: one byte per frame, != 0 if the frame
+                           has been written
+_data_offset + n * stride  Data of the frame n, _frame_size bytes
+                           (rows without pitch)
+
+All offsets are multiples of ALIGN. Frames which have not been requested
+during the analysis are missing from the file (index byte = 0).
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (VectFile_HEADER_INCLUDED)
+#define	VectFile_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"MVAnalysisData.h"
+
+#include	<stdint.h>
+
+
+
+class VectFile
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	enum
+	{
+		KEY     = 0x4656564D,	// 'MVVF'
+		VERSION = 1,
+		ALIGN   = 4096			// Bytes, for the data sections
+	};
+
+	class Header
+	{
+	public:
+		int32_t			_key;
+		int32_t			_version;
+		int32_t			_mad_size;			// sizeof (MVAnalysisData), for consistency checks
+		int32_t			_header_size;		// Bytes, multiple of ALIGN
+		int64_t			_data_offset;		// Bytes, multiple of ALIGN
+		int64_t			_frame_stride;		// Bytes, multiple of ALIGN
+		int32_t			_frame_size;		// Bytes
+		int32_t			_row_size;			// Bytes
+		int32_t			_nbr_frames;
+
+		// Vector clip format
+		int32_t			_width;
+		int32_t			_height;
+		int32_t			_pixel_type;
+		int32_t			_image_type;
+		uint32_t			_fps_num;
+		uint32_t			_fps_den;
+
+		// Analysis parameters, as transmitted to the clients
+		MVAnalysisData	_mad;
+	};
+
+	static inline int64_t
+						align (int64_t x)
+	{
+		return ((x + ALIGN - 1) & ~int64_t (ALIGN - 1));
+	}
+
+	// nbr_frames, row_size and height must be set
+	static inline void
+						compute_layout (Header &hdr)
+	{
+		hdr._key          = KEY;
+		hdr._version      = VERSION;
+		hdr._mad_size     = int32_t (sizeof (hdr._mad));
+		hdr._header_size  = int32_t (align (sizeof (hdr)));
+		hdr._data_offset  = hdr._header_size + align (hdr._nbr_frames);
+		hdr._frame_size   = hdr._row_size * hdr._height;
+		hdr._frame_stride = align (hdr._frame_size);
+	}
+
+	static inline int64_t
+						get_frame_offset (const Header &hdr, int n)
+	{
+		return (hdr._data_offset + n * hdr._frame_stride);
+	}
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						VectFile ();
+						VectFile (const VectFile &other);
+	VectFile &		operator = (const VectFile &other);
+	bool				operator == (const VectFile &other) const;
+	bool				operator != (const VectFile &other) const;
+
+};	// class VectFile
+
+
+
+#endif	// VectFile_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
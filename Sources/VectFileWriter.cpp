@@ -0,0 +1,155 @@
+/*****************************************************************************
+
+        VectFileWriter.cpp
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"VectFileWriter.h"
+
+#include	<vector>
+
+#include	<cassert>
+#include	<cstring>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+VectFileWriter::VectFileWriter ()
+:	_file_ptr (0)
+,	_hdr ()
+{
+	// Nothing
+}
+
+
+
+VectFileWriter::~VectFileWriter ()
+{
+	close ();
+}
+
+
+
+// Creates the file, writes the header and an empty index.
+// Returns false if the file cannot be created.
+bool	VectFileWriter::open (const char *filename_0, const ::VideoInfo &vi, const MVAnalysisData &mad)
+{
+	assert (filename_0 != 0);
+	assert (&vi != 0);
+	assert (&mad != 0);
+
+	close ();
+
+	memset (&_hdr, 0, sizeof (_hdr));
+	_hdr._row_size   = vi.RowSize ();
+	_hdr._nbr_frames = vi.num_frames;
+	_hdr._width      = vi.width;
+	_hdr._height     = vi.height;
+	_hdr._pixel_type = vi.pixel_type;
+	_hdr._image_type = vi.image_type;
+	_hdr._fps_num    = vi.fps_numerator;
+	_hdr._fps_den    = vi.fps_denominator;
+	_hdr._mad        = mad;
+	VectFile::compute_layout (_hdr);
+
+	_file_ptr = fopen (filename_0, "wb");
+	bool				ok_flag = (_file_ptr != 0);
+
+	// Header and index, up to the first frame
+	if (ok_flag)
+	{
+		std::vector <uint8_t>	buf (size_t (_hdr._data_offset), 0);
+		memcpy (&buf [0], &_hdr, sizeof (_hdr));
+		ok_flag = (fwrite (&buf [0], buf.size (), 1, _file_ptr) == 1);
+	}
+
+	if (! ok_flag)
+	{
+		close ();
+	}
+
+	return (ok_flag);
+}
+
+
+
+void	VectFileWriter::close ()
+{
+	if (_file_ptr != 0)
+	{
+		fclose (_file_ptr);
+		_file_ptr = 0;
+	}
+}
+
+
+
+// src_ptr points on the first row of the vector frame.
+// The index is updated after the data, so an interrupted write leaves the
+// frame marked as missing.
+bool	VectFileWriter::write_frame (int n, const uint8_t *src_ptr, int src_pitch)
+{
+	assert (_file_ptr != 0);
+	assert (n >= 0);
+	assert (n < _hdr._nbr_frames);
+	assert (src_ptr != 0);
+
+	bool				ok_flag = seek (VectFile::get_frame_offset (_hdr, n));
+	for (int y = 0; y < _hdr._height && ok_flag; ++y)
+	{
+		ok_flag = (fwrite (
+			src_ptr + y * src_pitch, _hdr._row_size, 1, _file_ptr
+		) == 1);
+	}
+
+	if (ok_flag)
+	{
+		const uint8_t	present = 1;
+		ok_flag =    seek (_hdr._header_size + n)
+		          && fwrite (&present, sizeof (present), 1, _file_ptr) == 1;
+	}
+
+	return (ok_flag);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// 64-bit seek, the files of long clips exceed 2 GB.
+bool	VectFileWriter::seek (int64_t pos)
+{
+	return (_fseeki64 (_file_ptr, pos, SEEK_SET) == 0);
+}
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
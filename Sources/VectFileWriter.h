@@ -0,0 +1,101 @@
+/*****************************************************************************
+
+        VectFileWriter.h
+
+Writes the frames of a vector clip in a file, see VectFile.h for the format.
+The frames can be written in any order. The writer is not thread-safe, the
+calling filter must be serialized.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (VectFileWriter_HEADER_INCLUDED)
+#define	VectFileWriter_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"VectFile.h"
+
+#define	NOGDI
+#define	NOMINMAX
+#define	WIN32_LEAN_AND_MEAN
+#include "Windows.h"
+#include	"avisynth.h"
+
+#include	<cstdio>
+
+
+
+class VectFileWriter
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+						VectFileWriter ();
+	virtual			~VectFileWriter ();
+
+	bool				open (const char *filename_0, const ::VideoInfo &vi, const MVAnalysisData &mad);
+	void				close ();
+	bool				write_frame (int n, const uint8_t *src_ptr, int src_pitch);
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	bool				seek (int64_t pos);
+
+	FILE *			_file_ptr;
+	VectFile::Header
+						_hdr;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						VectFileWriter (const VectFileWriter &other);
+	VectFileWriter &
+						operator = (const VectFileWriter &other);
+	bool				operator == (const VectFileWriter &other) const;
+	bool				operator != (const VectFileWriter &other) const;
+
+};	// class VectFileWriter
+
+
+
+//#include	"VectFileWriter.hpp"
+
+
+
+#endif	// VectFileWriter_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
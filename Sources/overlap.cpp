@@ -17,6 +17,7 @@
 // http://www.gnu.org/copyleft/gpl.html .
 
 #include "overlap.h"
+#include "overlap_avx2.h"
 #include "def.h"
 
 #include <cmath>
@@ -767,6 +768,55 @@ func_overlaps[make_tuple(x, y, 4, NO_SIMD)] = Overlaps_float_C<x, y>;
       //MAKE_OVR_FN(2, 1)
 #undef MAKE_OVR_FN
 
+    // define avx2 for 8/16 bits and float, mod4 widths only
+#define MAKE_OVR_FN(x, y) func_overlaps[make_tuple(x, y, 1, USE_AVX2)] = Overlaps_avx2<uint8_t, x, y>; \
+func_overlaps[make_tuple(x, y, 2, USE_AVX2)] = Overlaps_avx2<uint16_t, x, y>; \
+func_overlaps[make_tuple(x, y, 4, USE_AVX2)] = Overlaps_float_avx2<x, y>;
+    MAKE_OVR_FN(64, 64)
+      MAKE_OVR_FN(64, 48)
+      MAKE_OVR_FN(64, 32)
+      MAKE_OVR_FN(64, 16)
+      MAKE_OVR_FN(48, 64)
+      MAKE_OVR_FN(48, 48)
+      MAKE_OVR_FN(48, 24)
+      MAKE_OVR_FN(48, 12)
+      MAKE_OVR_FN(32, 64)
+      MAKE_OVR_FN(32, 32)
+      MAKE_OVR_FN(32, 24)
+      MAKE_OVR_FN(32, 16)
+      MAKE_OVR_FN(32, 8)
+      MAKE_OVR_FN(24, 48)
+      MAKE_OVR_FN(24, 32)
+      MAKE_OVR_FN(24, 24)
+      MAKE_OVR_FN(24, 12)
+      MAKE_OVR_FN(24, 6)
+      MAKE_OVR_FN(16, 64)
+      MAKE_OVR_FN(16, 32)
+      MAKE_OVR_FN(16, 16)
+      MAKE_OVR_FN(16, 12)
+      MAKE_OVR_FN(16, 8)
+      MAKE_OVR_FN(16, 4)
+      MAKE_OVR_FN(16, 2)
+      MAKE_OVR_FN(16, 1)
+      MAKE_OVR_FN(12, 48)
+      MAKE_OVR_FN(12, 24)
+      MAKE_OVR_FN(12, 16)
+      MAKE_OVR_FN(12, 12)
+      MAKE_OVR_FN(12, 6)
+      MAKE_OVR_FN(12, 3)
+      MAKE_OVR_FN(8, 32)
+      MAKE_OVR_FN(8, 16)
+      MAKE_OVR_FN(8, 8)
+      MAKE_OVR_FN(8, 4)
+      MAKE_OVR_FN(8, 2)
+      MAKE_OVR_FN(8, 1)
+      // 6, 3, 2: SSE2 or C
+      MAKE_OVR_FN(4, 8)
+      MAKE_OVR_FN(4, 4)
+      MAKE_OVR_FN(4, 2)
+      MAKE_OVR_FN(4, 1)
+#undef MAKE_OVR_FN
+
     OverlapsFunction *result = nullptr;
 
     arch_t archlist[] = { USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
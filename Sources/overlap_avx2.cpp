@@ -0,0 +1,296 @@
+// Overlap copy (really addition), AVX2 versions
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#include "overlap_avx2.h"
+#include "def.h"
+#include <immintrin.h>
+#include <cassert>
+#include <type_traits>
+
+#ifndef min
+#define min(a,b)            (((a) < (b)) ? (a) : (b))
+#endif
+
+// 8 bit: same as Overlaps_C and Overlap-a.asm
+// pDst[i] = pDst[i] + ((val * win + (1 << 5)) >> 6)
+// pWin is 0..2048. The 19 bit intermediate does not fit into 16 bits, but
+// _mm_mulhrs_epi16(a, b) = (a * b + (1 << 14)) >> 15, so with a = val << 7 (max 32640)
+// and b = win << 2 (max 8192) it gives exactly (val * win + (1 << 5)) >> 6 in one step.
+//
+// 16 bit: pDst[i] = pDst[i] + val * win, 32 bit result from mullo/mulhi_epu16
+template <typename pixel_t, int blockWidth, int blockHeight>
+void Overlaps_avx2(uint16_t *pDst0, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, short *pWin, int nWinPitch)
+{
+  static_assert(blockWidth % 4 == 0, "Overlaps_avx2: block width must be mod4");
+  // when pixel_t == uint16_t, dst should be int*
+  typedef typename std::conditional < sizeof(pixel_t) == 1, short, int>::type target_t;
+  target_t *pDst = reinterpret_cast<target_t *>(pDst0);
+
+  constexpr int wMod16 = (blockWidth / 16) * 16;
+  constexpr int wMod8 = (blockWidth / 8) * 8;
+
+  for (int j = 0; j < blockHeight; j++)
+  {
+    if constexpr(sizeof(pixel_t) == 1)
+    {
+      for (int x = 0; x < wMod16; x += 16)
+      {
+        __m256i src = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + x)));
+        __m256i win = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pWin + x));
+        __m256i res = _mm256_mulhrs_epi16(_mm256_slli_epi16(src, 7), _mm256_slli_epi16(win, 2));
+        __m256i dst = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pDst + x));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pDst + x), _mm256_adds_epu16(dst, res));
+      }
+      if constexpr(wMod8 != wMod16)
+      {
+        __m128i src = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pSrc + wMod16)));
+        __m128i win = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pWin + wMod16));
+        __m128i res = _mm_mulhrs_epi16(_mm_slli_epi16(src, 7), _mm_slli_epi16(win, 2));
+        __m128i dst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pDst + wMod16));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + wMod16), _mm_adds_epu16(dst, res));
+      }
+      if constexpr(wMod8 != blockWidth)
+      {
+        // 4 pixels left
+        __m128i src = _mm_cvtepu8_epi16(_mm_cvtsi32_si128(*reinterpret_cast<const int *>(pSrc + wMod8)));
+        __m128i win = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(pWin + wMod8));
+        __m128i res = _mm_mulhrs_epi16(_mm_slli_epi16(src, 7), _mm_slli_epi16(win, 2));
+        __m128i dst = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(pDst + wMod8));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(pDst + wMod8), _mm_adds_epu16(dst, res));
+      }
+    }
+    else
+    {
+      // 16 bits data + 11 bits window = 27 bits max (safe)
+      const uint16_t *pSrc16 = reinterpret_cast<const uint16_t *>(pSrc);
+      for (int x = 0; x < wMod16; x += 16)
+      {
+        __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pSrc16 + x));
+        __m256i win = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pWin + x));
+        __m256i mullo = _mm256_mullo_epi16(src, win);
+        __m256i mulhi = _mm256_mulhi_epu16(src, win); // win is never negative
+        __m256i res_lo = _mm256_unpacklo_epi16(mullo, mulhi); // pixels 0-3 and 8-11
+        __m256i res_hi = _mm256_unpackhi_epi16(mullo, mulhi); // pixels 4-7 and 12-15
+        __m256i res07 = _mm256_permute2x128_si256(res_lo, res_hi, 0x20);
+        __m256i res8f = _mm256_permute2x128_si256(res_lo, res_hi, 0x31);
+        __m256i dst07 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pDst + x));
+        __m256i dst8f = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pDst + x + 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pDst + x), _mm256_add_epi32(dst07, res07));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pDst + x + 8), _mm256_add_epi32(dst8f, res8f));
+      }
+      if constexpr(wMod8 != wMod16)
+      {
+        __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc16 + wMod16));
+        __m128i win = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pWin + wMod16));
+        __m128i mullo = _mm_mullo_epi16(src, win);
+        __m128i mulhi = _mm_mulhi_epu16(src, win);
+        __m128i dst03 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pDst + wMod16));
+        __m128i dst47 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pDst + wMod16 + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + wMod16), _mm_add_epi32(dst03, _mm_unpacklo_epi16(mullo, mulhi)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + wMod16 + 4), _mm_add_epi32(dst47, _mm_unpackhi_epi16(mullo, mulhi)));
+      }
+      if constexpr(wMod8 != blockWidth)
+      {
+        // 4 pixels left
+        __m128i src = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(pSrc16 + wMod8));
+        __m128i win = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(pWin + wMod8));
+        __m128i res = _mm_unpacklo_epi16(_mm_mullo_epi16(src, win), _mm_mulhi_epu16(src, win));
+        __m128i dst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pDst + wMod8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + wMod8), _mm_add_epi32(dst, res));
+      }
+    }
+    pDst += nDstPitch;
+    pSrc += nSrcPitch;
+    pWin += nWinPitch;
+  }
+  _mm256_zeroupper();
+}
+
+// same as Overlaps_float_C: pDst[i] = pDst[i] + val * (win / 2048)
+// no FMA, to keep the C rounding
+template <int blockWidth, int blockHeight>
+void Overlaps_float_avx2(uint16_t *pDst0, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, short *pWin, int nWinPitch)
+{
+  static_assert(blockWidth % 4 == 0, "Overlaps_float_avx2: block width must be mod4");
+  float *pDst = reinterpret_cast<float *>(pDst0);
+
+  constexpr int wMod8 = (blockWidth / 8) * 8;
+  const __m256 scale = _mm256_set1_ps(1.0f / 2048.0f);
+
+  for (int j = 0; j < blockHeight; j++)
+  {
+    const float *pSrcF = reinterpret_cast<const float *>(pSrc);
+    for (int x = 0; x < wMod8; x += 8)
+    {
+      __m256 win = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pWin + x))));
+      win = _mm256_mul_ps(win, scale);
+      __m256 src = _mm256_loadu_ps(pSrcF + x);
+      __m256 dst = _mm256_loadu_ps(pDst + x);
+      _mm256_storeu_ps(pDst + x, _mm256_add_ps(dst, _mm256_mul_ps(src, win)));
+    }
+    if constexpr(wMod8 != blockWidth)
+    {
+      // 4 pixels left
+      __m128 win = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pWin + wMod8))));
+      win = _mm_mul_ps(win, _mm256_castps256_ps128(scale));
+      __m128 src = _mm_loadu_ps(pSrcF + wMod8);
+      __m128 dst = _mm_loadu_ps(pDst + wMod8);
+      _mm_storeu_ps(pDst + wMod8, _mm_add_ps(dst, _mm_mul_ps(src, win)));
+    }
+    pDst += nDstPitch;
+    pSrc += nSrcPitch;
+    pWin += nWinPitch;
+  }
+  _mm256_zeroupper();
+}
+
+// see Short2Bytes_sse2: (Sum((overlapped + 32) >> 6) + 16) >> 5
+void Short2Bytes_avx2(unsigned char *pDst, int nDstPitch, uint16_t *pDstShort, int dstShortPitch, int nWidth, int nHeight)
+{
+  const int rounder_i = 1 << 4;
+  const __m256i rounder = _mm256_set1_epi16(rounder_i);
+  const int nSrcPitch = dstShortPitch * sizeof(short); // back to byte size
+  uint8_t *pSrc8 = reinterpret_cast<uint8_t *>(pDstShort);
+  uint8_t *pDst8 = reinterpret_cast<uint8_t *>(pDst);
+  const int wMod32 = (nWidth / 32) * 32;
+  const int wMod16 = (nWidth / 16) * 16;
+  const int wMod8 = (nWidth / 8) * 8;
+  for (int y = 0; y < nHeight; y++)
+  {
+    for (int x = 0; x < wMod32; x += 32) {
+      __m256i src00 = _mm256_loadu_si256((__m256i *)(pSrc8 + x * 2)); // 16 short pixels
+      __m256i src16 = _mm256_loadu_si256((__m256i *)(pSrc8 + x * 2 + 32)); // 16 short pixels
+      // total shift is 11: 6+5. Shift 6 is already done, we shift the rest 5.
+      __m256i res00 = _mm256_srai_epi16(_mm256_add_epi16(src00, rounder), 5);
+      __m256i res16 = _mm256_srai_epi16(_mm256_add_epi16(src16, rounder), 5);
+      __m256i res = _mm256_packus_epi16(res00, res16); // lane-wise: 0-7, 16-23, 8-15, 24-31
+      res = _mm256_permute4x64_epi64(res, (0 << 0) | (2 << 2) | (1 << 4) | (3 << 6));
+      _mm256_storeu_si256((__m256i *)(pDst8 + x), res);
+    }
+    if (wMod16 != wMod32) {
+      __m128i src07 = _mm_loadu_si128((__m128i *)(pSrc8 + wMod32 * 2));
+      __m128i src8f = _mm_loadu_si128((__m128i *)(pSrc8 + wMod32 * 2 + 16));
+      __m128i res07 = _mm_srai_epi16(_mm_add_epi16(src07, _mm256_castsi256_si128(rounder)), 5);
+      __m128i res8f = _mm_srai_epi16(_mm_add_epi16(src8f, _mm256_castsi256_si128(rounder)), 5);
+      _mm_storeu_si128((__m128i *)(pDst8 + wMod32), _mm_packus_epi16(res07, res8f));
+    }
+    if (wMod8 != wMod16) {
+      __m128i src07 = _mm_loadu_si128((__m128i *)(pSrc8 + wMod16 * 2));
+      __m128i res07 = _mm_srai_epi16(_mm_add_epi16(src07, _mm256_castsi256_si128(rounder)), 5);
+      _mm_storel_epi64((__m128i *)(pDst8 + wMod16), _mm_packus_epi16(res07, res07));
+    }
+    for (int x = wMod8; x < nWidth; x++) {
+      int a = (reinterpret_cast<uint16_t *>(pSrc8)[x] + rounder_i) >> 5;
+      pDst8[x] = min(255, a);
+    }
+    pDst8 += nDstPitch;
+    pSrc8 += nSrcPitch;
+  }
+  _mm256_zeroupper();
+}
+
+// see Short2Bytes_Int32toWord16_sse4. Like that one, it writes the last row
+// chunk in full 16 bytes (8 pixels)
+void Short2Bytes_Int32toWord16_avx2(uint16_t *pDst, int nDstPitch, int *pDstInt, int dstIntPitch, int nWidth, int nHeight, int bits_per_pixel)
+{
+  const int max_pixel_value = (1 << bits_per_pixel) - 1;
+  const __m256i limits16 = _mm256_set1_epi16(max_pixel_value);
+  // origin: overlap windows have 11 bits precision
+  const __m256i rounder = _mm256_set1_epi32(1 << 10);
+
+  const int nSrcPitch = dstIntPitch * sizeof(int); // back to byte size
+  const int width_b = nWidth * sizeof(uint16_t); // destination byte size
+  const int width_b_mod32 = (width_b / 32) * 32;
+  uint8_t *pSrc8 = reinterpret_cast<uint8_t *>(pDstInt);
+  uint8_t *pDst8 = reinterpret_cast<uint8_t *>(pDst);
+
+  for (int y = 0; y < nHeight; y++)
+  {
+    int x = 0;
+    for (; x < width_b_mod32; x += 32) { // 64 source bytes = 16 integer sized pixels, 32 bytes of 16*uint16_t destination
+      __m256i src07 = _mm256_loadu_si256((__m256i *)(pSrc8 + x * 2));
+      __m256i src8f = _mm256_loadu_si256((__m256i *)(pSrc8 + x * 2 + 32));
+      __m256i res07 = _mm256_srai_epi32(_mm256_add_epi32(src07, rounder), 11);
+      __m256i res8f = _mm256_srai_epi32(_mm256_add_epi32(src8f, rounder), 11);
+      __m256i res = _mm256_packus_epi32(res07, res8f); // lane-wise: 0-3, 8-11, 4-7, 12-15
+      res = _mm256_permute4x64_epi64(res, (0 << 0) | (2 << 2) | (1 << 4) | (3 << 6));
+      res = _mm256_min_epu16(res, limits16); // 10,12,14 bits can be lesser
+      _mm256_storeu_si256((__m256i *)(pDst8 + x), res);
+    }
+    for (; x < width_b; x += 16) {
+      __m128i src03 = _mm_loadu_si128((__m128i *)(pSrc8 + x * 2));
+      __m128i src47 = _mm_loadu_si128((__m128i *)(pSrc8 + x * 2 + 16));
+      __m128i res03 = _mm_srai_epi32(_mm_add_epi32(src03, _mm256_castsi256_si128(rounder)), 11);
+      __m128i res47 = _mm_srai_epi32(_mm_add_epi32(src47, _mm256_castsi256_si128(rounder)), 11);
+      __m128i res = _mm_packus_epi32(res03, res47);
+      res = _mm_min_epu16(res, _mm256_castsi256_si128(limits16));
+      _mm_storeu_si128((__m128i *)(pDst8 + x), res);
+    }
+    pDst8 += nDstPitch;
+    pSrc8 += nSrcPitch;
+  }
+  _mm256_zeroupper();
+}
+
+// Instantiate
+// match with get_overlaps_function in overlap.cpp, block widths mod4
+#define MAKE_OVR_FN(x, y) template void Overlaps_avx2<uint8_t, x, y>(uint16_t *pDst0, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, short *pWin, int nWinPitch); \
+template void Overlaps_avx2<uint16_t, x, y>(uint16_t *pDst0, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, short *pWin, int nWinPitch); \
+template void Overlaps_float_avx2<x, y>(uint16_t *pDst0, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, short *pWin, int nWinPitch);
+MAKE_OVR_FN(64, 64)
+MAKE_OVR_FN(64, 48)
+MAKE_OVR_FN(64, 32)
+MAKE_OVR_FN(64, 16)
+MAKE_OVR_FN(48, 64)
+MAKE_OVR_FN(48, 48)
+MAKE_OVR_FN(48, 24)
+MAKE_OVR_FN(48, 12)
+MAKE_OVR_FN(32, 64)
+MAKE_OVR_FN(32, 32)
+MAKE_OVR_FN(32, 24)
+MAKE_OVR_FN(32, 16)
+MAKE_OVR_FN(32, 8)
+MAKE_OVR_FN(24, 48)
+MAKE_OVR_FN(24, 32)
+MAKE_OVR_FN(24, 24)
+MAKE_OVR_FN(24, 12)
+MAKE_OVR_FN(24, 6)
+MAKE_OVR_FN(16, 64)
+MAKE_OVR_FN(16, 32)
+MAKE_OVR_FN(16, 16)
+MAKE_OVR_FN(16, 12)
+MAKE_OVR_FN(16, 8)
+MAKE_OVR_FN(16, 4)
+MAKE_OVR_FN(16, 2)
+MAKE_OVR_FN(16, 1)
+MAKE_OVR_FN(12, 48)
+MAKE_OVR_FN(12, 24)
+MAKE_OVR_FN(12, 16)
+MAKE_OVR_FN(12, 12)
+MAKE_OVR_FN(12, 6)
+MAKE_OVR_FN(12, 3)
+MAKE_OVR_FN(8, 32)
+MAKE_OVR_FN(8, 16)
+MAKE_OVR_FN(8, 8)
+MAKE_OVR_FN(8, 4)
+MAKE_OVR_FN(8, 2)
+MAKE_OVR_FN(8, 1)
+MAKE_OVR_FN(4, 8)
+MAKE_OVR_FN(4, 4)
+MAKE_OVR_FN(4, 2)
+MAKE_OVR_FN(4, 1)
+#undef MAKE_OVR_FN
@@ -0,0 +1,38 @@
+// Overlap copy (really addition), AVX2 versions
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef __OVERLAP_AVX2__
+#define __OVERLAP_AVX2__
+
+#include <stdint.h>
+
+// pDst is short* for 8 bit, int * for 16 bit sources
+// for block widths multiple of 4
+template <typename pixel_t, int blockWidth, int blockHeight>
+void Overlaps_avx2(uint16_t *pDst0, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, short *pWin, int nWinPitch);
+
+// pDst is float *
+// for block widths multiple of 4
+template <int blockWidth, int blockHeight>
+void Overlaps_float_avx2(uint16_t *pDst0, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, short *pWin, int nWinPitch);
+
+void Short2Bytes_avx2(unsigned char *pDst, int nDstPitch, uint16_t *pDstShort, int dstShortPitch, int nWidth, int nHeight);
+void Short2Bytes_Int32toWord16_avx2(uint16_t *pDst, int nDstPitch, int *pDstInt, int dstIntPitch, int nWidth, int nHeight, int bits_per_pixel);
+
+#endif
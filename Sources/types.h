@@ -36,7 +36,8 @@ enum arch_t {
     USE_SSE41,
     USE_SSE42,
     USE_AVX,
-    USE_AVX2
+    USE_AVX2,
+    USE_AVX512 // AVX-512F + AVX-512BW
 };
 
 typedef uint8_t BYTE;
@@ -45,6 +46,26 @@ typedef uint8_t BYTE;
 typedef unsigned int (SADFunction)(const uint8_t *pSrc, int nSrcPitch,
   const uint8_t *pRef, int nRefPitch);
 
+// Multi-candidate SAD: scores 3 or 4 reference blocks against the same
+// source block in a single pass. Results are written in sads[0..2] or [0..3].
+typedef void (SADx3Function)(const uint8_t *pSrc, int nSrcPitch,
+  const uint8_t *pRef0, const uint8_t *pRef1, const uint8_t *pRef2,
+  int nRefPitch, unsigned int *sads);
+typedef void (SADx4Function)(const uint8_t *pSrc, int nSrcPitch,
+  const uint8_t *pRef0, const uint8_t *pRef1, const uint8_t *pRef2, const uint8_t *pRef3,
+  int nRefPitch, unsigned int *sads);
+
+// Luma and chroma SAD of a YUV block in a single call. Planes are indexed
+// 0 (Y), 1 (U) and 2 (V). Returns the luma SAD; the U + V SAD, scaled with
+// ScaleSadChroma(chroma_scale), is written in *sad_uv.
+typedef unsigned int (SADYUVFunction)(const uint8_t * const *pSrc, const int *nSrcPitch,
+  const uint8_t * const *pRef, const int *nRefPitch, int chroma_scale, unsigned int *sad_uv);
+
+// Chroma part of SADYUVFunction: the U + V SAD, scaled with
+// ScaleSadChroma(chroma_scale). Plane 0 is not read.
+typedef unsigned int (SADUVFunction)(const uint8_t * const *pSrc, const int *nSrcPitch,
+  const uint8_t * const *pRef, const int *nRefPitch, int chroma_scale);
+
 #endif	// types_HEADER_INCLUDED
 
 